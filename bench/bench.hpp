@@ -0,0 +1,63 @@
+#ifndef AMBIENT3D_BENCH_HPP
+#define AMBIENT3D_BENCH_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+
+
+// Small helpers shared by the headless benchmarks in this directory.
+// Results are printed, nothing is compared against stored numbers.
+
+namespace AM {
+    namespace Bench {
+
+        inline double now_seconds() {
+            return std::chrono::duration<double>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // Keeps the compiler from removing work whose result is not used.
+        template<typename T>
+        inline void keep(const T& value) {
+            asm volatile("" : : "g"(&value) : "memory");
+        }
+
+        // Calls 'func' until 'min_seconds' have passed (at least 'min_calls' times).
+        // Returns average nanoseconds per call.
+        template<typename FUNC>
+        double time_ns(FUNC func, double min_seconds = 0.25, int64_t min_calls = 1) {
+            func(); // Warm up.
+            int64_t calls = 0;
+            const double start = now_seconds();
+            double elapsed = 0.0;
+            do {
+                func();
+                calls++;
+                elapsed = now_seconds() - start;
+            } while((elapsed < min_seconds) || (calls < min_calls));
+            return (elapsed * 1e9) / (double)calls;
+        }
+
+        // Fixed seed xorshift so every run uses the same data.
+        struct Random {
+            uint64_t state { 0x9E3779B97F4A7C15ULL };
+
+            uint64_t next() {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                return state;
+            }
+            float uniform(float min, float max) {
+                return min + (float)((double)(next() >> 11) / (double)(1ULL << 53)) * (max - min);
+            }
+            int range(int min, int max) {
+                return min + (int)(next() % (uint64_t)(max - min + 1));
+            }
+        };
+    };
+};
+
+
+#endif
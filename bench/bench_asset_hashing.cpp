@@ -0,0 +1,105 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <fstream>
+#include <filesystem>
+
+#include "bench.hpp"
+#include "server/assets_server/src/asset_files.hpp"
+#include "shared/include/logger.hpp"
+
+namespace fs = std::filesystem;
+
+
+// Startup of the assets server on a large synthetic asset tree:
+// find_asset_files + compute_asset_file_hashes with one thread and no cache (same as before),
+// with all threads, with a warm hash cache and with a few changed files.
+// The files were just written so they are read from the page cache.
+
+static constexpr int    NUM_FILES     = 1000;
+static constexpr size_t MIN_FILE_SIZE = 4 * 1024;
+static constexpr size_t MAX_FILE_SIZE = 512 * 1024;
+
+static const fs::path _bench_dir() {
+    return fs::temp_directory_path() / "ambient3d_bench_asset_hashing";
+}
+
+static size_t _create_tree(const fs::path& host_dir) {
+    fs::remove_all(host_dir);
+    AM::Bench::Random random;
+    std::vector<char> bytes(MAX_FILE_SIZE);
+    size_t total_bytes = 0;
+
+    for(int i = 0; i < NUM_FILES; i++) {
+        // Few levels of directories like a real asset tree has.
+        const bool model = (i % 3 == 0);
+        const fs::path dir = host_dir / (model ? "models" : "textures") / ("group_" + std::to_string(i % 17));
+        fs::create_directories(dir);
+
+        const size_t size = (size_t)random.range(MIN_FILE_SIZE, MAX_FILE_SIZE);
+        for(size_t k = 0; k < size; k++) {
+            bytes[k] = (char)random.next();
+        }
+        std::ofstream file(dir / ("file_" + std::to_string(i) + (model ? ".glb" : ".png")), std::ios::binary);
+        file.write(bytes.data(), size);
+        total_bytes += size;
+    }
+    return total_bytes;
+}
+
+// Returns milliseconds of one server start.
+static double _startup_ms(const AM::Config& config) {
+    AM::AssetFileStorage file_storage;
+    const double start = AM::Bench::now_seconds();
+    AM::find_asset_files(config, &file_storage);
+    AM::compute_asset_file_hashes(config, &file_storage);
+    file_storage.update_sorted_files();
+    const double ms = (AM::Bench::now_seconds() - start) * 1000.0;
+
+    if(file_storage.files.size() != (size_t)NUM_FILES) {
+        printf("ERROR! Found %zu files, expected %i\n", file_storage.files.size(), NUM_FILES);
+    }
+    return ms;
+}
+
+int main() {
+    AM::set_log_level(AM::LL_ERROR);
+
+    AM::Config config;
+    config.host_dir = (_bench_dir() / "host").string();
+    config.allowed_model_file_exts = ".glb";
+    config.allowed_texture_file_exts = ".png";
+    config.hash_cache_path = (_bench_dir() / "hash_cache.json").string();
+
+    const size_t total_bytes = _create_tree(config.host_dir);
+    printf("%i files, %.1f MB, %u cpu cores\n", NUM_FILES, total_bytes / 1e6, std::thread::hardware_concurrency());
+
+    fs::remove(config.hash_cache_path);
+    config.hash_threads = 1;
+    const double serial_ms = _startup_ms(config);
+
+    fs::remove(config.hash_cache_path);
+    config.hash_threads = 0;
+    const double parallel_ms = _startup_ms(config);
+
+    const double cached_ms = _startup_ms(config);
+
+    // Touched files are hashed again, others come from the cache.
+    const int num_changed = 10;
+    for(int i = 0; i < num_changed; i++) {
+        const fs::path path = fs::path(config.host_dir) / "textures" / ("group_" + std::to_string((i*3+1) % 17))
+            / ("file_" + std::to_string(i*3+1) + ".png");
+        fs::last_write_time(path, fs::file_time_type::clock::now());
+    }
+    const double changed_ms = _startup_ms(config);
+
+    printf("no cache, 1 thread     %8.1f ms\n", serial_ms);
+    printf("no cache, all threads  %8.1f ms\n", parallel_ms);
+    printf("warm cache             %8.1f ms\n", cached_ms);
+    printf("%2i files changed       %8.1f ms\n", num_changed, changed_ms);
+
+    fs::remove_all(_bench_dir());
+    return 0;
+}
+
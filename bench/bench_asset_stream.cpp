@@ -0,0 +1,146 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <fstream>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "bench.hpp"
+#include "server/assets_server/src/server.hpp"
+#include "src/ambient3d/network/assets_downloader.hpp"
+#include "shared/include/logger.hpp"
+
+namespace fs = std::filesystem;
+
+
+// Whole asset download through the assets server and AssetsDownloader on loopback.
+// The old protocol sends 1 KB ASSET_FILE_BYTES packets which each wait for GOT_SOME_FILE_BYTES,
+// file streaming sends the files with sendfile() as interleaved frames.
+// Compression and delta updates are disabled so only the transfer is measured.
+
+static constexpr int BENCH_PORT = 34590;
+
+static const fs::path _bench_dir() {
+    return fs::temp_directory_path() / "ambient3d_bench_asset_stream";
+}
+
+// Random bytes so nothing on the way can make the transfer cheaper.
+static void _create_files(const fs::path& dir, const char* extension, int count, size_t size) {
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    AM::Bench::Random random;
+    std::vector<char> bytes(size);
+    for(int i = 0; i < count; i++) {
+        for(char& byte : bytes) {
+            byte = (char)random.next();
+        }
+        std::ofstream file(dir / ("file_" + std::to_string(i) + extension), std::ios::binary);
+        file.write(bytes.data(), bytes.size());
+    }
+}
+
+static AM::Config _server_config(bool stream_files) {
+    AM::Config config;
+    config.port = BENCH_PORT;
+    config.host_dir = (_bench_dir() / "host").string();
+    config.allowed_model_file_exts = ".glb";
+    config.allowed_texture_file_exts = ".png";
+    config.watch_host_dir = false;
+    config.hash_cache_path = (_bench_dir() / "hash_cache.json").string();
+    config.hash_threads = 0;
+    config.stream_files = stream_files;
+    config.stream_window_bytes = 1024 * 1024;
+    config.max_concurrent_streams = 4;
+    config.delta_updates = false;
+    config.compress_files = false;
+    config.compression_level = 0;
+    return config;
+}
+
+// Returns seconds from connecting to the last file written or -1 if some file is missing.
+static double _download(bool stream_files, size_t* bytes_out) {
+    const AM::Config config = _server_config(stream_files);
+    AM::AssetFileStorage file_storage;
+    AM::find_asset_files(config, &file_storage);
+    AM::compute_asset_file_hashes(config, &file_storage);
+    file_storage.update_sorted_files();
+
+    asio::io_context server_context;
+    AM::GameAssetsServer server(config, &file_storage, server_context);
+    std::thread server_th([&server, &server_context]() {
+        server.start(server_context);
+    });
+
+    const fs::path client_dir = _bench_dir() / "client";
+    fs::remove_all(client_dir);
+    AM::ClientConfig client_config;
+    client_config.game_asset_dir = client_dir.string() + "/";
+
+    // Download progress is printed for every packet with the old protocol.
+    fflush(stdout);
+    const int stdout_fd = dup(1);
+    const int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, 1);
+
+    const double start = AM::Bench::now_seconds();
+    {
+        asio::io_context client_context;
+        AM::AssetsDownloader downloader(client_config, client_context, "127.0.0.1",
+                std::to_string(BENCH_PORT).c_str());
+        downloader.ask_download_permission = false;
+        downloader.update_assets();
+        downloader.close_connection(client_context);
+    }
+    const double seconds = AM::Bench::now_seconds() - start;
+
+    fflush(stdout);
+    dup2(stdout_fd, 1);
+    close(stdout_fd);
+    close(null_fd);
+
+    server_context.stop();
+    server_th.join();
+
+    *bytes_out = 0;
+    for(const auto& [name, file] : file_storage.files) {
+        std::error_code ec;
+        if(fs::file_size(client_dir / file->type_group / name, ec) != file->size) {
+            return -1.0;
+        }
+        *bytes_out += file->size;
+    }
+    return seconds;
+}
+
+static void _run(const char* name) {
+    for(const bool stream_files : { false, true }) {
+        size_t bytes = 0;
+        const double seconds = _download(stream_files, &bytes);
+        if(seconds < 0.0) {
+            printf("%-22s | %-14s | FAILED (downloaded files dont match)\n",
+                    name, stream_files ? "file streaming" : "old protocol");
+            continue;
+        }
+        printf("%-22s | %-14s | %8.1f ms | %8.1f MB/s\n",
+                name, stream_files ? "file streaming" : "old protocol",
+                seconds * 1000.0, bytes / seconds / 1e6);
+    }
+}
+
+int main() {
+    AM::set_log_level(AM::LL_ERROR);
+    const fs::path host_dir = _bench_dir() / "host";
+
+    _create_files(host_dir / "models", ".glb", 4, 8 * 1024 * 1024);
+    _run("4 x 8 MB models");
+
+    _create_files(host_dir / "models", ".glb", 0, 0);
+    _create_files(host_dir / "textures", ".png", 256, 32 * 1024);
+    _run("256 x 32 KB textures");
+
+    fs::remove_all(_bench_dir());
+    return 0;
+}
+
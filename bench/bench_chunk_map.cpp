@@ -0,0 +1,74 @@
+#include <cstdio>
+#include <unordered_map>
+
+#include "bench.hpp"
+#include "shared/include/chunk_map.hpp"
+
+
+// ChunkMap against std::unordered_map with the old and the current ChunkPos hash.
+// Keys are a square world of chunks around the origin, like the terrain maps have.
+
+struct OldChunkPosHash {
+    size_t operator()(const AM::ChunkPos& k) const {
+        return std::hash<int>()(k.x) ^ (std::hash<int>()(k.z) << 1);
+    }
+};
+
+template<typename MAP>
+static void _run(const char* name, int side) {
+    const size_t num_chunks = (size_t)side * side;
+    const int half = side / 2;
+    MAP map;
+
+    const double start = AM::Bench::now_seconds();
+    for(int z = 0; z < side; z++) {
+        for(int x = 0; x < side; x++) {
+            map.insert(std::make_pair(AM::ChunkPos(x - half, z - half), x));
+        }
+    }
+    const double insert_ns = (AM::Bench::now_seconds() - start) * 1e9 / num_chunks;
+
+    // Every key once, in rows like the terrain code walks neighbours.
+    long sum = 0;
+    const double find_ns = AM::Bench::time_ns([&]() {
+        for(int z = 0; z < side; z++) {
+            for(int x = 0; x < side; x++) {
+                auto it = map.find(AM::ChunkPos(x - half, z - half));
+                sum += it->second;
+            }
+        }
+    }) / num_chunks;
+
+    // Keys just outside of the world.
+    const double miss_ns = AM::Bench::time_ns([&]() {
+        for(int x = 0; x < side; x++) {
+            sum += (map.find(AM::ChunkPos(x - half, side - half)) != map.end());
+            sum += (map.find(AM::ChunkPos(side - half, x - half)) != map.end());
+        }
+    }) / (2 * side);
+
+    // Sliding window: the player walks along X, one column is erased and one inserted.
+    int column = 0;
+    const double slide_ns = AM::Bench::time_ns([&]() {
+        for(int z = 0; z < side; z++) {
+            map.erase(AM::ChunkPos(column - half, z - half));
+            map.insert(std::make_pair(AM::ChunkPos(column - half + side, z - half), z));
+        }
+        column++;
+    }) / side;
+
+    AM::Bench::keep(sum);
+    printf("%-24s %8zu chunks | insert %7.1f ns | find %7.1f ns | miss %7.1f ns | erase+insert %7.1f ns\n",
+            name, num_chunks, insert_ns, find_ns, miss_ns, slide_ns);
+}
+
+int main() {
+    for(const int side : { 32, 100, 316, 1000 }) {
+        _run<std::unordered_map<AM::ChunkPos, int, OldChunkPosHash>>("unordered_map (old hash)", side);
+        _run<std::unordered_map<AM::ChunkPos, int>>("unordered_map", side);
+        _run<AM::ChunkMap<int>>("ChunkMap", side);
+        printf("\n");
+    }
+    return 0;
+}
+
@@ -0,0 +1,136 @@
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+#include "bench.hpp"
+#include "src/ambient3d/terrain/chunk_mesh.hpp"
+
+
+// Chunk mesh build time and memory.
+// The old builder (6 unique vertices per cell, flat normals, no indices)
+// is copied here as it was before chunk_mesh.cpp, so both can be compared.
+
+static void _old_build(const float* heights, int chunk_size, float scale,
+        float* vertices, float* normals) {
+    const int row = chunk_size+1;
+    size_t v = 0;
+    for(int z = 0; z < chunk_size; z++) {
+        for(int x = 0; x < chunk_size; x++) {
+            const float xf = (float)x;
+            const float zf = (float)z;
+            const float h00 = heights[z * row + x];
+            const float h01 = heights[(z+1) * row + x];
+            const float h10 = heights[z * row + x+1];
+            const float h11 = heights[(z+1) * row + x+1];
+            const float tri[18] = {
+                xf * scale,        h00, zf * scale,
+                xf * scale,        h01, (zf+1.0f) * scale,
+                (xf+1.0f) * scale, h10, zf * scale,
+                (xf+1.0f) * scale, h10, zf * scale,
+                xf * scale,        h01, (zf+1.0f) * scale,
+                (xf+1.0f) * scale, h11, (zf+1.0f) * scale
+            };
+            for(int i = 0; i < 18; i++) {
+                vertices[v+i] = tri[i];
+            }
+            v += 18;
+        }
+    }
+
+    for(size_t i = 0; i < v; i += 9) {
+        const float* a = &vertices[i];
+        const float* b = &vertices[i+3];
+        const float* c = &vertices[i+6];
+        const float ux = b[0]-a[0], uy = b[1]-a[1], uz = b[2]-a[2];
+        const float wx = c[0]-a[0], wy = c[1]-a[1], wz = c[2]-a[2];
+        float nx = uy*wz - uz*wy;
+        float ny = uz*wx - ux*wz;
+        float nz = ux*wy - uy*wx;
+        const float len = sqrtf(nx*nx + ny*ny + nz*nz);
+        if(len > 0.0f) {
+            nx /= len; ny /= len; nz /= len;
+        }
+        for(int k = 0; k < 9; k += 3) {
+            normals[i+k+0] = nx;
+            normals[i+k+1] = ny;
+            normals[i+k+2] = nz;
+        }
+    }
+}
+
+static void _run(int chunk_size, float scale) {
+    const int row = chunk_size+1;
+    AM::Bench::Random random;
+
+    std::vector<float> heights(row * row);
+    for(int z = 0; z < row; z++) {
+        for(int x = 0; x < row; x++) {
+            heights[z * row + x] = sinf(x * 0.3f) * 6.0f + cosf(z * 0.2f) * 4.0f + random.uniform(-0.5f, 0.5f);
+        }
+    }
+
+    // Old.
+    const size_t old_num_vertices = (size_t)chunk_size * chunk_size * 6;
+    std::vector<float> old_vertices(old_num_vertices * 3);
+    std::vector<float> old_normals(old_num_vertices * 3);
+    const double old_ns = AM::Bench::time_ns([&]() {
+        _old_build(heights.data(), chunk_size, scale, old_vertices.data(), old_normals.data());
+        AM::Bench::keep(old_normals[0]);
+    });
+    const size_t old_bytes = old_num_vertices * 3 * sizeof(float) * 2;
+
+    // New, every level like Chunk::load builds them.
+    const int num_levels = AM::ChunkMesh::num_lod_levels(chunk_size);
+    std::vector<float> full_normals(AM::ChunkMesh::num_grid_vertices(chunk_size) * 3);
+    std::vector<std::vector<float>> vertices(num_levels);
+    std::vector<std::vector<float>> normals(num_levels);
+    std::vector<std::vector<uint16_t>> indices(num_levels);
+    size_t new_bytes = full_normals.size() * sizeof(float);
+    size_t level0_bytes = 0;
+    for(int level = 0; level < num_levels; level++) {
+        vertices[level].resize(AM::ChunkMesh::num_vertices(chunk_size, level) * 3);
+        normals[level].resize(AM::ChunkMesh::num_vertices(chunk_size, level) * 3);
+        indices[level].resize(AM::ChunkMesh::num_indices(chunk_size, level));
+        const size_t bytes = (vertices[level].size() + normals[level].size()) * sizeof(float)
+                           + indices[level].size() * sizeof(uint16_t);
+        new_bytes += bytes;
+        if(level == 0) {
+            level0_bytes = bytes;
+        }
+    }
+
+    const AM::ChunkMesh::Neighbours neighbours;
+    const double level0_ns = AM::Bench::time_ns([&]() {
+        AM::ChunkMesh::build_normals(heights.data(), chunk_size, scale, neighbours, full_normals.data());
+        AM::ChunkMesh::build_vertices(heights.data(), chunk_size, scale, 0, 1.0f, vertices[0].data());
+        AM::ChunkMesh::build_indices(chunk_size, 0, indices[0].data());
+        AM::ChunkMesh::build_level_normals(full_normals.data(), chunk_size, 0, normals[0].data());
+        AM::Bench::keep(normals[0][0]);
+    });
+    const double all_levels_ns = AM::Bench::time_ns([&]() {
+        const float skirt = AM::ChunkMesh::skirt_depth(heights.data(), chunk_size, scale, num_levels);
+        AM::ChunkMesh::build_normals(heights.data(), chunk_size, scale, neighbours, full_normals.data());
+        for(int level = 0; level < num_levels; level++) {
+            AM::ChunkMesh::build_vertices(heights.data(), chunk_size, scale, level, skirt, vertices[level].data());
+            AM::ChunkMesh::build_indices(chunk_size, level, indices[level].data());
+            AM::ChunkMesh::build_level_normals(full_normals.data(), chunk_size, level, normals[level].data());
+        }
+        AM::Bench::keep(normals[0][0]);
+    });
+
+    printf("chunk_size %3i | old %8.2f us %8.1f KB (%zu vertices)"
+            " | new level 0 %8.2f us %8.1f KB (%zu vertices)"
+            " | all %i levels %8.2f us %8.1f KB\n",
+            chunk_size,
+            old_ns / 1000.0, old_bytes / 1024.0, old_num_vertices,
+            level0_ns / 1000.0, level0_bytes / 1024.0, AM::ChunkMesh::num_vertices(chunk_size),
+            num_levels, all_levels_ns / 1000.0, new_bytes / 1024.0);
+}
+
+int main() {
+    for(const int chunk_size : { 16, 32, 64, 128 }) {
+        _run(chunk_size, 4.0f);
+    }
+    return 0;
+}
+
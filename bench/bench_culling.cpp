@@ -0,0 +1,93 @@
+#include <cstdio>
+#include <vector>
+
+#include "bench.hpp"
+#include "src/ambient3d/culling.hpp"
+#include "raymath.h"
+
+
+// Frustum and distance culling of a chunk grid.
+// find_visible (4 boxes at once) is compared to the same test done one box at a time.
+
+static size_t _find_visible_scalar(
+        const AM::Frustum& frustum,
+        const std::vector<BoundingBox>& boxes,
+        const Vector3& origin,
+        float max_distance,
+        std::vector<uint32_t>* visible_out
+){
+    visible_out->clear();
+    for(size_t i = 0; i < boxes.size(); i++) {
+        const BoundingBox& box = boxes[i];
+        const float dx = fmaxf(fmaxf(box.min.x - origin.x, origin.x - box.max.x), 0.0f);
+        const float dy = fmaxf(fmaxf(box.min.y - origin.y, origin.y - box.max.y), 0.0f);
+        const float dz = fmaxf(fmaxf(box.min.z - origin.z, origin.z - box.max.z), 0.0f);
+        bool inside = (dx*dx + dy*dy + dz*dz) <= max_distance * max_distance;
+        for(int p = 0; (p < 6) && inside; p++) {
+            const float px = (frustum.a[p] >= 0.0f) ? box.max.x : box.min.x;
+            const float py = (frustum.b[p] >= 0.0f) ? box.max.y : box.min.y;
+            const float pz = (frustum.c[p] >= 0.0f) ? box.max.z : box.min.z;
+            inside = (frustum.a[p] * px + frustum.b[p] * py + frustum.c[p] * pz + frustum.d[p]) >= 0.0f;
+        }
+        if(inside) {
+            visible_out->push_back((uint32_t)i);
+        }
+    }
+    return visible_out->size();
+}
+
+static void _run(int grid_size, float max_distance) {
+    const float chunk_world_size = 64.0f;
+    AM::Bench::Random random;
+
+    std::vector<BoundingBox> boxes;
+    for(int z = 0; z < grid_size; z++) {
+        for(int x = 0; x < grid_size; x++) {
+            const float wx = (x - grid_size / 2) * chunk_world_size;
+            const float wz = (z - grid_size / 2) * chunk_world_size;
+            const float min_y = random.uniform(-20.0f, 0.0f);
+            const float max_y = random.uniform(5.0f, 40.0f);
+            boxes.push_back({ { wx, min_y, wz }, { wx + chunk_world_size, max_y, wz + chunk_world_size } });
+        }
+    }
+
+    // Same camera setup as the client: 60 degree fov looking forward and slightly down.
+    const Matrix view = MatrixLookAt({ 10.0f, 20.0f, 10.0f }, { 40.0f, 10.0f, -60.0f }, { 0.0f, 1.0f, 0.0f });
+    const Matrix projection = MatrixPerspective(60.0f * DEG2RAD, 16.0 / 9.0, 0.1, 5000.0);
+    const AM::Frustum frustum = AM::Culling::extract_frustum(MatrixMultiply(view, projection));
+    const Vector3 origin = { 10.0f, 20.0f, 10.0f };
+
+    AM::CullBounds bounds;
+    const double fill_ns = AM::Bench::time_ns([&]() {
+        bounds.clear();
+        for(const BoundingBox& box : boxes) {
+            bounds.add(box);
+        }
+    });
+
+    std::vector<uint32_t> visible;
+    size_t num_visible = 0;
+    const double simd_ns = AM::Bench::time_ns([&]() {
+        num_visible = AM::Culling::find_visible(frustum, bounds, origin, max_distance, &visible);
+    });
+
+    std::vector<uint32_t> visible_scalar;
+    size_t num_visible_scalar = 0;
+    const double scalar_ns = AM::Bench::time_ns([&]() {
+        num_visible_scalar = _find_visible_scalar(frustum, boxes, origin, max_distance, &visible_scalar);
+    });
+
+    printf("%6zu boxes, distance %5.0f | visible %5zu (scalar %5zu)"
+            " | fill %7.1f us | find_visible %7.1f us | scalar %7.1f us\n",
+            boxes.size(), max_distance, num_visible, num_visible_scalar,
+            fill_ns / 1000.0, simd_ns / 1000.0, scalar_ns / 1000.0);
+}
+
+int main() {
+    _run(32, 1000.0f);
+    _run(100, 1500.0f);
+    _run(100, 4000.0f);
+    _run(316, 4000.0f);
+    return 0;
+}
+
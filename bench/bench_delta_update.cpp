@@ -0,0 +1,221 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <fstream>
+#include <filesystem>
+#include <unordered_set>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "bench.hpp"
+#include "server/assets_server/src/server.hpp"
+#include "src/ambient3d/network/assets_downloader.hpp"
+#include "shared/include/content_chunks.hpp"
+#include "shared/include/logger.hpp"
+
+namespace fs = std::filesystem;
+
+
+// Updating a client which has the previous version of the files.
+// The new versions have a few small edits: bytes overwritten in the middle,
+// bytes inserted at 1/3 and removed at 2/3 of the file.
+// The whole files are downloaded (delta updates disabled) against only the changed content chunks.
+// Both go through the assets server and AssetsDownloader on loopback with file streaming.
+
+static constexpr int    BENCH_PORT = 34591;
+static constexpr int    NUM_FILES  = 4;
+static constexpr size_t FILE_SIZE  = 8 * 1024 * 1024;
+
+static const fs::path _bench_dir() {
+    return fs::temp_directory_path() / "ambient3d_bench_delta_update";
+}
+
+static std::string _model_name(int i) {
+    return "file_" + std::to_string(i) + ".glb";
+}
+
+static std::vector<char> _edit(std::vector<char> bytes) {
+    for(size_t i = 0; i < 1024; i++) {
+        bytes[bytes.size() / 2 + i] ^= 0x5A;
+    }
+    bytes.insert(bytes.begin() + bytes.size() / 3, 100, 7);
+    bytes.erase(bytes.begin() + bytes.size() * 2 / 3, bytes.begin() + bytes.size() * 2 / 3 + 5000);
+    return bytes;
+}
+
+static void _write_file(const fs::path& path, const std::vector<char>& bytes) {
+    fs::create_directories(path.parent_path());
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), bytes.size());
+}
+
+static AM::Config _server_config(bool delta_updates) {
+    AM::Config config;
+    config.port = BENCH_PORT;
+    config.host_dir = (_bench_dir() / "host").string();
+    config.allowed_model_file_exts = ".glb";
+    config.allowed_texture_file_exts = ".png";
+    config.watch_host_dir = false;
+    config.hash_cache_path = (_bench_dir() / "hash_cache.json").string();
+    config.hash_threads = 0;
+    config.stream_files = true;
+    config.stream_window_bytes = 1024 * 1024;
+    config.max_concurrent_streams = 4;
+    config.delta_updates = delta_updates;
+    config.compress_files = false;
+    config.compression_level = 0;
+    return config;
+}
+
+// Runs the downloader to the end. Returns seconds.
+static double _download(const fs::path& client_dir) {
+    AM::ClientConfig client_config;
+    client_config.game_asset_dir = client_dir.string() + "/";
+
+    // Progress is printed to stdout.
+    fflush(stdout);
+    const int stdout_fd = dup(1);
+    const int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, 1);
+
+    const double start = AM::Bench::now_seconds();
+    {
+        asio::io_context client_context;
+        AM::AssetsDownloader downloader(client_config, client_context, "127.0.0.1",
+                std::to_string(BENCH_PORT).c_str());
+        downloader.ask_download_permission = false;
+        downloader.update_assets();
+        downloader.close_connection(client_context);
+    }
+    const double seconds = AM::Bench::now_seconds() - start;
+
+    fflush(stdout);
+    dup2(stdout_fd, 1);
+    close(stdout_fd);
+    close(null_fd);
+    return seconds;
+}
+
+// Every client starts from the old version in 'old_client_dir'
+// Content chunks are found when the first client needs them, so the first and the next clients are timed.
+static void _update_clients(bool delta_updates, const fs::path& old_client_dir, const std::vector<std::vector<char>>& new_files) {
+    const AM::Config config = _server_config(delta_updates);
+    AM::AssetFileStorage file_storage;
+    AM::find_asset_files(config, &file_storage);
+    AM::compute_asset_file_hashes(config, &file_storage);
+    file_storage.update_sorted_files();
+
+    asio::io_context server_context;
+    AM::GameAssetsServer server(config, &file_storage, server_context);
+    std::thread server_th([&server, &server_context]() {
+        server.start(server_context);
+    });
+
+    const fs::path client_dir = _bench_dir() / "client";
+    for(int client = 0; client < 3; client++) {
+        fs::remove_all(client_dir);
+        fs::copy(old_client_dir, client_dir, fs::copy_options::recursive);
+
+        const double seconds = _download(client_dir);
+
+        bool updated = true;
+        for(int i = 0; i < NUM_FILES; i++) {
+            std::ifstream file(client_dir / "models" / _model_name(i), std::ios::binary);
+            const std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            updated = updated && (bytes == new_files[i]);
+        }
+        printf("%-14s | %-12s | %7.1f ms%s\n",
+                delta_updates ? "delta update" : "whole files",
+                (client == 0) ? "first client" : "next client",
+                seconds * 1000.0, updated ? "" : " | FAILED (files dont match)");
+    }
+
+    server_context.stop();
+    server_th.join();
+}
+
+// Bytes a client needs to download with delta updates. (manifest + missing chunks)
+static void _print_changed_bytes(const std::vector<char>& old_bytes, const std::vector<char>& new_bytes) {
+    std::vector<AM::ContentChunk> old_chunks;
+    std::vector<AM::ContentChunk> new_chunks;
+    AM::ContentChunker chunker;
+
+    const double start = AM::Bench::now_seconds();
+    chunker.update((const uint8_t*)old_bytes.data(), old_bytes.size(), &old_chunks);
+    chunker.finish(&old_chunks);
+    const double chunk_seconds = AM::Bench::now_seconds() - start;
+
+    chunker.reset();
+    chunker.update((const uint8_t*)new_bytes.data(), new_bytes.size(), &new_chunks);
+    chunker.finish(&new_chunks);
+
+    std::unordered_set<std::string> old_hashes;
+    for(const AM::ContentChunk& chunk : old_chunks) {
+        old_hashes.insert(std::string(chunk.hash.begin(), chunk.hash.end()));
+    }
+    size_t missing_bytes = 0;
+    size_t num_missing = 0;
+    for(const AM::ContentChunk& chunk : new_chunks) {
+        if(!old_hashes.count(std::string(chunk.hash.begin(), chunk.hash.end()))) {
+            missing_bytes += chunk.size;
+            num_missing++;
+        }
+    }
+    const size_t manifest_bytes = new_chunks.size() * AM::MANIFEST_ENTRY_SIZE;
+
+    printf("content chunks: %zu (avg %zu bytes), %.0f MB/s\n",
+            new_chunks.size(), new_bytes.size() / new_chunks.size(), old_bytes.size() / chunk_seconds / 1e6);
+    printf("per file: %zu chunks changed, %zu + %zu bytes (manifest) of %zu sent (%.2f%%)\n",
+            num_missing, missing_bytes, manifest_bytes, new_bytes.size(),
+            100.0 * (missing_bytes + manifest_bytes) / new_bytes.size());
+}
+
+int main() {
+    AM::set_log_level(AM::LL_ERROR);
+    fs::remove_all(_bench_dir());
+
+    // Old version is downloaded first.
+    AM::Bench::Random random;
+    std::vector<std::vector<char>> old_files(NUM_FILES);
+    std::vector<std::vector<char>> new_files(NUM_FILES);
+    for(int i = 0; i < NUM_FILES; i++) {
+        old_files[i].resize(FILE_SIZE);
+        for(char& byte : old_files[i]) {
+            byte = (char)random.next();
+        }
+        new_files[i] = _edit(old_files[i]);
+        _write_file(_bench_dir() / "host" / "models" / _model_name(i), old_files[i]);
+    }
+
+    const fs::path old_client_dir = _bench_dir() / "old_client";
+    {
+        const AM::Config config = _server_config(false);
+        AM::AssetFileStorage file_storage;
+        AM::find_asset_files(config, &file_storage);
+        AM::compute_asset_file_hashes(config, &file_storage);
+        file_storage.update_sorted_files();
+
+        asio::io_context server_context;
+        AM::GameAssetsServer server(config, &file_storage, server_context);
+        std::thread server_th([&server, &server_context]() {
+            server.start(server_context);
+        });
+        _download(old_client_dir);
+        server_context.stop();
+        server_th.join();
+    }
+
+    for(int i = 0; i < NUM_FILES; i++) {
+        _write_file(_bench_dir() / "host" / "models" / _model_name(i), new_files[i]);
+    }
+
+    printf("%i x %zu MB files\n", NUM_FILES, FILE_SIZE / (1024 * 1024));
+    _print_changed_bytes(old_files[0], new_files[0]);
+    _update_clients(false, old_client_dir, new_files);
+    _update_clients(true, old_client_dir, new_files);
+
+    fs::remove_all(_bench_dir());
+    return 0;
+}
+
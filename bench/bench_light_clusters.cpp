@@ -0,0 +1,55 @@
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+
+#include "bench.hpp"
+#include "src/ambient3d/light_clusters.hpp"
+#include "raymath.h"
+
+
+// Light cluster build time for a view over lights scattered around the camera,
+// and how many lights a fragment loops over compared to all of them.
+
+static constexpr int SCREEN_WIDTH = 1000;
+static constexpr int SCREEN_HEIGHT = 800;
+
+static void _run(int num_lights, AM::Bench::Random& random) {
+    const Matrix view = MatrixLookAt({ 0.0f, 10.0f, 0.0f }, { 0.0f, 10.0f, -1.0f }, { 0.0f, 1.0f, 0.0f });
+    const Matrix projection = MatrixPerspective(60.0f * DEG2RAD,
+            (double)SCREEN_WIDTH / SCREEN_HEIGHT, 0.01, 1000.0);
+
+    std::vector<AM::Light> lights(num_lights);
+    for(AM::Light& light : lights) {
+        light.pos = { random.uniform(-300.0f, 300.0f), random.uniform(0.0f, 30.0f), random.uniform(-300.0f, 300.0f) };
+        light.color = WHITE;
+        light.cutoff = 2.0f;
+        light.strength = random.uniform(2.0f, 15.0f);
+    }
+
+    AM::LightClusters clusters;
+    const double build_ns = AM::Bench::time_ns([&]() {
+        clusters.build(view, projection, SCREEN_WIDTH, SCREEN_HEIGHT, lights.data(), lights.size());
+        AM::Bench::keep(clusters.cluster_data.data());
+    });
+
+    size_t total_refs = 0;
+    uint32_t max_count = 0;
+    for(int i = 0; i < AM::NUM_LIGHT_CLUSTERS; i++) {
+        const uint32_t count = clusters.cluster_data[i * 2 + 1];
+        total_refs += count;
+        max_count = std::max(max_count, count);
+    }
+
+    printf("%5i lights | build %7.3f ms | %5.1f lights per cluster (max %u, dropped %zu)\n",
+            num_lights, build_ns / 1e6, (double)total_refs / AM::NUM_LIGHT_CLUSTERS,
+            max_count, clusters.num_dropped);
+}
+
+int main() {
+    AM::Bench::Random random;
+    printf("%i clusters, %ix%i screen\n", AM::NUM_LIGHT_CLUSTERS, SCREEN_WIDTH, SCREEN_HEIGHT);
+    for(int num_lights : { 64, 1000, 4096 }) {
+        _run(num_lights, random);
+    }
+    return 0;
+}
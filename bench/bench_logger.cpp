@@ -0,0 +1,144 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <filesystem>
+#include <unistd.h>
+
+#include "bench.hpp"
+#include "shared/include/logger.hpp"
+
+namespace fs = std::filesystem;
+
+
+// Time spent in the calling thread per log call: the logger against fprintf
+// to a fully buffered file and fprintf + fflush (what a line buffered terminal does).
+// stdout goes to a file while measuring, results are written to the original stdout.
+//
+// Calls are made in bursts which fit the thread buffer, the logger thread
+// writes them out between the bursts. Only the calls are timed.
+
+static constexpr int BURST_SIZE         = 500;
+static constexpr int NUM_BURSTS         = 200;
+static constexpr int NUM_THREADS        = 4;
+static constexpr int NUM_THREAD_BURSTS  = 50;
+static constexpr int THREAD_TICK_MS     = 20; // Threads log one burst per tick.
+
+struct ChunkUpdate {
+    int         id;
+    float       x;
+    float       z;
+    std::string name;
+};
+
+static std::vector<ChunkUpdate> _make_updates() {
+    AM::Bench::Random random;
+    std::vector<ChunkUpdate> updates(BURST_SIZE);
+    for(ChunkUpdate& update : updates) {
+        update.id = random.range(0, 100000);
+        update.x = random.uniform(-5000.0f, 5000.0f);
+        update.z = random.uniform(-5000.0f, 5000.0f);
+        update.name = "chunk_" + std::to_string(update.id % 97);
+    }
+    return updates;
+}
+
+// Returns nanoseconds per call. 'after_burst' runs outside of the timing.
+template<typename LOG_FUNC, typename AFTER_FUNC>
+static double _time_bursts(const std::vector<ChunkUpdate>& updates, int num_bursts, LOG_FUNC log, AFTER_FUNC after_burst) {
+    double seconds = 0.0;
+    for(int burst = 0; burst < num_bursts; burst++) {
+        const double start = AM::Bench::now_seconds();
+        for(const ChunkUpdate& update : updates) {
+            log(update);
+        }
+        seconds += AM::Bench::now_seconds() - start;
+        after_burst();
+    }
+    return (seconds * 1e9) / (double)(num_bursts * updates.size());
+}
+
+static void _log_update(const ChunkUpdate& update) {
+    AM::log_info("[CHUNK]: Chunk %i updated at (%0.1f, %0.1f), %s\n", update.id, update.x, update.z, update.name);
+}
+
+static void _printf_update(FILE* file, const ChunkUpdate& update) {
+    fprintf(file, "[CHUNK]: Chunk %i updated at (%0.1f, %0.1f), %s\n", update.id, update.x, update.z, update.name.c_str());
+}
+
+static void _sleep_tick() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(THREAD_TICK_MS));
+}
+
+// Average of the threads' nanoseconds per call.
+template<typename THREAD_FUNC>
+static double _run_threads(THREAD_FUNC func) {
+    std::vector<double> results(NUM_THREADS);
+    std::vector<std::thread> threads;
+    for(int i = 0; i < NUM_THREADS; i++) {
+        threads.emplace_back([&results, &func, i]() { results[i] = func(); });
+    }
+    double sum = 0.0;
+    for(int i = 0; i < NUM_THREADS; i++) {
+        threads[i].join();
+        sum += results[i];
+    }
+    return sum / NUM_THREADS;
+}
+
+int main() {
+    const std::vector<ChunkUpdate> updates = _make_updates();
+
+    FILE* report = fdopen(dup(STDOUT_FILENO), "w");
+    const fs::path out_path = fs::temp_directory_path() / "ambient3d_bench_logger.txt";
+    if(!report || !freopen(out_path.c_str(), "w", stdout)) {
+        fprintf(stderr, "ERROR! Failed to redirect stdout to %s\n", out_path.c_str());
+        return 1;
+    }
+    FILE* file = fopen((out_path.string() + ".printf").c_str(), "w");
+    if(!file) {
+        fprintf(stderr, "ERROR! Failed to open a file for fprintf\n");
+        return 1;
+    }
+
+    AM::log_flush(); // Starts the logger thread.
+
+    // One thread.
+    const double logger_ns = _time_bursts(updates, NUM_BURSTS, _log_update, AM::log_flush);
+    const double printf_ns = _time_bursts(updates, NUM_BURSTS, [file](const ChunkUpdate& u) { _printf_update(file, u); }, []{});
+    const double printf_flush_ns = _time_bursts(updates, NUM_BURSTS, [file](const ChunkUpdate& u) {
+        _printf_update(file, u);
+        fflush(file);
+    }, []{});
+
+    // Threads at the same time. The logger thread is not waited for,
+    // a thread sleeps between its bursts like a server tick would.
+    const uint64_t dropped_before = AM::log_num_dropped();
+    const double logger_threads_ns = _run_threads([&updates]() {
+        return _time_bursts(updates, NUM_THREAD_BURSTS, _log_update, _sleep_tick);
+    });
+    AM::log_flush();
+    const uint64_t num_dropped = AM::log_num_dropped() - dropped_before;
+
+    const double printf_threads_ns = _run_threads([&updates, file]() {
+        return _time_bursts(updates, NUM_THREAD_BURSTS, [file](const ChunkUpdate& u) {
+            _printf_update(file, u);
+            fflush(file);
+        }, _sleep_tick);
+    });
+
+    fclose(file);
+    fs::remove(out_path.string() + ".printf");
+    fs::remove(out_path);
+
+    fprintf(report, "Message has an int, 2 floats and a std::string. %i threads log %i messages every %i ms\n",
+            NUM_THREADS, BURST_SIZE, THREAD_TICK_MS);
+    fprintf(report, "1 thread   logger             %6.1f ns/call\n", logger_ns);
+    fprintf(report, "1 thread   fprintf            %6.1f ns/call\n", printf_ns);
+    fprintf(report, "1 thread   fprintf + fflush   %6.1f ns/call\n", printf_flush_ns);
+    fprintf(report, "%i threads  logger             %6.1f ns/call (%lu dropped)\n", NUM_THREADS, logger_threads_ns, num_dropped);
+    fprintf(report, "%i threads  fprintf + fflush   %6.1f ns/call\n", NUM_THREADS, printf_threads_ns);
+    fclose(report);
+    return 0;
+}
+
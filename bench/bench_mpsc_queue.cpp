@@ -0,0 +1,273 @@
+#include <cstdio>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+
+#include "bench.hpp"
+#include "src/ambient3d/mpsc_queue.hpp"
+#include "src/ambient3d/item_manager.hpp"
+
+
+// MPSCQueue against a mutex and a std::deque (what the network code used before):
+//  - push + pop on one thread
+//  - latency and throughput with producer threads and a polling reader
+//  - the overflow list keeps every message and the order of each producer
+//  - ITEM_UPDATE packets every server tick, read every client tick:
+//    how many item updates the old and the new queue size drop
+
+static constexpr int    MESSAGES_PER_PRODUCER = 200000;
+static constexpr size_t THREADED_QUEUE_SIZE   = 1024;
+
+static constexpr double SERVER_TICK_MS  = 50.0;
+static constexpr double CLIENT_TICK_MS  = 75.0;
+static constexpr size_t OLD_ITEM_QUEUE_SIZE = 256;
+
+struct Message {
+    double   push_time;
+    uint32_t producer;
+    uint32_t index;
+};
+
+class MutexQueue {
+    public:
+        bool push(const Message& message) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_items.push_back(message);
+            return true;
+        }
+        bool pop(Message* out) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(m_items.empty()) {
+                return false;
+            }
+            *out = m_items.front();
+            m_items.pop_front();
+            return true;
+        }
+    private:
+        std::mutex          m_mutex;
+        std::deque<Message> m_items;
+};
+
+class LockFreeQueue {
+    public:
+        bool push(const Message& message) {
+            return m_queue.push(message);
+        }
+        bool pop(Message* out) {
+            const Message* message = m_queue.front();
+            if(!message) {
+                return false;
+            }
+            *out = *message;
+            m_queue.pop();
+            return true;
+        }
+    private:
+        AM::MPSCQueue<Message, THREADED_QUEUE_SIZE> m_queue;
+};
+
+// Bounded queue first, the overflow list while it has something. Nothing is dropped.
+class OverflowQueue {
+    public:
+        bool push(const Message& message) {
+            if(m_overflow.has_items() || !m_queue.push(message)) {
+                m_overflow.push(message);
+                m_num_overflowed.fetch_add(1, std::memory_order_relaxed);
+            }
+            return true;
+        }
+        // Same order as Terrain::update_chunkdata_queue, one message at a time.
+        bool pop(Message* out) {
+            if(m_read_index < m_read.size()) {
+                *out = m_read[m_read_index++];
+                return true;
+            }
+            if(!m_reading_queue) {
+                m_overflowed = m_overflow.has_items();
+                m_reading_queue = true;
+            }
+            if(const Message* message = m_queue.front()) {
+                *out = *message;
+                m_queue.pop();
+                return true;
+            }
+            m_reading_queue = false;
+            if(m_overflowed && m_overflow.take(&m_read)) {
+                m_read_index = 0;
+                *out = m_read[m_read_index++];
+                return true;
+            }
+            return false;
+        }
+        size_t num_overflowed() const { return m_num_overflowed.load(); }
+    private:
+        AM::MPSCQueue<Message, 64> m_queue; // Small so the overflow list is used a lot.
+        AM::OverflowList<Message>  m_overflow;
+        std::vector<Message>       m_read;
+        size_t                     m_read_index { 0 };
+        bool                       m_reading_queue { false };
+        bool                       m_overflowed { false };
+        std::atomic<size_t>        m_num_overflowed { 0 };
+};
+
+struct ThreadedResult {
+    size_t num_overflowed;
+    double messages_per_second;
+    double p50_us;
+    double p99_us;
+    double max_us;
+    bool   in_order; // Every message once and in the order of its producer.
+};
+
+// Producers push as fast as they can (yield when the queue is full),
+// the reader polls and yields when it is empty.
+template<typename QUEUE_T>
+static ThreadedResult _run_threaded(int num_producers) {
+    QUEUE_T queue;
+    std::atomic<bool> start { false };
+    std::vector<std::thread> producers;
+    for(int p = 0; p < num_producers; p++) {
+        producers.emplace_back([&queue, &start, p]() {
+            while(!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for(uint32_t i = 0; i < (uint32_t)MESSAGES_PER_PRODUCER; i++) {
+                while(!queue.push(Message{ AM::Bench::now_seconds(), (uint32_t)p, i })) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    const size_t total = (size_t)num_producers * MESSAGES_PER_PRODUCER;
+    std::vector<double> latencies;
+    latencies.reserve(total);
+    std::vector<uint32_t> next_index(num_producers, 0);
+    bool in_order = true;
+
+    const double start_time = AM::Bench::now_seconds();
+    start.store(true, std::memory_order_release);
+    Message message;
+    while(latencies.size() < total) {
+        if(!queue.pop(&message)) {
+            std::this_thread::yield();
+            continue;
+        }
+        latencies.push_back(AM::Bench::now_seconds() - message.push_time);
+        in_order = in_order && (message.index == next_index[message.producer]++);
+    }
+    const double elapsed = AM::Bench::now_seconds() - start_time;
+    for(std::thread& producer : producers) {
+        producer.join();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    size_t num_overflowed = 0;
+    if constexpr(std::is_same_v<QUEUE_T, OverflowQueue>) {
+        num_overflowed = queue.num_overflowed();
+    }
+    return ThreadedResult {
+        .num_overflowed = num_overflowed,
+        .messages_per_second = total / elapsed,
+        .p50_us = latencies[total / 2] * 1e6,
+        .p99_us = latencies[(total * 99) / 100] * 1e6,
+        .max_us = latencies.back() * 1e6,
+        .in_order = in_order
+    };
+}
+
+// Server sends a full ITEM_UPDATE packet every tick, the client reads the queue every
+// client tick. Runs one minute for every phase between the ticks (1 ms steps).
+// Returns the dropped item updates per minute, worst phase.
+template<size_t QUEUE_SIZE>
+static size_t _simulate_item_updates() {
+    size_t worst = 0;
+    for(int phase_ms = 0; phase_ms < (int)CLIENT_TICK_MS; phase_ms++) {
+        AM::MPSCQueue<int, QUEUE_SIZE> queue;
+        size_t num_dropped = 0;
+        double next_packet = 0.0;
+        double next_read = phase_ms;
+        while((next_packet < 60000.0) || (next_read < 60000.0)) {
+            if(next_packet <= next_read) {
+                for(size_t i = 0; i < AM::ITEM_UPDATE_MAX_ITEMS; i++) {
+                    num_dropped += !queue.push((int)i);
+                }
+                next_packet += SERVER_TICK_MS;
+            }
+            else {
+                queue.clear();
+                next_read += CLIENT_TICK_MS;
+            }
+        }
+        worst = std::max(worst, num_dropped);
+    }
+    return worst;
+}
+
+int main() {
+    // One thread.
+    AM::MPSCQueue<int, 1024> mpsc;
+    std::mutex mutex;
+    std::deque<int> deque;
+    int value = 0;
+    const double mpsc_ns = AM::Bench::time_ns([&]() {
+        for(int i = 0; i < 1000; i++) {
+            mpsc.push(i);
+            value += *mpsc.front();
+            mpsc.pop();
+        }
+    }) / 1000.0;
+    const double mutex_ns = AM::Bench::time_ns([&]() {
+        for(int i = 0; i < 1000; i++) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                deque.push_back(i);
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            value += deque.front();
+            deque.pop_front();
+        }
+    }) / 1000.0;
+    AM::Bench::keep(value);
+    printf("push + pop, 1 thread       MPSC %5.1f ns, mutex + deque %5.1f ns\n", mpsc_ns, mutex_ns);
+
+    bool all_in_order = true;
+    for(int num_producers : { 1, 2, 4 }) {
+        const ThreadedResult lock_free = _run_threaded<LockFreeQueue>(num_producers);
+        const ThreadedResult locked = _run_threaded<MutexQueue>(num_producers);
+        printf("%i producers  MPSC           %9.0f msg/s, latency p50 %8.1f us, p99 %8.1f us, max %8.1f us\n",
+                num_producers, lock_free.messages_per_second, lock_free.p50_us, lock_free.p99_us, lock_free.max_us);
+        printf("%i producers  mutex + deque  %9.0f msg/s, latency p50 %8.1f us, p99 %8.1f us, max %8.1f us\n",
+                num_producers, locked.messages_per_second, locked.p50_us, locked.p99_us, locked.max_us);
+        all_in_order = all_in_order && lock_free.in_order && locked.in_order;
+    }
+
+    const ThreadedResult overflow = _run_threaded<OverflowQueue>(4);
+    printf("4 producers  MPSC + overflow %9.0f msg/s, latency p50 %8.1f us, p99 %8.1f us, max %8.1f us (%zu overflowed)\n",
+            overflow.messages_per_second, overflow.p50_us, overflow.p99_us, overflow.max_us, overflow.num_overflowed);
+    all_in_order = all_in_order && overflow.in_order;
+
+    const size_t old_dropped = _simulate_item_updates<OLD_ITEM_QUEUE_SIZE>();
+    const size_t new_dropped = _simulate_item_updates<AM::ITEMBASE_QUEUE_SIZE>();
+    printf("ITEM_UPDATE, %zu items every %0.0f ms, read every %0.0f ms. Dropped per minute:"
+            " %zu slots %zu, %zu slots %zu (%zu KB)\n",
+            AM::ITEM_UPDATE_MAX_ITEMS, SERVER_TICK_MS, CLIENT_TICK_MS,
+            OLD_ITEM_QUEUE_SIZE, old_dropped, AM::ITEMBASE_QUEUE_SIZE, new_dropped,
+            (AM::ITEMBASE_QUEUE_SIZE * sizeof(AM::ItemBase)) / 1024);
+
+    if(!all_in_order) {
+        printf("ERROR! Messages were lost or out of order\n");
+        return 1;
+    }
+    if(new_dropped > 0) {
+        printf("ERROR! ITEMBASE_QUEUE_SIZE drops item updates\n");
+        return 1;
+    }
+    return 0;
+}
+
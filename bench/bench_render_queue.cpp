@@ -0,0 +1,161 @@
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+
+#include "bench.hpp"
+#include "src/ambient3d/render_queue.hpp"
+#include "raymath.h"
+
+
+// CPU side of the render queue: key encoding, submit and sort of one frame of packets.
+// The radix sort is compared to std::sort of the same keys, and the number of
+// shader, material and mesh changes is counted in submit order and sorted order.
+
+static constexpr int NUM_PACKETS   = 100000;
+static constexpr int NUM_SHADERS   = 8;
+static constexpr int NUM_MATERIALS = 64;
+static constexpr int NUM_MESHES    = 512;
+
+struct StateChanges {
+    size_t shaders;
+    size_t materials;
+    size_t meshes;
+};
+
+template<typename GET_PACKET>
+static StateChanges _count_state_changes(size_t count, GET_PACKET get_packet) {
+    StateChanges changes {};
+    unsigned int    prev_shader = 0;
+    const Material* prev_material = NULL;
+    const Mesh*     prev_mesh = NULL;
+    for(size_t i = 0; i < count; i++) {
+        const AM::RenderPacket& packet = get_packet(i);
+        if((i == 0) || (prev_shader != packet.material->shader.id)) {
+            changes.shaders++;
+        }
+        if(prev_material != packet.material) {
+            changes.materials++;
+        }
+        if(prev_mesh != packet.mesh) {
+            changes.meshes++;
+        }
+        prev_shader = packet.material->shader.id;
+        prev_material = packet.material;
+        prev_mesh = packet.mesh;
+    }
+    return changes;
+}
+
+int main() {
+    AM::Bench::Random random;
+
+    std::vector<Mesh> meshes(NUM_MESHES);
+    for(int i = 0; i < NUM_MESHES; i++) {
+        meshes[i] = Mesh{};
+        meshes[i].vaoId = 1 + i;
+    }
+    std::vector<Material> materials(NUM_MATERIALS);
+    for(int i = 0; i < NUM_MATERIALS; i++) {
+        materials[i] = Material{};
+        materials[i].shader.id = 3 + (i % NUM_SHADERS);
+    }
+
+    // Packets in random order, one in ten is transparent.
+    struct Input {
+        AM::RenderPass  pass;
+        const Mesh*     mesh;
+        const Material* material;
+        Matrix          transform;
+    };
+    std::vector<Input> inputs(NUM_PACKETS);
+    for(Input& input : inputs) {
+        input.pass = (random.next() % 10 == 0) ? AM::RP_TRANSPARENT : AM::RP_OPAQUE;
+        input.mesh = &meshes[random.next() % NUM_MESHES];
+        input.material = &materials[random.next() % NUM_MATERIALS];
+        input.transform = MatrixTranslate(
+                random.uniform(-2000.0f, 2000.0f), random.uniform(-20.0f, 100.0f), random.uniform(-2000.0f, 2000.0f));
+    }
+    inputs[0].pass = AM::RP_SKY;
+    const Vector3 view_pos = { 10.0f, 20.0f, 30.0f };
+
+    // Key encoding alone.
+    std::vector<uint64_t> keys(NUM_PACKETS);
+    const double encode_ns = AM::Bench::time_ns([&]() {
+        for(size_t i = 0; i < inputs.size(); i++) {
+            const Input& input = inputs[i];
+            keys[i] = AM::make_render_key(input.pass, input.material->shader.id,
+                    (uint64_t)((uintptr_t)input.material >> 3), input.mesh->vaoId,
+                    Vector3Distance({ input.transform.m12, input.transform.m13, input.transform.m14 }, view_pos));
+        }
+        AM::Bench::keep(keys);
+    });
+
+    // Submit (key encoding + packet copy), then sort.
+    AM::RenderQueue queue;
+    auto submit_all = [&]() {
+        queue.begin(view_pos);
+        for(const Input& input : inputs) {
+            queue.submit(input.pass, input.mesh, input.material, input.transform);
+        }
+    };
+    const double submit_ns = AM::Bench::time_ns(submit_all);
+
+    double sort_seconds = 0.0;
+    int num_sorts = 0;
+    while((sort_seconds < 0.25) || (num_sorts < 5)) {
+        submit_all();
+        const double start = AM::Bench::now_seconds();
+        queue.sort();
+        sort_seconds += AM::Bench::now_seconds() - start;
+        num_sorts++;
+    }
+    const double sort_ns = (sort_seconds * 1e9) / num_sorts;
+
+    // Same keys sorted with std::sort. The index keeps equal keys in submit order like the radix sort.
+    std::vector<std::pair<uint64_t, uint32_t>> items(NUM_PACKETS);
+    double std_sort_seconds = 0.0;
+    for(int n = 0; n < num_sorts; n++) {
+        for(size_t i = 0; i < keys.size(); i++) {
+            items[i] = { keys[i], (uint32_t)i };
+        }
+        const double start = AM::Bench::now_seconds();
+        std::sort(items.begin(), items.end());
+        std_sort_seconds += AM::Bench::now_seconds() - start;
+    }
+    const double std_sort_ns = (std_sort_seconds * 1e9) / num_sorts;
+
+    // Sorted queue must follow the keys and keep submit order for equal keys.
+    bool sorted_ok = (queue.size() == (size_t)NUM_PACKETS);
+    for(size_t i = 0; sorted_ok && (i < queue.size()); i++) {
+        const AM::RenderPacket* packet = &queue.sorted(i);
+        const Input& input = inputs[items[i].second];
+        sorted_ok = (packet->mesh == input.mesh) && (packet->material == input.material)
+            && (packet->pass == input.pass) && (packet->transform.m12 == input.transform.m12);
+    }
+
+    std::vector<AM::RenderPacket> unsorted_packets;
+    for(const Input& input : inputs) {
+        unsorted_packets.push_back(AM::RenderPacket{ input.mesh, input.material, NULL, NULL, input.transform, input.pass });
+    }
+    const StateChanges unsorted = _count_state_changes(unsorted_packets.size(), [&](size_t i) -> const AM::RenderPacket& {
+        return unsorted_packets[i];
+    });
+    const StateChanges sorted = _count_state_changes(queue.size(), [&](size_t i) -> const AM::RenderPacket& {
+        return queue.sorted(i);
+    });
+
+    printf("%i packets, %i shaders, %i materials, %i meshes\n", NUM_PACKETS, NUM_SHADERS, NUM_MATERIALS, NUM_MESHES);
+    printf("key encoding     %8.3f ms (%5.1f ns per key)\n", encode_ns / 1e6, encode_ns / NUM_PACKETS);
+    printf("submit           %8.3f ms (%5.1f ns per packet)\n", submit_ns / 1e6, submit_ns / NUM_PACKETS);
+    printf("radix sort       %8.3f ms\n", sort_ns / 1e6);
+    printf("std::sort        %8.3f ms\n", std_sort_ns / 1e6);
+    printf("state changes    shader %6zu -> %zu, material %6zu -> %zu, mesh %6zu -> %zu\n",
+            unsorted.shaders, sorted.shaders, unsorted.materials, sorted.materials,
+            unsorted.meshes, sorted.meshes);
+    if(!sorted_ok) {
+        printf("ERROR! Sorted order is different than std::sort of the keys\n");
+        return 1;
+    }
+    return 0;
+}
+
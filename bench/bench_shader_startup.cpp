@@ -0,0 +1,245 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "bench.hpp"
+#include "src/ambient3d/glsl_preproc.hpp"
+#include "src/ambient3d/internal_shaders.hpp"
+#include "src/ambient3d/shader_cache.hpp"
+
+#define GRAPHICS_API_OPENGL_43
+#define RLGL_IMPLEMENTATION
+#include "rlgl.h"
+
+namespace fs = std::filesystem;
+
+
+// Loading the shaders of the State constructor:
+//  - preprocessing the 18 sources with GLSL_preproc
+//  - compiling them like before the shader cache (LoadShaderFromMemory)
+//  - load_shader_cached with an empty cache (compiled and saved) and with a warm cache
+//
+// The GL context is a surfaceless EGL context (Mesa), so no window is needed.
+
+// raylib's rcore needs a window, these are the parts shader_cache.cpp uses.
+double GetTime() {
+    return AM::Bench::now_seconds();
+}
+
+Shader LoadShaderFromMemory(const char* vs_code, const char* fs_code) {
+    static constexpr std::pair<int, const char*> ATTRIBS[] = {
+        { SHADER_LOC_VERTEX_POSITION,    "vertexPosition" },
+        { SHADER_LOC_VERTEX_TEXCOORD01,  "vertexTexCoord" },
+        { SHADER_LOC_VERTEX_TEXCOORD02,  "vertexTexCoord2" },
+        { SHADER_LOC_VERTEX_NORMAL,      "vertexNormal" },
+        { SHADER_LOC_VERTEX_TANGENT,     "vertexTangent" },
+        { SHADER_LOC_VERTEX_COLOR,       "vertexColor" },
+        { SHADER_LOC_VERTEX_BONEIDS,     "vertexBoneIds" },
+        { SHADER_LOC_VERTEX_BONEWEIGHTS, "vertexBoneWeights" },
+        { SHADER_LOC_VERTEX_INSTANCE_TX, "instanceTransform" }
+    };
+    static constexpr std::pair<int, const char*> UNIFORMS[] = {
+        { SHADER_LOC_MATRIX_MVP,        "mvp" },
+        { SHADER_LOC_MATRIX_VIEW,       "matView" },
+        { SHADER_LOC_MATRIX_PROJECTION, "matProjection" },
+        { SHADER_LOC_MATRIX_MODEL,      "matModel" },
+        { SHADER_LOC_MATRIX_NORMAL,     "matNormal" },
+        { SHADER_LOC_BONE_MATRICES,     "boneMatrices" },
+        { SHADER_LOC_COLOR_DIFFUSE,     "colDiffuse" },
+        { SHADER_LOC_MAP_DIFFUSE,       "texture0" },
+        { SHADER_LOC_MAP_SPECULAR,      "texture1" },
+        { SHADER_LOC_MAP_NORMAL,        "texture2" }
+    };
+
+    Shader shader = { 0 };
+    shader.id = rlLoadShaderCode(vs_code, fs_code);
+    if(shader.id == rlGetShaderIdDefault()) {
+        shader.locs = rlGetShaderLocsDefault();
+        return shader;
+    }
+    shader.locs = (int*)RL_CALLOC(RL_MAX_SHADER_LOCATIONS, sizeof(int));
+    for(int i = 0; i < RL_MAX_SHADER_LOCATIONS; i++) {
+        shader.locs[i] = -1;
+    }
+    for(const auto& attrib : ATTRIBS) {
+        shader.locs[attrib.first] = rlGetLocationAttrib(shader.id, attrib.second);
+    }
+    for(const auto& uniform : UNIFORMS) {
+        shader.locs[uniform.first] = rlGetLocationUniform(shader.id, uniform.second);
+    }
+    return shader;
+}
+
+
+struct ShaderLoad {
+    AM::ShaderCode::GLSL_CodeID vertex;
+    AM::ShaderCode::GLSL_CodeID fragment;
+    int flags;
+};
+
+// Same as the State constructor.
+static const std::vector<ShaderLoad> STARTUP_SHADERS = {
+    { AM::ShaderCode::DEFAULT_VERTEX, AM::ShaderCode::DEFAULT_FRAGMENT, 0 },
+    { AM::ShaderCode::DEFAULT_VERTEX, AM::ShaderCode::DEFAULT_FRAGMENT, AM::PREPROC_FLAGS::DEFINE__RENDER_INSTANCED },
+    { AM::ShaderCode::DEFAULT_VERTEX, AM::ShaderCode::DEFAULT_FRAGMENT, AM::PREPROC_FLAGS::DEFINE__RENDER_SKINNED },
+    { AM::ShaderCode::DEFAULT_VERTEX, AM::ShaderCode::POSTPROCESS_FRAGMENT, 0 },
+    { AM::ShaderCode::DEFAULT_VERTEX, AM::ShaderCode::BLOOM_TRESH_FRAGMENT, 0 },
+    { AM::ShaderCode::DEFAULT_VERTEX, AM::ShaderCode::BLOOM_DOWNSAMPLE_FRAGMENT, 0 },
+    { AM::ShaderCode::DEFAULT_VERTEX, AM::ShaderCode::BLOOM_UPSAMPLE_FRAGMENT, 0 },
+    { AM::ShaderCode::DEFAULT_VERTEX, AM::ShaderCode::SKYBOX_FRAGMENT, 0 },
+    { AM::ShaderCode::DEFAULT_VERTEX, AM::ShaderCode::SINGLECOLOR_FRAGMENT, 0 }
+};
+
+static bool _create_context() {
+    auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if(!get_platform_display) {
+        return false;
+    }
+    EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    EGLint major = 0;
+    EGLint minor = 0;
+    if((display == EGL_NO_DISPLAY) || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API)) {
+        return false;
+    }
+    const EGLint attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attribs);
+    if((context == EGL_NO_CONTEXT) || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        return false;
+    }
+    rlLoadExtensions((void*)eglGetProcAddress);
+    rlglInit(1, 1);
+    return true;
+}
+
+static void _unload(std::vector<Shader>* shaders) {
+    for(Shader& shader : *shaders) {
+        if(shader.id != rlGetShaderIdDefault()) {
+            rlUnloadShaderProgram(shader.id);
+            RL_FREE(shader.locs);
+        }
+    }
+    shaders->clear();
+}
+
+// Returns milliseconds. Shaders which failed to compile are counted to 'num_failed'
+template<typename LOAD_FUNC>
+static double _load_all(LOAD_FUNC load, int* num_failed) {
+    std::vector<Shader> shaders;
+    const double start = AM::Bench::now_seconds();
+    for(const ShaderLoad& info : STARTUP_SHADERS) {
+        shaders.push_back(load(AM::ShaderCode::get(info.vertex), AM::ShaderCode::get(info.fragment), info.flags));
+    }
+    const double ms = (AM::Bench::now_seconds() - start) * 1000.0;
+    for(const Shader& shader : shaders) {
+        *num_failed += (shader.id == 0) || (shader.id == rlGetShaderIdDefault());
+    }
+    _unload(&shaders);
+    return ms;
+}
+
+enum class LoadMode {
+    COMPILE,
+    CACHED
+};
+
+// Each load runs in its own process with its own GL context and an empty Mesa shader cache,
+// like starting the game again. Mesa's cache can't be disabled, the program binaries need it.
+static bool _run_startup(const fs::path& bench_dir, const char* name, LoadMode mode) {
+    static int run_index = 0;
+    const fs::path mesa_cache_dir = bench_dir / ("mesa_cache_" + std::to_string(run_index++));
+    fflush(stdout);
+    const pid_t pid = fork();
+    if(pid < 0) {
+        return false;
+    }
+    if(pid > 0) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        return WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+    }
+
+    setenv("MESA_SHADER_CACHE_DIR", mesa_cache_dir.c_str(), 1);
+    if(!_create_context()) {
+        printf("No surfaceless EGL context, shader loading is not measured.\n");
+        _exit(0);
+    }
+    if(run_index == 1) {
+        printf("%s | %s\n", (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+    }
+    int num_failed = 0;
+    double ms = 0.0;
+    const AM::ShaderCacheStats start_stats = AM::shader_cache_stats();
+    if(mode == LoadMode::COMPILE) {
+        ms = _load_all([](const std::string& vs, const std::string& fs, int flags) {
+            return LoadShaderFromMemory(AM::GLSL_preproc(vs, flags).c_str(), AM::GLSL_preproc(fs, flags).c_str());
+        }, &num_failed);
+    }
+    else {
+        ms = _load_all([](const std::string& vs, const std::string& fs, int flags) {
+            return AM::load_shader_cached(vs, fs, flags, flags);
+        }, &num_failed);
+    }
+    const AM::ShaderCacheStats stats = AM::shader_cache_stats();
+    printf("%zu programs, %-26s %8.1f ms, %u loaded, %u compiled (shader_cache_stats %0.1f ms)\n",
+            STARTUP_SHADERS.size(), name, ms, stats.num_loaded - start_stats.num_loaded, stats.num_compiled - start_stats.num_compiled,
+            (stats.load_time - start_stats.load_time) * 1000.0);
+    if(num_failed > 0) {
+        printf("ERROR! %i shaders failed to load\n", num_failed);
+    }
+    fflush(stdout);
+    _exit((num_failed > 0) ? 1 : 0);
+}
+
+int main() {
+    AM::GLSL_preproc_add_meminclude("GLSL_VERSION", AM::ShaderCode::get(AM::ShaderCode::GLSL_VERSION));
+    AM::GLSL_preproc_add_meminclude("AMBIENT3D_FRAME", AM::ShaderCode::get(AM::ShaderCode::FRAME_GLSL));
+    AM::GLSL_preproc_add_meminclude("AMBIENT3D_LIGHTS", AM::ShaderCode::get(AM::ShaderCode::LIGHTS_GLSL));
+    AM::GLSL_preproc_add_meminclude("AMBIENT3D_FOG", AM::ShaderCode::get(AM::ShaderCode::FOG_GLSL));
+
+    std::vector<std::string> sources;
+    std::vector<int> source_flags;
+    for(const ShaderLoad& info : STARTUP_SHADERS) {
+        sources.push_back(AM::ShaderCode::get(info.vertex));
+        sources.push_back(AM::ShaderCode::get(info.fragment));
+        source_flags.push_back(info.flags);
+        source_flags.push_back(info.flags);
+    }
+    auto preproc_all = [&]() {
+        for(size_t i = 0; i < sources.size(); i++) {
+            AM::Bench::keep(AM::GLSL_preproc(sources[i], source_flags[i]));
+        }
+    };
+    const double first_start = AM::Bench::now_seconds();
+    preproc_all();
+    const double first_us = (AM::Bench::now_seconds() - first_start) * 1e6;
+    const double preproc_ns = AM::Bench::time_ns(preproc_all);
+    printf("GLSL_preproc, %zu sources: %0.1f us first time, %0.1f us after\n",
+            sources.size(), first_us, preproc_ns / 1000.0);
+
+    // The cache directory is relative to the working directory.
+    const fs::path bench_dir = fs::temp_directory_path() / "ambient3d_bench_shader_startup";
+    fs::remove_all(bench_dir);
+    fs::create_directories(bench_dir);
+    const fs::path prev_dir = fs::current_path();
+    fs::current_path(bench_dir);
+
+    const bool ok = _run_startup(bench_dir, "before the cache (compile)", LoadMode::COMPILE)
+                 && _run_startup(bench_dir, "empty cache", LoadMode::CACHED)
+                 && _run_startup(bench_dir, "warm cache", LoadMode::CACHED);
+
+    fs::current_path(prev_dir);
+    fs::remove_all(bench_dir);
+    return ok ? 0 : 1;
+}
+
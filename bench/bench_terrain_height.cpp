@@ -0,0 +1,151 @@
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+#include "bench.hpp"
+#include "shared/include/terrain_height.hpp"
+#include "shared/include/chunk_map.hpp"
+#include "shared/include/ray.hpp"
+
+
+// Surface height queries: the old ray cast against the cell rectangle
+// (four chunk lookups for the corner vertices, like get_chunk_vertex did)
+// against TerrainHeight::sample with one lookup, and the batched version
+// which keeps the previous chunk like Terrain::get_surface_levels.
+
+static constexpr int   CHUNK_SIZE = 16;
+static constexpr float CHUNK_SCALE = 4.0f;
+static constexpr int   WORLD_RADIUS = 16;
+
+using World = AM::ChunkMap<std::vector<float>>;
+
+static World _create_world() {
+    const int row = CHUNK_SIZE+1;
+    World world;
+    for(int cz = -WORLD_RADIUS; cz <= WORLD_RADIUS; cz++) {
+        for(int cx = -WORLD_RADIUS; cx <= WORLD_RADIUS; cx++) {
+            std::vector<float> heights(row * row);
+            for(int z = 0; z < row; z++) {
+                for(int x = 0; x < row; x++) {
+                    const float gx = (float)(cx * CHUNK_SIZE + x);
+                    const float gz = (float)(cz * CHUNK_SIZE + z);
+                    heights[z * row + x] = sinf(gx * 0.11f) * 8.0f + cosf(gz * 0.07f) * 5.0f;
+                }
+            }
+            world[AM::ChunkPos(cx, cz)] = heights;
+        }
+    }
+    return world;
+}
+
+static AM::Vec3 _chunk_vertex(const World& world, int grid_x, int grid_z) {
+    const int chunk_x = (int)floorf((float)grid_x / CHUNK_SIZE);
+    const int chunk_z = (int)floorf((float)grid_z / CHUNK_SIZE);
+    auto search = world.find(AM::ChunkPos(chunk_x, chunk_z));
+    if(search == world.end()) {
+        return AM::Vec3();
+    }
+    const int local_x = grid_x - chunk_x * CHUNK_SIZE;
+    const int local_z = grid_z - chunk_z * CHUNK_SIZE;
+    return AM::Vec3(grid_x * CHUNK_SCALE, search->second[local_z * (CHUNK_SIZE+1) + local_x], grid_z * CHUNK_SCALE);
+}
+
+static float _ray_surface_level(const World& world, float world_x, float world_z) {
+    const int gx = (int)floorf(world_x / CHUNK_SCALE);
+    const int gz = (int)floorf(world_z / CHUNK_SCALE);
+    const AM::Vec3 A = _chunk_vertex(world, gx,   gz);
+    const AM::Vec3 B = _chunk_vertex(world, gx+1, gz);
+    const AM::Vec3 C = _chunk_vertex(world, gx+1, gz+1);
+    const AM::Vec3 D = _chunk_vertex(world, gx,   gz+1);
+    AM::Ray ray(AM::Vec3(world_x, 100.0f, world_z), AM::Vec3(0.0f, -1.0f, 0.0f));
+    return ray.rectangle_intersection(AM::Rect(AM::Triangle(A, D, B), AM::Triangle(B, D, C))).point.y;
+}
+
+static float _sample_surface_level(const World& world, float world_x, float world_z) {
+    const AM::TerrainHeight::GridPoint point
+        = AM::TerrainHeight::world_to_grid(world_x, world_z, CHUNK_SIZE, CHUNK_SCALE);
+    auto search = world.find(point.chunk_pos);
+    if(search == world.end()) {
+        return 0.0f;
+    }
+    return AM::TerrainHeight::sample(search->second.data(), CHUNK_SIZE, point.local_x, point.local_z);
+}
+
+static void _batched_surface_levels(const World& world, const float* world_x, const float* world_z,
+        size_t count, float* levels_out) {
+    AM::ChunkPos prev_chunk_pos(0, 0);
+    const float* heights = NULL;
+    bool has_prev = false;
+    for(size_t i = 0; i < count; i++) {
+        const AM::TerrainHeight::GridPoint point
+            = AM::TerrainHeight::world_to_grid(world_x[i], world_z[i], CHUNK_SIZE, CHUNK_SCALE);
+        if(!has_prev || !(point.chunk_pos == prev_chunk_pos)) {
+            auto search = world.find(point.chunk_pos);
+            heights = (search != world.end()) ? search->second.data() : NULL;
+            prev_chunk_pos = point.chunk_pos;
+            has_prev = true;
+        }
+        levels_out[i] = heights ? AM::TerrainHeight::sample(heights, CHUNK_SIZE, point.local_x, point.local_z) : 0.0f;
+    }
+}
+
+int main() {
+    const World world = _create_world();
+    const float world_half = WORLD_RADIUS * CHUNK_SIZE * CHUNK_SCALE * 0.99f;
+
+    // Random positions and players walking in small groups (nearby queries share chunks).
+    const size_t num_queries = 100000;
+    std::vector<float> random_x(num_queries), random_z(num_queries);
+    std::vector<float> group_x(num_queries), group_z(num_queries);
+    AM::Bench::Random random;
+    for(size_t i = 0; i < num_queries; i++) {
+        random_x[i] = random.uniform(-world_half, world_half);
+        random_z[i] = random.uniform(-world_half, world_half);
+        if(i % 16 == 0) {
+            group_x[i] = random.uniform(-world_half, world_half);
+            group_z[i] = random.uniform(-world_half, world_half);
+        }
+        else {
+            group_x[i] = group_x[i-1] + random.uniform(-2.0f, 2.0f);
+            group_z[i] = group_z[i-1] + random.uniform(-2.0f, 2.0f);
+        }
+    }
+
+    std::vector<float> levels(num_queries);
+    float max_difference = 0.0f;
+    for(size_t i = 0; i < num_queries; i++) {
+        max_difference = fmaxf(max_difference,
+                fabsf(_ray_surface_level(world, random_x[i], random_z[i])
+                    - _sample_surface_level(world, random_x[i], random_z[i])));
+    }
+
+    for(int pass = 0; pass < 2; pass++) {
+        const float* xs = (pass == 0) ? random_x.data() : group_x.data();
+        const float* zs = (pass == 0) ? random_z.data() : group_z.data();
+
+        const double ray_ns = AM::Bench::time_ns([&]() {
+            for(size_t i = 0; i < num_queries; i++) {
+                levels[i] = _ray_surface_level(world, xs[i], zs[i]);
+            }
+            AM::Bench::keep(levels[0]);
+        }) / num_queries;
+
+        const double sample_ns = AM::Bench::time_ns([&]() {
+            for(size_t i = 0; i < num_queries; i++) {
+                levels[i] = _sample_surface_level(world, xs[i], zs[i]);
+            }
+            AM::Bench::keep(levels[0]);
+        }) / num_queries;
+
+        const double batched_ns = AM::Bench::time_ns([&]() {
+            _batched_surface_levels(world, xs, zs, num_queries, levels.data());
+            AM::Bench::keep(levels[0]);
+        }) / num_queries;
+
+        printf("%-18s | ray %6.1f ns | sample %6.1f ns | batched %6.1f ns (per query)\n",
+                (pass == 0) ? "random positions" : "grouped positions", ray_ns, sample_ns, batched_ns);
+    }
+    printf("max difference between ray and sample: %g\n", max_difference);
+    return 0;
+}
+
@@ -1,22 +1,67 @@
 
 #include <filesystem>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <chrono>
+#include <sys/stat.h>
+#include <unordered_set>
+#include <unordered_map>
 
 namespace fs = std::filesystem;
 
 
 #include "asset_files.hpp"
 #include "shared/include/file_sha256.hpp"
+#include "shared/include/logger.hpp"
 
 
 
+// Fills the file info if 'path' has an allowed file extension.
+static bool _make_asset_file(const AM::Config& config, const fs::path& path, AM::AssetFile* file) {
+    // TODO: It would be better to scan the file metadata for the type.
+    if(!path.has_extension()) {
+        return false;
+    }
+
+    const std::string file_ext = path.extension();
+    if(config.allowed_texture_file_exts.find(file_ext) != std::string::npos) {
+        file->type_group = "textures";
+    }
+    else
+    if(config.allowed_model_file_exts.find(file_ext) != std::string::npos) {
+        file->type_group = "models";
+    }
+    else {
+        return false;
+    }
+
+    std::error_code ec;
+    file->size = fs::file_size(path, ec);
+    file->full_path = path;
+    file->name = path.filename();
+    return !ec;
+}
+
+// Clients store the files by name so they must be unique.
+static bool _insert_asset_file(AM::AssetFileStorage* file_storage, const std::shared_ptr<AM::AssetFile>& file) {
+    const auto search = file_storage->files.find(file->name);
+    if((search != file_storage->files.end()) && (search->second->full_path != file->full_path)) {
+        AM::log_warning("WARNING! %s: '%s' has the same name as '%s'. Ignoring it.\n",
+                __func__, file->full_path.c_str(), search->second->full_path.c_str());
+        return false;
+    }
+    file_storage->files[file->name] = file;
+    return true;
+}
+
 static void scan_directories(
         const AM::Config& config,
         const std::string& path,
         AM::AssetFileStorage* file_storage) {
 
-    std::string tmp_file_ext = "";
-    tmp_file_ext.reserve(8);
-
     for(const fs::directory_entry& entry : fs::directory_iterator(path)) {
         const char* filename = entry.path().filename().c_str();
     
@@ -25,80 +70,399 @@ static void scan_directories(
             continue;
         }
             
-        printf("- %-16li %-16s ", entry.file_size(), filename);
-        fflush(stdout);
+        AM::log_info("- %-16li %-16s ", entry.file_size(), filename);
 
-        // TODO: It would be better to scan the file metadata for the type.
         if(!entry.path().has_extension()) {
-            printf(" (WARNING: No file extension!)\n");
+            AM::log_info(" (WARNING: No file extension!)\n");
             continue;
         }
 
-        tmp_file_ext.assign(entry.path().extension());
-        if(config.allowed_texture_file_exts.find(tmp_file_ext) != std::string::npos) {
-            printf(" (Texture)\n");
-            file_storage->texture_files.push_back({ 
-                    .size = entry.file_size(),
-                    .full_path = entry.path(),
-                    .name = entry.path().filename(),
-                    .type_group = "textures"
-            });
+        std::shared_ptr<AM::AssetFile> file = std::make_shared<AM::AssetFile>();
+        if(!_make_asset_file(config, entry.path(), file.get())) {
+            AM::log_info(" (Ignored)\n");
+            continue;
         }
-        else
-        if(config.allowed_model_file_exts.find(tmp_file_ext) != std::string::npos) {
-            printf(" (3D Model)\n");
-            file_storage->model_files.push_back({ 
-                            .size = entry.file_size(),
-                    .full_path = entry.path(),
-                    .name = entry.path().filename(),
-                    .type_group = "models"
-            });
+
+        AM::log_info(" (%s)\n", (file->type_group == "textures") ? "Texture" : "3D Model");
+        _insert_asset_file(file_storage, file);
+    }
+}
+
+
+void AM::find_asset_files(const AM::Config& config, AM::AssetFileStorage* file_storage) {
+
+    scan_directories(config, config.host_dir, file_storage);
+
+    AM::log_info("-------------------------------------\n");
+    AM::log_info("Found %li Texture files\n", file_storage->count("textures"));
+    AM::log_info("Found %li Model files\n", file_storage->count("models"));
+    AM::log_info("Found %li Audio files\n", file_storage->count("audio"));
+
+}
+
+
+// Modification time in nanoseconds or -1 if it cant be read.
+static int64_t _file_mtime(const std::string& path) {
+    struct stat file_stat;
+    if(stat(path.c_str(), &file_stat) != 0) {
+        return -1;
+    }
+    return (int64_t)file_stat.st_mtim.tv_sec * 1000000000LL + (int64_t)file_stat.st_mtim.tv_nsec;
+}
+
+static json _read_hash_cache(const std::string& path) {
+    std::ifstream stream(path);
+    if(!stream.is_open()) {
+        return json::object(); // No cache yet.
+    }
+    try {
+        json cache = json::parse(stream);
+        if(cache.is_object()) {
+            return cache;
+        }
+    }
+    catch(const std::exception& e) {
+        AM::log_warning("WARNING! %s: Ignoring broken hash cache '%s' (%s)\n", 
+                __func__, path.c_str(), e.what());
+    }
+    return json::object();
+}
+
+
+// Calls 'callback' for every index from 0 to 'count' with 'num_threads' threads.
+// Each thread takes the next index until they are all done.
+static void _parallel_for(size_t count, int num_threads, const std::function<void(size_t)>& callback) {
+    std::atomic<size_t> next_index { 0 };
+    auto worker = [count, &next_index, &callback]() {
+        size_t i;
+        while((i = next_index.fetch_add(1)) < count) {
+            callback(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(int i = 1; i < num_threads; i++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for(std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+static int _num_worker_threads(const AM::Config& config, size_t num_jobs) {
+    const int num_threads = (config.hash_threads > 0) 
+        ? config.hash_threads : (int)std::thread::hardware_concurrency();
+    return std::clamp(num_threads, 1, std::max((int)num_jobs, 1));
+}
+
+
+void AM::compute_asset_file_hashes(const AM::Config& config, AssetFileStorage* file_storage) {
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const json cache = _read_hash_cache(config.hash_cache_path);
+
+    // Find the files which are not in the cache or have changed.
+    std::vector<AM::AssetFile*> hash_queue;
+    size_t num_files = 0;
+    file_storage->foreach_file([&](AM::AssetFile& file) {
+        file.mtime = _file_mtime(file.full_path);
+        const auto entry = cache.find(file.full_path);
+        if((file.mtime >= 0)
+        && (entry != cache.end())
+        && (entry->value("size", (size_t)0) == file.size)
+        && (entry->value("mtime", (int64_t)-1) == file.mtime)) {
+            file.sha256_hash = entry->value("sha256", "");
+        }
+        if(file.sha256_hash.empty()) {
+            hash_queue.push_back(&file);
+        }
+        num_files++;
+    });
+
+    const size_t num_cached = num_files - hash_queue.size();
+
+    const int num_threads = _num_worker_threads(config, hash_queue.size());
+    _parallel_for(hash_queue.size(), num_threads, [&hash_queue](size_t i) {
+        AM::AssetFile* file = hash_queue[i];
+        if(!AM::compute_sha256_filehash(file->full_path, &file->sha256_hash)) {
+            file->sha256_hash.clear();
+        }
+    });
+
+    AM::save_asset_hash_cache(config, *file_storage);
+
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start_time;
+    AM::log_info("Hashed %li files (%li from cache) with %i threads in %0.2fms\n",
+            hash_queue.size(), num_cached, num_threads, elapsed.count());
+}
+
+void AM::save_asset_hash_cache(const AM::Config& config, const AssetFileStorage& file_storage) {
+    json cache = json::object();
+    for(const auto& [name, file] : file_storage.files) {
+        if((file->mtime < 0) || file->sha256_hash.empty()) {
+            continue;
+        }
+        cache[file->full_path] = {
+            { "size", file->size },
+            { "mtime", file->mtime },
+            { "sha256", file->sha256_hash }
+        };
+    }
+
+    std::ofstream cache_stream(config.hash_cache_path, std::ios::trunc);
+    if(cache_stream.is_open()) {
+        cache_stream << cache.dump(4);
+    }
+    else {
+        AM::log_warning("WARNING! %s: Failed to write hash cache '%s'\n", 
+                __func__, config.hash_cache_path.c_str());
+    }
+}
+
+// Cache files are named "<sha256>.<encoding>"
+// Empty "<sha256>.<encoding>.raw" is saved for files which didnt get smaller.
+static std::string _compression_cache_filename(const AM::Config& config, const AM::AssetFile& file) {
+    const auto encoding = config.compression_encodings.find(file.type_group);
+    if((encoding == config.compression_encodings.end()) 
+    || (encoding->second == AM::ASSET_ENCODING_NONE)
+    || file.sha256_hash.empty()) {
+        return "";
+    }
+    return file.sha256_hash +"."+ encoding->second;
+}
+
+// Returns number of files which were not found from the cache.
+static size_t _compress_files(const AM::Config& config, const std::vector<AM::AssetFile*>& all_files) {
+    std::error_code ec;
+    fs::create_directories(config.compression_cache_dir, ec);
+    if(ec) {
+        AM::log_error("ERROR! %s: Failed to create compression cache directory '%s' (%s)\n",
+                __func__, config.compression_cache_dir.c_str(), ec.message().c_str());
+        return 0;
+    }
+
+    // Files with the same content share a cache file. It is compressed once
+    // so two threads never write the same file, the other files copy the result.
+    std::vector<AM::AssetFile*> files;
+    std::vector<AM::AssetFile*> duplicates;
+    std::unordered_map<std::string, AM::AssetFile*> cache_files;
+    for(AM::AssetFile* file : all_files) {
+        const std::string cache_filename = _compression_cache_filename(config, *file);
+        if(cache_filename.empty()) {
+            continue;
+        }
+        file->encoding = config.compression_encodings.at(file->type_group);
+        file->encoded_path = config.compression_cache_dir +"/"+ cache_filename;
+        if(cache_files.emplace(file->encoded_path, file).second) {
+            files.push_back(file);
         }
         else {
-            printf(" (Ignored)\n");
+            duplicates.push_back(file);
         }
     }
+
+    std::atomic<size_t> num_compressed { 0 };
+    const int num_threads = _num_worker_threads(config, files.size());
+    _parallel_for(files.size(), num_threads, [&config, &files, &num_compressed](size_t i) {
+        AM::AssetFile* file = files[i];
+        const std::string raw_marker_path = file->encoded_path + ".raw";
+        std::error_code ec;
+
+        if(fs::exists(raw_marker_path, ec)) {
+            file->encoding = AM::ASSET_ENCODING_NONE;
+            return;
+        }
+        if(!fs::exists(file->encoded_path, ec)) {
+            if(file->encoding != AM::ASSET_ENCODING_LZ4HC) {
+                AM::log_warning("WARNING! %s: Unknown encoding \"%s\" for '%s'\n", 
+                        __func__, file->encoding.c_str(), file->name.c_str());
+                file->encoding = AM::ASSET_ENCODING_NONE;
+                return;
+            }
+            if(!AM::compress_asset_file(file->full_path, file->encoded_path, config.compression_level)) {
+                file->encoding = AM::ASSET_ENCODING_NONE;
+                return;
+            }
+            num_compressed++;
+        }
+
+        file->encoded_size = fs::file_size(file->encoded_path, ec);
+        if(ec || ((float)file->encoded_size > (float)file->size * (1.0f - AM::ASSET_COMPRESSION_MIN_SAVING))) {
+            fs::remove(file->encoded_path, ec);
+            std::ofstream(raw_marker_path).close();
+            file->encoding = AM::ASSET_ENCODING_NONE;
+        }
+    });
+
+    for(AM::AssetFile* file : duplicates) {
+        const AM::AssetFile* compressed = cache_files.at(file->encoded_path);
+        file->encoding = compressed->encoding;
+        file->encoded_size = compressed->encoded_size;
+    }
+
+    return num_compressed.load();
 }
 
+void AM::compress_asset_files(const AM::Config& config, AssetFileStorage* file_storage) {
+    if(!config.compress_files) {
+        return;
+    }
+    const auto start_time = std::chrono::steady_clock::now();
 
-void AM::find_asset_files(const AM::Config& config, AM::AssetFileStorage* file_storage) {
+    std::vector<AM::AssetFile*> files;
+    std::unordered_set<std::string> cache_filenames;
+    file_storage->foreach_file([&](AM::AssetFile& file) {
+        const std::string cache_filename = _compression_cache_filename(config, file);
+        if(!cache_filename.empty()) {
+            cache_filenames.insert(cache_filename);
+            cache_filenames.insert(cache_filename + ".raw");
+            files.push_back(&file);
+        }
+    });
 
-    scan_directories(config, config.host_dir, file_storage);
+    const size_t num_compressed = _compress_files(config, files);
+
+    // Remove files of old versions.
+    std::error_code ec;
+    for(const fs::directory_entry& entry : fs::directory_iterator(config.compression_cache_dir, ec)) {
+        if(!cache_filenames.contains(entry.path().filename())) {
+            fs::remove(entry.path(), ec);
+        }
+    }
+
+    size_t total_bytes = 0;
+    size_t total_transfer_bytes = 0;
+    file_storage->foreach_file([&](AM::AssetFile& file) {
+        total_bytes += file.size;
+        total_transfer_bytes += file.transfer_size();
+    });
 
-    printf("-------------------------------------\n");
-    printf("Found %li Texture files\n", file_storage->texture_files.size());
-    printf("Found %li Model files\n", file_storage->model_files.size());
-    printf("Found %li Audio files\n", file_storage->audio_files.size());
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start_time;
+    AM::log_info("Compressed %li files (%li from cache) in %0.2fms. Full download is %li -> %li bytes\n",
+            num_compressed, files.size() - num_compressed, elapsed.count(),
+            total_bytes, total_transfer_bytes);
+}
 
+const std::string& AM::AssetFile::transfer_path() const {
+    return (this->encoding != AM::ASSET_ENCODING_NONE) ? this->encoded_path : this->full_path;
 }
 
+size_t AM::AssetFile::transfer_size() const {
+    return (this->encoding != AM::ASSET_ENCODING_NONE) ? this->encoded_size : this->size;
+}
 
-void AM::compute_asset_file_hashes(AssetFileStorage* file_storage) {
-    file_storage->foreach_file([](AM::AssetFile& file) {
-        AM::compute_sha256_filehash(file.full_path, &file.sha256_hash);
+bool AM::AssetFile::find_content_chunks() {
+    if(this->chunks_found) {
+        return true;
+    }
+    if(!AM::split_file_content_chunks(this->full_path, &this->chunks)) {
+        return false;
+    }
+    AM::write_content_manifest(this->chunks, &this->manifest);
+    this->chunks_found = true;
+    return true;
+}
+ 
+AM::AssetFileUpdate AM::prepare_asset_file_update(const AM::Config& config,
+        const std::vector<std::string>& changed_paths) {
+    const auto start_time = std::chrono::steady_clock::now();
+    AM::AssetFileUpdate update;
+
+    for(const std::string& path : changed_paths) {
+        std::shared_ptr<AM::AssetFile> file = std::make_shared<AM::AssetFile>();
+        std::error_code ec;
+        if(fs::is_regular_file(path, ec) && _make_asset_file(config, path, file.get())) {
+            file->mtime = _file_mtime(path);
+            update.files.push_back(file);
+        }
+        else {
+            update.removed_paths.push_back(path);
+        }
+    }
+
+    const int num_threads = _num_worker_threads(config, update.files.size());
+    _parallel_for(update.files.size(), num_threads, [&update](size_t i) {
+        AM::AssetFile* file = update.files[i].get();
+        if(!AM::compute_sha256_filehash(file->full_path, &file->sha256_hash)) {
+            file->sha256_hash.clear();
+        }
     });
-    
-    /*
-    for(AM::AssetFile& file : file_storage->texture_files) {
-        AM::compute_sha256_filehash(file.full_path, &file.sha256_hash);
+
+    if(config.compress_files) {
+        std::vector<AM::AssetFile*> files;
+        for(const std::shared_ptr<AM::AssetFile>& file : update.files) {
+            files.push_back(file.get());
+        }
+        _compress_files(config, files);
     }
-    for(AM::AssetFile& file : file_storage->model_files) {
-        AM::compute_sha256_filehash(file.full_path, &file.sha256_hash);
+
+    update.prepare_time = std::chrono::steady_clock::now() - start_time;
+    return update;
+}
+
+void AM::apply_asset_file_update(const AM::Config& config, AssetFileStorage* file_storage,
+        const AssetFileUpdate& update) {
+    const auto start_time = std::chrono::steady_clock::now();
+
+    size_t num_removed = 0;
+    for(const std::string& path : update.removed_paths) {
+        const auto search = file_storage->files.find(fs::path(path).filename());
+        if((search != file_storage->files.end()) && (search->second->full_path == path)) {
+            file_storage->files.erase(search);
+            num_removed++;
+        }
     }
-    for(AM::AssetFile& file : file_storage->audio_files) {
-        AM::compute_sha256_filehash(file.full_path, &file.sha256_hash);
+
+    // Sessions which are sending the old version keep it until they are done.
+    size_t num_updated = 0;
+    for(const std::shared_ptr<AM::AssetFile>& file : update.files) {
+        if(file->sha256_hash.empty()) {
+            continue; // Removed while hashing.
+        }
+        num_updated += _insert_asset_file(file_storage, file);
     }
-    */
+
+    AM::save_asset_hash_cache(config, *file_storage);
+    file_storage->update_sorted_files();
+
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start_time;
+    AM::log_info("Updated %li files and removed %li (hashed in %0.2fms, applied in %0.2fms)\n",
+            num_updated, num_removed, update.prepare_time.count(), elapsed.count());
+}
+
+void AM::update_asset_files(const AM::Config& config, AssetFileStorage* file_storage,
+        const std::vector<std::string>& changed_paths) {
+    AM::apply_asset_file_update(config, file_storage, AM::prepare_asset_file_update(config, changed_paths));
 }
  
-void AM::AssetFileStorage::foreach_file(std::function<void(AM::AssetFile&)> callback) {
-    for(AM::AssetFile& file : this->texture_files) {
-        callback(file);
+void AM::AssetFileStorage::update_sorted_files() {
+    this->sorted_files.clear();
+    this->sorted_files.reserve(this->files.size());
+    for(const auto& [name, file] : this->files) {
+        file->name_hash = AM::asset_name_hash(file->name);
+        if(!AM::sha256_hex_to_digest(file->sha256_hash, file->digest.data())) {
+            file->digest.fill(0);
+        }
+        this->sorted_files.push_back(file);
     }
-    for(AM::AssetFile& file : this->model_files) {
-        callback(file);
+    std::sort(this->sorted_files.begin(), this->sorted_files.end(),
+            [](const std::shared_ptr<AM::AssetFile>& a, const std::shared_ptr<AM::AssetFile>& b) {
+                return a->name_hash < b->name_hash;
+            });
+}
+
+size_t AM::AssetFileStorage::count(const std::string& type_group) const {
+    size_t num_files = 0;
+    for(const auto& [name, file] : this->files) {
+        num_files += (file->type_group == type_group);
     }
-    for(AM::AssetFile& file : this->audio_files) {
-        callback(file);
+    return num_files;
+}
+
+void AM::AssetFileStorage::foreach_file(std::function<void(AM::AssetFile&)> callback) {
+    for(const auto& [name, file] : this->files) {
+        callback(*file);
     }
 }
+
@@ -4,8 +4,15 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <memory>
+#include <unordered_map>
+#include <array>
+#include <chrono>
 
 #include "config.hpp"
+#include "shared/include/content_chunks.hpp"
+#include "shared/include/asset_compression.hpp"
+#include "shared/include/asset_manifest.hpp"
 
 
 namespace AM {
@@ -16,19 +23,81 @@ namespace AM {
         std::string name;
         std::string sha256_hash;
         std::string type_group; // "textures" or "models"
+        int64_t     mtime { -1 }; // Modification time in nanoseconds. (for the hash cache)
+
+        // For comparing to client manifests. (see AssetFileStorage::update_sorted_files)
+        uint64_t    name_hash { 0 };
+        std::array<uint8_t, AM::ASSET_DIGEST_SIZE> digest {};
+
+        // Content defined chunks for delta updates.
+        // Computed when a client first needs them. (see find_content_chunks)
+        std::vector<AM::ContentChunk> chunks;
+        std::vector<char>             manifest;
+        bool                          chunks_found { false };
+
+        bool find_content_chunks();
+
+        // Compressed copy in the compression cache. (see AM::Config::compress_files)
+        std::string encoding { AM::ASSET_ENCODING_NONE };
+        std::string encoded_path;
+        size_t      encoded_size { 0 };
+
+        // What is sent to clients which download the whole file.
+        const std::string& transfer_path() const;
+        size_t             transfer_size() const;
     };
 
 
     struct AssetFileStorage {
-        std::vector<AssetFile> texture_files;
-        std::vector<AssetFile> model_files;
-        std::vector<AssetFile> audio_files;
+
+        // Files by name. They are shared with the sessions so a file 
+        // which is changed or removed can still be sent to the end. (see AM::AssetWatcher)
+        std::unordered_map<std::string, std::shared_ptr<AssetFile>> files;
+
+        // Files sorted by name hash. Clients send their files in the same order
+        // so they can be compared in one pass.
+        std::vector<std::shared_ptr<AssetFile>> sorted_files;
+
+        // Must be called after files are added, removed or hashed.
+        void update_sorted_files();
         
+        size_t count(const std::string& type_group) const;
         void foreach_file(std::function<void(AssetFile&)> callback);
     };
 
     void find_asset_files(const AM::Config& config, AssetFileStorage* file_storage);
-    void compute_asset_file_hashes(AssetFileStorage* file_storage);
+
+    // Hashes are computed with 'config.hash_threads' threads.
+    // Files with same path, size and modification time as in the hash cache are not hashed again.
+    void compute_asset_file_hashes(const AM::Config& config, AssetFileStorage* file_storage);
+
+    // Compresses the files whose type group has an encoding in 'config.compression_encodings'.
+    // Compressed files are saved by their hash so they are only compressed once.
+    // Files which dont get smaller are sent as they are.
+    void compress_asset_files(const AM::Config& config, AssetFileStorage* file_storage);
+
+    void save_asset_hash_cache(const AM::Config& config, const AssetFileStorage& file_storage);
+
+    // Changed files which are hashed and compressed but not yet in the storage.
+    struct AssetFileUpdate {
+        std::vector<std::shared_ptr<AssetFile>> files;
+        std::vector<std::string>                removed_paths; // Removed or not asset files anymore.
+        std::chrono::duration<double, std::milli> prepare_time { 0 };
+    };
+
+    // Hashes and compresses the files at 'changed_paths'.
+    // The storage is not used so this can run on another thread than the sessions.
+    AssetFileUpdate prepare_asset_file_update(const AM::Config& config,
+            const std::vector<std::string>& changed_paths);
+
+    // Adds, replaces or removes the files of 'update' in the storage.
+    void apply_asset_file_update(const AM::Config& config, AssetFileStorage* file_storage,
+            const AssetFileUpdate& update);
+
+    // Adds, replaces or removes the files at 'changed_paths'.
+    // Only the changed files are hashed and compressed.
+    void update_asset_files(const AM::Config& config, AssetFileStorage* file_storage,
+            const std::vector<std::string>& changed_paths);
 };
 
 
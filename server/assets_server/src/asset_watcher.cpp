@@ -0,0 +1,218 @@
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <filesystem>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include "asset_watcher.hpp"
+#include "shared/include/logger.hpp"
+
+namespace fs = std::filesystem;
+
+
+static constexpr uint32_t WATCH_EVENT_MASK 
+    = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_ONLYDIR;
+
+
+
+AM::AssetWatcher::AssetWatcher(
+        const AM::Config& config,
+        AM::AssetFileStorage* file_storage,
+        asio::io_context& context
+) :
+    m_config(config),
+    m_file_storage(file_storage),
+    m_context(context),
+    m_inotify(context),
+    m_settle_timer(context) {
+}
+
+AM::AssetWatcher::~AssetWatcher() {
+    if(m_update_th.joinable()) {
+        m_update_th.join();
+    }
+}
+
+bool AM::AssetWatcher::start() {
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(fd < 0) {
+        AM::log_error("ERROR! %s: inotify_init1 failed (%s)\n", __func__, strerror(errno));
+        return false;
+    }
+    m_inotify.assign(fd);
+
+    m_add_watch_recursive(m_config.host_dir, false);
+    if(m_watch_dirs.empty()) {
+        return false;
+    }
+
+    AM::log_info("Watching '%s' for changes (%li directories)\n", m_config.host_dir.c_str(), m_watch_dirs.size());
+    m_do_read_events();
+    return true;
+}
+
+void AM::AssetWatcher::m_add_watch_recursive(const std::string& dir, bool mark_files) {
+    const int wd = inotify_add_watch(m_inotify.native_handle(), dir.c_str(), WATCH_EVENT_MASK);
+    if(wd < 0) {
+        AM::log_error("ERROR! %s: Failed to watch '%s' (%s)\n", __func__, dir.c_str(), strerror(errno));
+        return;
+    }
+    m_watch_dirs[wd] = dir;
+
+    // Files may have been added before the watch.
+    std::error_code ec;
+    for(const fs::directory_entry& entry : fs::directory_iterator(dir, ec)) {
+        if(entry.is_directory(ec)) {
+            m_add_watch_recursive(entry.path(), mark_files);
+        }
+        else
+        if(mark_files) {
+            m_changed_paths.insert(entry.path());
+        }
+    }
+}
+
+void AM::AssetWatcher::m_remove_dir(const std::string& dir) {
+    const std::string prefix = dir + "/";
+    for(const auto& [name, file] : m_file_storage->files) {
+        if(file->full_path.starts_with(prefix)) {
+            m_changed_paths.insert(file->full_path);
+        }
+    }
+
+    // Moved directories keep their watches. Deleted ones get IN_IGNORED.
+    for(auto it = m_watch_dirs.begin(); it != m_watch_dirs.end();) {
+        if((it->second == dir) || it->second.starts_with(prefix)) {
+            inotify_rm_watch(m_inotify.native_handle(), it->first);
+            it = m_watch_dirs.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void AM::AssetWatcher::m_do_read_events() {
+    m_inotify.async_read_some(asio::buffer(m_event_buffer, sizeof(m_event_buffer)),
+            [this](std::error_code ec, std::size_t size) {
+                if(ec) {
+                    AM::log_error("[AssetWatcher](%i): %s\n", ec.value(), ec.message().c_str());
+                    return;
+                }
+                m_handle_events(size);
+                m_do_read_events();
+            });
+}
+
+void AM::AssetWatcher::m_handle_events(size_t size) {
+    size_t offset = 0;
+    while(offset + sizeof(struct inotify_event) <= size) {
+        const struct inotify_event* event = (const struct inotify_event*)(m_event_buffer + offset);
+        offset += sizeof(struct inotify_event) + event->len;
+
+        if(event->mask & IN_Q_OVERFLOW) {
+            // Some events were lost.
+            m_rescan = true;
+            continue;
+        }
+        if(event->mask & IN_IGNORED) {
+            m_watch_dirs.erase(event->wd);
+            continue;
+        }
+
+        const auto dir = m_watch_dirs.find(event->wd);
+        if((dir == m_watch_dirs.end()) || (event->len == 0)) {
+            continue;
+        }
+        const std::string path = fs::path(dir->second) / event->name;
+
+        if(event->mask & IN_ISDIR) {
+            if(event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                m_add_watch_recursive(path, true);
+            }
+            else
+            if(event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                m_remove_dir(path);
+            }
+        }
+        else
+        if(!(event->mask & IN_CREATE)) {
+            // New files are added when they are closed after writing.
+            m_changed_paths.insert(path);
+        }
+    }
+
+    if(!m_changed_paths.empty() || m_rescan) {
+        m_arm_settle_timer();
+    }
+}
+
+void AM::AssetWatcher::m_arm_settle_timer() {
+    if(m_settle_timer_armed) {
+        return;
+    }
+    m_settle_timer_armed = true;
+    m_settle_timer.expires_after(std::chrono::milliseconds(AM::WATCHER_SETTLE_MS));
+    m_settle_timer.async_wait([this](std::error_code ec) {
+        m_settle_timer_armed = false;
+        if(!ec) {
+            m_apply_changes();
+        }
+    });
+}
+
+void AM::AssetWatcher::m_apply_changes() {
+    if(m_updating) {
+        return; // Changes are applied when the update in progress is done.
+    }
+
+    bool rescan = false;
+    if(m_rescan) {
+        m_rescan = false;
+        rescan = true;
+        AM::log_info("[AssetWatcher]: Events were lost. Checking all files.\n");
+        for(const auto& [name, file] : m_file_storage->files) {
+            m_changed_paths.insert(file->full_path);
+        }
+    }
+    if(m_changed_paths.empty() && !rescan) {
+        return;
+    }
+
+    std::vector<std::string> changed_paths(m_changed_paths.begin(), m_changed_paths.end());
+    m_changed_paths.clear();
+    m_updating = true;
+
+    if(m_update_th.joinable()) {
+        m_update_th.join(); // Previous one has already posted its result.
+    }
+    m_update_th = std::thread([this, rescan](std::vector<std::string> changed_paths) {
+        if(rescan) {
+            std::error_code ec;
+            for(const fs::directory_entry& entry : fs::recursive_directory_iterator(m_config.host_dir, ec)) {
+                if(!entry.is_directory(ec)) {
+                    changed_paths.push_back(entry.path());
+                }
+            }
+            std::sort(changed_paths.begin(), changed_paths.end());
+            changed_paths.erase(std::unique(changed_paths.begin(), changed_paths.end()), changed_paths.end());
+        }
+        std::shared_ptr<AM::AssetFileUpdate> update = std::make_shared<AM::AssetFileUpdate>(
+                AM::prepare_asset_file_update(m_config, changed_paths));
+
+        asio::post(m_context, [this, update]() {
+            m_finish_update(*update);
+        });
+    },
+    std::move(changed_paths));
+}
+
+void AM::AssetWatcher::m_finish_update(const AM::AssetFileUpdate& update) {
+    AM::apply_asset_file_update(m_config, m_file_storage, update);
+    m_updating = false;
+    if(!m_changed_paths.empty() || m_rescan) {
+        m_arm_settle_timer();
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef AMBIENT3D_ASSETS_SERVER_ASSET_WATCHER_HPP
+#define AMBIENT3D_ASSETS_SERVER_ASSET_WATCHER_HPP
+
+#include <asio.hpp>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+
+#include "config.hpp"
+#include "asset_files.hpp"
+
+
+// Watches 'host_dir' with inotify and updates the file storage
+// when asset files are added, changed or removed, so the server doesnt need a restart.
+//
+// Events are collected for WATCHER_SETTLE_MS after the first one 
+// and handled together, so copying many files hashes them in one go.
+// The files are hashed and compressed on a worker thread so the sessions keep running.
+// The result is posted back to the io_context of the sessions and put in the storage there,
+// they never see the storage while it is being updated.
+
+namespace AM {
+
+    static constexpr int    WATCHER_SETTLE_MS = 100;
+    static constexpr size_t WATCHER_EVENT_BUFFER_SIZE = 64 * 1024;
+
+    class AssetWatcher {
+        public:
+            AssetWatcher(
+                    const AM::Config& config,
+                    AM::AssetFileStorage* file_storage,
+                    asio::io_context& context);
+
+            // Returns false if the directory cant be watched.
+            // The server still works without it but needs a restart to see changes.
+            bool start();
+
+            ~AssetWatcher();
+
+        private:
+            AM::Config                     m_config;
+            AM::AssetFileStorage*          m_file_storage;
+            asio::io_context&              m_context;
+            asio::posix::stream_descriptor m_inotify;
+            asio::steady_timer             m_settle_timer;
+            bool                           m_settle_timer_armed { false };
+
+            std::unordered_map<int, std::string> m_watch_dirs; // Watch descriptor -> directory path
+            std::unordered_set<std::string>      m_changed_paths;
+            bool                                 m_rescan { false };
+
+            alignas(8) char m_event_buffer[WATCHER_EVENT_BUFFER_SIZE];
+
+            // Files already in the directory are marked changed if 'mark_files' is set.
+            void m_add_watch_recursive(const std::string& dir, bool mark_files);
+            void m_remove_dir(const std::string& dir);
+            void m_do_read_events();
+            void m_handle_events(size_t size);
+            void m_arm_settle_timer();
+            void m_apply_changes();
+
+            // Only one update is prepared at a time.
+            // Changes seen meanwhile are handled after it.
+            std::thread m_update_th;
+            bool        m_updating { false };
+            void        m_finish_update(const AM::AssetFileUpdate& update);
+    };
+
+};
+
+
+
+#endif
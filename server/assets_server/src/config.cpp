@@ -1,12 +1,14 @@
 #include <fstream>
+#include <algorithm>
 
 #include "config.hpp"
+#include "shared/include/logger.hpp"
 
 
 AM::Config::Config(const char* json_cfg_path) {
     std::fstream stream(json_cfg_path);
     if(!stream.is_open()) {
-        fprintf(stderr, "ERROR! %s: Failed to open server configuration file (%s)\n",
+        AM::log_error("ERROR! %s: Failed to open server configuration file (%s)\n",
                 __func__, json_cfg_path);
         return;
     }
@@ -14,7 +16,7 @@ AM::Config::Config(const char* json_cfg_path) {
     json data = json::parse(stream);
     //this->json_data = data.dump();
 
-    printf("%s\n", data.dump(4).c_str());
+    AM::log_info("%s\n", data.dump(4).c_str());
 
     this->port = data["port"].template get<int>();
     this->host_dir = data["host_dir"].template get<std::string>();
@@ -22,6 +24,20 @@ AM::Config::Config(const char* json_cfg_path) {
     this->allowed_model_file_exts = data["allowed_file_extensions"]["models"].template get<std::string>();
     this->allowed_texture_file_exts = data["allowed_file_extensions"]["textures"].template get<std::string>();
 
+    this->watch_host_dir = data["watch_host_dir"].template get<bool>();
+    this->hash_cache_path = data["hash_cache_path"].template get<std::string>();
+    this->hash_threads = data["hash_threads"].template get<int>();
+    this->stream_files = data["file_streaming"]["enabled"].template get<bool>();
+    this->stream_window_bytes = data["file_streaming"]["window_bytes"].template get<size_t>();
+    this->max_concurrent_streams = std::max(data["file_streaming"]["max_streams"].template get<int>(), 1);
+    this->delta_updates = data["file_streaming"]["delta_updates"].template get<bool>();
+
+    this->compress_files = data["compression"]["enabled"].template get<bool>();
+    this->compression_cache_dir = data["compression"]["cache_dir"].template get<std::string>();
+    this->compression_level = data["compression"]["level"].template get<int>();
+    this->compression_encodings = data["compression"]["encodings"]
+        .template get<std::unordered_map<std::string, std::string>>();
+
 }
 
 
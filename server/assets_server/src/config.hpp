@@ -1,6 +1,8 @@
 #ifndef AMBIENT3D_ASSETS_SERVER_CONFIG_HPP
 #define AMBIENT3D_ASSETS_SERVER_CONFIG_HPP
 
+#include <string>
+#include <unordered_map>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
@@ -16,6 +18,42 @@ namespace AM {
         std::string  host_dir;
         std::string  allowed_model_file_exts;
         std::string  allowed_texture_file_exts;
+
+        // Files added, changed or removed in 'host_dir' are updated without restart.
+        bool         watch_host_dir;
+
+        // File hashes are saved here and reused on the next start
+        // for files which have the same size and modification time.
+        std::string  hash_cache_path;
+
+        // Number of threads used to hash and compress files. 0 uses one per cpu core.
+        int          hash_threads;
+
+        // When enabled files are sent with sendfile() as one raw byte stream
+        // instead of ASSET_FILE_BYTES packets which each wait for the client.
+        bool         stream_files;
+        
+        // How many bytes are written per socket wake up while streaming.
+        // The socket send buffer is also set to this size.
+        size_t       stream_window_bytes;
+
+        // Number of files streamed interleaved at once.
+        int          max_concurrent_streams;
+
+        // Clients which have an older version of a file download only
+        // the changed content chunks. Requires 'stream_files'
+        // Off by default: chunking both versions costs more than a fast link saves.
+        // (see bench/bench_delta_update.cpp)
+        bool         delta_updates;
+
+        // Files are compressed once into 'compression_cache_dir'
+        // and sent compressed to clients which download the whole file.
+        // 'compression_encodings' has the encoding for each type group ("models", "textures")
+        // (see shared/include/asset_compression.hpp)
+        bool         compress_files;
+        std::string  compression_cache_dir;
+        int          compression_level;
+        std::unordered_map<std::string, std::string> compression_encodings;
     };
 
 };
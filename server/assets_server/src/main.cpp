@@ -1,4 +1,5 @@
 #include "server.hpp"
+#include "asset_watcher.hpp"
 
 
 
@@ -11,9 +12,17 @@ int main(int argc, char** argv) {
     AM::AssetFileStorage file_storage;
 
     AM::find_asset_files(config, &file_storage);
-    AM::compute_asset_file_hashes(&file_storage);
+    AM::compute_asset_file_hashes(config, &file_storage);
+    file_storage.update_sorted_files();
+    AM::compress_asset_files(config, &file_storage);
 
     asio::io_context io_context;
+
+    AM::AssetWatcher watcher(config, &file_storage, io_context);
+    if(config.watch_host_dir) {
+        watcher.start();
+    }
+
     AM::GameAssetsServer server(config, &file_storage, io_context);
     server.start(io_context);
 
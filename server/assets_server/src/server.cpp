@@ -1,4 +1,7 @@
+#include <csignal>
+
 #include "server.hpp"
+#include "shared/include/logger.hpp"
 
 
 
@@ -22,7 +25,11 @@ AM::GameAssetsServer::~GameAssetsServer() {
 
 
 void AM::GameAssetsServer::start(asio::io_context& context) {
-    printf("Ambient3D - Game assets server started.\n");
+    // sendfile() has no MSG_NOSIGNAL flag. Streaming to a client which
+    // has disconnected would kill the server instead of failing with EPIPE.
+    signal(SIGPIPE, SIG_IGN);
+
+    AM::log_info("Ambient3D - Game assets server started.\n");
     m_do_accept_tcp();
     context.run();
 }
@@ -31,12 +38,12 @@ void AM::GameAssetsServer::start(asio::io_context& context) {
 void AM::GameAssetsServer::m_do_accept_tcp() {
     m_tcp_acceptor.async_accept([this](std::error_code ec, tcp::socket socket) {
         if(ec) {
-            printf("[accept](%i): %s\n", ec.value(), ec.message().c_str());
+            AM::log_info("[accept](%i): %s\n", ec.value(), ec.message().c_str());
             m_do_accept_tcp();
             return;
         }
 
-        printf("Client connected.\n");
+        AM::log_info("Client connected.\n");
 
         m_clients.push_back(std::make_shared<AM::TCP_session>(m_config, m_file_storage, std::move(socket)));
         m_clients.back()->start();
@@ -2,12 +2,22 @@
 #include <cstdlib>
 #include <ctime>
 #include <fstream>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <array>
 
 #include <nlohmann/json.hpp>
 
 #include "tcp_session.hpp"
 #include "config.hpp"
 #include "shared/include/packet_parser.hpp"
+#include "shared/include/logger.hpp"
 
 using json = nlohmann::json;
 
@@ -17,11 +27,29 @@ using json = nlohmann::json;
 void AM::TCP_session::m_send_download_queue_next_fileinfo() {
     json fileinfo = json::parse("{}");
 
-    AM::AssetFile& file = m_download_queue.front();
+    AM::AssetFile& file = *m_download_queue.front().file;
 
     fileinfo["filename"] = file.name;
     fileinfo["filesize"] = file.size;
     fileinfo["filegroup"] = file.type_group;
+    fileinfo["stream"] = m_config.stream_files;
+
+    if(m_download_queue.front().delta) {
+        if(file.find_content_chunks()) {
+            fileinfo["delta"] = true;
+            fileinfo["manifest_size"] = file.manifest.size();
+            fileinfo["sha256"] = file.sha256_hash;
+        }
+        else {
+            m_download_queue.front().delta = false; // Send the whole file.
+        }
+    }
+
+    // Delta updates send byte ranges of the original file.
+    if(!m_download_queue.front().delta) {
+        fileinfo["encoding"] = file.encoding;
+        fileinfo["encoded_size"] = file.transfer_size();
+    }
 
 
     this->packet.prepare(AM::PacketID::CREATE_ASSET_FILE);
@@ -31,11 +59,11 @@ void AM::TCP_session::m_send_download_queue_next_fileinfo() {
 
 
 void AM::TCP_session::m_read_next_file_for_sending() {
-    AM::AssetFile& file = m_download_queue.front();
+    AM::AssetFile& file = *m_download_queue.front().file;
 
-    std::ifstream current_file(file.full_path, std::ios::in | std::ios::binary | std::ios::ate);
+    std::ifstream current_file(file.transfer_path(), std::ios::in | std::ios::binary | std::ios::ate);
     if(!current_file.is_open()) {
-        fprintf(stderr, "%s: Failed to open '%s'\n", __func__, file.full_path.c_str());
+        AM::log_error("%s: Failed to open '%s'\n", __func__, file.transfer_path().c_str());
 
         // TODO: Inform client there was error on server side and abort download process.
         return;
@@ -54,11 +82,8 @@ void AM::TCP_session::m_read_next_file_for_sending() {
 
     current_file.read(m_current_file_bytes, m_current_file_size);
 
-    printf("'%s' First 16 bytes: \033[32m", file.name.c_str());
-    for(size_t i = 0; i < 16; i++) {
-        printf("%02X ", (uint8_t)m_current_file_bytes[i]);
-    }
-    printf("\033[0m\n");
+    AM::log_info("'%s' First 16 bytes: \033[32m%s\033[0m\n", file.name,
+            AM::LogBytes{ m_current_file_bytes, std::min(m_current_file_size, (size_t)16) });
 
     current_file.close();
 
@@ -69,13 +94,7 @@ void AM::TCP_session::m_read_next_file_for_sending() {
 void AM::TCP_session::m_send_download_queue_next_bytes() {
 
     if(m_current_file_complete) {
-        m_download_queue.pop_front();
-        if(m_download_queue.empty()) {
-            this->packet.prepare(AM::PacketID::ASSET_FILE_END);
-            this->send_packet();
-            return;
-        }
-        m_send_download_queue_next_fileinfo();
+        m_finish_download_queue_file();
         return;
     }
 
@@ -92,12 +111,12 @@ void AM::TCP_session::m_send_download_queue_next_bytes() {
             block_size);
     this->send_packet();
     
-    printf(" -> (block_size=%li) (offset=%li / %li)\n", block_size, m_current_file_byteoffset, m_current_file_size); 
+    AM::log_info(" -> (block_size=%li) (offset=%li / %li)\n", block_size, m_current_file_byteoffset, m_current_file_size); 
     m_current_file_byteoffset += block_size;
 
 
     if(m_current_file_byteoffset >= m_current_file_size) {
-        printf("COMPLETE!\n");
+        AM::log_info("COMPLETE!\n");
 
         m_current_file_complete = true;
 
@@ -105,84 +124,518 @@ void AM::TCP_session::m_send_download_queue_next_bytes() {
 }
 
 
-bool AM::TCP_session::m_match_client_filehash(
-        const json& client_filehashes_json, const AM::AssetFile& file) {
-  
-    if(client_filehashes_json.find(file.name) == client_filehashes_json.end()) {
+void AM::TCP_session::m_finish_download_queue_file() {
+    m_download_queue.pop_front();
+    if(m_download_queue.empty()) {
+        this->packet.prepare(AM::PacketID::ASSET_FILE_END);
+        this->send_packet();
+        return;
+    }
+    m_send_download_queue_next_fileinfo();
+}
+
+
+bool AM::TCP_session::m_begin_file_stream(const std::vector<mStreamRange>& ranges) {
+    AM::AssetFile& file = *m_download_queue.front().file;
+
+    // Delta update ranges are in the original file.
+    const bool delta = m_download_queue.front().delta;
+    const std::string& path = delta ? file.full_path : file.transfer_path();
+    const size_t expected_size = delta ? file.size : file.transfer_size();
+
+    m_close_file_stream();
+    m_stream_fd = open(path.c_str(), O_RDONLY);
+    if(m_stream_fd < 0) {
+        AM::log_error("%s: Failed to open '%s' (%s)\n", __func__, path.c_str(), strerror(errno));
         return false;
     }
 
-    
-    const std::string client_side_filehash = client_filehashes_json[file.name].template get<std::string>();
+    struct stat file_stat;
+    if(fstat(m_stream_fd, &file_stat) != 0) {
+        AM::log_error("%s: Failed to get size of '%s' (%s)\n", __func__, path.c_str(), strerror(errno));
+        m_close_file_stream();
+        return false;
+    }
+
+    // The client expects the size which was sent in the file info.
+    if((size_t)file_stat.st_size != expected_size) {
+        AM::log_error("%s: '%s' size has changed (%li -> %li bytes)\n",
+                __func__, path.c_str(), expected_size, (size_t)file_stat.st_size);
+        m_close_file_stream();
+        return false;
+    }
+
+    m_stream_ranges = ranges;
+    m_stream_range_index = 0;
+    if(!m_stream_ranges.empty()) {
+        m_stream_offset = m_stream_ranges[0].offset;
+        m_stream_range_end = m_stream_ranges[0].offset + m_stream_ranges[0].size;
+    }
 
-    return (client_side_filehash == file.sha256_hash);
+    if(!m_set_stream_socket_options()) {
+        m_close_file_stream();
+        return false;
+    }
 
+    m_do_stream_file();
+    return true;
 }
 
-void AM::TCP_session::m_handle_recv_data(size_t size) {
+bool AM::TCP_session::m_set_stream_socket_options() {
+    asio::error_code ec;
+    m_socket.set_option(asio::socket_base::send_buffer_size((int)m_config.stream_window_bytes), ec);
+    if(ec) {
+        // Streaming still works, there are only more socket wake ups per window.
+        AM::log_warning("%s: Failed to set socket send buffer size (%s)\n", __func__, ec.message().c_str());
+    }
+    m_socket.native_non_blocking(true, ec);
+    if(ec) {
+        AM::log_error("%s: Failed to set socket non blocking (%s)\n", __func__, ec.message().c_str());
+        return false;
+    }
+    return true;
+}
 
-    AM::PacketID packet_id = AM::parse_network_packet(m_data, size);
+// Client keeps what it has written when the connection is lost
+// and resumes from it on the next download.
+void AM::TCP_session::m_abort_download() {
+    AM::log_error("%s: Closing connection, client can resume the download later\n", __func__);
+    m_close_file_stream();
+    m_close_multi_file_stream();
+    m_download_queue.clear();
+
+    asio::error_code ec;
+    m_socket.shutdown(tcp::socket::shutdown_both, ec);
+    m_socket.close(ec); // Pending read fails and frees the session's buffers.
+}
 
-    switch(packet_id) {
+void AM::TCP_session::m_do_stream_file() {
+    // Skip to the next range when current one is sent.
+    while((m_stream_range_index < m_stream_ranges.size()) && (m_stream_offset >= m_stream_range_end)) {
+        m_stream_range_index++;
+        if(m_stream_range_index < m_stream_ranges.size()) {
+            const mStreamRange& range = m_stream_ranges[m_stream_range_index];
+            m_stream_offset = range.offset;
+            m_stream_range_end = range.offset + range.size;
+        }
+    }
 
-        case AM::PacketID::CLIENT_GAMEASSET_FILE_HASHES:
-            
-            // Respond with files which need downloading.
-            try {
-                const json client_filehashes = json::parse(m_data);
-               
-                m_download_queue.clear();
+    if(m_stream_range_index >= m_stream_ranges.size()) {
+        m_close_file_stream();
+        return; // Client will respond with GOT_ASSET_FILE.
+    }
 
-                if(client_filehashes.empty()) {
-                    m_file_storage->foreach_file([this](AM::AssetFile& file) {
-                       m_download_queue.push_back(file);
-                    });
+    m_socket.async_wait(tcp::socket::wait_write,
+            [this](std::error_code ec) {
+                if(ec) {
+                    AM::log_info("[stream](%i): %s\n", ec.value(), ec.message().c_str());
+                    m_close_file_stream();
+                    return;
                 }
-                else {
-                    m_file_storage->foreach_file([this, &client_filehashes](AM::AssetFile& file) {
-                        if(!m_match_client_filehash(client_filehashes, file)) {
-                            m_download_queue.push_back(file);
+
+                // Write until the window is full or the socket buffer is,
+                // then give other sessions a turn.
+                size_t window_left = m_config.stream_window_bytes;
+                while((window_left > 0) && (m_stream_offset < m_stream_range_end)) {
+                    const size_t count = std::min(window_left, (size_t)(m_stream_range_end - m_stream_offset));
+                    const ssize_t sent = sendfile(m_socket.native_handle(), m_stream_fd, &m_stream_offset, count);
+                    if(sent < 0) {
+                        if(errno == EINTR) {
+                            continue;
+                        }
+                        if((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                            break;
                         }
-                    });
+                        AM::log_error("[stream]: sendfile failed (%s)\n", strerror(errno));
+                        m_abort_download();
+                        return;
+                    }
+                    if(sent == 0) {
+                        AM::log_error("[stream]: File ended before expected size\n");
+                        m_abort_download();
+                        return;
+                    }
+                    window_left -= sent;
                 }
 
-                if(m_download_queue.empty()) {
-                    printf("Client files are up to date.\n");
-                    this->packet.prepare(AM::PacketID::ASSET_FILE_END);
-                    this->send_packet();
+                m_do_stream_file();
+            });
+}
+
+void AM::TCP_session::m_begin_multi_file_stream(const json& resume_json) {
+    std::vector<off_t> resume_offsets(m_download_queue.size(), 0);
+    for(const json& resume : resume_json) {
+        const size_t index = resume[0].template get<size_t>();
+        if(index < resume_offsets.size()) {
+            resume_offsets[index] = resume[1].template get<off_t>();
+        }
+    }
+
+    // Files sent whole are moved from the download queue to streams.
+    // Only delta updates are left in the queue.
+    std::deque<mQueuedFile> delta_files;
+    m_file_streams.clear();
+    for(size_t i = 0; i < m_download_queue.size(); i++) {
+        if(m_download_queue[i].delta) {
+            delta_files.push_back(m_download_queue[i]);
+            continue;
+        }
+        // Compressed files are always sent from the beginning
+        // because the client writes them decompressed.
+        const std::shared_ptr<AM::AssetFile>& file = m_download_queue[i].file;
+        const off_t end = (off_t)file->transfer_size();
+        const off_t offset = (file->encoding == AM::ASSET_ENCODING_NONE)
+            ? std::clamp(resume_offsets[i], (off_t)0, end) : 0;
+        if(offset > 0) {
+            AM::log_info("Resuming '%s' from %li / %li bytes\n", file->name.c_str(), offset, end);
+        }
+        m_file_streams.push_back(mFileStream{ file, (uint32_t)i, -1, offset, end });
+    }
+    m_download_queue = std::move(delta_files);
+
+    m_active_streams.clear();
+    m_next_stream = 0;
+    m_active_stream_turn = 0;
+    m_frame_in_progress = false;
+
+    if((!m_file_streams.empty() && !m_set_stream_socket_options())
+    || !m_open_next_file_streams()) {
+        m_abort_download();
+        return;
+    }
+
+    m_do_stream_frames();
+}
+
+bool AM::TCP_session::m_open_next_file_streams() {
+    while((m_active_streams.size() < (size_t)m_config.max_concurrent_streams)
+    && (m_next_stream < m_file_streams.size())) {
+        const size_t index = m_next_stream++;
+        mFileStream& stream = m_file_streams[index];
+        if(stream.offset >= stream.end) {
+            continue; // Client already has the whole file.
+        }
+
+        const std::string& path = stream.file->transfer_path();
+        stream.fd = open(path.c_str(), O_RDONLY);
+        if(stream.fd < 0) {
+            AM::log_error("%s: Failed to open '%s' (%s)\n", 
+                    __func__, path.c_str(), strerror(errno));
+            return false;
+        }
+
+        // The client expects the size which was sent in the file list.
+        struct stat file_stat;
+        if((fstat(stream.fd, &file_stat) != 0) || ((off_t)file_stat.st_size != stream.end)) {
+            AM::log_error("%s: '%s' size has changed or it cant be read\n",
+                    __func__, path.c_str());
+            return false;
+        }
+
+        m_active_streams.push_back(index);
+    }
+    return true;
+}
+
+void AM::TCP_session::m_do_stream_frames() {
+    if(!m_frame_in_progress && m_active_streams.empty()) {
+        m_finish_multi_file_stream();
+        return;
+    }
+
+    m_socket.async_wait(tcp::socket::wait_write,
+            [this](std::error_code ec) {
+                if(ec) {
+                    AM::log_info("[stream frames](%i): %s\n", ec.value(), ec.message().c_str());
+                    m_close_multi_file_stream();
                     return;
                 }
 
-                size_t total_download_bytes = 0;
-                json files_json = json::parse("{}");
+                // Same as m_do_stream_file() but active streams take turns sending a frame.
+                size_t window_left = m_config.stream_window_bytes;
+                while(window_left > 0) {
+                    if(!m_frame_in_progress) {
+                        if(m_active_streams.empty()) {
+                            break;
+                        }
+                        m_active_stream_turn %= m_active_streams.size();
+                        m_frame_stream = m_active_streams[m_active_stream_turn];
+                        
+                        const mFileStream& stream = m_file_streams[m_frame_stream];
+                        const size_t frame_size = std::min(AM::ASSET_STREAM_FRAME_MAX_SIZE, (size_t)(stream.end - stream.offset));
+                        m_frame_header.stream_id = stream.stream_id;
+                        m_frame_header.size = (uint32_t)frame_size;
+                        m_frame_header_sent = 0;
+                        m_frame_end = stream.offset + frame_size;
+                        m_frame_in_progress = true;
+                    }
+
+                    mFileStream& stream = m_file_streams[m_frame_stream];
+                    ssize_t sent = 0;
+
+                    if(m_frame_header_sent < sizeof(m_frame_header)) {
+                        sent = send(m_socket.native_handle(), 
+                                (char*)&m_frame_header + m_frame_header_sent,
+                                sizeof(m_frame_header) - m_frame_header_sent,
+                                MSG_NOSIGNAL | MSG_MORE);
+                        if(sent > 0) {
+                            m_frame_header_sent += sent;
+                        }
+                    }
+                    else
+                    if(stream.offset < m_frame_end) {
+                        const size_t count = std::min(window_left, (size_t)(m_frame_end - stream.offset));
+                        sent = sendfile(m_socket.native_handle(), stream.fd, &stream.offset, count);
+                        if(sent == 0) {
+                            AM::log_error("[stream frames]: '%s' ended before expected size\n", stream.file->name.c_str());
+                            m_abort_download();
+                            return;
+                        }
+                    }
+                    else {
+                        // Frame is complete.
+                        m_frame_in_progress = false;
+                        if(stream.offset < stream.end) {
+                            m_active_stream_turn++;
+                            continue;
+                        }
 
-                for(size_t i = 0; i < m_download_queue.size(); i++) {
-                    AM::AssetFile& file = m_download_queue[i];
-                    files_json["files"][i][0] = file.name;
-                    files_json["files"][i][1] = file.size;
+                        close(stream.fd);
+                        stream.fd = -1;
+                        m_active_streams.erase(m_active_streams.begin() + m_active_stream_turn);
+                        if(!m_open_next_file_streams()) {
+                            m_abort_download();
+                            return;
+                        }
+                        continue;
+                    }
 
-                    total_download_bytes += file.size;
+                    if(sent < 0) {
+                        if(errno == EINTR) {
+                            continue;
+                        }
+                        if((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                            break;
+                        }
+                        AM::log_error("[stream frames]: send failed (%s)\n", strerror(errno));
+                        m_abort_download();
+                        return;
+                    }
+                    window_left -= std::min((size_t)sent, window_left);
                 }
 
-                //printf("CLIENT DOWNLOAD QUEUE:\n%s\n", files_json.dump(4).c_str());
+                m_do_stream_frames();
+            });
+}
 
-                this->packet.prepare(AM::PacketID::DO_ACCEPT_ASSETS_DOWNLOAD);
-                this->packet.write<size_t>({ total_download_bytes });
-                this->packet.write_string({ files_json.dump() });
-                this->send_packet();
-            }
-            catch(const std::exception& e) {
-                fprintf(stderr, "[CLIENT_GAMEASSET_FILE_HASHES]: %s\n", e.what());
+void AM::TCP_session::m_finish_multi_file_stream() {
+    m_close_multi_file_stream();
+    if(m_download_queue.empty()) {
+        this->packet.prepare(AM::PacketID::ASSET_FILE_END);
+        this->send_packet();
+        return;
+    }
+    m_send_download_queue_next_fileinfo();
+}
+
+void AM::TCP_session::m_close_multi_file_stream() {
+    for(mFileStream& stream : m_file_streams) {
+        if(stream.fd >= 0) {
+            close(stream.fd);
+        }
+    }
+    m_file_streams.clear();
+    m_active_streams.clear();
+    m_frame_in_progress = false;
+}
+
+void AM::TCP_session::m_send_content_manifest() {
+    AM::AssetFile& file = *m_download_queue.front().file;
+
+    // The manifest may be bigger than one packet so it is written raw like streamed files.
+    asio::async_write(m_socket, asio::buffer(file.manifest.data(), file.manifest.size()),
+            [](std::error_code ec, std::size_t /*size*/) {
+                if(ec) {
+                    AM::log_info("[write manifest](%i): %s\n", ec.value(), ec.message().c_str());
+                }
+            });
+}
+
+void AM::TCP_session::m_stream_requested_chunks(size_t sizeb) {
+    if(m_download_queue.empty() || !m_download_queue.front().delta) {
+        return;
+    }
+
+    AM::AssetFile& file = *m_download_queue.front().file;
+    const size_t num_chunks = file.chunks.size();
+    if(sizeb < (num_chunks + 7) / 8) {
+        AM::log_error("%s: Chunk request for '%s' is too small (%li bytes for %li chunks)\n",
+                __func__, file.name.c_str(), sizeb, num_chunks);
+        m_abort_download();
+        return;
+    }
+
+    // Requested chunks next to each other are sent as one range.
+    std::vector<mStreamRange> ranges;
+    size_t requested_bytes = 0;
+    for(size_t i = 0; i < num_chunks; i++) {
+        if(!((uint8_t)m_data[i / 8] & (1 << (i % 8)))) {
+            continue;
+        }
+        const AM::ContentChunk& chunk = file.chunks[i];
+        if(!ranges.empty() && ((size_t)(ranges.back().offset + ranges.back().size) == chunk.offset)) {
+            ranges.back().size += chunk.size;
+        }
+        else {
+            ranges.push_back(mStreamRange{ (off_t)chunk.offset, chunk.size });
+        }
+        requested_bytes += chunk.size;
+    }
+
+    AM::log_info("Client requested %li / %li bytes of '%s'\n", requested_bytes, file.size, file.name.c_str());
+    if(!m_begin_file_stream(ranges)) {
+        m_abort_download();
+    }
+}
+
+void AM::TCP_session::m_close_file_stream() {
+    if(m_stream_fd >= 0) {
+        close(m_stream_fd);
+        m_stream_fd = -1;
+    }
+}
+
+
+void AM::TCP_session::m_handle_client_manifest() {
+    std::vector<AM::AssetManifestEntry> client_manifest;
+    client_manifest.swap(m_client_manifest);
+    m_client_manifest_received = 0;
+
+    // Clients are not trusted to sort it.
+    if(!std::is_sorted(client_manifest.begin(), client_manifest.end(),
+                [](const AM::AssetManifestEntry& a, const AM::AssetManifestEntry& b) {
+                    return a.name_hash < b.name_hash;
+                })) {
+        AM::sort_asset_manifest(&client_manifest);
+    }
+
+    // Respond with files which need downloading.
+    m_download_queue.clear();
+    const bool delta_updates = m_config.stream_files && m_config.delta_updates;
+    const std::vector<std::shared_ptr<AM::AssetFile>>& files = m_file_storage->sorted_files;
+
+    AM::merge_join_asset_manifest(files,
+            [](const std::shared_ptr<AM::AssetFile>& file) { return file->name_hash; },
+            client_manifest.data(), client_manifest.size(),
+            [this, &files, delta_updates](size_t i, const AM::AssetManifestEntry* client_file) {
+                const std::shared_ptr<AM::AssetFile>& file = files[i];
+                if(client_file && (memcmp(client_file->digest, file->digest.data(), AM::ASSET_DIGEST_SIZE) == 0)) {
+                    return; // Up to date.
+                }
+                // Small files are not worth the extra round trip.
+                const bool delta = delta_updates
+                    && (client_file != NULL)
+                    && (file->size >= AM::DELTA_UPDATE_MIN_FILE_SIZE);
+                m_download_queue.push_back({ file, delta });
+            });
+
+    if(m_download_queue.empty()) {
+        AM::log_info("Client files are up to date.\n");
+        this->packet.prepare(AM::PacketID::ASSET_FILE_END);
+        this->send_packet();
+        return;
+    }
+
+    size_t total_download_bytes = 0;
+    json files_json = json::parse("{}");
+
+    for(size_t i = 0; i < m_download_queue.size(); i++) {
+        AM::AssetFile& file = *m_download_queue[i].file;
+        files_json["files"][i][0] = file.name;
+        files_json["files"][i][1] = file.size;
+        files_json["files"][i][2] = file.type_group;
+        files_json["files"][i][3] = file.sha256_hash;
+        files_json["files"][i][4] = m_download_queue[i].delta;
+        files_json["files"][i][5] = file.encoding;
+        files_json["files"][i][6] = file.transfer_size();
+
+        total_download_bytes += m_download_queue[i].delta ? file.size : file.transfer_size();
+    }
+    files_json["streams"] = m_config.stream_files ? m_config.max_concurrent_streams : 0;
+
+    //printf("CLIENT DOWNLOAD QUEUE:\n%s\n", files_json.dump(4).c_str());
+
+    // The list can be larger than a packet so it is written raw after the packet.
+    m_file_list = files_json.dump();
+    this->packet.prepare(AM::PacketID::DO_ACCEPT_ASSETS_DOWNLOAD);
+    this->packet.write<size_t>({ total_download_bytes });
+    this->packet.write<size_t>({ m_file_list.size() });
+    m_send_packet_with_data(m_file_list.data(), m_file_list.size());
+}
+
+void AM::TCP_session::m_handle_recv_data(size_t size) {
+
+    AM::PacketID packet_id = AM::parse_network_packet(m_data, size);
+
+    switch(packet_id) {
+
+        case AM::PacketID::CLIENT_GAMEASSET_FILE_HASHES:
+            {
+                uint64_t manifest_sizeb = 0;
+                if(size < sizeof(manifest_sizeb)) {
+                    AM::log_error("[CLIENT_GAMEASSET_FILE_HASHES]: Invalid packet size(%li)\n", size);
+                    return;
+                }
+                memmove(&manifest_sizeb, m_data, sizeof(manifest_sizeb));
+                
+                if(((manifest_sizeb % sizeof(AM::AssetManifestEntry)) != 0)
+                || ((manifest_sizeb / sizeof(AM::AssetManifestEntry)) > AM::MAX_ASSET_MANIFEST_ENTRIES)) {
+                    AM::log_error("[CLIENT_GAMEASSET_FILE_HASHES]: Invalid manifest size(%li)\n", manifest_sizeb);
+                    return;
+                }
+
+                // Beginning of the manifest may have been read with the packet.
+                m_client_manifest.resize(manifest_sizeb / sizeof(AM::AssetManifestEntry));
+                m_client_manifest_received = std::min(size - sizeof(manifest_sizeb), (size_t)manifest_sizeb);
+                memmove(m_client_manifest.data(), m_data + sizeof(manifest_sizeb), m_client_manifest_received);
+
+                if(m_client_manifest_received == manifest_sizeb) {
+                    m_handle_client_manifest();
+                }
             }
             break;
 
         case AM::PacketID::ACCEPTED_ASSETS_DOWNLOAD:
-            printf("Client accepted download.\n");
+            AM::log_info("Client accepted download.\n");
+            if(m_config.stream_files) {
+                json resume_json = json::array();
+                try {
+                    resume_json = json::parse(m_data).value("resume", json::array());
+                }
+                catch(const std::exception& e) {
+                    AM::log_error("[ACCEPTED_ASSETS_DOWNLOAD]: %s\n", e.what());
+                }
+                m_begin_multi_file_stream(resume_json);
+                break;
+            }
             m_send_download_queue_next_fileinfo();
             break;
 
         case AM::PacketID::CLIENT_CREATED_ASSET_FILE:
-            printf("Client has created the asset file. Begin download process\n");
+            AM::log_info("Client has created the asset file. Begin download process\n");
+            if(m_download_queue.empty()) {
+                return;
+            }
+            if(m_config.stream_files && m_download_queue.front().delta) {
+                m_send_content_manifest(); // Client responds with ASSET_CHUNK_REQUEST.
+                break;
+            }
+            if(m_config.stream_files) {
+                if(!m_begin_file_stream({ mStreamRange{ 0, m_download_queue.front().file->transfer_size() } })) {
+                    m_abort_download();
+                }
+                break;
+            }
             m_read_next_file_for_sending();
             m_send_download_queue_next_bytes();
             break;
@@ -190,6 +643,18 @@ void AM::TCP_session::m_handle_recv_data(size_t size) {
         case AM::PacketID::GOT_SOME_FILE_BYTES:
             m_send_download_queue_next_bytes();
             break;
+
+        case AM::PacketID::ASSET_CHUNK_REQUEST:
+            m_stream_requested_chunks(size);
+            break;
+
+        case AM::PacketID::GOT_ASSET_FILE:
+            if(m_download_queue.empty()) {
+                return;
+            }
+            AM::log_info("Client got '%s'\n", m_download_queue.front().file->name.c_str());
+            m_finish_download_queue_file();
+            break;
     }
 
 
@@ -202,21 +667,44 @@ void AM::TCP_session::start() {
 
 
 void AM::TCP_session::m_do_read() {
-    
-    memset(m_data, 0, AM::MAX_PACKET_SIZE);
+
+    // Rest of the client manifest is read straight to its buffer.
+    const size_t manifest_sizeb = m_client_manifest.size() * sizeof(AM::AssetManifestEntry);
+    const bool reading_manifest = (m_client_manifest_received < manifest_sizeb);
+    char*  read_buffer = m_data;
+    size_t read_size = AM::MAX_PACKET_SIZE;
+
+    if(reading_manifest) {
+        read_buffer = (char*)m_client_manifest.data() + m_client_manifest_received;
+        read_size = std::min(read_size, manifest_sizeb - m_client_manifest_received);
+    }
+    else {
+        memset(m_data, 0, AM::MAX_PACKET_SIZE);
+    }
 
     //const std::shared_ptr<TCP_session>& self(shared_from_this());
-    m_socket.async_read_some(asio::buffer(m_data, AM::MAX_PACKET_SIZE),
-            [this](std::error_code ec, std::size_t size) {
+    m_socket.async_read_some(asio::buffer(read_buffer, read_size),
+            [this, reading_manifest](std::error_code ec, std::size_t size) {
                 if(ec) {
-                    printf("[read](%i): %s\n", ec.value(), ec.message().c_str());
+                    AM::log_info("[read](%i): %s\n", ec.value(), ec.message().c_str());
                     this->packet.free_memory();
+                    m_close_file_stream();
+                    m_close_multi_file_stream();
                     if(m_current_file_bytes) {
                         delete[] m_current_file_bytes;
+                        m_current_file_bytes = NULL;
                     }
                     
                     // TODO: Remove client.
                 
+                    return; // Reading again would fail right away and loop forever.
+                }
+                else
+                if(reading_manifest) {
+                    m_client_manifest_received += size;
+                    if(m_client_manifest_received >= m_client_manifest.size() * sizeof(AM::AssetManifestEntry)) {
+                        m_handle_client_manifest();
+                    }
                 }
                 else {
                     m_handle_recv_data(size);
@@ -235,10 +723,11 @@ void AM::TCP_session::send_packet() {
     asio::async_write(m_socket, asio::buffer(this->packet.data, this->packet.size),
             [this](std::error_code ec, std::size_t /*size*/) {
                 if(ec) {
-                    printf("[write](%i): %s\n", ec.value(), ec.message().c_str());
+                    AM::log_info("[write](%i): %s\n", ec.value(), ec.message().c_str());
                     this->packet.free_memory();
                     if(m_current_file_bytes) {
                         delete[] m_current_file_bytes;
+                        m_current_file_bytes = NULL;
                     }
 
                     // TODO: Remove client.
@@ -250,4 +739,22 @@ void AM::TCP_session::send_packet() {
     this->packet.enable_flag(AM::Packet::FLG_COMPLETE);
 }
 
+void AM::TCP_session::m_send_packet_with_data(const void* data, size_t sizeb) {
+    if((this->packet.get_flags() & AM::Packet::FLG_WRITE_ERROR)) {
+        return;
+    }
 
+    // One write so nothing else can be written between them.
+    const std::array<asio::const_buffer, 2> buffers {
+        asio::buffer(this->packet.data, this->packet.size),
+        asio::buffer(data, sizeb)
+    };
+    asio::async_write(m_socket, buffers,
+            [](std::error_code ec, std::size_t /*size*/) {
+                if(ec) {
+                    AM::log_info("[write](%i): %s\n", ec.value(), ec.message().c_str());
+                }
+            });
+
+    this->packet.enable_flag(AM::Packet::FLG_COMPLETE);
+}
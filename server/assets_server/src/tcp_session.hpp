@@ -9,6 +9,7 @@
 #include "asset_files.hpp"
 #include "shared/include/networking_agreements.hpp"
 #include "shared/include/packet_writer.hpp"
+#include "shared/include/asset_manifest.hpp"
 
 using namespace asio::ip;
 
@@ -16,6 +17,8 @@ using namespace asio::ip;
 
 namespace AM {
 
+    // Files smaller than this are always sent whole.
+    static constexpr size_t DELTA_UPDATE_MIN_FILE_SIZE = 64 * 1024;
 
     class TCP_session : public std::enable_shared_from_this<TCP_session> {
         public:
@@ -38,21 +41,81 @@ namespace AM {
             tcp::socket            m_socket;
 
 
-            std::deque<AM::AssetFile> m_download_queue;
+            struct mQueuedFile {
+                std::shared_ptr<AM::AssetFile> file;
+                bool           delta; // Client has an older version, send only the missing chunks.
+            };
+            std::deque<mQueuedFile> m_download_queue;
             void    m_do_read();
             void    m_handle_recv_data(size_t size);
 
             void    m_send_download_queue_next_fileinfo();
             void    m_read_next_file_for_sending();
             void    m_send_download_queue_next_bytes();
+            void    m_finish_download_queue_file();
+
+            // Streaming mode. (see AM::Config::stream_files)
+            // Byte ranges of the file are sent one after another.
+            struct mStreamRange {
+                off_t  offset;
+                size_t size;
+            };
+            int     m_stream_fd { -1 };
+            off_t   m_stream_offset { 0 };
+            off_t   m_stream_range_end { 0 };
+            size_t  m_stream_range_index { 0 };
+            std::vector<mStreamRange> m_stream_ranges;
+            bool    m_begin_file_stream(const std::vector<mStreamRange>& ranges);
+            void    m_do_stream_file();
+            void    m_close_file_stream();
+
+            bool    m_set_stream_socket_options();
+            void    m_abort_download();
+
+            // Multi file streaming. (see AM::PacketID::ACCEPTED_ASSETS_DOWNLOAD)
+            // Files sent whole are streamed interleaved in frames, 
+            // 'max_concurrent_streams' files at once so the client doesnt wait a round trip per file.
+            struct mFileStream {
+                std::shared_ptr<AM::AssetFile> file;
+                uint32_t       stream_id;
+                int            fd;
+                off_t          offset;
+                off_t          end;
+            };
+            std::vector<mFileStream> m_file_streams;
+            std::vector<size_t>      m_active_streams; // Indices to 'm_file_streams'
+            size_t  m_next_stream { 0 }; // Next stream to open.
+            size_t  m_active_stream_turn { 0 };
+            bool    m_frame_in_progress { false };
+            size_t  m_frame_stream { 0 };
+            off_t   m_frame_end { 0 };
+            size_t  m_frame_header_sent { 0 };
+            AM::AssetStreamFrameHeader m_frame_header;
+            void    m_begin_multi_file_stream(const json& resume_json);
+            bool    m_open_next_file_streams();
+            void    m_do_stream_frames();
+            void    m_finish_multi_file_stream();
+            void    m_close_multi_file_stream();
+
+            // Delta updates. (see AM::Config::delta_updates)
+            void    m_send_content_manifest();
+            void    m_stream_requested_chunks(size_t sizeb);
 
             char*   m_current_file_bytes { NULL };
             size_t  m_current_file_size { 0 };
             size_t  m_current_file_byteoffset { 0 };
             bool    m_current_file_complete { false };
 
-            bool    m_match_client_filehash(
-                    const json& client_filehashes_json, const AM::AssetFile& file);
+            // Binary manifest of the client's files. (see AM::PacketID::CLIENT_GAMEASSET_FILE_HASHES)
+            std::vector<AM::AssetManifestEntry> m_client_manifest;
+            size_t  m_client_manifest_received { 0 }; // Bytes.
+            void    m_handle_client_manifest();
+
+            // File list of DO_ACCEPT_ASSETS_DOWNLOAD.
+            std::string m_file_list;
+
+            // 'data' is written right after the packet and must stay valid until it is sent.
+            void    m_send_packet_with_data(const void* data, size_t sizeb);
 
             // Packet data. TODO: Rename,
             char m_data[AM::MAX_PACKET_SIZE] { 0 };
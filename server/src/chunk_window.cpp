@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "chunk_window.hpp"
+
+
+// Bits from 'lo' to 'hi' (not included) which are in the word starting at 'word_begin'
+static uint64_t _range_mask(int word_begin, int lo, int hi) {
+    lo = std::max(lo - word_begin, 0);
+    hi = std::min(hi - word_begin, 64);
+    if(lo >= hi) {
+        return 0;
+    }
+    const uint64_t upper = (hi == 64) ? ~0ULL : ((1ULL << hi) - 1);
+    return upper & ~((1ULL << lo) - 1);
+}
+
+
+void AM::ChunkWindow::resize(int radius) {
+    m_radius = std::max(radius, 0);
+    m_side = 1;
+    while(m_side < (m_radius * 2 + 1)) {
+        m_side <<= 1;
+    }
+    m_mask = m_side - 1;
+    m_words_per_row = std::max(m_side / 64, 1);
+    m_bits.assign((size_t)m_side * m_words_per_row, 0);
+}
+
+void AM::ChunkWindow::clear() {
+    std::fill(m_bits.begin(), m_bits.end(), 0);
+}
+
+void AM::ChunkWindow::insert(const AM::ChunkPos& pos) {
+    if((abs(pos.x - m_center.x) > m_radius) || (abs(pos.z - m_center.z) > m_radius)) {
+        return;
+    }
+    const size_t bit = m_bit_index(pos);
+    m_bits[bit >> 6] |= (1ULL << (bit & 63));
+}
+
+void AM::ChunkWindow::erase(const AM::ChunkPos& pos) {
+    if((abs(pos.x - m_center.x) > m_radius) || (abs(pos.z - m_center.z) > m_radius)) {
+        return;
+    }
+    const size_t bit = m_bit_index(pos);
+    m_bits[bit >> 6] &= ~(1ULL << (bit & 63));
+}
+
+void AM::ChunkWindow::m_drop_column(int x, const std::function<void(const AM::ChunkPos&)>& on_drop) {
+    for(int z = m_center.z - m_radius; z <= m_center.z + m_radius; z++) {
+        const AM::ChunkPos pos(x, z);
+        const size_t bit = m_bit_index(pos);
+        uint64_t& word = m_bits[bit >> 6];
+        const uint64_t flag = (1ULL << (bit & 63));
+        if(on_drop && (word & flag)) {
+            on_drop(pos);
+        }
+        word &= ~flag;
+    }
+}
+
+void AM::ChunkWindow::m_drop_row(int z, const std::function<void(const AM::ChunkPos&)>& on_drop) {
+    for(int x = m_center.x - m_radius; x <= m_center.x + m_radius; x++) {
+        const AM::ChunkPos pos(x, z);
+        const size_t bit = m_bit_index(pos);
+        uint64_t& word = m_bits[bit >> 6];
+        const uint64_t flag = (1ULL << (bit & 63));
+        if(on_drop && (word & flag)) {
+            on_drop(pos);
+        }
+        word &= ~flag;
+    }
+}
+
+void AM::ChunkWindow::set_center(const AM::ChunkPos& center,
+        const std::function<void(const AM::ChunkPos&)>& on_drop) {
+    const int dx = center.x - m_center.x;
+    const int dz = center.z - m_center.z;
+    if((dx == 0) && (dz == 0)) {
+        return;
+    }
+
+    const int width = m_radius * 2 + 1;
+
+    // Rows and columns are dropped using the old center.
+    if((abs(dx) >= width) || (abs(dz) >= width)) {
+        // Nothing overlaps.
+        if(on_drop) {
+            for(int x = m_center.x - m_radius; x <= m_center.x + m_radius; x++) {
+                m_drop_column(x, on_drop);
+            }
+        }
+        this->clear();
+    }
+    else {
+        if(dx > 0) {
+            for(int x = m_center.x - m_radius; x < m_center.x - m_radius + dx; x++) {
+                m_drop_column(x, on_drop);
+            }
+        }
+        else
+        if(dx < 0) {
+            for(int x = m_center.x + m_radius + dx + 1; x <= m_center.x + m_radius; x++) {
+                m_drop_column(x, on_drop);
+            }
+        }
+
+        if(dz > 0) {
+            for(int z = m_center.z - m_radius; z < m_center.z - m_radius + dz; z++) {
+                m_drop_row(z, on_drop);
+            }
+        }
+        else
+        if(dz < 0) {
+            for(int z = m_center.z + m_radius + dz + 1; z <= m_center.z + m_radius; z++) {
+                m_drop_row(z, on_drop);
+            }
+        }
+    }
+
+    m_center = center;
+}
+
+void AM::ChunkWindow::foreach_missing(int distance,
+        const std::function<void(const AM::ChunkPos&)>& callback) const {
+    const int d = std::clamp(distance, 0, m_radius);
+    const int first_x = m_center.x - d;
+    const int first_col = first_x & m_mask;
+    const int num_cols = d * 2 + 1;
+
+    // Columns of the area may wrap around the end of the row.
+    std::vector<uint64_t> col_masks(m_words_per_row);
+    for(int w = 0; w < m_words_per_row; w++) {
+        const int word_begin = w * 64;
+        col_masks[w] = _range_mask(word_begin, first_col, std::min(first_col + num_cols, m_side));
+        if(first_col + num_cols > m_side) {
+            col_masks[w] |= _range_mask(word_begin, 0, first_col + num_cols - m_side);
+        }
+    }
+
+    for(int z = m_center.z - d; z <= m_center.z + d; z++) {
+        const uint64_t* row = &m_bits[(size_t)(z & m_mask) * m_words_per_row];
+        for(int w = 0; w < m_words_per_row; w++) {
+            uint64_t missing = col_masks[w] & ~row[w];
+            while(missing) {
+                const int col = w * 64 + __builtin_ctzll(missing);
+                missing &= missing - 1;
+                callback(AM::ChunkPos(first_x + ((col - first_col) & m_mask), z));
+            }
+        }
+    }
+}
+
+
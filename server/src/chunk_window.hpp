@@ -0,0 +1,80 @@
+#ifndef AMBIENT3D_SERVER_CHUNK_WINDOW_HPP
+#define AMBIENT3D_SERVER_CHUNK_WINDOW_HPP
+
+#include <cstdint>
+#include <vector>
+#include <functional>
+
+#include "shared/include/chunk_pos.hpp"
+
+
+// Keeps track of which chunks a player has received.
+//
+// One bit per chunk in a square window around the player's chunk.
+// The window side is a power of two and chunk positions wrap around it
+// ((x & mask), (z & mask)), so when the player moves only the rows and
+// columns that left the window are cleared. Nothing is copied.
+//
+// Chunks outside of the window are never marked as loaded.
+
+namespace AM {
+
+    class ChunkWindow {
+        public:
+
+            // Clears the window. 'radius' is the furthest distance in chunks
+            // (on either axis) from the center that can be marked as loaded.
+            void resize(int radius);
+            int  radius() const { return m_radius; }
+
+            const AM::ChunkPos& center() const { return m_center; }
+
+            // Slides the window. Positions that were loaded and are now outside
+            // of the window are passed to 'on_drop' if it is set.
+            void set_center(const AM::ChunkPos& center,
+                    const std::function<void(const AM::ChunkPos&)>& on_drop = nullptr);
+
+            bool contains(const AM::ChunkPos& pos) const {
+                const int dx = pos.x - m_center.x;
+                const int dz = pos.z - m_center.z;
+                const uint32_t width = (uint32_t)(m_radius * 2);
+                const bool inside
+                    = ((uint32_t)(dx + m_radius) <= width)
+                    & ((uint32_t)(dz + m_radius) <= width);
+                const size_t bit = m_bit_index(pos);
+                return inside & (bool)((m_bits[bit >> 6] >> (bit & 63)) & 1);
+            }
+
+            // Does nothing if the position is outside of the window.
+            void insert(const AM::ChunkPos& pos);
+            void erase(const AM::ChunkPos& pos);
+            void clear();
+
+            // Calls 'callback' for every position in 'distance' (on either axis) from the center
+            // which is not loaded. 'distance' is clamped to the window radius.
+            // Rows are scanned a word at a time so loaded chunks cost almost nothing.
+            void foreach_missing(int distance,
+                    const std::function<void(const AM::ChunkPos&)>& callback) const;
+
+        private:
+
+            int m_radius { 0 };
+            int m_side   { 1 };  // Power of two >= (m_radius * 2 + 1)
+            int m_mask   { 0 };
+            int m_words_per_row { 1 };
+            AM::ChunkPos m_center { 0, 0 };
+
+            std::vector<uint64_t> m_bits { 0 };
+
+            size_t m_bit_index(const AM::ChunkPos& pos) const {
+                return (size_t)(pos.z & m_mask) * (m_words_per_row * 64) + (size_t)(pos.x & m_mask);
+            }
+
+            void m_drop_column(int x, const std::function<void(const AM::ChunkPos&)>& on_drop);
+            void m_drop_row(int z, const std::function<void(const AM::ChunkPos&)>& on_drop);
+    };
+
+};
+
+
+#endif
@@ -2,6 +2,7 @@
 #include <cstdlib>
 
 #include "server.hpp"
+#include "shared/include/logger.hpp"
 
     
 //constexpr const char* item_list_path = "../items/item_list.json";
@@ -13,7 +14,7 @@
 
 
 int main() {
-    printf("Ambient3D - Server\n");
+    AM::log_info("Ambient3D - Server\n");
 
     asio::io_context io_context;
     AM::ServerCFG config("server_config.json");
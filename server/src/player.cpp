@@ -129,14 +129,50 @@ void AM::Player::clear_next_position_flags() {
 }
 
 
-       
-void AM::Player::update() {
+
+void AM::Player::set_client_position(const AM::Vec3& p) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_client_position = p;
+    m_has_client_position = true;
+}
+
+void AM::Player::request_jump() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jump_requested = true;
+}
+
+AM::PlayerInput AM::Player::take_input(float tick_ms) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    m_input_age_ms += tick_ms;
+
+    AM::PlayerInput input;
+    input.position = m_client_position;
+    input.age_ms = m_input_age_ms;
+    input.has_position = m_has_client_position;
+    input.jump = m_jump_requested;
+
+    if(m_has_client_position) {
+        m_input_age_ms = 0.0f;
+    }
+    m_has_client_position = false;
+    m_jump_requested = false;
+    return input;
+}
+
+void AM::Player::apply_physics(
+        const AM::Vec3& position,
+        float velocity_y,
+        float terrain_surface_y,
+        bool  is_on_ground
+){
     std::lock_guard<std::mutex> lock(m_mutex);
 
-    m_terrain_surface_y = m_server->terrain.get_surface_level(m_position);
+    m_position = position;
+    m_velocity.y = velocity_y;
+    m_terrain_surface_y = terrain_surface_y;
     m_chunk_pos = m_server->terrain.get_chunk_pos(m_position.x, m_position.z);
-        
-    this->on_ground = ((m_position.y - (m_server->config.player_cam_height)) < m_terrain_surface_y);
+    this->on_ground = is_on_ground;
 }
 
 
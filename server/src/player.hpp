@@ -9,19 +9,32 @@
 #include "terrain/chunk.hpp"
 #include "shared/include/inventory.hpp"
 #include "shared/include/vec3.hpp"
+#include "chunk_window.hpp"
 
 
 
 namespace AM {
     class Server;
 
+    // Input received from the client since the previous physics update.
+    struct PlayerInput {
+        AM::Vec3 position;            // Position the client reported.
+        float    age_ms  { 0.0f };    // Time since the previous reported position.
+        bool     has_position { false };
+        bool     jump    { false };
+    };
+
     class Player {
         public:
 
             Player(std::shared_ptr<AM::TCP_session> _tcp_session);
             Player(){}
             std::shared_ptr<AM::TCP_session> tcp_session;
-            std::unordered_map<AM::ChunkPos, bool> loaded_chunks;
+
+            // Chunks the player has received. Centered at the player's chunk
+            // every tick before new chunks are sent.
+            std::mutex         loaded_chunks_mutex;
+            AM::ChunkWindow    loaded_chunks;
 
             void free_memory();
 
@@ -63,7 +76,21 @@ namespace AM {
             int next_position_flags() const;               // < thread safe >
             void clear_next_position_flags();              // < thread safe >
 
-            void update();  // < thread safe >
+            // Client reported position is not applied directly.
+            // It is validated on the next physics update. (see player_physics.hpp)
+            void set_client_position(const AM::Vec3& p);   // < thread safe >
+            void request_jump();                           // < thread safe >
+
+            // Returns the input and clears it for the next tick.
+            // 'tick_ms' is added to the input age.
+            AM::PlayerInput take_input(float tick_ms);      // < thread safe >
+
+            // Physics writes the result here after every update.
+            void apply_physics(
+                    const AM::Vec3& position,
+                    float velocity_y,
+                    float terrain_surface_y,
+                    bool  is_on_ground);                    // < thread safe >
 
             std::atomic<bool> on_ground       { true };
 
@@ -81,11 +108,14 @@ namespace AM {
             float m_cam_pitch { 0.0f };
             int m_animation_id { 0 };
             float m_terrain_surface_y { 0.0f };
+
+            AM::Vec3 m_client_position { 0.0f, 0.0f, 0.0f };
+            float m_input_age_ms { 0.0f };
+            bool m_has_client_position { false };
+            bool m_jump_requested { false };
             
             AM::Server* m_server { NULL };
 
-            void m_update_gravity();
-
     };
 
 
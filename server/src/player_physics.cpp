@@ -0,0 +1,165 @@
+#include <cmath>
+#include <cstdio>
+
+#include "player_physics.hpp"
+#include "server.hpp"
+#include "shared/include/logger.hpp"
+
+
+
+void AM::PlayerPhysics::update(AM::Server* server, float tick_ms) {
+    m_gather(server, tick_ms);
+    if(m_players.empty()) {
+        m_step_accumulator_ms = 0.0f;
+        return;
+    }
+
+    // Players dont move on the XZ plane during the steps
+    // so the surface levels are needed only once.
+    server->terrain.chunk_map_mutex.lock();
+    server->terrain.get_surface_levels(
+            m_pos_x.data(),
+            m_pos_z.data(),
+            m_players.size(),
+            m_surface_y.data(),
+            m_surface_found.data());
+    server->terrain.chunk_map_mutex.unlock();
+
+    m_step_accumulator_ms += tick_ms;
+
+    int num_steps = 0;
+    while(m_step_accumulator_ms >= AM::PHYSICS_STEP_MS) {
+        m_step_accumulator_ms -= AM::PHYSICS_STEP_MS;
+        if(num_steps >= AM::PHYSICS_MAX_STEPS_PER_TICK) {
+            continue; // Drop the time that cant be simulated.
+        }
+        m_step(AM::PHYSICS_STEP_MS / 1000.0f, server->config.gravity, server->config.player_cam_height);
+        num_steps++;
+    }
+
+    m_scatter(server);
+}
+
+void AM::PlayerPhysics::m_gather(AM::Server* server, float tick_ms) {
+    m_players.clear();
+    m_pos_x.clear();
+    m_pos_y.clear();
+    m_pos_z.clear();
+    m_vel_y.clear();
+    m_client_y.clear();
+    m_on_ground.clear();
+    m_has_client_y.clear();
+    m_correct_xz.clear();
+
+    const float max_speed = server->config.player_max_speed;
+    const float tolerance = server->config.player_position_tolerance;
+
+    for(auto it = server->players.begin(); it != server->players.end(); ++it) {
+        AM::Player* player = it->second;
+        if(!player->tcp_session->is_fully_connected()) {
+            continue;
+        }
+
+        const AM::PlayerInput input = player->take_input(tick_ms);
+        const AM::Vec3 position = player->position();
+
+        float   x = position.x;
+        float   z = position.z;
+        float   vel_y = player->velocity().y;
+        uint8_t on_ground = player->on_ground;
+        uint8_t correct_xz = 0;
+        uint8_t has_client_y = 0;
+
+        if(input.has_position) {
+            const float dx = input.position.x - position.x;
+            const float dz = input.position.z - position.z;
+            const float max_distance = max_speed * (input.age_ms / 1000.0f) + tolerance;
+
+            const bool is_finite
+                =  std::isfinite(input.position.x)
+                && std::isfinite(input.position.y)
+                && std::isfinite(input.position.z);
+
+            if(is_finite && (dx*dx + dz*dz) <= (max_distance * max_distance)) {
+                x = input.position.x;
+                z = input.position.z;
+                has_client_y = 1;
+            }
+            else {
+                correct_xz = 1;
+                if(server->show_debug_info) {
+                    AM::log_info("[PHYSICS]: Player(%i) moved too far (%0.2f > %0.2f) correcting position.\n",
+                            player->id(), sqrtf(dx*dx + dz*dz), max_distance);
+                }
+            }
+        }
+
+        if(input.jump && on_ground) {
+            vel_y = server->config.player_jump_force;
+            on_ground = 0;
+        }
+
+        m_players.push_back(player);
+        m_pos_x.push_back(x);
+        m_pos_y.push_back(position.y);
+        m_pos_z.push_back(z);
+        m_vel_y.push_back(vel_y);
+        m_client_y.push_back(input.position.y);
+        m_on_ground.push_back(on_ground);
+        m_has_client_y.push_back(has_client_y);
+        m_correct_xz.push_back(correct_xz);
+    }
+
+    m_surface_y.resize(m_players.size());
+    m_surface_found.resize(m_players.size());
+}
+
+void AM::PlayerPhysics::m_step(float dt, float gravity, float cam_height) {
+    const size_t count = m_players.size();
+    for(size_t i = 0; i < count; i++) {
+        if(!m_surface_found[i]) {
+            continue; // Chunk is not generated yet, keep the player where it is.
+        }
+
+        const float ground_y = m_surface_y[i] + cam_height;
+
+        if(m_on_ground[i]) {
+            if((m_pos_y[i] - ground_y) <= AM::PHYSICS_GROUND_SNAP_DISTANCE) {
+                m_pos_y[i] = ground_y;
+                m_vel_y[i] = 0.0f;
+                continue;
+            }
+            m_on_ground[i] = 0; // Walked off from a ledge.
+        }
+
+        m_vel_y[i] -= gravity * dt;
+        m_pos_y[i] += m_vel_y[i] * dt;
+
+        if(m_pos_y[i] < ground_y) {
+            m_pos_y[i] = ground_y;
+            m_vel_y[i] = 0.0f;
+            m_on_ground[i] = 1;
+        }
+    }
+}
+
+void AM::PlayerPhysics::m_scatter(AM::Server* server) {
+    const float tolerance = server->config.player_position_tolerance;
+
+    for(size_t i = 0; i < m_players.size(); i++) {
+        AM::Player* player = m_players[i];
+        const AM::Vec3 position = AM::Vec3(m_pos_x[i], m_pos_y[i], m_pos_z[i]);
+
+        player->apply_physics(position, m_vel_y[i], m_surface_y[i], m_on_ground[i]);
+
+        if(m_correct_xz[i]) {
+            player->set_next_position_XYZ(position);
+        }
+        else
+        if(m_has_client_y[i] && (fabsf(m_client_y[i] - m_pos_y[i]) > tolerance)) {
+            player->set_next_position_Y(m_pos_y[i]);
+        }
+    }
+}
+
+
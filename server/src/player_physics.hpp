@@ -0,0 +1,64 @@
+#ifndef AMBIENT3D_SERVER_PLAYER_PHYSICS_HPP
+#define AMBIENT3D_SERVER_PLAYER_PHYSICS_HPP
+
+#include <vector>
+#include <cstdint>
+
+
+// Server side player physics.
+//
+// Clients still move themselves on the XZ plane and report the position
+// but the server validates it and owns the vertical movement (gravity, jumping, ground).
+// When the client position is not accepted the player is told
+// to move back with 'AM::Player::set_next_position_*'
+//
+// All players are copied into flat arrays once per tick,
+// stepped with a fixed time step and then written back.
+
+namespace AM {
+    class Server;
+    class Player;
+
+    // Fixed time step. Server tick is longer so one tick usually runs few steps.
+    static constexpr float PHYSICS_STEP_MS = 1000.0f / 60.0f;
+
+    // Limits the steps per tick if the server falls behind
+    // so it doesnt get even slower trying to catch up.
+    static constexpr int   PHYSICS_MAX_STEPS_PER_TICK = 8;
+
+    // Players on ground follow the terrain down slopes
+    // unless the ground drops more than this in one step.
+    static constexpr float PHYSICS_GROUND_SNAP_DISTANCE = 1.0f;
+
+    class PlayerPhysics {
+        public:
+
+            // Called from the update thread once per tick.
+            // 'tick_ms' is the time passed since the previous call.
+            void update(AM::Server* server, float tick_ms);
+
+        private:
+
+            float m_step_accumulator_ms { 0.0f };
+
+            std::vector<AM::Player*> m_players;
+            std::vector<float>       m_pos_x;
+            std::vector<float>       m_pos_y;
+            std::vector<float>       m_pos_z;
+            std::vector<float>       m_vel_y;
+            std::vector<float>       m_surface_y;
+            std::vector<float>       m_client_y;
+            std::vector<uint8_t>     m_surface_found;
+            std::vector<uint8_t>     m_on_ground;
+            std::vector<uint8_t>     m_has_client_y;
+            std::vector<uint8_t>     m_correct_xz;
+
+            void m_gather(AM::Server* server, float tick_ms);
+            void m_step(float dt, float gravity, float cam_height);
+            void m_scatter(AM::Server* server);
+    };
+
+};
+
+
+#endif
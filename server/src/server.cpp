@@ -11,6 +11,7 @@
 
 #include "server.hpp"
 #include "math_functions.hpp"
+#include "shared/include/logger.hpp"
 
 
 AM::Server::Server(asio::io_context& context, const AM::ServerCFG& cfg) :
@@ -34,14 +35,14 @@ AM::Server::~Server() {
         player->free_memory();
     }
 
-    printf("Server closed.\n");
+    AM::log_info("Server closed.\n");
 }
 
 void AM::Server::m_read_terrain_config() {
-    printf("Reading terrain config.\n");
+    AM::log_info("Reading terrain config.\n");
     std::fstream stream(this->config.terrain_config_path);
     if(!stream.is_open()) {
-        fprintf(stderr, "ERROR! %s: Failed to open server terrain configuration file (%s)\n",
+        AM::log_error("ERROR! %s: Failed to open server terrain configuration file (%s)\n",
                 __func__, this->config.terrain_config_path.c_str());
         return;
     }
@@ -124,7 +125,7 @@ void AM::Server::start(asio::io_context& io_context) {
 void AM::Server::remove_player(int player_id) {
     const auto search = this->players.find(player_id);
     if(search == this->players.end()) {
-        fprintf(stderr, "ERROR! %s: Trying to remove player id (%i). But it doesnt exist.\n",
+        AM::log_error("ERROR! %s: Trying to remove player id (%i). But it doesnt exist.\n",
                 __func__, player_id);
         return;
     }
@@ -147,7 +148,7 @@ void AM::Server::m_do_accept_TCP() {
     m_tcp_acceptor.async_accept(
             [this](std::error_code ec, tcp::socket socket) {
                 if(ec) {
-                    printf("[accept](%i): %s\n", ec.value(), ec.message().c_str());
+                    AM::log_info("[accept](%i): %s\n", ec.value(), ec.message().c_str());
                 
                     m_do_accept_TCP();
                     return;
@@ -172,7 +173,7 @@ void AM::Server::m_do_accept_TCP() {
                 player->tcp_session->packet.write<int>({ player_id });
                 player->tcp_session->send_packet();
 
-                printf("[SERVER]: Player(%i) has been prepared.\n", player_id);
+                AM::log_info("[SERVER]: Player(%i) has been prepared.\n", player_id);
 
                 m_do_accept_TCP();
             });
@@ -181,7 +182,7 @@ void AM::Server::m_do_accept_TCP() {
 AM::Player* AM::Server::get_player_by_id(int player_id) {
     const auto search = this->players.find(player_id);
     if(search == this->players.end()) {
-        fprintf(stderr, "ERROR! No player found with ID: %i\n", player_id);
+        AM::log_error("ERROR! No player found with ID: %i\n", player_id);
         return NULL;
     }
 
@@ -264,7 +265,6 @@ void AM::Server::m_send_player_updates() {
             continue;
         }
 
-        player->update();
         m_send_player_position(player);
         m_send_player_weather_data(player);
 
@@ -369,31 +369,36 @@ void AM::Server::m_send_player_chunk_updates() {
         m_chunkdata_buf.clear();
 
         AM::Vec3 player_pos = player->position();
+        const int area_half = player->tcp_session->config.render_distance / 2;
 
-        this->terrain.foreach_chunk_nearby(player_pos.x, player_pos.z,
-        player->tcp_session->config.render_distance,
+        // Client keeps the chunks until they are 'CHUNK_UNLOAD_MARGIN' chunks further away
+        // so they are remembered as loaded that far too.
+        std::lock_guard<std::mutex> lock(player->loaded_chunks_mutex);
+        if(player->loaded_chunks.radius() != area_half + AM::CHUNK_UNLOAD_MARGIN) {
+            player->loaded_chunks.resize(area_half + AM::CHUNK_UNLOAD_MARGIN);
+        }
+        player->loaded_chunks.set_center(this->terrain.get_chunk_pos(player_pos.x, player_pos.z));
+
+        player->loaded_chunks.foreach_missing(area_half,
         [this, &num_chunks, &height_points_sizeb, &chunk_positions, player]
-        (const AM::Chunk* chunk, const AM::ChunkPos& chunk_pos) {
+        (const AM::ChunkPos& chunk_pos) {
         
             // Packets may be broken into few little bit smaller packets.
             if(m_chunkdata_buf.size_inbytes() >= AM::MAX_PACKET_SIZE) {
                 return; // TODO: return bool to continue loop or break.
             }
 
-            if(!chunk) {
-                return;
-            }
-        
-            if(player->loaded_chunks.find(chunk_pos)
-                    != player->loaded_chunks.end()) {
-                return; // Player has already received this chunk.
+            auto chunk_it = this->terrain.chunk_map.find(chunk_pos);
+            if(chunk_it == this->terrain.chunk_map.end()) {
+                return; // Not generated yet.
             }
+            const AM::Chunk* chunk = &chunk_it->second;
 
             m_chunkdata_buf.write_bytes((void*)&chunk_pos.x, sizeof(chunk_pos.x));
             m_chunkdata_buf.write_bytes((void*)&chunk_pos.z, sizeof(chunk_pos.z));
             m_chunkdata_buf.write_bytes((void*)chunk->height_points, height_points_sizeb);
 
-            player->loaded_chunks.insert(std::make_pair(chunk_pos, true));
+            player->loaded_chunks.insert(chunk_pos);
             chunk_positions.push_back(chunk_pos);
 
             num_chunks++;
@@ -413,7 +418,7 @@ void AM::Server::m_send_player_chunk_updates() {
                     m_chunkdata_buf.size_inbytes(),   // Source size.
                     AM::MAX_PACKET_SIZE);             // Destination max size.
         if(compressed_size <= 0) {
-            fprintf(stderr, "ERROR! %s: Failed to compress chunk data. (client will not receive an update)\n",
+            AM::log_error("ERROR! %s: Failed to compress chunk data. (client will not receive an update)\n",
                     __func__);
             
             // Remove "loaded" chunks that were marked as written.
@@ -425,7 +430,7 @@ void AM::Server::m_send_player_chunk_updates() {
             continue;
         }
 
-        printf("[CHUNK_UPDATE] (Uncompressed %0.2fkB) -> (Compressed %0.2fkB) to player_id: %i\n",
+        AM::log_info("[CHUNK_UPDATE] (Uncompressed %0.2fkB) -> (Compressed %0.2fkB) to player_id: %i\n",
                 (float)m_chunkdata_buf.size_inbytes() / 1000.0f,
                 (float)compressed_size / 1000.0f, 
                 player->id());
@@ -465,6 +470,7 @@ void AM::Server::m_update_loop_th__func() {
 
         m_process_resend_id_queue();
         m_send_player_chunk_updates();
+        m_player_physics.update(this, m_prev_tick_ms);
         m_send_player_updates();
         m_send_item_updates();
         m_send_player_itemuuid_unloads();
@@ -481,7 +487,8 @@ void AM::Server::m_update_loop_th__func() {
         }
 
         m_tick_timer.stop();
-        m_update_timeofday(m_tick_timer.delta_time_ms());
+        m_prev_tick_ms = m_tick_timer.delta_time_ms();
+        m_update_timeofday(m_prev_tick_ms);
         //m_update_timeofday(delta_time_ms + (this->config.tick_delay_ms - delta_time_ms));
     }
 }
@@ -535,8 +542,8 @@ void AM::Server::m_userinput_handler_th__func() {
         }
         else
         if(input == "clear") {
-            printf("\033[2J\033[H");
-            fflush(stdout);
+            AM::log_info("\033[2J\033[H");
+            AM::log_flush();
         }
         else
         if(input == "spawn_item") {
@@ -545,17 +552,19 @@ void AM::Server::m_userinput_handler_th__func() {
         else 
         if(input == "show_debug") {
             this->show_debug_info = true;
+            AM::set_log_level(AM::LL_DEBUG);
         }
         else
         if(input == "hide_debug") {
             this->show_debug_info = false;
+            AM::set_log_level(AM::LL_INFO);
         }
         else
         if(input == "online") {
-            printf("Online players: %li\n", this->players.size());
+            AM::log_info("Online players: %li\n", this->players.size());
         }
         else {
-            printf(" Unknown command.\n");
+            AM::log_info(" Unknown command.\n");
         }
 
     }
@@ -568,7 +577,7 @@ void AM::Server::m_userinput_handler_th__func() {
 bool AM::Server::m_parse_item_list(const std::string& item_list_path) {
     std::fstream item_list_stream(item_list_path);
     if(!item_list_stream.is_open()) {
-        fprintf(stderr, "ERROR! %s: Failed to open item list (%s)\n",
+        AM::log_error("ERROR! %s: Failed to open item list (%s)\n",
                 __func__, item_list_path);
         return false;
     }
@@ -598,7 +607,7 @@ void AM::Server::load_item_template(const char* entry_name, AM::ItemID item_id)
 // TODO: Probably good idea to move chunk generation to server side.
 void AM::Server::spawn_item(AM::ItemID item_id, int count, const Vec3& pos) {
     if(item_id >= AM::ItemID::NUM_ITEMS) {
-        fprintf(stderr, "ERROR! %s: Invalid item_id\n", __func__);
+        AM::log_error("ERROR! %s: Invalid item_id\n", __func__);
         return;
     }
     
@@ -607,7 +616,7 @@ void AM::Server::spawn_item(AM::ItemID item_id, int count, const Vec3& pos) {
     int item_uuid = std::rand();
     auto itembase = this->dropped_items.insert({ item_uuid, this->item_templates[item_id] }).first;
     if(itembase == this->dropped_items.end()) {
-        fprintf(stderr, "ERROR! %s: Failed to insert item into dropped_items (unordered_map). "
+        AM::log_error("ERROR! %s: Failed to insert item into dropped_items (unordered_map). "
                 "UUID may already exist??\n",
                 __func__);
         return;
@@ -618,7 +627,7 @@ void AM::Server::spawn_item(AM::ItemID item_id, int count, const Vec3& pos) {
     itembase->second.pos_z = pos.z;
     itembase->second.uuid = item_uuid;
     
-    printf("%s -> \"%s\" XYZ = (%0.1f, %0.1f, %0.1f) UUID = %i\n", 
+    AM::log_info("%s -> \"%s\" XYZ = (%0.1f, %0.1f, %0.1f) UUID = %i\n", 
             __func__, 
             itembase->second.entry_name,
             pos.x,
@@ -16,6 +16,7 @@
 
 #include "udp_handler.hpp"
 #include "player.hpp"
+#include "player_physics.hpp"
 #include "terrain/terrain.hpp"
 #include "terrain/chunk_data.hpp"
 #include "timer.hpp"
@@ -96,6 +97,9 @@ namespace AM {
             AM::Timer    m_update_timer; // Measures time how long update took for the tick.
             AM::Timer    m_tick_timer;   // Measures how long the tick was.
 
+            AM::PlayerPhysics m_player_physics;
+            float             m_prev_tick_ms { 0.0f };
+
 
             // When server wants to unload dropped item.
             // It will call void unload_dropped_item(int item_uuid);
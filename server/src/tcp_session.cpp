@@ -7,6 +7,7 @@
 
 #include "shared/include/packet_ids.hpp"
 #include "shared/include/packet_parser.hpp"
+#include "shared/include/logger.hpp"
 
 
 
@@ -32,11 +33,7 @@ void AM::TCP_session::m_handle_received_packet(size_t sizeb) {
     AM::PacketID packet_id = AM::parse_network_packet(m_data, sizeb);
 
     if(m_server->show_debug_info) {
-        printf("[TCP] (PacketID=%i) -> ", packet_id);
-        for(size_t i = 0; i < sizeb; i++) {
-            printf("0x%x, ", m_data[i]);
-        }
-        printf("\n");
+        AM::log_debug("[TCP] (PacketID=%i) -> %s\n", packet_id, AM::LogBytes{ m_data, sizeb });
     }
 
     switch(packet_id) {
@@ -44,7 +41,7 @@ void AM::TCP_session::m_handle_received_packet(size_t sizeb) {
             {
                 if(sizeb == 0) { return; }
                 if(sizeb > 512) {
-                    fprintf(stderr, "[CHAT_WARNING]: Ignored %li long message.\n", sizeb);
+                    AM::log_warning("[CHAT_WARNING]: Ignored %li long message.\n", sizeb);
                     return;
                 }
 
@@ -56,7 +53,7 @@ void AM::TCP_session::m_handle_received_packet(size_t sizeb) {
                     }
                 }
 
-                printf("[CHAT(%li)]: %s\n", sizeb, m_data);
+                AM::log_info("[CHAT(%li)]: %s\n", sizeb, m_data);
                 m_server->broadcast_msg(AM::PacketID::CHAT_MESSAGE, m_data);
             }
             break;
@@ -83,7 +80,7 @@ void AM::TCP_session::m_handle_received_packet(size_t sizeb) {
 
         case AM::PacketID::CLIENT_CONFIG:
             {
-                printf("[NETWORK]: Received client config:\n%s\n", m_data);
+                AM::log_info("[NETWORK]: Received client config:\n%s\n", m_data);
                 this->config.parse_from_memory(json::parse(m_data));
                 this->packet.prepare(AM::PacketID::TIMEOFDAY_SYNC);
                 this->packet.write<float>({ m_server->timeofday });
@@ -94,7 +91,7 @@ void AM::TCP_session::m_handle_received_packet(size_t sizeb) {
         case AM::PacketID::PLAYER_FULLY_CONNECTED:
             {
                 m_fully_connected = true;
-                printf("Player connected. (ID: %i)\n", this->player_id);
+                AM::log_info("Player connected. (ID: %i)\n", this->player_id);
             }
             break;
 
@@ -103,7 +100,7 @@ void AM::TCP_session::m_handle_received_packet(size_t sizeb) {
                 return;
             }
             if(sizeb < AM::PacketSize::PLAYER_UNLOADED_CHUNKS_MIN) {
-                fprintf(stderr, "ERROR! Unexpected packet size for: "
+                AM::log_error("ERROR! Unexpected packet size for: "
                         "PLAYER_UNLOADED_CHUNKS (Got: %li bytes)\n",
                         sizeb);
                 return;
@@ -116,12 +113,13 @@ void AM::TCP_session::m_handle_received_packet(size_t sizeb) {
                     
                 AM::Player* player = m_server->get_player_by_id(this->player_id);
                 if(!player) {
-                    fprintf(stderr, "[NETWORK](PLAYER_UNLOADED_CHUNKS):"
+                    AM::log_error("[NETWORK](PLAYER_UNLOADED_CHUNKS):"
                             " Cant find player with ID = %i\n", this->player_id);
                     return;
                 }
 
                 int num_chunks = 0;
+                std::lock_guard<std::mutex> lock(player->loaded_chunks_mutex);
 
                 while(byte_offset < sizeb) {
                     memmove(&chunk_x, &m_data[byte_offset], sizeof(int));
@@ -130,29 +128,29 @@ void AM::TCP_session::m_handle_received_packet(size_t sizeb) {
                     memmove(&chunk_z, &m_data[byte_offset], sizeof(int));
                     byte_offset += sizeof(int);
 
-                    auto chunk_search = player->loaded_chunks.find(AM::ChunkPos(chunk_x, chunk_z));
-                    if(chunk_search == player->loaded_chunks.end()) {
+                    const AM::ChunkPos chunk_pos(chunk_x, chunk_z);
+                    if(!player->loaded_chunks.contains(chunk_pos)) {
                         continue;
                     }
 
                     num_chunks++;
-                    player->loaded_chunks.erase(chunk_search);
+                    player->loaded_chunks.erase(chunk_pos);
                 }
 
-                printf("Unloaded %i chunks for player: %i\n", num_chunks, this->player_id);
+                AM::log_info("Unloaded %i chunks for player: %i\n", num_chunks, this->player_id);
             }
             break;
 
         case AM::PacketID::PLAYER_PICKUP_ITEM:
             if(sizeb != AM::PacketSize::PLAYER_PICKUP_ITEM) {
-                fprintf(stderr, "[NETWORK] Unexpected packet size for: "
+                AM::log_error("[NETWORK] Unexpected packet size for: "
                         "PLAYER_PICKUP_ITEM (Got: %li bytes)\n", sizeb);
                 return;
             }
             {
                 AM::Player* player = m_server->get_player_by_id(this->player_id);
                 if(!player) {
-                    fprintf(stderr, "[NETWORK](PLAYER_PICKUP_ITEM):"
+                    AM::log_error("[NETWORK](PLAYER_PICKUP_ITEM):"
                             " Cant find player with ID = %i\n", this->player_id);
                     return;
                 }
@@ -164,7 +162,7 @@ void AM::TCP_session::m_handle_received_packet(size_t sizeb) {
 
                 auto item_search = m_server->dropped_items.find(item_uuid);
                 if(item_search == m_server->dropped_items.end()) {
-                    fprintf(stderr, "[NETWORK](PLAYER_PICKUP_ITEM): "
+                    AM::log_error("[NETWORK](PLAYER_PICKUP_ITEM): "
                             "Cant find item with uuid %i\n", item_uuid);
                     return;
                 }
@@ -177,7 +175,7 @@ void AM::TCP_session::m_handle_received_packet(size_t sizeb) {
                 m_server->unload_dropped_item(itembase.uuid);
                 //m_server->dropped_items.erase(item_search);
                 
-                printf("PLAYER_PICKUP_ITEM %s\n", itembase.display_name);
+                AM::log_info("PLAYER_PICKUP_ITEM %s\n", itembase.display_name);
             }
             break;
 
@@ -193,7 +191,7 @@ void AM::TCP_session::m_do_read() {
     m_socket.async_read_some(asio::buffer(m_data, AM::MAX_PACKET_SIZE),
             [this, self](std::error_code ec, std::size_t size) {
                 if(ec) {
-                    printf("[read_tcp](%i): %s\n", ec.value(), ec.message().c_str());
+                    AM::log_info("[read_tcp](%i): %s\n", ec.value(), ec.message().c_str());
                     m_server->remove_player(self->player_id);
                 }
                 else {
@@ -214,7 +212,7 @@ void AM::TCP_session::send_packet() {
     asio::async_write(m_socket, asio::buffer(this->packet.data, this->packet.size),
             [this, self](std::error_code ec, std::size_t /*size*/) {
                 if(ec) {
-                    printf("[write_tcp](%i): %s\n", ec.value(), ec.message().c_str());
+                    AM::log_info("[write_tcp](%i): %s\n", ec.value(), ec.message().c_str());
                     m_server->remove_player(self->player_id);
                     return;
                 }
@@ -2,6 +2,7 @@
 
 #include "chunk.hpp"
 #include "shared/include/perlin_noise.hpp"
+#include "shared/include/logger.hpp"
 
 
 void AM::Chunk::generate(
@@ -44,7 +45,7 @@ float AM::Chunk::get_height_at(const AM::iVec2& local_coords) {
 
 bool AM::Chunk::unload() {
     if(!m_loaded) {
-        fprintf(stderr, "ERROR! Trying to unload not loaded chunk.\n");
+        AM::log_error("ERROR! Trying to unload not loaded chunk.\n");
         return false;
     }
 
@@ -2,6 +2,7 @@
 #include <cstdio>
 
 #include "chunk_data.hpp"
+#include "shared/include/logger.hpp"
 
 
 void AM::ChunkData::clear() {
@@ -13,11 +14,11 @@ void AM::ChunkData::clear() {
 
 void AM::ChunkData::write_bytes(void* bytes, size_t sizeb) {
     if(!data) { 
-        printf("ERROR! %s: No memory allocated for ChunkData?\n", __func__);
+        AM::log_error("ERROR! %s: No memory allocated for ChunkData?\n", __func__);
         return;
     }
     if((m_data_sizeb + sizeb) >= m_memsizeb) {
-        fprintf(stderr, "ERROR! %s: Trying to write too much chunk data!\n",
+        AM::log_error("ERROR! %s: Trying to write too much chunk data!\n",
                 __func__);
         return;
     }
@@ -2,14 +2,15 @@
 #include <cmath>
 
 #include "terrain.hpp"
-#include "shared/include/ray.hpp"
+#include "shared/include/terrain_height.hpp"
 #include "../server.hpp"
+#include "shared/include/logger.hpp"
 
 
 void AM::Terrain::add_chunk(const AM::Chunk& chunk) {
     auto inserted = this->chunk_map.insert(std::make_pair(chunk.pos, chunk)).first;
     if(inserted == this->chunk_map.end()) {
-        fprintf(stderr, "ERROR! %s: Failed to add chunk (X=%i, Z=%i)\n",
+        AM::log_error("ERROR! %s: Failed to add chunk (X=%i, Z=%i)\n",
                 __func__, chunk.pos.x, chunk.pos.z);
         this->chunk_map_mutex.unlock();
         return;
@@ -32,7 +33,7 @@ void AM::Terrain::delete_terrain() {
         num_unloaded++;
     }
 
-    printf("[WORLD_GEN]: Unloaded %li chunks\n", num_unloaded);
+    AM::log_info("[WORLD_GEN]: Unloaded %li chunks\n", num_unloaded);
 }
 
 AM::ChunkPos AM::Terrain::get_chunk_pos(float world_x, float world_z) {
@@ -86,59 +87,65 @@ AM::Rect AM::Terrain::get_chunk_meshrect(float world_x, float world_z, AM::iVec2
     // This could be optimized to save memory because only 4 vertices are needed, 
     // 2 of them are shared between the 2 triangles.
     // It will waste some memory for now because it feels more easy.
+    //
+    // The triangles are split the same way as the chunk mesh (see terrain_height.hpp)
 
     return AM::Rect(
                 AM::Triangle(
                     vertex_A,
-                    vertex_B,
-                    vertex_C
+                    vertex_D,
+                    vertex_B
                 ),
                 AM::Triangle(
+                    vertex_B,
                     vertex_D,
-                    vertex_A,
                     vertex_C
                 )   
             );
 }
 
 float AM::Terrain::get_surface_level(const AM::Vec3& world_pos) {
-    
-    AM::Ray ray(
-            world_pos + AM::Vec3(0.0f, 10.0f, 0.0f), // Ray origin
-            AM::Vec3(0.0f, -1.0f, 0.0f));            // Ray direction
-
-    AM::RayHitResult hit_result = {};
-    AM::Rect rect = {};
-
-    // Check the most likely hit first.
-    rect = this->get_chunk_meshrect(world_pos.x, world_pos.z, AM::iVec2(0, 0));
-    hit_result = ray.rectangle_intersection(rect);
-   
-    if(!hit_result.hit) {
-        // The rectangle was not hit under the player, search bigger area.
-        // Resulting search area will be (AREA_HALF*2) * (AREA_HALF*2)
-        constexpr int AREA_HALF = 1;
-
-        for(int z = -AREA_HALF; z <= AREA_HALF; z++) {
-            for(int x = -AREA_HALF; x <= AREA_HALF; x++) {
-                rect = this->get_chunk_meshrect(world_pos.x, world_pos.z, AM::iVec2(x, z));
-                
-                hit_result = ray.triangle_intersection(rect.tA);
-                if(hit_result.hit) {
-                    goto loop_exit;
-                }
-
-                hit_result = ray.triangle_intersection(rect.tB);
-                if(hit_result.hit) {
-                    goto loop_exit;
-                }
-            }
-        }
+    const int chunk_size = m_server->config.chunk_size;
+    const AM::TerrainHeight::GridPoint point 
+        = AM::TerrainHeight::world_to_grid(world_pos.x, world_pos.z, chunk_size, m_server->config.chunk_scale);
+
+    auto chunk_search = this->chunk_map.find(point.chunk_pos);
+    if(chunk_search == this->chunk_map.end() || !chunk_search->second.height_points) {
+        return 0.0f;
     }
 
-loop_exit:
+    return AM::TerrainHeight::sample(chunk_search->second.height_points, chunk_size, point.local_x, point.local_z);
+}
 
-    return hit_result.point.y;
+void AM::Terrain::get_surface_levels(const float* world_x, const float* world_z, size_t count,
+        float* levels_out, uint8_t* found_out) {
+    const int   chunk_size = m_server->config.chunk_size;
+    const float chunk_scale = m_server->config.chunk_scale;
+
+    // Positions near each other are likely in the same chunk
+    // so the previous chunk is checked before doing a new lookup.
+    AM::ChunkPos prev_chunk_pos(0, 0);
+    const float* heights = NULL;
+    bool has_prev = false;
+
+    for(size_t i = 0; i < count; i++) {
+        const AM::TerrainHeight::GridPoint point 
+            = AM::TerrainHeight::world_to_grid(world_x[i], world_z[i], chunk_size, chunk_scale);
+
+        if(!has_prev || !(point.chunk_pos == prev_chunk_pos)) {
+            auto chunk_search = this->chunk_map.find(point.chunk_pos);
+            heights = (chunk_search != this->chunk_map.end()) ? chunk_search->second.height_points : NULL;
+            prev_chunk_pos = point.chunk_pos;
+            has_prev = true;
+        }
+
+        levels_out[i] = heights
+            ? AM::TerrainHeight::sample(heights, chunk_size, point.local_x, point.local_z)
+            : 0.0f;
+        if(found_out) {
+            found_out[i] = (heights != NULL);
+        }
+    }
 }
 
 
@@ -148,7 +155,7 @@ void AM::Terrain::foreach_chunk_nearby(float world_x, float world_z, int distanc
     AM::ChunkPos origin_chunk_pos = this->get_chunk_pos(world_x, world_z);
 
     /*
-    printf("%s: (%i, %i)\n",
+    AM::log_info("%s: (%i, %i)\n",
             __func__, origin_chunk_pos.x, origin_chunk_pos.z);
     */
 
@@ -6,6 +6,7 @@
 #include <functional>
 
 #include "chunk.hpp"
+#include "shared/include/chunk_map.hpp"
 #include "shared/include/ivec2.hpp"
 #include "shared/include/geometry/rect.hpp"
 
@@ -17,7 +18,7 @@ namespace AM {
     class Terrain {
         public:
             std::mutex                                  chunk_map_mutex;
-            std::unordered_map<AM::ChunkPos, AM::Chunk> chunk_map;
+            AM::ChunkMap<AM::Chunk>                     chunk_map;
             
             AM::NoiseGen noise_gen;
 
@@ -31,6 +32,12 @@ namespace AM {
             AM::Vec3     get_chunk_vertex    (float world_x, float world_z, AM::iVec2 offset = {});
             float        get_surface_level   (const AM::Vec3& world_pos);
 
+            // Same as 'get_surface_level' for 'count' positions.
+            // Levels are 0.0 where the chunk is not generated.
+            // If 'found_out' is not NULL it is set to 1 for levels that came from a chunk and 0 otherwise.
+            void         get_surface_levels  (const float* world_x, const float* world_z, size_t count,
+                                              float* levels_out, uint8_t* found_out = NULL);
+
             // Returns X and Y in range of 0 to chunk size
             AM::iVec2 get_chunk_local_coords(float world_x, float world_z); 
 
@@ -4,24 +4,21 @@
 #include "udp_handler.hpp"
 #include "shared/include/packet_ids.hpp"
 #include "shared/include/packet_parser.hpp"
+#include "shared/include/logger.hpp"
 
 
 void AM::UDP_handler::m_handle_received_packet(size_t sizeb) {
     AM::PacketID packet_id = AM::parse_network_packet(m_data, sizeb);
 
     if(m_server->show_debug_info) {
-        printf("[UDP] (PacketID=%i) -> ", packet_id);
-        for(size_t i = 0; i < sizeb; i++) {
-            printf("0x%x, ", m_data[i]);
-        }
-        printf("\n");
+        AM::log_debug("[UDP] (PacketID=%i) -> %s\n", packet_id, AM::LogBytes{ m_data, sizeb });
     }
 
     switch(packet_id) {
 
         case AM::PacketID::PLAYER_ID:
             if(sizeb != AM::PacketSize::PLAYER_ID) {
-                fprintf(stderr, "ERROR! Unexpected packet size for: "
+                AM::log_error("ERROR! Unexpected packet size for: "
                         "PLAYER_ID (Got: %li bytes)\n", sizeb);
                 return;
             }
@@ -41,14 +38,14 @@ void AM::UDP_handler::m_handle_received_packet(size_t sizeb) {
 
                 player->tcp_session->packet.prepare(AM::PacketID::PLAYER_ID_HAS_BEEN_SAVED);
                 player->tcp_session->send_packet();
-                printf("[NETWORK]: PlayerID(%i) has been saved.\n", player_id);
+                AM::log_info("[NETWORK]: PlayerID(%i) has been saved.\n", player_id);
             
             }
             break;
 
         case AM::PacketID::PLAYER_MOVEMENT_AND_CAMERA:
             if(sizeb != AM::PacketSize::PLAYER_MOVEMENT_AND_CAMERA) {
-                fprintf(stderr, "ERROR! Unexpected packet size for: "
+                AM::log_error("ERROR! Unexpected packet size for: "
                         "PLAYER_MOVEMENT_AND_CAMERA (Got: %li bytes)\n",
                         sizeb);
                 return;
@@ -81,7 +78,7 @@ void AM::UDP_handler::m_handle_received_packet(size_t sizeb) {
                 memmove(&cam_pitch, m_data+offset, sizeof(float));
                 //offset += sizeof(float);
             
-                player->set_position(position);
+                player->set_client_position(position);
                 player->set_cam_yaw(cam_yaw);
                 player->set_cam_pitch(cam_pitch);
                 player->set_animation_id(anim_id);
@@ -90,7 +87,7 @@ void AM::UDP_handler::m_handle_received_packet(size_t sizeb) {
 
         case AM::PacketID::PLAYER_JUMP:
             if(sizeb != AM::PacketSize::PLAYER_JUMP) {
-                fprintf(stderr, "ERROR! Unexpected packet size for: "
+                AM::log_error("ERROR! Unexpected packet size for: "
                         "PLAYER_MOVEMENT_AND_CAMERA (Got: %li bytes)\n",
                         sizeb);
                 return;
@@ -104,8 +101,7 @@ void AM::UDP_handler::m_handle_received_packet(size_t sizeb) {
                     return;
                 }
 
-                player->on_ground = false;
-                player->set_position(player->position() + AM::Vec3(0.0f, 1.0f, 0.0f));
+                player->request_jump();
             }
             break;
     }
@@ -119,7 +115,7 @@ void AM::UDP_handler::m_do_read() {
             asio::buffer(m_data, AM::MAX_PACKET_SIZE), m_sender_endpoint,
             [this](std::error_code ec, std::size_t size) {
                 if(ec) {
-                    printf("[read_udp](%i): %s\n", ec.value(), ec.message().c_str());
+                    AM::log_info("[read_udp](%i): %s\n", ec.value(), ec.message().c_str());
                 }
                 else {
                     m_handle_received_packet(size);
@@ -137,7 +133,7 @@ void AM::UDP_handler::send_packet(int player_id) {
 
     const auto endpoint = m_recv_endpoints.find(player_id);
     if(endpoint == m_recv_endpoints.end()) {
-        fprintf(stderr, "ERROR! No UDP endpoint was found for player id (%i)\n",
+        AM::log_error("ERROR! No UDP endpoint was found for player id (%i)\n",
                 player_id);
 
         // Add player id to queue for trying to send player id to client again
@@ -151,7 +147,7 @@ void AM::UDP_handler::send_packet(int player_id) {
             asio::buffer(this->packet.data, this->packet.size), endpoint->second,
             [this](std::error_code ec, std::size_t size) {
                 if(ec) {
-                    printf("[write_udp](%i): %s\n", ec.value(), ec.message().c_str());
+                    AM::log_info("[write_udp](%i): %s\n", ec.value(), ec.message().c_str());
                     return;
                 }
             });
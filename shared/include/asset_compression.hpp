@@ -0,0 +1,62 @@
+#ifndef AMBIENT3D_ASSET_COMPRESSION_HPP
+#define AMBIENT3D_ASSET_COMPRESSION_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstddef>
+
+
+// Asset files can be sent compressed.
+// The assets server compresses them once into a cache directory
+// and the client decompresses while writing the file.
+//
+// Encodings:
+//  "none"  : Raw file.
+//  "lz4hc" : LZ4 frame compressed with LZ4 HC. 
+//            Fast to decompress and fine for models. (Textures are usually compressed already)
+
+namespace AM {
+
+    static constexpr const char* ASSET_ENCODING_NONE = "none";
+    static constexpr const char* ASSET_ENCODING_LZ4HC = "lz4hc";
+
+    // Compressed file must be smaller than this much of the original
+    // or it is not worth decompressing.
+    static constexpr float ASSET_COMPRESSION_MIN_SAVING = 0.05f;
+
+    // Writes the compressed file to 'dst_filepath'.
+    // 'level' is LZ4 HC compression level (3 - 12).
+    // Returns false if the file could not be compressed.
+    bool compress_asset_file(const std::string& src_filepath, const std::string& dst_filepath, int level);
+
+    // Decompresses bytes given in any size of pieces into a file.
+    class AssetFileDecoder {
+        public:
+            AssetFileDecoder();
+            ~AssetFileDecoder();
+
+            AssetFileDecoder(const AssetFileDecoder&) = delete;
+            AssetFileDecoder& operator=(const AssetFileDecoder&) = delete;
+
+            // Returns false if the encoding is not supported.
+            bool begin(const std::string& encoding);
+
+            // Returns false if the data is not valid.
+            bool write(std::ofstream& out, const char* data, size_t size);
+
+            // True when the end of the compressed data has been received.
+            bool complete() const { return m_complete; }
+
+        private:
+            void*             m_dctx { NULL };
+            bool              m_complete { false };
+            std::vector<char> m_buffer;
+    };
+
+};
+
+
+
+
+#endif
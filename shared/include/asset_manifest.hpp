@@ -0,0 +1,62 @@
+#ifndef AMBIENT3D_ASSET_MANIFEST_HPP
+#define AMBIENT3D_ASSET_MANIFEST_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+// Binary list of asset files and their hashes which the client sends to the assets server.
+// (see AM::PacketID::CLIENT_GAMEASSET_FILE_HASHES)
+//
+// Entries are sorted by the name hash so the server can compare
+// them to its own sorted files in one pass.
+
+namespace AM {
+
+    static constexpr size_t ASSET_DIGEST_SIZE = 32;
+
+    // Larger manifests are not accepted from clients.
+    static constexpr size_t MAX_ASSET_MANIFEST_ENTRIES = 1024 * 1024;
+
+    struct AssetManifestEntry {
+        uint64_t name_hash;
+        uint8_t  digest[ASSET_DIGEST_SIZE]; // sha256 of the file.
+    };
+    static_assert(sizeof(AssetManifestEntry) == sizeof(uint64_t) + ASSET_DIGEST_SIZE);
+
+    // FNV-1a 64 bit.
+    uint64_t asset_name_hash(const std::string& name);
+
+    // Converts sha256 hex string to bytes. Returns false if it is not valid.
+    // Bytes may be separated with '-' like compute_sha256_filehash writes them.
+    bool sha256_hex_to_digest(const std::string& hex, uint8_t* digest_out);
+
+    void sort_asset_manifest(std::vector<AM::AssetManifestEntry>* entries);
+
+
+    // Walks through 'a' and 'b' which are sorted by name hash.
+    // 'callback(a_index, b_entry)' is called for every entry in 'a'.
+    // 'b_entry' is the entry in 'b' with the same name hash or NULL.
+    template<typename T, typename GetHashA, typename Callback>
+    void merge_join_asset_manifest(
+            const std::vector<T>& a, GetHashA get_hash_a,
+            const AM::AssetManifestEntry* b, size_t b_count,
+            Callback callback) {
+        size_t j = 0;
+        for(size_t i = 0; i < a.size(); i++) {
+            const uint64_t hash = get_hash_a(a[i]);
+            while((j < b_count) && (b[j].name_hash < hash)) {
+                j++;
+            }
+            callback(i, ((j < b_count) && (b[j].name_hash == hash)) ? &b[j] : NULL);
+        }
+    }
+
+};
+
+
+
+
+#endif
@@ -0,0 +1,258 @@
+#ifndef AMBIENT3D_CHUNK_MAP_HPP
+#define AMBIENT3D_CHUNK_MAP_HPP
+
+#include <vector>
+#include <utility>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+#include "chunk_pos.hpp"
+
+
+namespace AM {
+
+    // Hash map for chunk positions.
+    // All entries are stored in one flat array (open addressing with linear probing)
+    // so looking up nearby chunks doesnt jump around in memory like std::unordered_map does.
+    //
+    // The interface is the same subset of std::unordered_map that the engine uses
+    // (find, insert, erase, operator[], iteration).
+    //
+    // IMPORTANT NOTE: Pointers and iterators are invalidated when new entries are inserted
+    //                 (the table may grow). Erasing doesnt move other entries.
+    //                 'T' must be default constructible.
+
+    template<typename T>
+    class ChunkMap {
+        public:
+            using value_type = std::pair<AM::ChunkPos, T>;
+
+            template<bool IS_CONST>
+            class Iterator {
+                public:
+                    using map_type = std::conditional_t<IS_CONST, const ChunkMap, ChunkMap>;
+                    using reference = std::conditional_t<IS_CONST, const value_type&, value_type&>;
+                    using pointer = std::conditional_t<IS_CONST, const value_type*, value_type*>;
+
+                    Iterator(){}
+                    Iterator(map_type* map, size_t index) : m_map(map), m_index(index) {}
+                    
+                    // Allow iterator -> const_iterator
+                    operator Iterator<true>() const requires(!IS_CONST) {
+                        return Iterator<true>(m_map, m_index);
+                    }
+
+                    reference operator*()  const { return m_map->m_slots[m_index]; }
+                    pointer   operator->() const { return &m_map->m_slots[m_index]; }
+
+                    Iterator& operator++() {
+                        m_index = m_map->m_next_used(m_index + 1);
+                        return *this;
+                    }
+
+                    bool operator==(const Iterator& rhs) const { return m_index == rhs.m_index; }
+                    bool operator!=(const Iterator& rhs) const { return m_index != rhs.m_index; }
+
+                private:
+                    friend class ChunkMap;
+                    map_type* m_map { NULL };
+                    size_t    m_index { 0 };
+            };
+
+            using iterator = Iterator<false>;
+            using const_iterator = Iterator<true>;
+
+            ChunkMap() {}
+
+            iterator        begin()       { return iterator(this, m_next_used(0)); }
+            iterator        end()         { return iterator(this, m_capacity); }
+            const_iterator  begin() const { return const_iterator(this, m_next_used(0)); }
+            const_iterator  end()   const { return const_iterator(this, m_capacity); }
+
+            size_t  size()  const { return m_size; }
+            bool    empty() const { return m_size == 0; }
+
+            iterator find(const AM::ChunkPos& pos) {
+                return iterator(this, m_find_index(pos));
+            }
+            
+            const_iterator find(const AM::ChunkPos& pos) const {
+                return const_iterator(this, m_find_index(pos));
+            }
+
+            bool contains(const AM::ChunkPos& pos) const {
+                return m_find_index(pos) != m_capacity;
+            }
+
+            // Existing value is not replaced.
+            // Returns iterator to the entry and true if it was inserted.
+            std::pair<iterator, bool> insert(const value_type& value) {
+                return m_insert(value.first, value.second);
+            }
+
+            std::pair<iterator, bool> insert(value_type&& value) {
+                return m_insert(value.first, std::move(value.second));
+            }
+
+            T& operator[](const AM::ChunkPos& pos) {
+                return m_insert(pos, T{}).first->second;
+            }
+
+            // Returns iterator to the next entry.
+            iterator erase(iterator it) {
+                m_erase_index(it.m_index);
+                return iterator(this, m_next_used(it.m_index + 1));
+            }
+
+            size_t erase(const AM::ChunkPos& pos) {
+                const size_t index = m_find_index(pos);
+                if(index == m_capacity) {
+                    return 0;
+                }
+                m_erase_index(index);
+                return 1;
+            }
+
+            void clear() {
+                m_slots.clear();
+                m_ctrl.clear();
+                m_capacity = 0;
+                m_size = 0;
+                m_num_deleted = 0;
+            }
+
+            void reserve(size_t num_entries) {
+                size_t capacity = MIN_CAPACITY;
+                while(capacity * MAX_LOAD_NUM < num_entries * MAX_LOAD_DEN) {
+                    capacity *= 2;
+                }
+                if(capacity > m_capacity) {
+                    m_rehash(capacity);
+                }
+            }
+
+        private:
+
+            enum : uint8_t {
+                SLOT_EMPTY = 0,
+                SLOT_USED,
+                SLOT_DELETED  // Keeps the probe sequence going for other entries.
+            };
+
+            static constexpr size_t MIN_CAPACITY = 16;
+
+            // Table grows when used + deleted slots exceed 7/8 of the capacity.
+            static constexpr size_t MAX_LOAD_NUM = 7;
+            static constexpr size_t MAX_LOAD_DEN = 8;
+
+            std::vector<value_type> m_slots;
+            std::vector<uint8_t>    m_ctrl;
+            size_t                  m_capacity     { 0 }; // Always power of 2 (or 0)
+            size_t                  m_size         { 0 };
+            size_t                  m_num_deleted  { 0 };
+
+            size_t m_next_used(size_t index) const {
+                while(index < m_capacity && m_ctrl[index] != SLOT_USED) {
+                    index++;
+                }
+                return index;
+            }
+
+            // Returns 'm_capacity' if not found.
+            size_t m_find_index(const AM::ChunkPos& pos) const {
+                if(m_size == 0) {
+                    return m_capacity;
+                }
+                const size_t mask = m_capacity - 1;
+                size_t index = (size_t)AM::chunk_pos_hash(pos) & mask;
+                while(true) {
+                    const uint8_t ctrl = m_ctrl[index];
+                    if(ctrl == SLOT_EMPTY) {
+                        return m_capacity;
+                    }
+                    if(ctrl == SLOT_USED && m_slots[index].first == pos) {
+                        return index;
+                    }
+                    index = (index + 1) & mask;
+                }
+            }
+
+            template<typename V>
+            std::pair<iterator, bool> m_insert(const AM::ChunkPos& pos, V&& value) {
+                if((m_size + m_num_deleted + 1) * MAX_LOAD_DEN > m_capacity * MAX_LOAD_NUM) {
+                    // Only clean up the deleted slots if the table is not actually full.
+                    const bool grow = (m_size + 1) * MAX_LOAD_DEN * 2 > m_capacity * MAX_LOAD_NUM;
+                    m_rehash((m_capacity == 0) ? MIN_CAPACITY : (grow ? m_capacity * 2 : m_capacity));
+                }
+
+                const size_t mask = m_capacity - 1;
+                size_t index = (size_t)AM::chunk_pos_hash(pos) & mask;
+                size_t first_deleted = m_capacity;
+
+                while(true) {
+                    const uint8_t ctrl = m_ctrl[index];
+                    if(ctrl == SLOT_EMPTY) {
+                        break;
+                    }
+                    if(ctrl == SLOT_DELETED) {
+                        if(first_deleted == m_capacity) {
+                            first_deleted = index;
+                        }
+                    }
+                    else if(m_slots[index].first == pos) {
+                        return std::make_pair(iterator(this, index), false);
+                    }
+                    index = (index + 1) & mask;
+                }
+
+                if(first_deleted != m_capacity) {
+                    index = first_deleted;
+                    m_num_deleted--;
+                }
+
+                m_ctrl[index] = SLOT_USED;
+                m_slots[index].first = pos;
+                m_slots[index].second = std::forward<V>(value);
+                m_size++;
+                return std::make_pair(iterator(this, index), true);
+            }
+
+            void m_erase_index(size_t index) {
+                m_ctrl[index] = SLOT_DELETED;
+                m_slots[index].second = T{};
+                m_size--;
+                m_num_deleted++;
+            }
+
+            void m_rehash(size_t new_capacity) {
+                std::vector<value_type> old_slots = std::move(m_slots);
+                std::vector<uint8_t>    old_ctrl = std::move(m_ctrl);
+                const size_t            old_capacity = m_capacity;
+
+                m_slots = std::vector<value_type>(new_capacity);
+                m_ctrl = std::vector<uint8_t>(new_capacity, SLOT_EMPTY);
+                m_capacity = new_capacity;
+                m_size = 0;
+                m_num_deleted = 0;
+
+                const size_t mask = m_capacity - 1;
+                for(size_t i = 0; i < old_capacity; i++) {
+                    if(old_ctrl[i] != SLOT_USED) {
+                        continue;
+                    }
+                    size_t index = (size_t)AM::chunk_pos_hash(old_slots[i].first) & mask;
+                    while(m_ctrl[index] != SLOT_EMPTY) {
+                        index = (index + 1) & mask;
+                    }
+                    m_ctrl[index] = SLOT_USED;
+                    m_slots[index] = std::move(old_slots[i]);
+                    m_size++;
+                }
+            }
+    };
+
+};
+
+
+#endif
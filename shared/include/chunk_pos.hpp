@@ -2,6 +2,7 @@
 #define AMBIENT3D_CHUNK_POS_HPP
 
 #include <functional>
+#include <cstdint>
 #include <cstdio>
 
 namespace AM {
@@ -20,13 +21,25 @@ namespace AM {
         }
     };
 
+    // Both coordinates are packed into 64 bits and mixed with splitmix64 finalizer
+    // so that nearby positions and diagonals dont end up in the same buckets.
+    inline uint64_t chunk_pos_hash(const ChunkPos& pos) {
+        uint64_t h = ((uint64_t)(uint32_t)pos.x << 32) | (uint64_t)(uint32_t)pos.z;
+        h ^= h >> 30;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 27;
+        h *= 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+        return h;
+    }
+
 };
 
 namespace std {
     template <>
     struct hash<AM::ChunkPos> {
         std::size_t operator()(const AM::ChunkPos& k) const {
-            return std::hash<int>()(k.x) ^ (std::hash<int>()(k.z) << 1);
+            return (std::size_t)AM::chunk_pos_hash(k);
         }
     };
 }
@@ -19,6 +19,7 @@ namespace AM {
         std::string fonts_directory;
         std::string font_file;
         int render_distance;
+        int terrain_lod_distance; // Distance in chunks between terrain detail levels.
 
         std::string json_data;
     };
@@ -0,0 +1,78 @@
+#ifndef AMBIENT3D_CONTENT_CHUNKS_HPP
+#define AMBIENT3D_CONTENT_CHUNKS_HPP
+
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+
+// Content defined chunking for asset file delta updates.
+//
+// Files are split where a rolling (gear) hash of the last bytes matches a pattern,
+// so the boundaries depend only on the nearby content. Editing a part of the file
+// changes only the chunks around the edit and the rest keep their hashes.
+//
+// The client can then download only the chunks it doesnt already have
+// in the old version of the file.
+//
+// Manifest is the list of chunks of a file in order,
+// MANIFEST_ENTRY_SIZE bytes per chunk:
+//  chunk size (uint32_t) + sha256 of the chunk (32 bytes)
+
+namespace AM {
+
+    static constexpr size_t CONTENT_CHUNK_MIN_SIZE = 2 * 1024;
+    static constexpr size_t CONTENT_CHUNK_MAX_SIZE = 64 * 1024;
+    static constexpr int    CONTENT_CHUNK_AVG_BITS = 13; // Average size is about (MIN_SIZE + 8 KB)
+
+    static constexpr size_t CONTENT_CHUNK_HASH_SIZE = 32;
+    static constexpr size_t MANIFEST_ENTRY_SIZE = sizeof(uint32_t) + CONTENT_CHUNK_HASH_SIZE;
+
+    struct ContentChunk {
+        uint64_t offset;
+        uint32_t size;
+        std::array<uint8_t, CONTENT_CHUNK_HASH_SIZE> hash;
+    };
+
+    // Finds chunk boundaries from bytes given in any size of pieces.
+    class ContentChunker {
+        public:
+            ContentChunker();
+            ~ContentChunker();
+
+            ContentChunker(const ContentChunker&) = delete;
+            ContentChunker& operator=(const ContentChunker&) = delete;
+
+            void reset();
+
+            // Completed chunks are added to 'chunks_out'
+            void update(const uint8_t* data, size_t size, std::vector<AM::ContentChunk>* chunks_out);
+
+            // Adds the last chunk if there are bytes left.
+            void finish(std::vector<AM::ContentChunk>* chunks_out);
+
+        private:
+            void*    m_sha256_ctx { NULL };
+            uint64_t m_gear_hash { 0 };
+            uint64_t m_chunk_offset { 0 };
+            uint32_t m_chunk_size { 0 };
+
+            void m_end_chunk(std::vector<AM::ContentChunk>* chunks_out);
+    };
+
+    // Returns false if the file cant be read.
+    bool split_file_content_chunks(const std::string& filepath, std::vector<AM::ContentChunk>* chunks_out);
+
+    void write_content_manifest(const std::vector<AM::ContentChunk>& chunks, std::vector<char>* out);
+
+    // Offsets are calculated from the sizes.
+    // Returns false if the manifest size is not multiple of MANIFEST_ENTRY_SIZE.
+    bool read_content_manifest(const char* data, size_t sizeb, std::vector<AM::ContentChunk>* chunks_out);
+
+};
+
+
+
+#endif
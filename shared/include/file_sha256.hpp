@@ -2,11 +2,16 @@
 #define AMBIENT3D_FILE_SHA256_HPP
 
 #include <string>
+#include <cstddef>
 
 
 namespace AM {
 
-    void compute_sha256_filehash(const std::string filepath, std::string* out);
+    static constexpr size_t FILEHASH_READ_BUFFER_SIZE = 64 * 1024;
+
+    // Writes sha256 hash of the file as hex string to 'out'.
+    // Returns false if the file could not be read.
+    bool compute_sha256_filehash(const std::string filepath, std::string* out);
 
 };
 
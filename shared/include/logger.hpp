@@ -0,0 +1,434 @@
+#ifndef AMBIENT3D_LOGGER_HPP
+#define AMBIENT3D_LOGGER_HPP
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+
+// Logging for threads that shouldnt wait for the terminal (server tick, network).
+//
+// The calling thread only copies the format pointer and the arguments
+// to its own ring buffer. A background thread formats the messages later
+// and writes them in batches, ordered by the time they were logged.
+// Nothing is allocated per message and the calling thread takes no locks.
+//
+// Format is the same as printf but it must be a string literal (only the pointer is stored).
+// It is checked against the arguments at compile time, a wrong type or count
+// does not compile (see LogFormat).
+// Strings (const char*, char arrays, std::string) are copied, LogBytes is written as hex.
+// Warnings and errors are written to stderr, others to stdout.
+//
+// IMPORTANT NOTE: If the ring buffer of a thread is full the message is dropped
+//                 and counted. (the logger reports how many were lost)
+//                 Messages logged after the program started exiting may be lost too.
+
+namespace AM {
+
+    enum LogLevel : uint8_t {
+        LL_DEBUG,
+        LL_INFO,
+        LL_WARNING,
+        LL_ERROR,
+        LL_NONE
+    };
+
+    static constexpr size_t LOG_THREAD_BUFFER_SIZE = 128 * 1024; // Bytes for every thread, power of 2.
+    static constexpr size_t LOG_MAX_STRING_LENGTH  = 4096;       // Longer string arguments are cut.
+    static constexpr size_t LOG_MAX_HEX_BYTES      = 512;        // LogBytes shows this many.
+    static constexpr size_t LOG_MAX_MESSAGE_LENGTH = 8192;       // Formatted message.
+
+    // Raw bytes, written as "0A 1B 2C". Data is copied when logged.
+    struct LogBytes {
+        const void* data;
+        size_t      size;
+    };
+
+    void     set_log_level(LogLevel level);
+    LogLevel get_log_level();
+
+    // Blocks until everything logged before this is written.
+    void     log_flush();
+
+    // Messages lost because a thread buffer was full.
+    uint64_t log_num_dropped();
+
+
+    namespace log_internal {
+
+        using format_func_t = int(*)(char* out, size_t out_size, const char* format, const uint8_t* args);
+
+        struct RecordHeader {
+            format_func_t format_func; // NULL for padding at the end of a buffer.
+            const char*   format;
+            int64_t       time;
+            uint32_t      size;        // With the header, multiple of sizeof(RecordHeader)
+            LogLevel      level;
+        };
+        static_assert(sizeof(RecordHeader) == 32);
+
+        extern std::atomic<uint8_t> min_level;
+
+        // Space for 'args_size' bytes in the ring buffer of this thread, NULL if it is full.
+        uint8_t* begin_record(LogLevel level, const char* format, format_func_t format_func, size_t args_size);
+        void     end_record();
+
+        struct HexString {
+            char str[LOG_MAX_HEX_BYTES * 3 + 4];
+        };
+
+        inline size_t clip_length(size_t length) {
+            return (length < LOG_MAX_STRING_LENGTH) ? length : LOG_MAX_STRING_LENGTH;
+        }
+
+        // Length of the string followed by its characters and a null terminator.
+        inline void encode_string(const char* str, size_t length, uint8_t** data) {
+            const uint32_t length32 = (uint32_t)length;
+            memcpy(*data, &length32, sizeof(length32));
+            memcpy(*data + sizeof(length32), str, length);
+            (*data)[sizeof(length32) + length] = 0;
+            *data += sizeof(length32) + length + 1;
+        }
+
+        inline const char* decode_string(const uint8_t** data) {
+            uint32_t length = 0;
+            memcpy(&length, *data, sizeof(length));
+            const char* str = (const char*)(*data + sizeof(length));
+            *data += sizeof(length) + length + 1;
+            return str;
+        }
+
+        // How each argument type is stored in the ring buffer and read back for printf.
+        template<typename T>
+        struct ArgCodec {
+            static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>,
+                    "Log arguments must be numbers, enums, pointers, strings or LogBytes");
+
+            static size_t size(const T&) { return sizeof(T); }
+            static void encode(const T& value, uint8_t** data) {
+                memcpy(*data, &value, sizeof(T));
+                *data += sizeof(T);
+            }
+            static T decode(const uint8_t** data) {
+                T value;
+                memcpy(&value, *data, sizeof(T));
+                *data += sizeof(T);
+                return value;
+            }
+        };
+
+        struct CStringCodec {
+            static size_t length(const char* str) {
+                return (str) ? strnlen(str, LOG_MAX_STRING_LENGTH) : strlen("(null)");
+            }
+            static size_t size(const char* str) {
+                return sizeof(uint32_t) + length(str) + 1;
+            }
+            static void encode(const char* str, uint8_t** data) {
+                encode_string((str) ? str : "(null)", length(str), data);
+            }
+            static const char* decode(const uint8_t** data) {
+                return decode_string(data);
+            }
+        };
+
+        template<> struct ArgCodec<const char*> : CStringCodec {};
+        template<> struct ArgCodec<char*> : CStringCodec {};
+
+        template<typename STR_T>
+        struct StringCodec {
+            static size_t size(const STR_T& str) {
+                return sizeof(uint32_t) + clip_length(str.size()) + 1;
+            }
+            static void encode(const STR_T& str, uint8_t** data) {
+                encode_string(str.data(), clip_length(str.size()), data);
+            }
+            static const char* decode(const uint8_t** data) {
+                return decode_string(data);
+            }
+        };
+
+        template<> struct ArgCodec<std::string> : StringCodec<std::string> {};
+        template<> struct ArgCodec<std::string_view> : StringCodec<std::string_view> {};
+
+        template<>
+        struct ArgCodec<LogBytes> {
+            static size_t shown(const LogBytes& bytes) {
+                return (bytes.size < LOG_MAX_HEX_BYTES) ? bytes.size : LOG_MAX_HEX_BYTES;
+            }
+            static size_t size(const LogBytes& bytes) {
+                return sizeof(uint32_t) * 2 + shown(bytes);
+            }
+            static void encode(const LogBytes& bytes, uint8_t** data) {
+                const uint32_t header[2] = { (uint32_t)shown(bytes), (uint32_t)bytes.size };
+                memcpy(*data, header, sizeof(header));
+                memcpy(*data + sizeof(header), bytes.data, header[0]);
+                *data += sizeof(header) + header[0];
+            }
+            static HexString decode(const uint8_t** data) {
+                static constexpr char DIGITS[] = "0123456789ABCDEF";
+                uint32_t header[2];
+                memcpy(header, *data, sizeof(header));
+                const uint8_t* bytes = *data + sizeof(header);
+                *data += sizeof(header) + header[0];
+
+                HexString hex;
+                char* ptr = hex.str;
+                for(uint32_t i = 0; i < header[0]; i++) {
+                    *ptr++ = DIGITS[bytes[i] >> 4];
+                    *ptr++ = DIGITS[bytes[i] & 0xF];
+                    *ptr++ = ' ';
+                }
+                if(header[0] < header[1]) {
+                    memcpy(ptr, "...", 3);
+                    ptr += 3;
+                }
+                else
+                if(ptr > hex.str) {
+                    ptr--; // Trailing space.
+                }
+                *ptr = 0;
+                return hex;
+            }
+        };
+
+        template<typename T>
+        T printf_arg(T value) { return value; }
+        inline const char* printf_arg(const HexString& hex) { return hex.str; }
+
+        // Runs in the logger thread. Arguments are decoded in order
+        // (braced initialization) and then given to snprintf.
+        template<typename... Args>
+        int format_record(char* out, size_t out_size, const char* format, const uint8_t* data) {
+            std::tuple<decltype(ArgCodec<Args>::decode(&data))...> values { ArgCodec<Args>::decode(&data)... };
+            return std::apply([out, out_size, format](const auto&... args) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-security"
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+                return snprintf(out, out_size, format, printf_arg(args)...);
+#pragma GCC diagnostic pop
+            }, values);
+        }
+
+        // Compile time format check.
+        // Arguments are matched like printf sees them after the logger decoded them:
+        // strings and LogBytes are "%s", small integers are promoted to int and
+        // integer sizes must match the length modifier. Signedness is not checked.
+
+        enum class FormatError {
+            NONE,
+            TOO_FEW_ARGUMENTS,
+            TOO_MANY_ARGUMENTS,
+            WRONG_ARGUMENT_TYPE,
+            UNKNOWN_CONVERSION
+        };
+
+        enum class ArgKind {
+            INTEGER,
+            FLOAT,
+            LONG_DOUBLE,
+            STRING,
+            POINTER,
+            OTHER
+        };
+
+        struct FormatArg {
+            ArgKind kind;
+            size_t  size; // Integers after promotion.
+        };
+
+        template<typename T>
+        constexpr FormatArg format_arg() {
+            using U = std::decay_t<T>;
+            if constexpr(std::is_same_v<U, const char*> || std::is_same_v<U, char*>
+                    || std::is_same_v<U, std::string> || std::is_same_v<U, std::string_view>
+                    || std::is_same_v<U, LogBytes>) {
+                return { ArgKind::STRING, 0 };
+            }
+            else if constexpr(std::is_pointer_v<U>) {
+                return { ArgKind::POINTER, 0 };
+            }
+            else if constexpr(std::is_enum_v<U>) {
+                return format_arg<std::underlying_type_t<U>>();
+            }
+            else if constexpr(std::is_integral_v<U>) {
+                return { ArgKind::INTEGER, (sizeof(U) < sizeof(int)) ? sizeof(int) : sizeof(U) };
+            }
+            else if constexpr(std::is_same_v<U, long double>) {
+                return { ArgKind::LONG_DOUBLE, 0 };
+            }
+            else if constexpr(std::is_floating_point_v<U>) {
+                return { ArgKind::FLOAT, 0 };
+            }
+            return { ArgKind::OTHER, 0 };
+        }
+
+        template<typename... Args>
+        constexpr FormatError check_format(const char* format) {
+            const FormatArg args[sizeof...(Args) + 1] = { format_arg<Args>()..., FormatArg { ArgKind::OTHER, 0 } };
+            const size_t num_args = sizeof...(Args);
+            size_t next_arg = 0;
+
+            auto is_digit = [](char c) { return (c >= '0') && (c <= '9'); };
+            auto is_flag = [](char c) {
+                return (c == '-') || (c == '+') || (c == ' ') || (c == '#') || (c == '0') || (c == '\'');
+            };
+
+            for(const char* p = format; *p; p++) {
+                if(*p != '%') {
+                    continue;
+                }
+                p++;
+                if(*p == '%') {
+                    continue;
+                }
+
+                while(is_flag(*p)) {
+                    p++;
+                }
+                // Width and precision, '*' takes an int argument.
+                for(int part = 0; part < 2; part++) {
+                    if((part == 1) && (*p != '.')) {
+                        break;
+                    }
+                    if(part == 1) {
+                        p++;
+                    }
+                    if(*p == '*') {
+                        if(next_arg >= num_args) {
+                            return FormatError::TOO_FEW_ARGUMENTS;
+                        }
+                        const FormatArg& arg = args[next_arg++];
+                        if((arg.kind != ArgKind::INTEGER) || (arg.size != sizeof(int))) {
+                            return FormatError::WRONG_ARGUMENT_TYPE;
+                        }
+                        p++;
+                    }
+                    while(is_digit(*p)) {
+                        p++;
+                    }
+                }
+
+                size_t int_size = sizeof(int);
+                bool long_double = false;
+                switch(*p) {
+                    case 'h': p += (p[1] == 'h') ? 2 : 1; break;
+                    case 'l':
+                        int_size = (p[1] == 'l') ? sizeof(long long) : sizeof(long);
+                        p += (p[1] == 'l') ? 2 : 1;
+                        break;
+                    case 'z': int_size = sizeof(size_t); p++; break;
+                    case 'j': int_size = sizeof(intmax_t); p++; break;
+                    case 't': int_size = sizeof(ptrdiff_t); p++; break;
+                    case 'L': long_double = true; p++; break;
+                }
+
+                ArgKind expected = ArgKind::OTHER;
+                switch(*p) {
+                    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+                        expected = ArgKind::INTEGER;
+                        break;
+                    case 'c':
+                        expected = ArgKind::INTEGER;
+                        int_size = sizeof(int);
+                        break;
+                    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                        expected = (long_double) ? ArgKind::LONG_DOUBLE : ArgKind::FLOAT;
+                        break;
+                    case 's': expected = ArgKind::STRING; break;
+                    case 'p': expected = ArgKind::POINTER; break;
+                    default:
+                        return FormatError::UNKNOWN_CONVERSION; // Also "%n" and a '%' at the end.
+                }
+
+                if(next_arg >= num_args) {
+                    return FormatError::TOO_FEW_ARGUMENTS;
+                }
+                const FormatArg& arg = args[next_arg++];
+                const bool matches = (arg.kind == expected)
+                    || ((expected == ArgKind::POINTER) && (arg.kind == ArgKind::STRING));
+                if(!matches || ((expected == ArgKind::INTEGER) && (arg.size != int_size))) {
+                    return FormatError::WRONG_ARGUMENT_TYPE;
+                }
+            }
+            return (next_arg == num_args) ? FormatError::NONE : FormatError::TOO_MANY_ARGUMENTS;
+        }
+
+        // Not constexpr, calling these from LogFormat's constructor stops the compilation.
+        // The compiler shows the call and the log call it came from.
+        void log_format_has_too_few_arguments();
+        void log_format_has_too_many_arguments();
+        void log_format_argument_does_not_match_conversion();
+        void log_format_has_unknown_conversion();
+    };
+
+
+    // Format string of a log call. Constructed from the string literal
+    // at compile time, which checks it against the argument types.
+    template<typename... Args>
+    struct LogFormat {
+        const char* str;
+
+        consteval LogFormat(const char* format) : str(format) {
+            switch(log_internal::check_format<Args...>(format)) {
+                case log_internal::FormatError::NONE: break;
+                case log_internal::FormatError::TOO_FEW_ARGUMENTS:
+                    log_internal::log_format_has_too_few_arguments();
+                    break;
+                case log_internal::FormatError::TOO_MANY_ARGUMENTS:
+                    log_internal::log_format_has_too_many_arguments();
+                    break;
+                case log_internal::FormatError::WRONG_ARGUMENT_TYPE:
+                    log_internal::log_format_argument_does_not_match_conversion();
+                    break;
+                case log_internal::FormatError::UNKNOWN_CONVERSION:
+                    log_internal::log_format_has_unknown_conversion();
+                    break;
+            }
+        }
+    };
+
+
+    template<typename... Args>
+    void log_message(LogLevel level, LogFormat<std::type_identity_t<Args>...> format, const Args&... args) {
+        if(level < log_internal::min_level.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        const size_t args_size = (log_internal::ArgCodec<std::decay_t<Args>>::size(args) + ... + 0);
+        uint8_t* data = log_internal::begin_record(level, format.str,
+                &log_internal::format_record<std::decay_t<Args>...>, args_size);
+        if(!data) {
+            return;
+        }
+
+        (log_internal::ArgCodec<std::decay_t<Args>>::encode(args, &data), ...);
+        log_internal::end_record();
+    }
+
+    template<typename... Args>
+    void log_debug(LogFormat<std::type_identity_t<Args>...> format, const Args&... args) {
+        AM::log_message(LL_DEBUG, format, args...);
+    }
+    template<typename... Args>
+    void log_info(LogFormat<std::type_identity_t<Args>...> format, const Args&... args) {
+        AM::log_message(LL_INFO, format, args...);
+    }
+    template<typename... Args>
+    void log_warning(LogFormat<std::type_identity_t<Args>...> format, const Args&... args) {
+        AM::log_message(LL_WARNING, format, args...);
+    }
+    template<typename... Args>
+    void log_error(LogFormat<std::type_identity_t<Args>...> format, const Args&... args) {
+        AM::log_message(LL_ERROR, format, args...);
+    }
+};
+
+
+#endif
@@ -2,6 +2,7 @@
 #define AMBIENT3D_NETWORKING_AGREEMENTS_HPP
 
 #include <cstdint>
+#include <cstddef>
 
 
 namespace AM {
@@ -14,6 +15,21 @@ namespace AM {
     static constexpr int FLG_PLAYER_UPDATE_Y_AXIS = (1 << 0);
     static constexpr int FLG_PLAYER_UPDATE_XZ_AXIS = (1 << 1);
 
+    // Chunks are unloaded only after they are this many chunks
+    // further away than the server sends them, so moving back and forth
+    // over a chunk border doesnt unload and receive the same chunks again.
+    // Server keeps track of the sent chunks this far too.
+    static constexpr int CHUNK_UNLOAD_MARGIN = 2;
+
+    // Asset files streamed after AM::PacketID::ACCEPTED_ASSETS_DOWNLOAD
+    // are sent in frames of raw bytes. Every frame starts with this header
+    // and is followed by 'size' bytes of the file 'stream_id'.
+    struct AssetStreamFrameHeader {
+        uint32_t stream_id; // Index in the DO_ACCEPT_ASSETS_DOWNLOAD file list.
+        uint32_t size;
+    };
+    static constexpr size_t ASSET_STREAM_FRAME_MAX_SIZE = 256 * 1024;
+
 };
 
 #endif
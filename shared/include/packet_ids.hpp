@@ -261,7 +261,12 @@ namespace AM {
         // Byte offset  |  Value name
         // ---------------------------------
         // 0            :  Packet ID        (int)
-        // 4            :  Asset files      (json data)
+        // 4            :  Manifest size    (uint64_t, bytes)
+        //
+        // NOTES:
+        // The manifest is written right after the packet.
+        // It is an array of AM::AssetManifestEntry sorted by the name hash.
+        // (see shared/include/asset_manifest.hpp)
         CLIENT_GAMEASSET_FILE_HASHES, // (tcp only)
 
         // Assets file server will send list of downloadable assets.
@@ -270,17 +275,40 @@ namespace AM {
         // byte offset  |  value name
         // ---------------------------------
         // 0            :  packet id        (int)
-        // 4            :  Total bytes      (int)
-        // 8            :  Filenames        (json data)
+        // 4            :  Total bytes      (size_t)
+        // 12           :  File list size   (size_t, bytes)
+        //
+        // NOTES:
+        // The file list (json data) is written right after the packet.
+        // "files" has [name, size, group, sha256, delta, encoding, encoded size] for each file.
+        // Files without "delta" are sent "encoding" encoded and the size sent is "encoded size".
+        // (see shared/include/asset_compression.hpp)
+        // "streams" is the number of files streamed at once, 0 if streaming is disabled.
         DO_ACCEPT_ASSETS_DOWNLOAD, // (tcp only)
 
         // If the client accepts the download they will send this packet.
         // And if they dont, nothing will happen.
+        //
+        // byte offset  |  value name
+        // ---------------------------------
+        // 0            :  packet id        (int)
+        // 4            :  Resume info      (json data)
+        //
+        // NOTES:
+        // If "streams" was not 0, files without "delta" are not sent one by one.
+        // The server streams them right after this packet, up to "streams" files
+        // interleaved in frames (see AM::AssetStreamFrameHeader).
+        // "resume" has [file index, byte offset] for files the client has partially
+        // downloaded before. Those files are sent starting from the offset.
+        // Files with "delta" are sent after all the streams are complete
+        // starting with CREATE_ASSET_FILE.
         ACCEPTED_ASSETS_DOWNLOAD,
 
 
         // When client starts to download a file
         // they will first receive the filename and the type.
+        // If "encoding" is not "none" the file bytes sent after are compressed
+        // and there are "encoded_size" of them.
         //
         // byte offset  |  value name
         // ---------------------------------
@@ -304,6 +332,28 @@ namespace AM {
         // this packet to continue receiving data.
         GOT_SOME_FILE_BYTES,
 
+        // If the file info had "stream": true the server doesnt send
+        // ASSET_FILE_BYTES packets. After CLIENT_CREATED_ASSET_FILE 
+        // it writes exactly "filesize" raw bytes (no packet id) to the socket 
+        // and waits for the client to respond with this packet 
+        // before sending the next file info.
+        GOT_ASSET_FILE,
+
+        // Delta updates:
+        // If the file info has "delta": true the client has an older version of the file.
+        // After CLIENT_CREATED_ASSET_FILE the server writes the content chunk manifest
+        // ("manifest_size" raw bytes, see content_chunks.hpp) instead of the file.
+        // Client compares it to the chunks of its old file and requests the missing ones.
+        // The server then streams the requested chunks in order as raw bytes
+        // and the client responds with GOT_ASSET_FILE when the file is assembled.
+        // If nothing is missing the client responds with GOT_ASSET_FILE right away.
+        //
+        // byte offset  |  value name
+        // ---------------------------------
+        // 0            :  packet id        (int)
+        // 4            :  Bitmap           (bit 'i' is set if chunk 'i' is needed)
+        ASSET_CHUNK_REQUEST,
+
         // When the server sees every byte was sent, 
         // this packet id is sent after.
         ASSET_FILE_END,
@@ -325,6 +375,9 @@ namespace AM {
         static constexpr size_t WEATHER_DATA = 16;
         static constexpr size_t PLAYER_PICKUP_ITEM = 4;
         static constexpr size_t PLAYER_UNLOAD_DROPPED_ITEM = 4;
+
+        // Smallest item in ITEM_UPDATE: uuid, id, position, 1 character entry name and the separator.
+        static constexpr size_t ITEM_UPDATE_MIN_ITEM = 22;
     };
 };
 
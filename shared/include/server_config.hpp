@@ -31,6 +31,8 @@ namespace AM {
         float gravity;
         float player_jump_force;
         float player_cam_height;
+        float player_max_speed;
+        float player_position_tolerance;
         float day_cycle_in_minutes;
         AM::iVec2 player_default_inventory_size;
 
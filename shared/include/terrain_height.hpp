@@ -0,0 +1,67 @@
+#ifndef AMBIENT3D_TERRAIN_HEIGHT_HPP
+#define AMBIENT3D_TERRAIN_HEIGHT_HPP
+
+#include <cmath>
+
+#include "chunk_pos.hpp"
+
+
+// Closed form terrain height sampling.
+// The height is exactly on the triangles of the chunk mesh, which splits every grid cell
+// with the diagonal from (x, z+1) to (x+1, z):
+//
+//   (x,z) ---- (x+1,z)
+//     |  T1   /  |
+//     |     /    |
+//     |   /  T2  |
+//   (x,z+1) -- (x+1,z+1)
+//
+
+namespace AM {
+    namespace TerrainHeight {
+
+        // Position on the chunk grid. 'local_x' and 'local_z' are in range of 0 to chunk size.
+        struct GridPoint {
+            AM::ChunkPos chunk_pos;
+            float        local_x;
+            float        local_z;
+        };
+
+        inline GridPoint world_to_grid(float world_x, float world_z, int chunk_size, float chunk_scale) {
+            const float grid_x = world_x / chunk_scale;
+            const float grid_z = world_z / chunk_scale;
+            const int chunk_x = (int)floorf(grid_x / (float)chunk_size);
+            const int chunk_z = (int)floorf(grid_z / (float)chunk_size);
+
+            GridPoint point;
+            point.chunk_pos = AM::ChunkPos(chunk_x, chunk_z);
+            point.local_x = fminf(fmaxf(grid_x - (float)(chunk_x * chunk_size), 0.0f), (float)chunk_size);
+            point.local_z = fminf(fmaxf(grid_z - (float)(chunk_z * chunk_size), 0.0f), (float)chunk_size);
+            return point;
+        }
+
+        // 'heights' has (chunk_size+1) * (chunk_size+1) points.
+        inline float sample(const float* heights, int chunk_size, float local_x, float local_z) {
+            const int row = chunk_size + 1;
+            const int x = (int)fminf(local_x, (float)(chunk_size - 1));
+            const int z = (int)fminf(local_z, (float)(chunk_size - 1));
+            const float fx = local_x - (float)x;
+            const float fz = local_z - (float)z;
+
+            const float* cell = &heights[z * row + x];
+            const float h00 = cell[0];
+            const float h10 = cell[1];
+            const float h01 = cell[row];
+            const float h11 = cell[row + 1];
+
+            if(fx + fz <= 1.0f) {
+                return h00 + fx * (h10 - h00) + fz * (h01 - h00);  // T1
+            }
+            return h11 + (1.0f - fx) * (h01 - h11) + (1.0f - fz) * (h10 - h11); // T2
+        }
+
+    };
+};
+
+
+#endif
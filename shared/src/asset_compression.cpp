@@ -0,0 +1,150 @@
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <lz4frame.h>
+#include <lz4hc.h>
+
+#include "../include/asset_compression.hpp"
+#include "../include/file_sha256.hpp"
+
+namespace fs = std::filesystem;
+
+
+bool AM::compress_asset_file(const std::string& src_filepath, const std::string& dst_filepath, int level) {
+    FILE* src = fopen(src_filepath.c_str(), "rb");
+    if(!src) {
+        fprintf(stderr, "ERROR! %s: Failed to open \"%s\"\n", __func__, src_filepath.c_str());
+        return false;
+    }
+
+    // Written to temporary file first so a half written file is never used.
+    const std::string tmp_filepath = dst_filepath + ".tmp";
+    FILE* dst = fopen(tmp_filepath.c_str(), "wb");
+    if(!dst) {
+        fprintf(stderr, "ERROR! %s: Failed to create \"%s\"\n", __func__, tmp_filepath.c_str());
+        fclose(src);
+        return false;
+    }
+
+    LZ4F_preferences_t prefs;
+    memset(&prefs, 0, sizeof(prefs));
+    prefs.compressionLevel = std::clamp(level, LZ4HC_CLEVEL_MIN, LZ4HC_CLEVEL_MAX);
+    prefs.frameInfo.blockSizeID = LZ4F_max256KB;
+    prefs.frameInfo.blockMode = LZ4F_blockLinked;
+    prefs.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+
+    std::vector<char> in_buffer(AM::FILEHASH_READ_BUFFER_SIZE);
+    std::vector<char> out_buffer(LZ4F_compressBound(in_buffer.size(), &prefs) + LZ4F_HEADER_SIZE_MAX);
+
+    LZ4F_cctx* cctx = NULL;
+    bool result = false;
+    size_t out_size = 0;
+
+    if(LZ4F_isError(LZ4F_createCompressionContext(&cctx, LZ4F_VERSION))) {
+        fprintf(stderr, "ERROR! %s: Failed to create compression context\n", __func__);
+        goto done;
+    }
+
+    out_size = LZ4F_compressBegin(cctx, out_buffer.data(), out_buffer.size(), &prefs);
+    if(LZ4F_isError(out_size)) {
+        goto compress_error;
+    }
+    fwrite(out_buffer.data(), 1, out_size, dst);
+
+    while(true) {
+        const size_t read_size = fread(in_buffer.data(), 1, in_buffer.size(), src);
+        if(read_size == 0) {
+            break;
+        }
+        out_size = LZ4F_compressUpdate(cctx, out_buffer.data(), out_buffer.size(), in_buffer.data(), read_size, NULL);
+        if(LZ4F_isError(out_size)) {
+            goto compress_error;
+        }
+        fwrite(out_buffer.data(), 1, out_size, dst);
+    }
+
+    out_size = LZ4F_compressEnd(cctx, out_buffer.data(), out_buffer.size(), NULL);
+    if(LZ4F_isError(out_size)) {
+        goto compress_error;
+    }
+    fwrite(out_buffer.data(), 1, out_size, dst);
+
+    result = !ferror(src) && !ferror(dst);
+    goto done;
+
+compress_error:
+    fprintf(stderr, "ERROR! %s: \"%s\" (%s)\n", __func__, src_filepath.c_str(), LZ4F_getErrorName(out_size));
+
+done:
+    LZ4F_freeCompressionContext(cctx);
+    fclose(src);
+    result = (fclose(dst) == 0) && result;
+
+    std::error_code ec;
+    if(result) {
+        fs::rename(tmp_filepath, dst_filepath, ec);
+        result = !ec;
+    }
+    if(!result) {
+        fs::remove(tmp_filepath, ec);
+    }
+    return result;
+}
+
+
+AM::AssetFileDecoder::AssetFileDecoder() {
+    LZ4F_dctx* dctx = NULL;
+    if(LZ4F_isError(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION))) {
+        fprintf(stderr, "ERROR! %s: Failed to create decompression context\n", __func__);
+    }
+    m_dctx = dctx;
+    m_buffer.resize(AM::FILEHASH_READ_BUFFER_SIZE);
+}
+
+AM::AssetFileDecoder::~AssetFileDecoder() {
+    LZ4F_freeDecompressionContext((LZ4F_dctx*)m_dctx);
+}
+
+bool AM::AssetFileDecoder::begin(const std::string& encoding) {
+    if(encoding != AM::ASSET_ENCODING_LZ4HC) {
+        fprintf(stderr, "ERROR! %s: Unsupported encoding \"%s\"\n", __func__, encoding.c_str());
+        return false;
+    }
+    if(!m_dctx) {
+        return false;
+    }
+    LZ4F_resetDecompressionContext((LZ4F_dctx*)m_dctx);
+    m_complete = false;
+    return true;
+}
+
+bool AM::AssetFileDecoder::write(std::ofstream& out, const char* data, size_t size) {
+    // Keep going while there is input left or the output buffer was filled
+    // because then the decoder may still have more bytes to give.
+    size_t out_size = 0;
+    do {
+        if(m_complete && (size > 0)) {
+            fprintf(stderr, "ERROR! %s: Data after end of compressed file\n", __func__);
+            return false;
+        }
+
+        out_size = m_buffer.size();
+        size_t in_size = size;
+        const size_t hint = LZ4F_decompress((LZ4F_dctx*)m_dctx, m_buffer.data(), &out_size, data, &in_size, NULL);
+        if(LZ4F_isError(hint)) {
+            fprintf(stderr, "ERROR! %s: %s\n", __func__, LZ4F_getErrorName(hint));
+            return false;
+        }
+
+        out.write(m_buffer.data(), out_size);
+        data += in_size;
+        size -= in_size;
+        // Stays complete when the last call only emptied the output buffer.
+        m_complete = m_complete || (hint == 0);
+    }
+    while((size > 0) || (out_size == m_buffer.size()));
+
+    return true;
+}
+
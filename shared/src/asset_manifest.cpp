@@ -0,0 +1,48 @@
+#include <algorithm>
+
+#include "../include/asset_manifest.hpp"
+
+
+uint64_t AM::asset_name_hash(const std::string& name) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for(const char c : name) {
+        hash ^= (uint8_t)c;
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static int _hex_value(char c) {
+    if((c >= '0') && (c <= '9')) { return c - '0'; }
+    if((c >= 'a') && (c <= 'f')) { return c - 'a' + 10; }
+    if((c >= 'A') && (c <= 'F')) { return c - 'A' + 10; }
+    return -1;
+}
+
+bool AM::sha256_hex_to_digest(const std::string& hex, uint8_t* digest_out) {
+    size_t pos = 0;
+    for(size_t i = 0; i < AM::ASSET_DIGEST_SIZE; i++) {
+        if((i > 0) && (pos < hex.size()) && (hex[pos] == '-')) {
+            pos++;
+        }
+        if(pos + 2 > hex.size()) {
+            return false;
+        }
+        const int hi = _hex_value(hex[pos]);
+        const int lo = _hex_value(hex[pos + 1]);
+        if((hi < 0) || (lo < 0)) {
+            return false;
+        }
+        digest_out[i] = (uint8_t)((hi << 4) | lo);
+        pos += 2;
+    }
+    return (pos == hex.size());
+}
+
+void AM::sort_asset_manifest(std::vector<AM::AssetManifestEntry>* entries) {
+    std::sort(entries->begin(), entries->end(),
+            [](const AM::AssetManifestEntry& a, const AM::AssetManifestEntry& b) {
+                return a.name_hash < b.name_hash;
+            });
+}
+
@@ -1,4 +1,5 @@
 #include <cstring>
+#include <cstdint>
 #include "../include/byte_array.hpp"
 
 
@@ -31,8 +32,9 @@ void AM::ByteArray::to_hexstring(std::string* out) {
     
     const char* HEX = "0123456789abcdef";
     for(size_t i = 0; i < m_bytes.size(); i++) {
-        out->push_back(HEX[ (abs(m_bytes[i]) >> 4) % 0xf ]);
-        out->push_back(HEX[ (abs(m_bytes[i])) & 0xf ]);
+        const uint8_t byte = (uint8_t)m_bytes[i];
+        out->push_back(HEX[ byte >> 4 ]);
+        out->push_back(HEX[ byte & 0xf ]);
         if(i+1 < m_bytes.size()) {
             out->push_back('-');
         }
@@ -25,6 +25,7 @@ void AM::ClientConfig::parse_from_memory(const json& data) {
     this->fonts_directory = data["fonts_directory"].template get<std::string>();
     this->font_file = data["font_file"].template get<std::string>();
     this->render_distance = data["render_distance"].template get<int>();
+    this->terrain_lod_distance = data["terrain_lod_distance"].template get<int>();
 }
 
 
@@ -0,0 +1,140 @@
+#include <cstdio>
+#include <cstring>
+#include <openssl/evp.h>
+
+#include "../include/content_chunks.hpp"
+#include "../include/file_sha256.hpp"
+
+
+// Random value for every byte. Generated with splitmix64 so it is the same everywhere.
+static constexpr std::array<uint64_t, 256> GEAR_TABLE = []() {
+    std::array<uint64_t, 256> table {};
+    uint64_t state = 0x3D2A1F0E5B6C7D8EULL;
+    for(uint64_t& value : table) {
+        state += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        value = z ^ (z >> 31);
+    }
+    return table;
+}();
+
+// The newest byte affects the lowest bits of the gear hash
+// so the high bits are the ones which depend on the most bytes.
+static constexpr uint64_t BOUNDARY_MASK = ~0ULL << (64 - AM::CONTENT_CHUNK_AVG_BITS);
+
+
+AM::ContentChunker::ContentChunker() {
+    m_sha256_ctx = EVP_MD_CTX_new();
+    this->reset();
+}
+
+AM::ContentChunker::~ContentChunker() {
+    EVP_MD_CTX_free((EVP_MD_CTX*)m_sha256_ctx);
+}
+
+void AM::ContentChunker::reset() {
+    m_gear_hash = 0;
+    m_chunk_offset = 0;
+    m_chunk_size = 0;
+    EVP_DigestInit_ex((EVP_MD_CTX*)m_sha256_ctx, EVP_sha256(), NULL);
+}
+
+void AM::ContentChunker::m_end_chunk(std::vector<AM::ContentChunk>* chunks_out) {
+    AM::ContentChunk chunk;
+    chunk.offset = m_chunk_offset;
+    chunk.size = m_chunk_size;
+    EVP_DigestFinal_ex((EVP_MD_CTX*)m_sha256_ctx, chunk.hash.data(), NULL);
+    chunks_out->push_back(chunk);
+
+    m_chunk_offset += m_chunk_size;
+    m_chunk_size = 0;
+    m_gear_hash = 0;
+    EVP_DigestInit_ex((EVP_MD_CTX*)m_sha256_ctx, EVP_sha256(), NULL);
+}
+
+void AM::ContentChunker::update(const uint8_t* data, size_t size, std::vector<AM::ContentChunk>* chunks_out) {
+    size_t span_begin = 0;
+    for(size_t i = 0; i < size; i++) {
+        m_gear_hash = (m_gear_hash << 1) + GEAR_TABLE[data[i]];
+        m_chunk_size++;
+
+        if(m_chunk_size < AM::CONTENT_CHUNK_MIN_SIZE) {
+            continue;
+        }
+        if(((m_gear_hash & BOUNDARY_MASK) != 0) && (m_chunk_size < AM::CONTENT_CHUNK_MAX_SIZE)) {
+            continue;
+        }
+
+        EVP_DigestUpdate((EVP_MD_CTX*)m_sha256_ctx, data + span_begin, (i + 1) - span_begin);
+        span_begin = i + 1;
+        m_end_chunk(chunks_out);
+    }
+
+    if(span_begin < size) {
+        EVP_DigestUpdate((EVP_MD_CTX*)m_sha256_ctx, data + span_begin, size - span_begin);
+    }
+}
+
+void AM::ContentChunker::finish(std::vector<AM::ContentChunk>* chunks_out) {
+    if(m_chunk_size > 0) {
+        m_end_chunk(chunks_out);
+    }
+}
+
+
+bool AM::split_file_content_chunks(const std::string& filepath, std::vector<AM::ContentChunk>* chunks_out) {
+    FILE* file = fopen(filepath.c_str(), "rb");
+    if(!file) {
+        fprintf(stderr, "ERROR! %s: Failed to open \"%s\"\n", __func__, filepath.c_str());
+        return false;
+    }
+
+    AM::ContentChunker chunker;
+    chunks_out->clear();
+
+    uint8_t buffer[AM::FILEHASH_READ_BUFFER_SIZE];
+    size_t read_size = 0;
+    while((read_size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        chunker.update(buffer, read_size, chunks_out);
+    }
+    chunker.finish(chunks_out);
+
+    const bool read_error = ferror(file);
+    fclose(file);
+    if(read_error) {
+        fprintf(stderr, "ERROR! %s: Failed to read \"%s\"\n", __func__, filepath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void AM::write_content_manifest(const std::vector<AM::ContentChunk>& chunks, std::vector<char>* out) {
+    out->resize(chunks.size() * AM::MANIFEST_ENTRY_SIZE);
+    char* ptr = out->data();
+    for(const AM::ContentChunk& chunk : chunks) {
+        memmove(ptr, &chunk.size, sizeof(chunk.size));
+        memmove(ptr + sizeof(chunk.size), chunk.hash.data(), AM::CONTENT_CHUNK_HASH_SIZE);
+        ptr += AM::MANIFEST_ENTRY_SIZE;
+    }
+}
+
+bool AM::read_content_manifest(const char* data, size_t sizeb, std::vector<AM::ContentChunk>* chunks_out) {
+    chunks_out->clear();
+    if((sizeb % AM::MANIFEST_ENTRY_SIZE) != 0) {
+        return false;
+    }
+
+    uint64_t offset = 0;
+    for(size_t i = 0; i < sizeb; i += AM::MANIFEST_ENTRY_SIZE) {
+        AM::ContentChunk chunk;
+        memmove(&chunk.size, data + i, sizeof(chunk.size));
+        memmove(chunk.hash.data(), data + i + sizeof(chunk.size), AM::CONTENT_CHUNK_HASH_SIZE);
+        chunk.offset = offset;
+        offset += chunk.size;
+        chunks_out->push_back(chunk);
+    }
+    return true;
+}
+
@@ -1,28 +1,52 @@
-#include <fstream>
+#include <cstdio>
+#include <openssl/evp.h>
 #include <openssl/sha.h>
 
 #include "../include/file_sha256.hpp"
 #include "../include/byte_array.hpp"
 
 
-void AM::compute_sha256_filehash(const std::string filepath, std::string* out) {
+bool AM::compute_sha256_filehash(const std::string filepath, std::string* out) {
 
-    std::fstream file_stream(filepath);
-    file_stream.seekg(0, file_stream.end);
-    size_t file_size = file_stream.tellg();
-    file_stream.seekg(0, file_stream.beg);
-    
-    if(file_size == 0) {
-        fprintf(stderr, "ERROR! %s: \"%s\" File size is zero.\n", __func__, filepath.c_str());
+    FILE* file = fopen(filepath.c_str(), "rb");
+    if(!file) {
+        fprintf(stderr, "ERROR! %s: Failed to open \"%s\"\n", __func__, filepath.c_str());
+        return false;
     }
 
-    char* buffer = new char[file_size];
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    if(!ctx || !EVP_DigestInit_ex(ctx, EVP_sha256(), NULL)) {
+        fprintf(stderr, "ERROR! %s: Failed to initialize sha256 context.\n", __func__);
+        EVP_MD_CTX_free(ctx);
+        fclose(file);
+        return false;
+    }
+
+    // The file is read in fixed size blocks so big files dont need to fit in memory.
+    unsigned char buffer[AM::FILEHASH_READ_BUFFER_SIZE];
+    size_t file_size = 0;
+    size_t read_size = 0;
+    while((read_size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        EVP_DigestUpdate(ctx, buffer, read_size);
+        file_size += read_size;
+    }
 
-    file_stream.read(buffer, file_size);
+    const bool read_error = ferror(file);
+    fclose(file);
 
     AM::ByteArray hash(SHA256_DIGEST_LENGTH);
-    SHA256((unsigned char*)buffer, file_size, (unsigned char*)hash.data());
+    EVP_DigestFinal_ex(ctx, (unsigned char*)hash.data(), NULL);
+    EVP_MD_CTX_free(ctx);
+
+    if(read_error) {
+        fprintf(stderr, "ERROR! %s: Failed to read \"%s\"\n", __func__, filepath.c_str());
+        return false;
+    }
+    
+    if(file_size == 0) {
+        fprintf(stderr, "ERROR! %s: \"%s\" File size is zero.\n", __func__, filepath.c_str());
+    }
 
     hash.to_hexstring(out);
-    delete[] buffer;
+    return true;
 }
@@ -0,0 +1,305 @@
+#include <mutex>
+#include <algorithm>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+#include "../include/logger.hpp"
+
+
+namespace {
+
+    static constexpr auto FLUSH_INTERVAL = std::chrono::milliseconds(5);
+    static constexpr size_t RECORD_ALIGN = sizeof(AM::log_internal::RecordHeader);
+    static constexpr size_t BUFFER_MASK = AM::LOG_THREAD_BUFFER_SIZE - 1;
+    static constexpr size_t WRITE_BATCH_SIZE = 32 * 1024;
+
+    static_assert((AM::LOG_THREAD_BUFFER_SIZE & BUFFER_MASK) == 0,
+            "LOG_THREAD_BUFFER_SIZE must be power of 2");
+
+    // Single producer (the owner thread), single consumer (the logger thread).
+    // 'head' and 'tail' only grow, the position in 'data' is them masked.
+    struct mThreadBuffer {
+        alignas(64) std::atomic<uint64_t> head { 0 };
+        alignas(64) std::atomic<uint64_t> tail { 0 };
+        alignas(64) uint64_t              pending_head { 0 };
+        std::atomic<uint64_t>             num_dropped { 0 };
+        std::atomic<bool>                 in_use { true };
+        uint8_t*                          data { NULL };
+    };
+
+    struct mLogger {
+        std::mutex                  mutex;
+        std::condition_variable     wake_cv;
+        std::condition_variable     flushed_cv;
+        std::vector<mThreadBuffer*> buffers;
+        std::thread                 thread;
+        uint64_t                    flush_requested { 0 };
+        uint64_t                    flush_done { 0 };
+        uint64_t                    num_dropped_reported { 0 };
+        bool                        running { false };
+    };
+
+    // Never deleted, other threads may still log while the program exits.
+    static mLogger*       logger = NULL;
+    static std::once_flag logger_once;
+
+    // Releases the buffer when the thread exits so a new thread can use it.
+    struct mThreadBufferOwner {
+        mThreadBuffer* buffer { NULL };
+        ~mThreadBufferOwner() {
+            if(buffer) {
+                buffer->in_use.store(false, std::memory_order_release);
+            }
+        }
+    };
+    static thread_local mThreadBufferOwner thread_buffer;
+};
+
+
+std::atomic<uint8_t> AM::log_internal::min_level { AM::LL_INFO };
+
+
+static int64_t _now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void _write(std::string* out, FILE* stream) {
+    if(!out->empty()) {
+        fwrite(out->data(), 1, out->size(), stream);
+        out->clear();
+    }
+}
+
+// Writes everything that was in the buffers when this was called.
+// Records from different threads are merged by their time.
+static void _drain(std::vector<mThreadBuffer*>* buffers, std::vector<uint64_t>* heads, std::string* out) {
+    {
+        std::lock_guard<std::mutex> lock(::logger->mutex);
+        *buffers = ::logger->buffers;
+    }
+
+    heads->resize(buffers->size());
+    for(size_t i = 0; i < buffers->size(); i++) {
+        (*heads)[i] = (*buffers)[i]->head.load(std::memory_order_acquire);
+    }
+
+    char message[AM::LOG_MAX_MESSAGE_LENGTH];
+    FILE* stream = stdout;
+
+    while(true) {
+        mThreadBuffer* oldest = NULL;
+        const AM::log_internal::RecordHeader* oldest_record = NULL;
+
+        for(size_t i = 0; i < buffers->size(); i++) {
+            mThreadBuffer* buffer = (*buffers)[i];
+            uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+            if(tail >= (*heads)[i]) {
+                continue;
+            }
+
+            auto* record = (const AM::log_internal::RecordHeader*)(buffer->data + (tail & ::BUFFER_MASK));
+            if(!record->format_func) {
+                // Padding, the next record is at the beginning.
+                tail += record->size;
+                buffer->tail.store(tail, std::memory_order_release);
+                if(tail >= (*heads)[i]) {
+                    continue;
+                }
+                record = (const AM::log_internal::RecordHeader*)(buffer->data + (tail & ::BUFFER_MASK));
+            }
+
+            if(!oldest_record || (record->time < oldest_record->time)) {
+                oldest = buffer;
+                oldest_record = record;
+            }
+        }
+
+        if(!oldest) {
+            break;
+        }
+
+        FILE* record_stream = (oldest_record->level >= AM::LL_WARNING) ? stderr : stdout;
+        if(record_stream != stream) {
+            _write(out, stream);
+            fflush(stream);
+            stream = record_stream;
+        }
+
+        const int length = oldest_record->format_func(message, sizeof(message),
+                oldest_record->format, (const uint8_t*)(oldest_record + 1));
+        if(length > 0) {
+            out->append(message, std::min((size_t)length, sizeof(message) - 1));
+        }
+
+        oldest->tail.fetch_add(oldest_record->size, std::memory_order_release);
+
+        if(out->size() >= ::WRITE_BATCH_SIZE) {
+            _write(out, stream);
+        }
+    }
+
+    _write(out, stream);
+    fflush(stream);
+
+    uint64_t num_dropped = 0;
+    for(const mThreadBuffer* buffer : *buffers) {
+        num_dropped += buffer->num_dropped.load(std::memory_order_relaxed);
+    }
+    if(num_dropped != ::logger->num_dropped_reported) {
+        fprintf(stderr, "[LOG]: %lu messages were dropped (buffer full)\n",
+                num_dropped - ::logger->num_dropped_reported);
+        ::logger->num_dropped_reported = num_dropped;
+    }
+}
+
+static void _logger_thread() {
+    std::vector<mThreadBuffer*> buffers;
+    std::vector<uint64_t> heads;
+    std::string out;
+    out.reserve(::WRITE_BATCH_SIZE + AM::LOG_MAX_MESSAGE_LENGTH);
+
+    while(true) {
+        uint64_t requested = 0;
+        bool stop = false;
+        {
+            std::unique_lock<std::mutex> lock(::logger->mutex);
+            ::logger->wake_cv.wait_for(lock, ::FLUSH_INTERVAL, [] {
+                return (::logger->flush_requested != ::logger->flush_done) || !::logger->running;
+            });
+            requested = ::logger->flush_requested;
+            stop = !::logger->running;
+        }
+
+        _drain(&buffers, &heads, &out);
+
+        {
+            std::lock_guard<std::mutex> lock(::logger->mutex);
+            ::logger->flush_done = requested;
+        }
+        ::logger->flushed_cv.notify_all();
+
+        if(stop) {
+            break;
+        }
+    }
+}
+
+static void _stop_logger() {
+    {
+        std::lock_guard<std::mutex> lock(::logger->mutex);
+        ::logger->running = false;
+    }
+    ::logger->wake_cv.notify_one();
+    ::logger->thread.join();
+}
+
+static void _start_logger() {
+    ::logger = new mLogger;
+    ::logger->running = true;
+    ::logger->thread = std::thread(_logger_thread);
+    atexit(_stop_logger);
+}
+
+// Buffers of exited threads are used again once they are empty.
+static mThreadBuffer* _acquire_thread_buffer() {
+    std::call_once(::logger_once, _start_logger);
+    std::lock_guard<std::mutex> lock(::logger->mutex);
+
+    for(mThreadBuffer* buffer : ::logger->buffers) {
+        if(!buffer->in_use.load(std::memory_order_acquire)
+        && (buffer->tail.load(std::memory_order_acquire) == buffer->head.load(std::memory_order_relaxed))) {
+            buffer->in_use.store(true, std::memory_order_relaxed);
+            return buffer;
+        }
+    }
+
+    mThreadBuffer* buffer = new mThreadBuffer;
+    buffer->data = new uint8_t[AM::LOG_THREAD_BUFFER_SIZE];
+    ::logger->buffers.push_back(buffer);
+    return buffer;
+}
+
+uint8_t* AM::log_internal::begin_record(AM::LogLevel level, const char* format,
+        AM::log_internal::format_func_t format_func, size_t args_size) {
+    mThreadBuffer* buffer = ::thread_buffer.buffer;
+    if(!buffer) {
+        buffer = _acquire_thread_buffer();
+        ::thread_buffer.buffer = buffer;
+    }
+
+    const size_t size = (sizeof(RecordHeader) + args_size + ::RECORD_ALIGN - 1) & ~(::RECORD_ALIGN - 1);
+    if(size > AM::LOG_THREAD_BUFFER_SIZE / 2) {
+        buffer->num_dropped.fetch_add(1, std::memory_order_relaxed);
+        return NULL;
+    }
+
+    // Records are not split. If it doesnt fit before the end of the buffer
+    // the rest of it is padding and the record goes to the beginning.
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    const size_t contiguous = AM::LOG_THREAD_BUFFER_SIZE - (head & ::BUFFER_MASK);
+    const size_t padding = (contiguous < size) ? contiguous : 0;
+
+    if((head + padding + size) - buffer->tail.load(std::memory_order_acquire) > AM::LOG_THREAD_BUFFER_SIZE) {
+        buffer->num_dropped.fetch_add(1, std::memory_order_relaxed);
+        return NULL;
+    }
+
+    if(padding > 0) {
+        RecordHeader* pad = (RecordHeader*)(buffer->data + (head & ::BUFFER_MASK));
+        pad->format_func = NULL;
+        pad->size = (uint32_t)padding;
+        head += padding;
+    }
+
+    RecordHeader* record = (RecordHeader*)(buffer->data + (head & ::BUFFER_MASK));
+    record->format_func = format_func;
+    record->format = format;
+    record->time = _now();
+    record->size = (uint32_t)size;
+    record->level = level;
+
+    buffer->pending_head = head + size;
+    return (uint8_t*)(record + 1);
+}
+
+void AM::log_internal::end_record() {
+    mThreadBuffer* buffer = ::thread_buffer.buffer;
+    buffer->head.store(buffer->pending_head, std::memory_order_release);
+}
+
+void AM::set_log_level(AM::LogLevel level) {
+    AM::log_internal::min_level.store(level, std::memory_order_relaxed);
+}
+
+AM::LogLevel AM::get_log_level() {
+    return (AM::LogLevel)AM::log_internal::min_level.load(std::memory_order_relaxed);
+}
+
+void AM::log_flush() {
+    std::call_once(::logger_once, _start_logger);
+    std::unique_lock<std::mutex> lock(::logger->mutex);
+    if(!::logger->running) {
+        return;
+    }
+    const uint64_t target = ++::logger->flush_requested;
+    ::logger->wake_cv.notify_one();
+    ::logger->flushed_cv.wait(lock, [target] {
+        return (::logger->flush_done >= target) || !::logger->running;
+    });
+}
+
+uint64_t AM::log_num_dropped() {
+    std::call_once(::logger_once, _start_logger);
+    std::lock_guard<std::mutex> lock(::logger->mutex);
+    uint64_t num_dropped = 0;
+    for(const mThreadBuffer* buffer : ::logger->buffers) {
+        num_dropped += buffer->num_dropped.load(std::memory_order_relaxed);
+    }
+    return num_dropped;
+}
+
@@ -50,7 +50,7 @@ AM::RayHitResult AM::Ray::triangle_intersection(const AM::Triangle& triangle) {
     // Calculate v parameter and test bound.
     v = this->direction.dot(q) * inv_det;
     
-    if((v < 0.0f) || (u > 1.0f)) {
+    if((v < 0.0f) || ((u + v) > 1.0f)) {
         return result; // Intersection lies outside the triangle.
     }
 
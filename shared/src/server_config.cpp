@@ -31,6 +31,8 @@ void AM::ServerCFG::parse_from_memory(const json& data) {
     this->gravity = data["gravity"].template get<float>();
     this->player_jump_force = data["player_jump_force"].template get<float>();
     this->player_cam_height = data["player_camera_height"].template get<float>();
+    this->player_max_speed = data["player_max_speed"].template get<float>();
+    this->player_position_tolerance = data["player_position_tolerance"].template get<float>();
     this->day_cycle_in_minutes = data["day_cycle_in_minutes"].template get<float>();
     this->player_default_inventory_size.x = data["player_default_inventory_size"]["width"].template get<int>();
     this->player_default_inventory_size.y = data["player_default_inventory_size"]["height"].template get<int>();
@@ -3,8 +3,12 @@
 #include "util.hpp"
 #include "rlgl.h"
 #include "bloom.hpp"
+#include "shader_cache.hpp"
 
 
+// MAX_MATERIAL_MAPS in raylib's config.h, it is not in the public headers.
+static constexpr int MATERIAL_MAPS = 12;
+
 AM::State::State(
         uint16_t win_width,
         uint16_t win_height, 
@@ -52,6 +56,7 @@ AM::State::State(
 
 
     GLSL_preproc_add_meminclude("GLSL_VERSION", AM::ShaderCode::get(AM::ShaderCode::GLSL_VERSION));
+    GLSL_preproc_add_meminclude("AMBIENT3D_FRAME", AM::ShaderCode::get(AM::ShaderCode::FRAME_GLSL));
     GLSL_preproc_add_meminclude("AMBIENT3D_LIGHTS", AM::ShaderCode::get(AM::ShaderCode::LIGHTS_GLSL));
     GLSL_preproc_add_meminclude("AMBIENT3D_FOG", AM::ShaderCode::get(AM::ShaderCode::FOG_GLSL));
 
@@ -62,65 +67,76 @@ AM::State::State(
 
     // DEFAULT
     this->set_shader(AM::ShaderIDX::DEFAULT,
-            LoadShaderFromMemory(
-                GLSL_preproc(AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX)).c_str(),
-                GLSL_preproc(AM::ShaderCode::get(AM::ShaderCode::DEFAULT_FRAGMENT)).c_str()
+            AM::load_shader_cached(
+                AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX),
+                AM::ShaderCode::get(AM::ShaderCode::DEFAULT_FRAGMENT)
                 ));
 
     // DEFAULT_INSTANCED
     this->set_shader(AM::ShaderIDX::DEFAULT_INSTANCED,
-            LoadShaderFromMemory(
-                GLSL_preproc(AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX), 
-                        PREPROC_FLAGS::DEFINE__RENDER_INSTANCED).c_str(),
-
-                GLSL_preproc(AM::ShaderCode::get(AM::ShaderCode::DEFAULT_FRAGMENT)).c_str()
+            AM::load_shader_cached(
+                AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX),
+                AM::ShaderCode::get(AM::ShaderCode::DEFAULT_FRAGMENT),
+                PREPROC_FLAGS::DEFINE__RENDER_INSTANCED
                 ));
 
     AM::init_instanced_shader(&this->shaders[AM::ShaderIDX::DEFAULT_INSTANCED]);
+
+    // DEFAULT_SKINNED
+    this->set_shader(AM::ShaderIDX::DEFAULT_SKINNED,
+            AM::load_shader_cached(
+                AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX),
+                AM::ShaderCode::get(AM::ShaderCode::DEFAULT_FRAGMENT),
+                PREPROC_FLAGS::DEFINE__RENDER_SKINNED
+                ));
     
     // POST_PROCESSING
     this->set_shader(AM::ShaderIDX::POST_PROCESSING,
-            LoadShaderFromMemory(
-                GLSL_preproc(AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX)).c_str(),
-                GLSL_preproc(AM::ShaderCode::get(AM::ShaderCode::POSTPROCESS_FRAGMENT)).c_str()
+            AM::load_shader_cached(
+                AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX),
+                AM::ShaderCode::get(AM::ShaderCode::POSTPROCESS_FRAGMENT)
                 ));
  
     // BLOOM_TRESHOLD
     this->set_shader(AM::ShaderIDX::BLOOM_TRESHOLD,
-            LoadShaderFromMemory(
-                GLSL_preproc(AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX)).c_str(),
-                GLSL_preproc(AM::ShaderCode::get(AM::ShaderCode::BLOOM_TRESH_FRAGMENT)).c_str()
+            AM::load_shader_cached(
+                AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX),
+                AM::ShaderCode::get(AM::ShaderCode::BLOOM_TRESH_FRAGMENT)
                 ));  
 
     // BLOOM_DOWNSAMPLE_FRAGMENT
     this->set_shader(AM::ShaderIDX::BLOOM_DOWNSAMPLE_FILTER,
-            LoadShaderFromMemory(
-                GLSL_preproc(AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX)).c_str(),
-                GLSL_preproc(AM::ShaderCode::get(AM::ShaderCode::BLOOM_DOWNSAMPLE_FRAGMENT)).c_str()
+            AM::load_shader_cached(
+                AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX),
+                AM::ShaderCode::get(AM::ShaderCode::BLOOM_DOWNSAMPLE_FRAGMENT)
                 ));  
 
     // BLOOM_UPSAMPLE_FRAGMENT
     this->set_shader(AM::ShaderIDX::BLOOM_UPSAMPLE_FILTER,
-            LoadShaderFromMemory(
-                GLSL_preproc(AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX)).c_str(),
-                GLSL_preproc(AM::ShaderCode::get(AM::ShaderCode::BLOOM_UPSAMPLE_FRAGMENT)).c_str()
+            AM::load_shader_cached(
+                AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX),
+                AM::ShaderCode::get(AM::ShaderCode::BLOOM_UPSAMPLE_FRAGMENT)
                 ));  
 
     // SKYBOX_FRAGMENT
     this->set_shader(AM::ShaderIDX::SKYBOX,
-            LoadShaderFromMemory(
-                GLSL_preproc(AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX)).c_str(),
-                GLSL_preproc(AM::ShaderCode::get(AM::ShaderCode::SKYBOX_FRAGMENT)).c_str()
+            AM::load_shader_cached(
+                AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX),
+                AM::ShaderCode::get(AM::ShaderCode::SKYBOX_FRAGMENT)
                 ));
 
     // SINGLECOLOR_FRAGMENT
     this->set_shader(AM::ShaderIDX::SINGLE_COLOR,
-            LoadShaderFromMemory(
-                GLSL_preproc(AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX)).c_str(),
-                GLSL_preproc(AM::ShaderCode::get(AM::ShaderCode::SINGLECOLOR_FRAGMENT)).c_str()
+            AM::load_shader_cached(
+                AM::ShaderCode::get(AM::ShaderCode::DEFAULT_VERTEX),
+                AM::ShaderCode::get(AM::ShaderCode::SINGLECOLOR_FRAGMENT)
                 ));
 
 
+    const AM::ShaderCacheStats& shader_stats = AM::shader_cache_stats();
+    printf("[SHADER_CACHE]: %i loaded, %i compiled in %0.2fms\n",
+            shader_stats.num_loaded, shader_stats.num_compiled, shader_stats.load_time * 1000.0);
+
     this->item_manager.set_item_default_shader(this->shaders[AM::ShaderIDX::DEFAULT]);
     SetTraceLogLevel(LOG_NONE);
 
@@ -155,16 +171,15 @@ AM::State::State(
 
     SetTraceLogLevel(LOG_ALL);
 
-    // TODO: Create memory include for light glsl (for number of lights)
-
-    m_lights_ubo.create(1, { 
-            UBO_ELEMENT {
-                .num = 64, .elem_sizeb = 48
-            },
+    m_frame_ubo.create(0, {
             UBO_ELEMENT {
-                .num = 1, .elem_sizeb = 4
+                .num = 1, .elem_sizeb = sizeof(mFrameUniforms)
             }});
 
+    m_lights_ssbo.create(1, AM::MAX_LIGHTS * sizeof(AM::LightShaderData));
+    m_light_clusters_ssbo.create(2, sizeof(AM::LightClusterParams)
+            + AM::LIGHT_CLUSTER_DATA_MAX_SIZE * sizeof(uint32_t));
+
    
     this->player.set_engine_state(this);
     this->terrain.set_engine_state(this);
@@ -188,7 +203,9 @@ AM::State::~State() {
         return;
     }
 
-    m_lights_ubo.free();
+    m_frame_ubo.free();
+    m_lights_ssbo.free();
+    m_light_clusters_ssbo.free();
 
     SetTraceLogLevel(LOG_NONE);
     
@@ -206,6 +223,7 @@ AM::State::~State() {
     this->terrain.unload_materials();
 
     for(size_t i = 0; i < AM::ShaderIDX::NUM_SHADERS; i++) {
+        AM::forget_shader_uniforms(this->shaders[i].id);
         UnloadShader(&this->shaders[i]);
     }
 
@@ -218,15 +236,15 @@ void AM::State::m_create_internal_timers() {
     this->create_named_timer("FAST_FIXED_TICK_TIMER");
     this->create_named_timer("SLOW_FIXED_TICK_TIMER");
 
-    this->create_named_timer("PLAYER_YPOS_INTERP_TIMER");
+    this->create_named_timer("PLAYER_POS_INTERP_TIMER");
     //this->create_named_timer("TIMEOFDAY_INTERP_TIMER");
 
-    // Create callback to reset PLAYER_YPOS_INTERP_TIMER
+    // Create callback to reset PLAYER_POS_INTERP_TIMER
     this->net->add_packet_callback(AM::NetProto::UDP, AM::PacketID::PLAYER_POSITION,
     [this](float interval_ms, char* data, size_t sizeb) {
         (void)data; (void)sizeb; (void)interval_ms;
         
-        AM::Timer* timer = this->get_named_timer("PLAYER_YPOS_INTERP_TIMER");
+        AM::Timer* timer = this->get_named_timer("PLAYER_POS_INTERP_TIMER");
         timer->reset();
     });
 
@@ -274,101 +292,48 @@ void AM::State::set_material(int material_idx, const Material& material) {
 
 
 
-AM::Light** AM::State::add_light(const Light& light) {
-    if(m_num_lights+1 >= AM::MAX_LIGHTS) {
+AM::LightHandle AM::State::add_light(const Light& light) {
+    const AM::LightHandle handle = m_lights.add(light);
+    if(!m_lights.valid(handle)) {
         fprintf(stderr, "Increase the light array size or remove unused lights.\n");
-        return NULL;
     }
-
-    m_lights[m_num_lights] = light;
-    m_light_ptrs[m_num_lights] = &m_lights[m_num_lights];
-    Light** result = &m_light_ptrs[m_num_lights];
-
-    m_num_lights++;
-    // Update lights uniform buffer "num_lights"
-    m_lights_ubo.update_element(m_lights_ubo.size()-1, (void*)&m_num_lights, sizeof(int));
-
-    return result;
+    return handle;
 }
 
-void AM::State::remove_light(Light** light) {
-    if(!light) { return; }
-    if(!(*light)) { return; }
-
-    size_t id = (*light)->id;
-
-    for(uint64_t i = id; i < m_num_lights-1; i++) {
-        m_lights[i] = m_lights[i+1];
-        if(id > 0) {
-            m_lights[i].id--;
-        }
-        m_lights[i].force_update = true;
-    }
-    m_num_lights--;
-
-    // Update pointers.
-    for(size_t i = 0; i < m_num_lights; i++) {
-        m_light_ptrs[i] = &m_lights[i];
-    }
-
-    *light = NULL;
-    // Update lights uniform buffer "num_lights"
-    m_lights_ubo.update_element(m_lights_ubo.size()-1, (void*)&m_num_lights, sizeof(int));
+void AM::State::remove_light(AM::LightHandle* handle) {
+    if(!handle) { return; }
+    m_lights.remove(*handle);
+    *handle = AM::LightHandle{};
 }
 
-
-// Updates lights only if they have changed even little bit.
 void AM::State::update_lights() {
-    for(size_t i = 0; i < m_lights.size(); i++) {
-        Light& light = m_lights[i];
-
-        light.id = i;
-        bool need_update = false;
-        if(light.force_update) {
-            m_lights_pframe_map[light.id] = light;
-            light.force_update = false;
-            need_update = true;
-        }
-        else {
-            const auto search = m_lights_pframe_map.find(light.id);
-            if(search == m_lights_pframe_map.end()) {
-                need_update = true;
-                m_lights_pframe_map.insert(std::make_pair(light.id, m_lights[i]));
-            }
-            else {
-                if((need_update = !light.equal(search->second))) {
-                    m_lights_pframe_map[light.id] = light;       
-                }
-            }
-        }
-
-        if(need_update) {
-            float light_data[] = {
-                light.pos.x,
-                light.pos.y,
-                light.pos.z,
-                0.0f,
-
-                (float)light.color.r / 255.0f,
-                (float)light.color.g / 255.0f,
-                (float)light.color.b / 255.0f,
-                1.0f,
-
-                light.strength,
-                light.cutoff,
-                0.0f,
-                0.0f
-            };
+    m_lights.flush(
+            [this](size_t first, const AM::LightShaderData* data, size_t count) {
+                m_lights_ssbo.update(
+                        first * sizeof(AM::LightShaderData),
+                        data, count * sizeof(AM::LightShaderData));
+            });
+}
 
-            m_lights_ubo.update_element(light.id, light_data, sizeof(light_data));
-        }
-    }
+void AM::State::m_update_light_clusters() {
+    const RenderTexture2D& target = m_render_targets[RenderTargetIDX::RESULT];
+    m_light_clusters.build(
+            rlGetMatrixModelview(),
+            rlGetMatrixProjection(),
+            target.texture.width,
+            target.texture.height,
+            m_lights.data(),
+            m_lights.size());
+
+    m_light_clusters_ssbo.update(0, &m_light_clusters.params, sizeof(AM::LightClusterParams));
+    m_light_clusters_ssbo.update(sizeof(AM::LightClusterParams),
+            m_light_clusters.cluster_data.data(),
+            m_light_clusters.cluster_data.size() * sizeof(uint32_t));
 }
 
 void AM::State::set_vision_effect(float amount) {
     AMutil::clamp<float>(amount, 0.0f, 1.0f);
     AM::set_uniform_float(this->shaders[AM::ShaderIDX::POST_PROCESSING].id, "u_vision_effect", amount);
-    AM::set_uniform_float(this->shaders[AM::ShaderIDX::POST_PROCESSING].id, "u_time", GetTime());
 }
 
 void AM::State::draw_text(int font_size, const char* text, int x, int y, const Color& color) {
@@ -407,6 +372,10 @@ void AM::State::draw_info() {
 
 void AM::State::m_update_dropped_items() {    
     auto items = this->item_manager.get_dropped_items();
+
+    m_item_bounds.clear();
+    m_cull_items.clear();
+
     for(auto it = items->begin(); it != items->end(); ++it) {
         const AM::Item* item = &it->second;
       
@@ -417,17 +386,15 @@ void AM::State::m_update_dropped_items() {
             continue;
         }
 
-        *item->renderable->transform = MatrixTranslate(item->pos_x, item->pos_y, item->pos_z);
-        item->renderable->render();
-
-        if(!(m_flags & AM::StateFlags::DONT_RENDER_DEFAULT_ITEMINFO)) {
-            m_render_default_iteminfo(item);
-        }
+        const BoundingBox& box = item->renderable->boundingbox;
+        const Vector3 item_pos = Vector3(item->pos_x, item->pos_y, item->pos_z);
+        m_item_bounds.add(BoundingBox(
+                    Vector3Add(box.min, item_pos),
+                    Vector3Add(box.max, item_pos)));
+        m_cull_items.push_back(item);
 
         if(IsKeyPressed(KEY_E)) {
-            float distance = Vector3Distance(
-                    Vector3(item->pos_x, item->pos_y, item->pos_z),
-                    this->player.position());
+            float distance = Vector3Distance(item_pos, this->player.position());
             if(distance < this->net->server_cfg.item_pickup_distance) {
                 this->net->packet.prepare(AM::PacketID::PLAYER_PICKUP_ITEM);
                 this->net->packet.write<int>({ item->uuid });
@@ -435,8 +402,234 @@ void AM::State::m_update_dropped_items() {
             }
         }
     }
+
+    const float chunk_world_size = this->net->server_cfg.chunk_size * this->net->server_cfg.chunk_scale;
+    AM::Culling::find_visible(
+            m_view_frustum,
+            m_item_bounds,
+            this->player.camera.position,
+            this->config.render_distance * chunk_world_size,
+            &m_visible_items);
+
+    // Items of the same type share the renderable.
+    for(const uint32_t idx : m_visible_items) {
+        const AM::Item* item = m_cull_items[idx];
+
+        this->render_instanced(item->renderable.get(),
+                MatrixTranslate(item->pos_x, item->pos_y, item->pos_z));
+
+        if(!(m_flags & AM::StateFlags::DONT_RENDER_DEFAULT_ITEMINFO)) {
+            m_render_default_iteminfo(item);
+        }
+    }
 }
             
+void AM::State::render_instanced(AM::Renderable* renderable, const Matrix& transform) {
+    m_instance_batcher.submit(renderable, transform);
+}
+
+void AM::State::m_render_instances() {
+    m_instance_batcher.build();
+    const std::vector<Matrix>& transforms = m_instance_batcher.transforms();
+
+    for(const AM::InstanceBatcher::Batch& batch : m_instance_batcher.batches()) {
+        AM::Renderable* renderable = (AM::Renderable*)batch.key;
+        if(batch.count >= AM::INSTANCED_RENDER_MIN_INSTANCES) {
+            renderable->render_instanced(&transforms[batch.first], batch.count,
+                    this->shaders[AM::ShaderIDX::DEFAULT_INSTANCED]);
+            continue;
+        }
+        for(uint32_t i = batch.first; i < batch.first + batch.count; i++) {
+            *renderable->transform = transforms[i];
+            renderable->submit(&this->render_queue);
+        }
+    }
+
+    m_instance_batcher.clear();
+}
+
+void AM::State::m_bind_render_material(const Material* material) {
+    const Shader& shader = material->shader;
+    for(int i = 0; i < MATERIAL_MAPS; i++) {
+        const unsigned int texture_id = material->maps[i].texture.id;
+        if(texture_id == 0) {
+            continue;
+        }
+        rlActiveTextureSlot(i);
+        if((i == MATERIAL_MAP_IRRADIANCE) || (i == MATERIAL_MAP_PREFILTER) || (i == MATERIAL_MAP_CUBEMAP)) {
+            rlEnableTextureCubemap(texture_id);
+        }
+        else {
+            rlEnableTexture(texture_id);
+        }
+        rlSetUniform(shader.locs[SHADER_LOC_MAP_DIFFUSE + i], &i, SHADER_UNIFORM_INT, 1);
+    }
+}
+
+void AM::State::m_unbind_render_material(const Material* material) {
+    for(int i = 0; i < MATERIAL_MAPS; i++) {
+        if(material->maps[i].texture.id == 0) {
+            continue;
+        }
+        rlActiveTextureSlot(i);
+        if((i == MATERIAL_MAP_IRRADIANCE) || (i == MATERIAL_MAP_PREFILTER) || (i == MATERIAL_MAP_CUBEMAP)) {
+            rlDisableTextureCubemap();
+        }
+        else {
+            rlDisableTexture();
+        }
+    }
+}
+
+void AM::State::m_draw_render_queue() {
+    this->render_queue.sort();
+
+    // Same uniforms as raylib's DrawMesh sets
+    // but the shader, material and mesh are bound only when they change.
+    const Matrix view = rlGetMatrixModelview();
+    const Matrix projection = rlGetMatrixProjection();
+    const Matrix view_projection = MatrixMultiply(view, projection);
+    const Matrix internal_transform = rlGetMatrixTransform();
+    const AM::MeshAttrib default_attrib;
+
+    int              pass = -1;
+    bool             backface = false;
+    unsigned int     bound_shader = 0;
+    const Material*  bound_material = NULL;
+    unsigned int     bound_vao = 0;
+    const Matrix*    bound_pose = NULL;
+    AM::UniformHandle skinned_uniform;
+    AM::UniformHandle wind_uniform;
+    AM::UniformHandle shine_uniform;
+    AM::UniformHandle specular_uniform;
+
+    for(size_t i = 0; i < this->render_queue.size(); i++) {
+        const AM::RenderPacket& packet = this->render_queue.sorted(i);
+        const Shader& shader = packet.material->shader;
+        const AM::MeshAttrib& attrib = packet.attrib ? *packet.attrib : default_attrib;
+
+        if(packet.pass != pass) {
+            pass = packet.pass;
+            if(pass == AM::RenderPass::RP_SKY) {
+                rlDisableDepthMask();
+            }
+            else {
+                rlEnableDepthMask();
+            }
+        }
+
+        const bool draw_backface = (pass == AM::RenderPass::RP_SKY) || attrib.render_backface;
+        if(draw_backface != backface) {
+            backface = draw_backface;
+            if(backface) {
+                rlDisableBackfaceCulling();
+            }
+            else {
+                rlEnableBackfaceCulling();
+            }
+        }
+
+        // Meshes without vertex array cant be bound once, leave them to raylib.
+        if(packet.mesh->vaoId == 0) {
+            Material material = *packet.material;
+            material.maps[MATERIAL_MAP_DIFFUSE].color = attrib.tint;
+            Mesh mesh = *packet.mesh;
+            if(packet.bone_matrices) {
+                mesh.boneMatrices = (Matrix*)packet.bone_matrices;
+            }
+            DrawMesh(mesh, material, packet.transform);
+            bound_shader = 0;
+            bound_material = NULL;
+            bound_vao = 0;
+            continue;
+        }
+
+        if(shader.id != bound_shader) {
+            if(bound_material) {
+                m_unbind_render_material(bound_material);
+            }
+            rlEnableShader(shader.id);
+            if(shader.locs[SHADER_LOC_MATRIX_VIEW] != -1) {
+                rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_VIEW], view);
+            }
+            if(shader.locs[SHADER_LOC_MATRIX_PROJECTION] != -1) {
+                rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_PROJECTION], projection);
+            }
+            skinned_uniform = AM::find_uniform(shader.id, "u_skinned");
+            wind_uniform = AM::find_uniform(shader.id, "u_affected_by_wind");
+            shine_uniform = AM::find_uniform(shader.id, "u_material_shine_level");
+            specular_uniform = AM::find_uniform(shader.id, "u_material_specular");
+            bound_shader = shader.id;
+            bound_material = NULL;
+            bound_pose = NULL;
+        }
+
+        if(packet.material != bound_material) {
+            if(bound_material) {
+                m_unbind_render_material(bound_material);
+            }
+            m_bind_render_material(packet.material);
+            bound_material = packet.material;
+        }
+
+        if(packet.mesh->vaoId != bound_vao) {
+            rlEnableVertexArray(packet.mesh->vaoId);
+            bound_vao = packet.mesh->vaoId;
+        }
+
+        // Without mesh attribute the material's own color is used.
+        const Color color = packet.attrib ? attrib.tint : packet.material->maps[MATERIAL_MAP_DIFFUSE].color;
+        if(shader.locs[SHADER_LOC_COLOR_DIFFUSE] != -1) {
+            const float values[4] = {
+                color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f
+            };
+            rlSetUniform(shader.locs[SHADER_LOC_COLOR_DIFFUSE], values, SHADER_UNIFORM_VEC4, 1);
+        }
+
+        // Instances showing the same animation frame share the bone matrices.
+        if(packet.bone_matrices && (packet.bone_matrices != bound_pose)
+        && (shader.locs[SHADER_LOC_BONE_MATRICES] != -1)) {
+            rlSetUniformMatrices(shader.locs[SHADER_LOC_BONE_MATRICES],
+                    packet.bone_matrices, packet.mesh->boneCount);
+            bound_pose = packet.bone_matrices;
+        }
+
+        // Values are cached, these do nothing when they dont change.
+        AM::set_uniform_int(skinned_uniform, (packet.bone_matrices != NULL));
+        AM::set_uniform_int(wind_uniform, attrib.affected_by_wind);
+        AM::set_uniform_float(shine_uniform, attrib.shine);
+        AM::set_uniform_float(specular_uniform, attrib.specular);
+
+        const Matrix model = MatrixMultiply(packet.transform, internal_transform);
+        if(shader.locs[SHADER_LOC_MATRIX_MODEL] != -1) {
+            rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_MODEL], model);
+        }
+        if(shader.locs[SHADER_LOC_MATRIX_NORMAL] != -1) {
+            rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_NORMAL], MatrixTranspose(MatrixInvert(model)));
+        }
+        rlSetUniformMatrix(shader.locs[SHADER_LOC_MATRIX_MVP], MatrixMultiply(model, view_projection));
+
+        if(packet.mesh->indices != NULL) {
+            rlDrawVertexArrayElements(0, packet.mesh->triangleCount * 3, 0);
+        }
+        else {
+            rlDrawVertexArray(0, packet.mesh->vertexCount);
+        }
+    }
+
+    // Leave the state as raylib expects it.
+    if(bound_material) {
+        m_unbind_render_material(bound_material);
+    }
+    rlActiveTextureSlot(0);
+    rlDisableVertexArray();
+    rlDisableShader();
+    rlEnableDepthMask();
+    rlEnableBackfaceCulling();
+
+    this->render_queue.clear();
+}
+
 void AM::State::m_render_default_iteminfo(const AM::Item* item) {
     Vector3 item_pos = Vector3(item->pos_x, item->pos_y, item->pos_z);
     Vector3 player_pos = this->player.position();
@@ -517,27 +710,15 @@ void AM::State::m_update_player() {
 }
 
 void AM::State::m_set_shader_uniforms() {
-    const Vector3 player_pos = this->player.position();
-    const float time = GetTime();
-    const float fog_density = this->net->dynamic_data.get_float(AM::NDD_ID::FOG_DENSITY);
-    const Vector3 fog_color = this->net->dynamic_data.get_vector3(AM::NDD_ID::FOG_COLOR);
-
-    // TODO: Use uniform buffer for data which may update every frame.
-
-    AM::set_uniform_vec3(this->shaders[AM::ShaderIDX::DEFAULT].id, "u_view_pos", player_pos);
-    AM::set_uniform_float(this->shaders[AM::ShaderIDX::DEFAULT].id, "u_timeofday_curve", this->timeofday_curve);
-    AM::set_uniform_float(this->shaders[AM::ShaderIDX::DEFAULT].id, "u_time", time);
-    AM::set_uniform_float(this->shaders[AM::ShaderIDX::DEFAULT].id, "u_fog_density", fog_density);
-    AM::set_uniform_vec3(this->shaders[AM::ShaderIDX::DEFAULT].id, "u_fog_color", fog_color);
-
-    AM::set_uniform_vec3(this->shaders[AM::ShaderIDX::DEFAULT_INSTANCED].id, "u_view_pos", player_pos);
-    AM::set_uniform_float(this->shaders[AM::ShaderIDX::DEFAULT_INSTANCED].id, "u_timeofday_curve", this->timeofday_curve);
-    AM::set_uniform_float(this->shaders[AM::ShaderIDX::DEFAULT_INSTANCED].id, "u_time", time);
-    AM::set_uniform_float(this->shaders[AM::ShaderIDX::DEFAULT_INSTANCED].id, "u_fog_density", fog_density);
-    AM::set_uniform_vec3(this->shaders[AM::ShaderIDX::DEFAULT_INSTANCED].id, "u_fog_color", fog_color);
-    
-    AM::set_uniform_float(this->shaders[AM::ShaderIDX::SKYBOX].id, "u_timeofday_curve", this->timeofday_curve);
-    AM::set_uniform_vec3(this->shaders[AM::ShaderIDX::SKYBOX].id, "u_fog_color", fog_color);
+    // Shared by all shaders. (see FRAME_GLSL)
+    const mFrameUniforms frame {
+        .view_pos = this->player.position(),
+        .time = (float)GetTime(),
+        .fog_color = this->net->dynamic_data.get_vector3(AM::NDD_ID::FOG_COLOR),
+        .fog_density = this->net->dynamic_data.get_float(AM::NDD_ID::FOG_DENSITY),
+        .timeofday_curve = this->timeofday_curve
+    };
+    m_frame_ubo.update_element(0, (void*)&frame, sizeof(frame));
 }
             
 void AM::State::m_render_skybox() {
@@ -547,12 +728,19 @@ void AM::State::m_render_skybox() {
     fog_color *= this->timeofday_curve;
     fog_color *= 0.5f;
 
-    rlDisableDepthMask();
-    rlDisableBackfaceCulling();
-
-    DrawModel(m_skybox_model, player_pos, 50.0f, BLACK);
-    rlEnableDepthMask();
-    rlEnableBackfaceCulling();
+    // Same as DrawModel(m_skybox_model, player_pos, 50.0f, BLACK)
+    static const AM::MeshAttrib skybox_attrib = { .tint = BLACK };
+    const Matrix transform = MatrixMultiply(
+            MatrixMultiply(m_skybox_model.transform, MatrixScale(50.0f, 50.0f, 50.0f)),
+            MatrixTranslate(player_pos.x, player_pos.y, player_pos.z));
+
+    for(int i = 0; i < m_skybox_model.meshCount; i++) {
+        this->render_queue.submit(AM::RenderPass::RP_SKY,
+                &m_skybox_model.meshes[i],
+                &m_skybox_model.materials[m_skybox_model.meshMaterial[i]],
+                transform,
+                &skybox_attrib);
+    }
 }
 
 
@@ -563,10 +751,18 @@ void AM::State::frame_begin() {
     ClearBackground(BLACK);
     BeginMode3D(this->player.camera);
 
+    m_view_frustum = AM::Culling::extract_frustum(
+            MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+
+    this->render_queue.begin(this->player.camera.position);
     m_render_skybox();
 
     this->update_lights();
-    this->terrain.render();
+    m_update_light_clusters();
+    this->terrain.render(m_view_frustum, &this->render_queue);
+
+    // The sky must be drawn before anything which is drawn immediately.
+    m_draw_render_queue();
 
     m_slow_fixed_tick_update();
     m_fast_fixed_tick_update();
@@ -585,6 +781,8 @@ void AM::State::frame_begin() {
 
 void AM::State::frame_end() {
     m_update_timeofday();
+    m_render_instances();
+    m_draw_render_queue();
     
     EndMode3D();
     EndTextureMode();
@@ -651,6 +849,22 @@ void AM::State::m_fast_fixed_tick_update() {
 
         this->terrain.update_chunkdata_queue();
 
+        // Unload far away chunks few at a time and let the server know
+        // so it can send them again when needed.
+        m_unloaded_chunk_positions.clear();
+        this->terrain.evict_far_chunks(
+                this->player.chunk_pos(),
+                AM::CHUNK_EVICTION_BUDGET_MS,
+                &m_unloaded_chunk_positions);
+
+        if(!m_unloaded_chunk_positions.empty()) {
+            this->net->packet.prepare(AM::PacketID::PLAYER_UNLOADED_CHUNKS);
+            for(const AM::ChunkPos& chunk_pos : m_unloaded_chunk_positions) {
+                this->net->packet.write<int>({ chunk_pos.x, chunk_pos.z });
+            }
+            this->net->send_packet(AM::NetProto::TCP);
+        }
+
         this->net->packet.prepare(AM::PacketID::PLAYER_MOVEMENT_AND_CAMERA);
         this->net->packet.write<int>({ this->net->player_id, this->player.animation_id() });
         this->net->packet.write<float>({
@@ -674,40 +888,6 @@ void AM::State::m_slow_fixed_tick_update() {
     if(slow_tick_timer->time_sc() >= AM::SLOW_FIXED_TICK_DELAY_SECONDS) {
         slow_tick_timer->reset();
 
-        // Unload far away chunks and send updates to the server.
-        // This should be optimized a bit in the future 
-        // but doesnt matter right now because this code runs only about every 4 seconds.
-
-        std::vector<AM::ChunkPos> unloaded_chunk_positions;
-        AM::ChunkPos player_chunk_pos = this->player.chunk_pos();
-
-        int num_chunks = 0;
-
-        for(auto chunk_it = this->terrain.chunk_map.begin();
-                chunk_it != this->terrain.chunk_map.end(); ) {
-            AM::Chunk* chunk = &chunk_it->second;
-            num_chunks++;
-            
-            if(!this->terrain.chunkpos_in_renderdist(player_chunk_pos, chunk->pos)) {
-                unloaded_chunk_positions.push_back(chunk->pos);
-                chunk->unload();
-                chunk_it = this->terrain.chunk_map.erase(chunk_it);
-                continue;
-            }
-
-            ++chunk_it;
-        }
-
-        if(!unloaded_chunk_positions.empty()) {
-            printf("[STATE]: Unloaded %li chunks.\n", unloaded_chunk_positions.size());
-            
-            this->net->packet.prepare(AM::PacketID::PLAYER_UNLOADED_CHUNKS);
-            for(const AM::ChunkPos& chunk_pos : unloaded_chunk_positions) {
-                this->net->packet.write<int>({ chunk_pos.x, chunk_pos.z });
-            }
-            this->net->send_packet(AM::NetProto::TCP);
-        }
-
         // Callback to user if needed.
         if(m_slow_fixed_tick_callback) {
             m_slow_fixed_tick_callback(this);
@@ -11,8 +11,14 @@
 #include "player.hpp"
 #include "shader_util.hpp"
 #include "uniform_buffer.hpp"
+#include "storage_buffer.hpp"
 #include "light.hpp"
+#include "light_store.hpp"
+#include "light_clusters.hpp"
 #include "renderable.hpp"
+#include "culling.hpp"
+#include "instance_batcher.hpp"
+#include "render_queue.hpp"
 #include "glsl_preproc.hpp"
 #include "util.hpp"
 #include "timer.hpp"
@@ -25,7 +31,7 @@
 namespace AM {
 
     //static constexpr int NUM_BLOOM_SAMPLES = 16;
-    static constexpr int MAX_LIGHTS = 64;
+    static constexpr int MAX_LIGHTS = 4096;
     static constexpr int CHAT_KEY = KEY_ENTER;
     static constexpr Vector3 UP_VECTOR = Vector3(0.0f, 1.0f, 0.0f);
     static constexpr float FRICTION_TCONST = 120.0f;
@@ -37,6 +43,7 @@ namespace AM {
         enum : int {
             DEFAULT,
             DEFAULT_INSTANCED,
+            DEFAULT_SKINNED,
             POST_PROCESSING,
             BLOOM_TRESHOLD,
             BLOOM_DOWNSAMPLE_FILTER,
@@ -80,6 +87,9 @@ namespace AM {
             Font         font;
             Player       player;
             Terrain      terrain;
+
+            // Cleared in 'frame_begin'. Packets submitted before 'frame_end' are drawn there.
+            AM::RenderQueue render_queue;
             ItemManager  item_manager;
             Network*     net;
             ClientConfig config;
@@ -107,9 +117,17 @@ namespace AM {
 
             // ===  LIGHTS ===
 
-            Light** add_light(const Light& light);
-            void    remove_light(Light** light);
-            void    update_lights();
+            // Returns invalid handle if there are already MAX_LIGHTS lights.
+            AM::LightHandle add_light(const Light& light);
+            void            remove_light(AM::LightHandle* handle); // Handle is made invalid.
+
+            // Return NULL if the light was removed.
+            // The pointers are valid until a light is added or removed.
+            const Light*    get_light(const AM::LightHandle& handle) const { return m_lights.get(handle); }
+            Light*          edit_light(const AM::LightHandle& handle) { return m_lights.edit(handle); }
+
+            // Uploads the lights changed with 'edit_light'
+            void            update_lights();
 
 
             // === NAMED TIMERS ===
@@ -158,6 +176,12 @@ namespace AM {
             void    set_vision_effect(float amount);
 
 
+            // Renders 'renderable' with 'transform' at the end of the frame.
+            // Submissions of the same renderable are drawn together with instancing.
+            // The renderable must use the DEFAULT shader and must stay loaded until 'frame_end'
+            void    render_instanced(AM::Renderable* renderable, const Matrix& transform);
+
+
             void set_fast_fixed_tick_callback(std::function<void(AM::State*)> callback) {
                 m_fast_fixed_tick_callback = callback;
             }
@@ -194,6 +218,24 @@ namespace AM {
             std::array<RenderTexture2D, RenderTargetIDX::NUM_TARGETS>
                 m_render_targets;
 
+            // Frustum of the camera for current frame.
+            AM::Frustum                      m_view_frustum;
+
+            // Rebuilt every frame for culling dropped items.
+            AM::CullBounds                   m_item_bounds;
+            std::vector<const AM::Item*>     m_cull_items;
+            std::vector<uint32_t>            m_visible_items;
+
+            std::vector<AM::ChunkPos>        m_unloaded_chunk_positions;
+
+            AM::InstanceBatcher              m_instance_batcher;
+            void                             m_render_instances();
+
+            // Sorts and draws everything in 'render_queue' and clears it.
+            void                             m_draw_render_queue();
+            void                             m_bind_render_material(const Material* material);
+            void                             m_unbind_render_material(const Material* material);
+
             void                             m_update_dropped_items();
             void                             m_render_default_iteminfo(const AM::Item* item);
             void                             m_render_skybox();
@@ -214,12 +256,22 @@ namespace AM {
 
     
 
-            UniformBuffer m_lights_ubo;
-            std::array<Light, MAX_LIGHTS> m_lights;
-            std::array<Light*, MAX_LIGHTS> m_light_ptrs { NULL };
-            size_t m_num_lights { 0 };
+            // Same layout as 'frame_ubo' in FRAME_GLSL. (std140)
+            struct mFrameUniforms {
+                Vector3 view_pos;
+                float   time;
+                Vector3 fog_color;
+                float   fog_density;
+                float   timeofday_curve;
+                float   padding[3];
+            };
+            UniformBuffer     m_frame_ubo;
 
-            std::map<int/*light ID*/, Light>        m_lights_pframe_map; // Previous frame lights.
+            AM::LightStore    m_lights { MAX_LIGHTS };
+            StorageBuffer     m_lights_ssbo;
+            StorageBuffer     m_light_clusters_ssbo;
+            AM::LightClusters m_light_clusters;
+            void              m_update_light_clusters();
        
 
 
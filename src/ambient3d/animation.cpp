@@ -43,6 +43,7 @@ void AM::Animation::unload() {
         delete[] m_animation_speeds;
         m_animation_speeds = NULL;
     }
+    m_pose_cache.clear();
     UnloadModelAnimations(m_anim_data, m_num_anims);
     m_anim_data = NULL;
     m_loaded = false;
@@ -95,5 +96,21 @@ void AM::Animation::update(uint32_t anim_index, float frame_time, Model* model)
     m_prev_anim_index = anim_index;
 }
 
+bool AM::Animation::init_pose_cache(const Model& model) {
+    if(!m_loaded) {
+        fprintf(stderr, "ERROR! %s: Animation must be loaded first.\n",
+                __func__);
+        return false;
+    }
+    return m_pose_cache.init(model.bindPose, model.boneCount, m_anim_data, m_num_anims);
+}
+
+const Matrix* AM::Animation::pose(uint32_t anim_index, float time) {
+    if(!m_loaded) { return NULL; }
+    if(anim_index >= m_pose_cache.num_anims()) { return NULL; }
 
+    const int frame = AM::sample_animation_frame(time,
+            m_animation_speeds[anim_index], m_pose_cache.frame_count(anim_index));
+    return m_pose_cache.get(anim_index, frame);
+}
 
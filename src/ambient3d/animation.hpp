@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include "raylib.h"
+#include "pose_cache.hpp"
 
 
 namespace AM {
@@ -16,9 +17,20 @@ namespace AM {
             void set_animation_speed  (uint32_t anim_index, float anim_speed);
             void update               (uint32_t anim_index, float frame_time, Model* model);
 
-            uint32_t  num_animations()  { return m_num_anims; }
+            // For GPU skinning. 'update' skins the vertices on the CPU
+            // and must not be used together with these.
+            bool          init_pose_cache (const Model& model);
+
+            // Bone matrices of the frame shown 'time' seconds after the animation started.
+            // Returns NULL if there is no pose. (see Renderable::set_pose)
+            const Matrix* pose            (uint32_t anim_index, float time);
+
+            uint32_t  num_animations() const { return m_num_anims; }
             bool      is_loaded()       { return m_loaded; }
 
+            const ModelAnimation* data() const { return m_anim_data; }
+            float     animation_speed(uint32_t anim_index) const { return m_animation_speeds[anim_index]; }
+
         private:
             
             ModelAnimation*  m_anim_data { NULL };
@@ -29,6 +41,8 @@ namespace AM {
             int       m_current_frame { 0 };
             float     m_animation_timer;
             float*    m_animation_speeds;
+
+            AM::PoseCache m_pose_cache;
     };
 
 };
@@ -0,0 +1,267 @@
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+#include "animator.hpp"
+#include "animation.hpp"
+#include "pose_cache.hpp"
+#include "raymath.h"
+
+
+static constexpr float DEFAULT_FRAME_DURATION = 0.05f;
+
+
+// Linear interpolation of translation and scale, normalized lerp of rotation.
+// Rotation of 'b' is flipped if needed so it goes the short way around.
+static void _blend_transforms(const Transform* a, const Transform* b, float t, Transform* out, int count) {
+    const float s = 1.0f - t;
+    for(int i = 0; i < count; i++) {
+        const Quaternion& qa = a[i].rotation;
+        const Quaternion& qb = b[i].rotation;
+        const float dot = qa.x * qb.x + qa.y * qb.y + qa.z * qb.z + qa.w * qb.w;
+        const float tb = (dot < 0.0f) ? -t : t;
+
+        Quaternion q;
+        q.x = qa.x * s + qb.x * tb;
+        q.y = qa.y * s + qb.y * tb;
+        q.z = qa.z * s + qb.z * tb;
+        q.w = qa.w * s + qb.w * tb;
+        const float len = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+        const float inv_len = (len > 0.0f) ? (1.0f / len) : 0.0f;
+
+        out[i].translation.x = a[i].translation.x * s + b[i].translation.x * t;
+        out[i].translation.y = a[i].translation.y * s + b[i].translation.y * t;
+        out[i].translation.z = a[i].translation.z * s + b[i].translation.z * t;
+        out[i].rotation.x = q.x * inv_len;
+        out[i].rotation.y = q.y * inv_len;
+        out[i].rotation.z = q.z * inv_len;
+        out[i].rotation.w = q.w * inv_len;
+        out[i].scale.x = a[i].scale.x * s + b[i].scale.x * t;
+        out[i].scale.y = a[i].scale.y * s + b[i].scale.y * t;
+        out[i].scale.z = a[i].scale.z * s + b[i].scale.z * t;
+    }
+}
+
+
+bool AM::Animator::init(const Transform* bind_pose, int bone_count,
+        const ModelAnimation* anims, uint32_t num_anims) {
+    this->clear();
+
+    if(bone_count > AM::MAX_SKINNING_BONES) {
+        fprintf(stderr, "ERROR! %s: Too many bones (%i), the limit is %i\n",
+                __func__, bone_count, AM::MAX_SKINNING_BONES);
+        return false;
+    }
+    for(uint32_t i = 0; i < num_anims; i++) {
+        if(anims[i].boneCount != bone_count) {
+            fprintf(stderr, "ERROR! %s: Number of bones in model and animation %i doesnt match.\n",
+                    __func__, i);
+            return false;
+        }
+    }
+
+    m_anims = anims;
+    m_bone_count = bone_count;
+    m_frame_durations.assign(num_anims, DEFAULT_FRAME_DURATION);
+    m_update_lengths();
+
+    m_bind_pose.assign(bind_pose, bind_pose + bone_count);
+    m_inverse_bind.resize(bone_count);
+    for(int i = 0; i < bone_count; i++) {
+        m_inverse_bind[i] = MatrixInvert(AM::transform_matrix(bind_pose[i]));
+    }
+    m_sample_current.resize(bone_count);
+    m_sample_previous.resize(bone_count);
+    return true;
+}
+
+bool AM::Animator::init(const Model& model, const AM::Animation& anim) {
+    if(!this->init(model.bindPose, model.boneCount, anim.data(), anim.num_animations())) {
+        return false;
+    }
+    for(uint32_t i = 0; i < m_frame_durations.size(); i++) {
+        this->set_frame_duration(i, anim.animation_speed(i));
+    }
+    return true;
+}
+
+void AM::Animator::clear() {
+    m_anims = NULL;
+    m_bone_count = 0;
+    m_frame_durations.clear();
+    m_lengths.clear();
+    m_active.clear();
+    m_anim.clear();
+    m_time.clear();
+    m_prev_anim.clear();
+    m_prev_time.clear();
+    m_fade.clear();
+    m_fade_rate.clear();
+    m_matrices.clear();
+    m_free_ids.clear();
+    m_inverse_bind.clear();
+    m_bind_pose.clear();
+    m_sample_current.clear();
+    m_sample_previous.clear();
+}
+
+void AM::Animator::m_update_lengths() {
+    m_lengths.resize(m_frame_durations.size());
+    for(size_t i = 0; i < m_lengths.size(); i++) {
+        // Empty animations get some length so the time can still wrap around.
+        m_lengths[i] = std::max(m_anims[i].frameCount, 1) * m_frame_durations[i];
+    }
+}
+
+void AM::Animator::set_frame_duration(uint32_t anim_index, float seconds) {
+    if(anim_index >= m_frame_durations.size()) {
+        fprintf(stderr, "ERROR! %s: anim_index(%i) is out of bounds.\n",
+                __func__, anim_index);
+        return;
+    }
+    if(seconds <= 0.0f) {
+        fprintf(stderr, "ERROR! %s: Frame duration must be more than zero.\n",
+                __func__);
+        return;
+    }
+    m_frame_durations[anim_index] = seconds;
+    m_update_lengths();
+}
+
+uint32_t AM::Animator::add(uint32_t anim_index) {
+    if(anim_index >= m_frame_durations.size()) {
+        anim_index = 0;
+    }
+
+    uint32_t id = 0;
+    if(!m_free_ids.empty()) {
+        id = m_free_ids.back();
+        m_free_ids.pop_back();
+    }
+    else {
+        id = (uint32_t)m_anim.size();
+        m_active.push_back(0);
+        m_anim.push_back(0);
+        m_time.push_back(0.0f);
+        m_prev_anim.push_back(0);
+        m_prev_time.push_back(0.0f);
+        m_fade.push_back(1.0f);
+        m_fade_rate.push_back(0.0f);
+        m_matrices.resize(m_matrices.size() + m_bone_count, MatrixIdentity());
+    }
+
+    m_active[id] = 1;
+    m_anim[id] = anim_index;
+    m_time[id] = 0.0f;
+    m_prev_anim[id] = anim_index;
+    m_prev_time[id] = 0.0f;
+    m_fade[id] = 1.0f;
+    m_fade_rate[id] = 0.0f;
+    return id;
+}
+
+void AM::Animator::remove(uint32_t id) {
+    if((id >= m_active.size()) || !m_active[id]) {
+        return;
+    }
+    m_active[id] = 0;
+    m_free_ids.push_back(id);
+}
+
+void AM::Animator::play(uint32_t id, uint32_t anim_index, float crossfade) {
+    if((id >= m_active.size()) || !m_active[id]) {
+        return;
+    }
+    if((anim_index >= m_frame_durations.size()) || (anim_index == m_anim[id])) {
+        return;
+    }
+
+    m_prev_anim[id] = m_anim[id];
+    m_prev_time[id] = m_time[id];
+    m_anim[id] = anim_index;
+    m_time[id] = 0.0f;
+
+    if(crossfade > 0.0f) {
+        m_fade[id] = 0.0f;
+        m_fade_rate[id] = 1.0f / crossfade;
+    }
+    else {
+        m_fade[id] = 1.0f;
+        m_fade_rate[id] = 0.0f;
+    }
+}
+
+const Matrix* AM::Animator::pose(uint32_t id) const {
+    if((id >= m_active.size()) || !m_active[id]) {
+        return NULL;
+    }
+    return &m_matrices[(size_t)id * m_bone_count];
+}
+
+void AM::Animator::m_sample(uint32_t anim_index, float time, Transform* out) const {
+    const ModelAnimation& anim = m_anims[anim_index];
+    if(anim.frameCount <= 0) {
+        std::copy(m_bind_pose.begin(), m_bind_pose.end(), out);
+        return;
+    }
+
+    // 'time' is already wrapped to the animation length.
+    const float frame_pos = time / m_frame_durations[anim_index];
+    const int   frame = std::clamp((int)frame_pos, 0, anim.frameCount - 1);
+    const float t = std::clamp(frame_pos - (float)frame, 0.0f, 1.0f);
+    const int   next_frame = (frame + 1) % anim.frameCount;
+
+    _blend_transforms(anim.framePoses[frame], anim.framePoses[next_frame], t, out, m_bone_count);
+}
+
+void AM::Animator::update(float frame_time) {
+    const size_t num = m_anim.size();
+    if((num == 0) || (m_bone_count == 0)) {
+        return;
+    }
+
+    // Playback state of every instance, one field at a time.
+    // (inactive ones are updated too, it is cheaper than checking)
+    float* time = m_time.data();
+    float* prev_time = m_prev_time.data();
+    float* fade = m_fade.data();
+    const float* fade_rate = m_fade_rate.data();
+    const float* lengths = m_lengths.data();
+    const uint32_t* anim = m_anim.data();
+    const uint32_t* prev_anim = m_prev_anim.data();
+
+    for(size_t i = 0; i < num; i++) {
+        fade[i] = std::min(fade[i] + frame_time * fade_rate[i], 1.0f);
+    }
+    for(size_t i = 0; i < num; i++) {
+        const float length = lengths[anim[i]];
+        const float t = time[i] + frame_time;
+        time[i] = t - floorf(t / length) * length;
+    }
+    for(size_t i = 0; i < num; i++) {
+        const float length = lengths[prev_anim[i]];
+        const float t = prev_time[i] + frame_time;
+        prev_time[i] = t - floorf(t / length) * length;
+    }
+
+    // Poses.
+    Transform* current = m_sample_current.data();
+    Transform* previous = m_sample_previous.data();
+    for(size_t i = 0; i < num; i++) {
+        if(!m_active[i]) {
+            continue;
+        }
+
+        m_sample(anim[i], time[i], current);
+        if(fade[i] < 1.0f) {
+            m_sample(prev_anim[i], prev_time[i], previous);
+            _blend_transforms(previous, current, fade[i], current, m_bone_count);
+        }
+
+        Matrix* matrices = &m_matrices[i * m_bone_count];
+        for(int b = 0; b < m_bone_count; b++) {
+            matrices[b] = MatrixMultiply(m_inverse_bind[b], AM::transform_matrix(current[b]));
+        }
+    }
+}
+
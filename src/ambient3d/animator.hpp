@@ -0,0 +1,96 @@
+#ifndef AMBIENT3D_ANIMATOR_HPP
+#define AMBIENT3D_ANIMATOR_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "raylib.h"
+
+
+// Plays animations of one model for many instances (remote players for example).
+//
+// Every instance has its own playhead, poses are interpolated between frames
+// so they dont depend on the frame rate, and changing the animation crossfades
+// from the previous one.
+//
+// Playback state is stored in one array per field and 'update' goes through
+// them one array at a time, then writes the bone matrices of all instances
+// to one contiguous buffer. (see Renderable::set_pose)
+//
+// Nothing in here touches OpenGL so it can be used and measured without a window.
+
+namespace AM {
+
+    class Animation;
+
+    static constexpr float ANIMATOR_DEFAULT_CROSSFADE = 0.2f; // Seconds.
+
+    class Animator {
+        public:
+
+            // 'bind_pose' is from the model and 'anims' from LoadModelAnimations.
+            // They must stay valid until 'clear'. Returns false if the bones dont match.
+            bool init(const Transform* bind_pose, int bone_count,
+                    const ModelAnimation* anims, uint32_t num_anims);
+
+            // Frame durations are taken from 'anim' (Animation::set_animation_speed)
+            bool init(const Model& model, const AM::Animation& anim);
+            void clear();
+
+            // Seconds per frame. Default is 0.05
+            void set_frame_duration(uint32_t anim_index, float seconds);
+
+            // Returns id of the new instance. Ids of removed instances are reused.
+            uint32_t add(uint32_t anim_index);
+            void     remove(uint32_t id);
+
+            // Starts 'anim_index' from the beginning if it isnt already playing.
+            // The previous animation fades out in 'crossfade' seconds.
+            void play(uint32_t id, uint32_t anim_index, float crossfade = ANIMATOR_DEFAULT_CROSSFADE);
+
+            // Advances every instance and computes their poses.
+            void update(float frame_time);
+
+            // Bone matrices from the last 'update' or NULL if the id is not valid.
+            // Valid until the next 'add' or 'update'
+            const Matrix* pose(uint32_t id) const;
+
+            uint32_t current_animation(uint32_t id) const { return m_anim[id]; }
+            float    current_time(uint32_t id) const { return m_time[id]; }
+            int      bone_count() const { return m_bone_count; }
+            size_t   num_instances() const { return m_anim.size() - m_free_ids.size(); }
+
+        private:
+
+            const ModelAnimation* m_anims { NULL };
+            int                   m_bone_count { 0 };
+
+            // For every animation.
+            std::vector<float>    m_frame_durations;
+            std::vector<float>    m_lengths;
+
+            // For every instance.
+            std::vector<uint8_t>  m_active;
+            std::vector<uint32_t> m_anim;
+            std::vector<float>    m_time;
+            std::vector<uint32_t> m_prev_anim;
+            std::vector<float>    m_prev_time;
+            std::vector<float>    m_fade;       // Weight of the current animation.
+            std::vector<float>    m_fade_rate;  // Added to 'm_fade' per second.
+            std::vector<Matrix>   m_matrices;   // 'm_bone_count' for every instance.
+
+            std::vector<uint32_t>  m_free_ids;
+            std::vector<Matrix>    m_inverse_bind;
+            std::vector<Transform> m_bind_pose;
+            std::vector<Transform> m_sample_current;
+            std::vector<Transform> m_sample_previous;
+
+            void m_update_lengths();
+            void m_sample(uint32_t anim_index, float time, Transform* out) const;
+    };
+
+};
+
+
+#endif
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cstring>
+
+#include "culling.hpp"
+
+
+void AM::CullBounds::clear() {
+    this->min_x.clear();
+    this->min_y.clear();
+    this->min_z.clear();
+    this->max_x.clear();
+    this->max_y.clear();
+    this->max_z.clear();
+    m_num_boxes = 0;
+}
+
+void AM::CullBounds::reserve(size_t num_boxes) {
+    num_boxes += 4;
+    this->min_x.reserve(num_boxes);
+    this->min_y.reserve(num_boxes);
+    this->min_z.reserve(num_boxes);
+    this->max_x.reserve(num_boxes);
+    this->max_y.reserve(num_boxes);
+    this->max_z.reserve(num_boxes);
+}
+
+void AM::CullBounds::add(const BoundingBox& box) {
+    // The arrays are padded to multiple of 4 for 'find_visible'.
+    // Padding is overwritten by the next box.
+    if(m_num_boxes % 4 == 0) {
+        const size_t padded_size = m_num_boxes + 4;
+        this->min_x.resize(padded_size);
+        this->min_y.resize(padded_size);
+        this->min_z.resize(padded_size);
+        this->max_x.resize(padded_size);
+        this->max_y.resize(padded_size);
+        this->max_z.resize(padded_size);
+    }
+
+    this->min_x[m_num_boxes] = box.min.x;
+    this->min_y[m_num_boxes] = box.min.y;
+    this->min_z[m_num_boxes] = box.min.z;
+    this->max_x[m_num_boxes] = box.max.x;
+    this->max_y[m_num_boxes] = box.max.y;
+    this->max_z[m_num_boxes] = box.max.z;
+    m_num_boxes++;
+}
+
+AM::Frustum AM::Culling::extract_frustum(const Matrix& m) {
+    // Rows of the matrix (raylib stores them as m0, m4, m8, m12 and so on)
+    const float r0[4] = { m.m0, m.m4, m.m8,  m.m12 };
+    const float r1[4] = { m.m1, m.m5, m.m9,  m.m13 };
+    const float r2[4] = { m.m2, m.m6, m.m10, m.m14 };
+    const float r3[4] = { m.m3, m.m7, m.m11, m.m15 };
+
+    const float* rows[3] = { r0, r1, r2 };
+    AM::Frustum frustum;
+
+    for(int i = 0; i < 3; i++) {
+        const float* r = rows[i];
+        const int p = i * 2;
+
+        // Left, bottom, near.
+        frustum.a[p] = r3[0] + r[0];
+        frustum.b[p] = r3[1] + r[1];
+        frustum.c[p] = r3[2] + r[2];
+        frustum.d[p] = r3[3] + r[3];
+        
+        // Right, top, far.
+        frustum.a[p+1] = r3[0] - r[0];
+        frustum.b[p+1] = r3[1] - r[1];
+        frustum.c[p+1] = r3[2] - r[2];
+        frustum.d[p+1] = r3[3] - r[3];
+    }
+
+    return frustum;
+}
+
+// 4 boxes are tested at once with GCC/Clang vector extensions.
+// They compile to SSE on x86 and NEON on ARM.
+typedef float   v4f __attribute__((vector_size(16)));
+typedef int32_t v4i __attribute__((vector_size(16)));
+
+static inline v4f _load4(const float* p) {
+    v4f v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline v4f _max4(v4f a, v4f b) {
+    return (a > b) ? a : b;
+}
+
+size_t AM::Culling::find_visible(
+        const Frustum& frustum,
+        const CullBounds& bounds,
+        const Vector3& origin,
+        float max_distance,
+        std::vector<uint32_t>* visible_out
+){
+    const size_t num_boxes = bounds.size();
+    const v4f zero = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const v4f origin_x = zero + origin.x;
+    const v4f origin_y = zero + origin.y;
+    const v4f origin_z = zero + origin.z;
+    const v4f max_distance_sq = zero + max_distance * max_distance;
+
+    // CullBounds keeps the arrays padded to multiple of 4.
+    visible_out->resize(num_boxes + 4);
+    uint32_t* visible = visible_out->data();
+    size_t num_visible = 0;
+
+    for(size_t i = 0; i < num_boxes; i += 4) {
+        const v4f min_x = _load4(&bounds.min_x[i]);
+        const v4f min_y = _load4(&bounds.min_y[i]);
+        const v4f min_z = _load4(&bounds.min_z[i]);
+        const v4f max_x = _load4(&bounds.max_x[i]);
+        const v4f max_y = _load4(&bounds.max_y[i]);
+        const v4f max_z = _load4(&bounds.max_z[i]);
+
+        // Distance from origin to the closest point of the box.
+        const v4f dx = _max4(_max4(min_x - origin_x, origin_x - max_x), zero);
+        const v4f dy = _max4(_max4(min_y - origin_y, origin_y - max_y), zero);
+        const v4f dz = _max4(_max4(min_z - origin_z, origin_z - max_z), zero);
+        v4i inside = (dx*dx + dy*dy + dz*dz) <= max_distance_sq;
+
+        // The box is outside if its corner furthest along the plane normal is behind the plane.
+        // Which corner that is depends only on the plane.
+        for(int p = 0; p < 6; p++) {
+            const float a = frustum.a[p];
+            const float b = frustum.b[p];
+            const float c = frustum.c[p];
+            const v4f px = (a >= 0.0f) ? max_x : min_x;
+            const v4f py = (b >= 0.0f) ? max_y : min_y;
+            const v4f pz = (c >= 0.0f) ? max_z : min_z;
+            inside &= (a * px + b * py + c * pz + frustum.d[p]) >= zero;
+        }
+
+        // Compact the visible indices without branching.
+        for(int k = 0; k < 4; k++) {
+            visible[num_visible] = (uint32_t)(i + k);
+            num_visible += (inside[k] != 0) & ((i + k) < num_boxes);
+        }
+    }
+
+    visible_out->resize(num_visible);
+    return num_visible;
+}
+
@@ -0,0 +1,67 @@
+#ifndef AMBIENT3D_CULLING_HPP
+#define AMBIENT3D_CULLING_HPP
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "raylib.h"
+
+
+// Frustum and distance culling for axis aligned bounding boxes.
+// Nothing in here touches OpenGL so it can be used and measured without a window.
+
+namespace AM {
+
+    // Planes are stored as (a, b, c, d) where a*x + b*y + c*z + d >= 0 is inside.
+    // Order: left, right, bottom, top, near, far.
+    struct Frustum {
+        std::array<float, 6> a;
+        std::array<float, 6> b;
+        std::array<float, 6> c;
+        std::array<float, 6> d;
+    };
+
+    // Bounding boxes in structure of arrays layout
+    // so the plane tests can be done for many boxes at once.
+    class CullBounds {
+        public:
+
+            void   clear();
+            void   reserve(size_t num_boxes);
+            void   add(const BoundingBox& box);
+            size_t size() const { return m_num_boxes; }
+
+            std::vector<float> min_x;
+            std::vector<float> min_y;
+            std::vector<float> min_z;
+            std::vector<float> max_x;
+            std::vector<float> max_y;
+            std::vector<float> max_z;
+
+        private:
+            size_t m_num_boxes { 0 };
+    };
+
+    namespace Culling {
+
+        // 'view_projection' is the matrix used for transforming world positions into clip space.
+        // With raylib: MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection())
+        Frustum extract_frustum(const Matrix& view_projection);
+
+        // Writes indices of the boxes which are at least partially inside of the frustum
+        // and not further than 'max_distance' away from 'origin' into 'visible_out'.
+        // Returns number of visible boxes.
+        size_t find_visible(
+                const Frustum& frustum,
+                const CullBounds& bounds,
+                const Vector3& origin,
+                float max_distance,
+                std::vector<uint32_t>* visible_out);
+    };
+
+};
+
+
+#endif
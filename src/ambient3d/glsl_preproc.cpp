@@ -1,122 +1,221 @@
 #include <map>
+#include <algorithm>
+#include <vector>
+#include <string_view>
 #include <cstring>
 #include <cstdio>
 #include <filesystem>
 #include <fstream>
+#include <system_error>
 
 #include "glsl_preproc.hpp"
 
 
 namespace {
-    static std::map<std::string, std::string> memincludes;
+    static std::map<std::string, std::string, std::less<>> memincludes;
+    static size_t memincludes_size = 0; // Bytes of all memory includes.
     static constexpr const char* INCLUDE_TAG = "#include";
     static constexpr int INCLUDE_TAG_LENGTH = strlen(INCLUDE_TAG);
+    static constexpr const char* VERSION_TAG = "#version";
+    static constexpr int VERSION_TAG_LENGTH = strlen(VERSION_TAG);
 
     static const std::string 
         RENDER_INSTANCED_STR = "#define RENDER_INSTANCED\n";
+    static const std::string 
+        RENDER_SKINNED_STR = "#define RENDER_SKINNED\n";
+
+    struct mIncludeFile {
+        std::filesystem::file_time_type write_time;
+        std::string                     code;
+    };
+    static std::map<std::string, mIncludeFile> include_files;
+
+    struct mExpandState {
+        std::vector<std::string_view> included; // Only a few per shader.
+        std::string                   definitions;
+        bool                          version_found { false };
+    };
 };
 
 
-std::string AM::GLSL_preproc(std::string code, int flags) {
+// Contents of included files are read again only if the file has changed.
+static const std::string* _read_include_file(const std::string& path) {
+    std::error_code error;
+    const std::filesystem::file_time_type write_time = std::filesystem::last_write_time(path, error);
+    if(error) {
+        fprintf(stderr, "ERROR! %s: Failed to open file \"%s\"\n",
+                __func__, path.c_str());
+        return NULL;
+    }
 
+    const auto search = ::include_files.find(path);
+    if((search != ::include_files.end()) && (search->second.write_time == write_time)) {
+        return &search->second.code;
+    }
 
-    std::string::size_type search_pos = 0;
+    std::ifstream stream(path, std::ios::ate | std::ios::in | std::ios::binary);
+    if(!stream.is_open()) {
+        fprintf(stderr, "ERROR! %s: Failed to open file \"%s\"\n",
+                __func__, path.c_str());
+        return NULL;
+    }
+    const size_t file_size = static_cast<size_t>(stream.tellg());
+    mIncludeFile file;
+    file.write_time = write_time;
+    file.code.resize(file_size);
+    stream.seekg(0);
+    stream.read(&file.code[0], file_size);
+
+    mIncludeFile& stored = ::include_files[path];
+    stored = std::move(file);
+    return &stored.code;
+}
 
-    while(true) {
-        std::string::size_type include_begin = 
-            code.find(::INCLUDE_TAG, search_pos);
+// Appends code[begin..end) to 'out'.
+// Definitions from the flags are added after the first #version line.
+static void _append(const std::string& code, size_t begin, size_t end, std::string* out, mExpandState* state) {
+    if(!state->version_found && (begin < end)) {
+        // Searched only from the appended part.
+        const size_t found = std::string_view(code).substr(begin, end - begin).find(::VERSION_TAG);
+        const size_t version = (found == std::string_view::npos) ? found : (begin + found);
+        if(version != std::string::npos) {
+            size_t version_end = code.find('\n', version);
+            version_end = (version_end == std::string::npos) ? code.size() : version_end;
+            out->append(code, begin, version_end - begin);
+            out->push_back('\n');
+            out->append(state->definitions);
+            state->version_found = true;
+            begin = std::min(version_end + 1, end);
+        }
+    }
+    out->append(code, begin, end - begin);
+}
 
-        if(include_begin == std::string::npos) {
+// Includes are expanded in place while the code is copied to 'out'.
+// Each include is expanded only the first time it is seen.
+static void _expand(const std::string& code, std::string* out, mExpandState* state) {
+    size_t pos = 0;
+    while(true) {
+        const size_t tag = code.find(::INCLUDE_TAG, pos);
+        if(tag == std::string::npos) {
+            _append(code, pos, code.size(), out, state);
             break;
         }
-        std::string::size_type include_value_begin 
-            = include_begin + ::INCLUDE_TAG_LENGTH+1;
-        search_pos = include_begin;
 
-        std::string::size_type include_end =
-            code.find('\n', include_begin);
+        // Only whitespace can be before the tag on its line.
+        size_t line_begin = code.find_last_of('\n', tag);
+        line_begin = (line_begin == std::string::npos) ? 0 : (line_begin + 1);
+        if(code.find_first_not_of(" \t", line_begin) != tag) {
+            _append(code, pos, tag + ::INCLUDE_TAG_LENGTH, out, state);
+            pos = tag + ::INCLUDE_TAG_LENGTH;
+            continue;
+        }
+
+        size_t line_end = code.find('\n', tag);
+        line_end = (line_end == std::string::npos) ? code.size() : line_end;
 
-        if(include_end == std::string::npos) {
-            fprintf(stderr, "ERROR! %s: Could not find where the '%s <value>' ends. No newline was found.\n",
+        _append(code, pos, line_begin, out, state);
+        pos = std::min(line_end + 1, code.size());
+
+        const size_t value_begin = code.find_first_not_of(" \t", tag + ::INCLUDE_TAG_LENGTH);
+        const size_t value_end = code.find_last_not_of(" \t\r", line_end - 1);
+        if((value_begin >= line_end) || (value_end < value_begin) || (value_end == std::string::npos)) {
+            fprintf(stderr, "ERROR! %s: Missing value for '%s'\n",
                     __func__, ::INCLUDE_TAG);
-            break;
+            continue;
         }
 
-        std::string value = code.substr(include_value_begin, 
-                include_end - include_value_begin);
+        // 'code' outlives the expansion so the value can point to it.
+        const std::string_view value(code.data() + value_begin, value_end + 1 - value_begin);
+        if(std::find(state->included.begin(), state->included.end(), value) != state->included.end()) {
+            continue; // Already included.
+        }
+        state->included.push_back(value);
 
         if(value[0] == '@') {
             // Try to find code to include from hashmap.
-            value.erase(0, 1);
-
-            const auto search = ::memincludes.find(value);
+            const auto search = ::memincludes.find(value.substr(1));
             if(search == ::memincludes.end()) {
-                fprintf(stderr, "ERROR! %s: Could not find memory include \"%s\"\n",
-                        __func__, value.c_str());
-                break;
+                fprintf(stderr, "ERROR! %s: Could not find memory include \"%.*s\"\n",
+                        __func__, (int)value.size() - 1, value.data() + 1);
+                continue;
             }
-
-            code.erase(include_begin, include_end - include_begin);
-            code.insert(include_begin+1, search->second);
+            _expand(search->second, out, state);
         }
         else
-        if(value[0] == '"') {
+        if((value[0] == '"') && (value.size() >= 2) && (value.back() == '"')) {
             // Try to find file to include.
-
-            value.erase(0, 1);
-            value.erase(value.size()-1, 1);
-
-            std::ifstream stream(value, std::ios::ate | std::ios::in);
-            if(!stream.is_open()) {
-                fprintf(stderr, "ERROR! %s: Failed to open file \"%s\"\n",
-                        __func__, value.c_str());
+            const std::string* file_code = _read_include_file(std::string(value.substr(1, value.size() - 2)));
+            if(file_code) {
+                _expand(*file_code, out, state);
             }
-           
-            size_t file_size = static_cast<size_t>(stream.tellg());
-            std::string tmp(file_size, '\0');
-            stream.seekg(0);
-            stream.read(&tmp[0], file_size);
-            
-            stream.close();
-            code.erase(include_begin, include_end - include_begin);
-        
-            code.insert(include_begin+1, tmp);
         }
         else {
             fprintf(stderr, "ERROR! %s: Invalid value prefix for \"%s\": '%c'\n",
                     __func__, ::INCLUDE_TAG, value[0]);
-            fprintf(stderr, "     '-> %s\n", value.c_str());
-            break;
+            fprintf(stderr, "     '-> %.*s\n", (int)value.size(), value.data());
+            continue;
         }
-    }
 
-    if(flags == PREPROC_FLAGS::DEFINE__RENDER_INSTANCED) {
-        std::string::size_type version_begin = code.find("#version", 0);
-        if(version_begin == std::string::npos) {
-            fprintf(stderr, "ERROR! %s: The shader seems to not have version."
-                            " Cant add definition for instanced rendering.\n",
-                            __func__);
-            return std::string();
-        }
-            
-        std::string::size_type version_end = code.find('\n', version_begin);
-        if(version_end == std::string::npos) {
-            fprintf(stderr, "ERROR! %s: Could not find new line after #version while"
-                            " trying to add definition for instanced rendering.\n",
-                            __func__);
-            return std::string();
+        if(!out->empty() && (out->back() != '\n')) {
+            out->push_back('\n');
         }
+    }
+}
+
+
+uint64_t AM::GLSL_hash(const std::string& data, uint64_t hash) {
+    const char* ptr = data.data();
+    size_t size = data.size();
+    while(size >= sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, ptr, sizeof(word));
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+        hash ^= hash >> 29;
+        ptr += sizeof(word);
+        size -= sizeof(word);
+    }
+    for(; size > 0; size--, ptr++) {
+        hash = (hash ^ (uint8_t)*ptr) * 0x100000001B3ULL;
+    }
+
+    // splitmix64 finalizer.
+    hash ^= data.size();
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
 
-        code.insert(version_end+1, ::RENDER_INSTANCED_STR);
-    } 
+std::string AM::GLSL_preproc(const std::string& code, int flags) {
+    mExpandState state;
+    if((flags & PREPROC_FLAGS::DEFINE__RENDER_INSTANCED)) {
+        state.definitions += ::RENDER_INSTANCED_STR;
+    }
+    if((flags & PREPROC_FLAGS::DEFINE__RENDER_SKINNED)) {
+        state.definitions += ::RENDER_SKINNED_STR;
+    }
 
-    //printf("%s\n", code.c_str());
+    // Enough unless included files are large.
+    std::string result;
+    result.reserve(code.size() + ::memincludes_size + state.definitions.size());
+    _expand(code, &result, &state);
 
-    return code;
+    if((flags != 0) && !state.version_found) {
+        fprintf(stderr, "ERROR! %s: The shader seems to not have version."
+                        " Cant add definitions from flags.\n",
+                        __func__);
+        return std::string();
+    }
+
+    //printf("%s\n", result.c_str());
+
+    return result;
 }
 
     
 void AM::GLSL_preproc_add_meminclude(const std::string& tag_name, const std::string& code) {
-    ::memincludes.insert(std::make_pair(tag_name, code));
+    if(::memincludes.insert(std::make_pair(tag_name, code)).second) {
+        ::memincludes_size += code.size();
+    }
 }
 
@@ -2,6 +2,7 @@
 #define AMBIENT3D_GLSL_PREPROCESSOR_HPP
 
 #include <string>
+#include <cstdint>
 
 
 /*
@@ -18,10 +19,18 @@
 namespace AM {
 
     enum PREPROC_FLAGS : int {
-        DEFINE__RENDER_INSTANCED = 1 // Adds "#define RENDER_INSTANCED"
+        DEFINE__RENDER_INSTANCED = 1 << 0, // Adds "#define RENDER_INSTANCED"
+        DEFINE__RENDER_SKINNED   = 1 << 1  // Adds "#define RENDER_SKINNED"
     };
 
-    std::string GLSL_preproc(std::string code, int flags = 0);
+    static constexpr uint64_t GLSL_HASH_SEED = 0xCBF29CE484222325ULL;
+
+    // Includes are expanded in one pass and each of them only once.
+    // Included files are read again only when their write time changes.
+    std::string GLSL_preproc(const std::string& code, int flags = 0);
+
+    // 64 bit hash, 8 bytes at a time. 'hash' can be previous result to continue it.
+    uint64_t GLSL_hash(const std::string& data, uint64_t hash = GLSL_HASH_SEED);
     void GLSL_preproc_add_meminclude(const std::string& tag_name, const std::string& code);
 };
 
@@ -0,0 +1,54 @@
+#include <algorithm>
+
+#include "instance_batcher.hpp"
+
+
+void AM::InstanceBatcher::clear() {
+    m_group_keys.clear();
+    m_instance_groups.clear();
+    m_submitted_transforms.clear();
+    m_batches.clear();
+    m_transforms.clear();
+    m_last_key = NULL;
+    m_last_group = 0;
+}
+
+void AM::InstanceBatcher::submit(void* key, const Matrix& transform) {
+    uint32_t group = m_last_group;
+    if((key != m_last_key) || m_group_keys.empty()) {
+        // Number of different objects is small so searching is faster than hashing.
+        const auto search = std::find(m_group_keys.begin(), m_group_keys.end(), key);
+        group = (uint32_t)(search - m_group_keys.begin());
+        if(search == m_group_keys.end()) {
+            m_group_keys.push_back(key);
+        }
+        m_last_key = key;
+        m_last_group = group;
+    }
+
+    m_instance_groups.push_back(group);
+    m_submitted_transforms.push_back(transform);
+}
+
+void AM::InstanceBatcher::build() {
+    // Counting sort by group.
+    m_group_counts.assign(m_group_keys.size(), 0);
+    for(const uint32_t group : m_instance_groups) {
+        m_group_counts[group]++;
+    }
+
+    m_batches.resize(m_group_keys.size());
+    uint32_t first = 0;
+    for(size_t i = 0; i < m_group_keys.size(); i++) {
+        m_batches[i] = Batch{ m_group_keys[i], first, 0 };
+        first += m_group_counts[i];
+    }
+
+    m_transforms.resize(m_submitted_transforms.size());
+    for(size_t i = 0; i < m_submitted_transforms.size(); i++) {
+        Batch& batch = m_batches[m_instance_groups[i]];
+        m_transforms[batch.first + batch.count] = m_submitted_transforms[i];
+        batch.count++;
+    }
+}
+
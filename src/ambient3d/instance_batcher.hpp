@@ -0,0 +1,63 @@
+#ifndef AMBIENT3D_INSTANCE_BATCHER_HPP
+#define AMBIENT3D_INSTANCE_BATCHER_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "raylib.h"
+
+
+// Groups objects submitted during the frame by what they render
+// so each group can be drawn with one instanced draw call per mesh.
+//
+// Transforms of a group are next to each other in 'transforms()'
+// in the order they were submitted.
+//
+// Nothing in here touches OpenGL so it can be used and measured without a window.
+
+namespace AM {
+
+    // Smaller groups are rendered normally.
+    // (raylib creates a vertex buffer for every instanced draw)
+    static constexpr uint32_t INSTANCED_RENDER_MIN_INSTANCES = 2;
+
+    class InstanceBatcher {
+        public:
+
+            struct Batch {
+                void*    key;    // What was submitted. (AM::Renderable* in the engine)
+                uint32_t first;  // Index in 'transforms()'
+                uint32_t count;
+            };
+
+            void clear();
+            void submit(void* key, const Matrix& transform);
+            size_t num_submitted() const { return m_submitted_transforms.size(); }
+
+            // Groups the submitted instances. Batches are ordered by the first time
+            // their key was submitted.
+            void build();
+
+            const std::vector<Batch>&  batches() const { return m_batches; }
+            const std::vector<Matrix>& transforms() const { return m_transforms; }
+
+        private:
+
+            std::vector<void*>     m_group_keys;
+            std::vector<uint32_t>  m_instance_groups; // Group of each submitted transform.
+            std::vector<Matrix>    m_submitted_transforms;
+
+            // Key of the previous submit. Same object is usually submitted many times in a row.
+            void*    m_last_key { NULL };
+            uint32_t m_last_group { 0 };
+
+            std::vector<uint32_t>  m_group_counts;
+            std::vector<Batch>     m_batches;
+            std::vector<Matrix>    m_transforms;
+    };
+
+};
+
+
+#endif
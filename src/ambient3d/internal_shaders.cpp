@@ -13,6 +13,7 @@ std::string AM::ShaderCode::get(GLSL_CodeID codeid) {
         case AM::ShaderCode::DEFAULT_VERTEX:
             return R"(
             #include @GLSL_VERSION
+            #include @AMBIENT3D_FRAME
 
             in vec3 vertexPosition;
             in vec2 vertexTexcoord;
@@ -23,12 +24,19 @@ std::string AM::ShaderCode::get(GLSL_CodeID codeid) {
                 in mat4 instanceTransform;
             #endif
 
+            #ifdef RENDER_SKINNED
+                #define MAX_BONES 128
+                in vec4 vertexBoneIds;
+                in vec4 vertexBoneWeights;
+                uniform mat4 boneMatrices[MAX_BONES];
+                uniform int  u_skinned;
+            #endif
+
             uniform mat4 mvp;
             uniform mat4 matModel;
             uniform mat4 matNormal;
            
             uniform int    u_affected_by_wind;
-            uniform float  u_time;
 
             out vec2 frag_texcoord;
             out vec4 frag_color;
@@ -40,6 +48,19 @@ std::string AM::ShaderCode::get(GLSL_CodeID codeid) {
                 frag_texcoord = vertexTexcoord;
                 frag_color = vertexColor;
                 vec3 vertex_pos = vertexPosition;
+                vec3 vertex_normal = vertexNormal;
+
+                #ifdef RENDER_SKINNED
+                if(u_skinned == 1) {
+                    mat4 skin
+                        = boneMatrices[int(vertexBoneIds.x)] * vertexBoneWeights.x
+                        + boneMatrices[int(vertexBoneIds.y)] * vertexBoneWeights.y
+                        + boneMatrices[int(vertexBoneIds.z)] * vertexBoneWeights.z
+                        + boneMatrices[int(vertexBoneIds.w)] * vertexBoneWeights.w;
+                    vertex_pos = vec3(skin * vec4(vertex_pos, 1.0));
+                    vertex_normal = vec3(skin * vec4(vertex_normal, 0.0));
+                }
+                #endif
 
                 if(u_affected_by_wind == 1) {
                     float T = u_time * 3.0;
@@ -48,11 +69,11 @@ std::string AM::ShaderCode::get(GLSL_CodeID codeid) {
                 }
                 #ifdef RENDER_INSTANCED
                     frag_position = vec3(instanceTransform*vec4(vertex_pos, 1.0)); 
-                    frag_normal = vec3(instanceTransform * vec4(vertexNormal, 0.0));
+                    frag_normal = vec3(instanceTransform * vec4(vertex_normal, 0.0));
                     gl_Position = mvp*instanceTransform*vec4(vertex_pos, 1.0);
                 #else
                     frag_position = vec3(matModel*vec4(vertex_pos, 1.0));
-                    frag_normal = normalize(vec3(matNormal * vec4(vertexNormal, 1.0)));
+                    frag_normal = normalize(vec3(matNormal * vec4(vertex_normal, 1.0)));
                     gl_Position = mvp * vec4(vertex_pos, 1.0);
                 #endif
             }
@@ -61,6 +82,7 @@ std::string AM::ShaderCode::get(GLSL_CodeID codeid) {
         case AM::ShaderCode::DEFAULT_FRAGMENT:
             return R"(
             #include @GLSL_VERSION
+            #include @AMBIENT3D_FRAME
             #include @AMBIENT3D_LIGHTS
             #include @AMBIENT3D_FOG
             
@@ -72,12 +94,8 @@ std::string AM::ShaderCode::get(GLSL_CodeID codeid) {
 
             uniform sampler2D texture0;
             uniform vec4 colDiffuse;
-            uniform vec3 u_view_pos;
             uniform float u_material_shine_level;
             uniform float u_material_specular;
-            uniform float u_timeofday_curve;
-            uniform float u_fog_density;
-            uniform vec3 u_fog_color;
 
             out vec4 out_color;
 
@@ -118,6 +136,7 @@ std::string AM::ShaderCode::get(GLSL_CodeID codeid) {
         case AM::ShaderCode::SKYBOX_FRAGMENT:
             return R"(
             #include @GLSL_VERSION
+            #include @AMBIENT3D_FRAME
             #include @AMBIENT3D_LIGHTS
             #include @AMBIENT3D_FOG
             
@@ -129,8 +148,6 @@ std::string AM::ShaderCode::get(GLSL_CodeID codeid) {
 
             uniform sampler2D texture0;
             uniform vec4 colDiffuse;
-            uniform float u_timeofday_curve;
-            uniform vec3 u_fog_color;
 
             out vec4 out_color;
 
@@ -181,21 +198,56 @@ std::string AM::ShaderCode::get(GLSL_CodeID codeid) {
             }
             )";
 
-        case AM::ShaderCode::LIGHTS_GLSL:
+        case AM::ShaderCode::FRAME_GLSL:
             return R"(
-            #define MAX_LIGHTS 64
+            // Updated once per frame. (see AM::State::m_set_shader_uniforms)
+            layout(std140, binding = 0) uniform frame_ubo {
+                vec3  u_view_pos;
+                float u_time;
+                vec3  u_fog_color;
+                float u_fog_density;
+                float u_timeofday_curve;
+            };
+            )";
 
+        case AM::ShaderCode::LIGHTS_GLSL:
+            return R"(
             struct Light {
                 vec4 pos;
                 vec4 color;
-                vec4 settings;
+                vec4 settings; // radius, cutoff, range
+            };
+
+            layout(std430, binding = 1) readonly buffer lights_ssbo {
+                Light lights[];
             };
 
-            layout(std140, binding = 1) uniform lights_ubo {
-                Light lights[MAX_LIGHTS];
-                int num_lights;
+            // See src/ambient3d/light_clusters.hpp
+            layout(std430, binding = 2) readonly buffer light_clusters_ssbo {
+                vec4  light_cluster_depth;  // near, slice scale, projection near, projection far
+                vec4  light_cluster_screen; // width, height
+                uvec4 light_cluster_dims;
+                uint  light_cluster_data[];
             };
 
+            uint find_light_cluster() {
+                float near = light_cluster_depth.z;
+                float far = light_cluster_depth.w;
+                float z_ndc = gl_FragCoord.z * 2.0 - 1.0;
+                float depth = (2.0 * near * far) / max(far + near - z_ndc * (far - near), 0.0001);
+
+                uint slice = 0;
+                if(depth >= light_cluster_depth.x) {
+                    slice = min(1 + uint(log(depth / light_cluster_depth.x) * light_cluster_depth.y),
+                            light_cluster_dims.z - 1);
+                }
+
+                uvec2 tile = uvec2(gl_FragCoord.xy / light_cluster_screen.xy * vec2(light_cluster_dims.xy));
+                tile = min(tile, light_cluster_dims.xy - 1);
+
+                return (slice * light_cluster_dims.y + tile.y) * light_cluster_dims.x + tile.x;
+            }
+
             // Returns RGB.
             vec3 compute_sun(
                 vec3 frag_pos,
@@ -226,15 +278,22 @@ std::string AM::ShaderCode::get(GLSL_CodeID codeid) {
                 vec3 final = vec3(0, 0, 0);
                 vec3 normal = normalize(frag_n);
                 //normal = mix(normal, vec3(0.0, 1.0, 0.0), 0.3);
-                for(int i = 0; i < num_lights; i++) {
-                    vec3 light_pos = lights[i].pos.xyz;
+
+                uint cluster = find_light_cluster();
+                uint first = light_cluster_data[cluster * 2 + 0];
+                uint count = light_cluster_data[cluster * 2 + 1];
+
+                for(uint i = 0; i < count; i++) {
+                    Light light = lights[light_cluster_data[first + i]];
+                    vec3 light_pos = light.pos.xyz;
                     vec3 light_dir = normalize(light_pos - frag_pos);
                     vec3 view_dir = normalize(view_pos - frag_pos);
                     vec3 halfway_dir = normalize(light_dir - view_dir);
 
-                    vec3 light_color = lights[i].color.rgb;
-                    float radius = lights[i].settings.x;
-                    float cutoff = lights[i].settings.y;
+                    vec3 light_color = light.color.rgb;
+                    float radius = light.settings.x;
+                    float cutoff = light.settings.y;
+                    float range = light.settings.z;
 
 
                     // Diffuse.
@@ -252,6 +311,9 @@ std::string AM::ShaderCode::get(GLSL_CodeID codeid) {
                     float dist = distance(frag_pos, light_pos) / radius;
                     dist = pow(dist, cutoff);
                     float a = 1.0 / (2.0 + L * dist + Q * (dist * dist));
+
+                    // Fade out near the end of the range so cluster edges are not visible.
+                    a *= 1.0 - smoothstep(range * 0.75, range, distance(frag_pos, light_pos));
                     
                     diffuse *= a;
                     specular *= (a*0.5);
@@ -267,6 +329,7 @@ std::string AM::ShaderCode::get(GLSL_CodeID codeid) {
         case AM::ShaderCode::POSTPROCESS_FRAGMENT:
             return R"(
             #include @GLSL_VERSION
+            #include @AMBIENT3D_FRAME
             
             in vec2 frag_texcoord;
             in vec4 frag_color;
@@ -275,7 +338,6 @@ std::string AM::ShaderCode::get(GLSL_CodeID codeid) {
 
 
             uniform float u_vision_effect;
-            uniform float u_time;
             uniform sampler2D texture_result;
             layout (location = 3) uniform sampler2D texture_bloom;
            
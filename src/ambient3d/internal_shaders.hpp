@@ -12,6 +12,7 @@ namespace AM {
             DEFAULT_VERTEX,
             DEFAULT_FRAGMENT,
             FOG_GLSL,
+            FRAME_GLSL,
             LIGHTS_GLSL,
             POSTPROCESS_FRAGMENT,
             BLOOM_TRESH_FRAGMENT,
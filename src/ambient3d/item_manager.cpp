@@ -22,8 +22,6 @@ AM::ItemManager::~ItemManager() {
 
 
 void AM::ItemManager::cleanup_unused_items(const Vector3& player_pos) { 
-    m_itembase_queue_mutex.unlock();
-    
     for(auto it = m_dropped_items.begin(); it != m_dropped_items.end(); ) {
         AM::Item* item = &it->second;
         std::shared_ptr<AM::Renderable>& renderable_ptr = m_item_renderables[item->id];
@@ -101,46 +99,47 @@ void AM::ItemManager::m_update_item_data(AM::ItemBase* itembase) {
 
 
 void AM::ItemManager::update_items_queue() {
-    std::lock_guard<std::mutex> lock(m_itembase_queue_mutex);
-    for(size_t i = 0; i < m_itembase_queue.size(); i++) {
-        AM::ItemBase* itembase = &m_itembase_queue[i];
-        if(itembase->id >= AM::NUM_ITEMS) {
-            continue;
-        }
-
-        auto item_search = m_dropped_items.find(itembase->uuid);
-        if(item_search != m_dropped_items.end()) {
-            m_update_item_data(itembase);
-        }
-        else {
-            m_load_item_data(itembase);
+    while(AM::ItemBase* itembase = m_itembase_queue.front()) {
+        if(itembase->id < AM::NUM_ITEMS) {
+            auto item_search = m_dropped_items.find(itembase->uuid);
+            if(item_search != m_dropped_items.end()) {
+                m_update_item_data(itembase);
+            }
+            else {
+                m_load_item_data(itembase);
+            }
         }
+        m_itembase_queue.pop();
     }
 
-    m_itembase_queue.clear();
+    const uint32_t num_dropped = m_num_dropped_itembases.exchange(0, std::memory_order_relaxed);
+    if(num_dropped > 0) {
+        fprintf(stderr, "ERROR! %s: Item queue was full, dropped %u item updates\n",
+                __func__, num_dropped);
+    }
 
 
     // Remove unloaded items.
-    for(size_t i = 0; i < m_removed_itemuuid_queue.size(); i++) {
-        auto item_search = m_dropped_items.find(m_removed_itemuuid_queue[i]);
-        if(item_search == m_dropped_items.end()) {
-            continue;
+    while(const int* item_uuid = m_removed_itemuuid_queue.front()) {
+        m_dropped_items.erase(*item_uuid);
+        m_removed_itemuuid_queue.pop();
+    }
+    if(m_removed_itemuuid_overflow.take(&m_removed_itemuuid_read)) {
+        for(int item_uuid : m_removed_itemuuid_read) {
+            m_dropped_items.erase(item_uuid);
         }
-
-        m_dropped_items.erase(item_search);
     }
-
-    m_removed_itemuuid_queue.clear();
 }
 
 void AM::ItemManager::add_itembase_to_queue(const AM::ItemBase& itembase) {
-    std::lock_guard<std::mutex> lock(m_itembase_queue_mutex);
-    m_itembase_queue.push_back(itembase);
+    if(!m_itembase_queue.push(itembase)) {
+        m_num_dropped_itembases.fetch_add(1, std::memory_order_relaxed);
+    }
 }
-
             
 void AM::ItemManager::add_itemuuid_removed(int item_uuid) {
-    std::lock_guard<std::mutex> lock(m_itembase_queue_mutex);
-    m_removed_itemuuid_queue.push_back(item_uuid);
+    if(!m_removed_itemuuid_queue.push(item_uuid)) {
+        m_removed_itemuuid_overflow.push(item_uuid);
+    }
 }
 
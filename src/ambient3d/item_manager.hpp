@@ -13,20 +13,38 @@
 
 #include <map>
 #include <array>
+#include <atomic>
+#include <vector>
 #include <nlohmann/json.hpp>
-#include <deque>
-#include <mutex>
 #include <unordered_map>
 
 #include "raylib.h"
 #include "item.hpp"
+#include "mpsc_queue.hpp"
 #include "shared/include/server_config.hpp"
+#include "shared/include/packet_ids.hpp"
+#include "shared/include/networking_agreements.hpp"
 
 using json = nlohmann::json;
 
 
 namespace AM {
 
+    // Most items one ITEM_UPDATE packet can have (1582).
+    static constexpr size_t ITEM_UPDATE_MAX_ITEMS = AM::MAX_PACKET_SIZE / AM::PacketSize::ITEM_UPDATE_MIN_ITEM;
+
+    // Item updates waiting for the main thread.
+    // The server sends ITEM_UPDATE every tick (50 ms) and the queue is read
+    // every fast fixed tick (75 ms). It holds one full packet and the two packets
+    // which can arrive during one client tick.
+    // If it is full the update is dropped, the server sends it again next tick.
+    static constexpr size_t ITEMBASE_QUEUE_SIZE = 8192;
+    static_assert(ITEMBASE_QUEUE_SIZE >= ITEM_UPDATE_MAX_ITEMS * 3);
+
+    // Removed items waiting for the main thread. These are never dropped
+    // (PLAYER_UNLOAD_DROPPED_ITEM is not sent again), the rest go to an overflow list.
+    static constexpr size_t REMOVED_ITEM_QUEUE_SIZE = 256;
+
     class State;
     class ItemManager {
         public:
@@ -39,7 +57,10 @@ namespace AM {
                 m_engine = engine;
             }
 
-            void cleanup_unused_items(const Vector3& player_pos);     // < thread safe >
+            void cleanup_unused_items(const Vector3& player_pos);
+
+            // Can be called from any thread. Item updates are dropped if the queue is full,
+            // the number of dropped updates is reported once per 'update_items_queue'
             void add_itembase_to_queue(const AM::ItemBase& itembase); // < thread safe >
             void add_itemuuid_removed(int item_uuid);                 // < thread safe >
 
@@ -64,10 +85,12 @@ namespace AM {
             AM::State*               m_engine;
             //AM::ServerCFG            m_server_cfg;
 
-            std::mutex               m_itembase_queue_mutex;
-            std::deque<AM::ItemBase> m_itembase_queue;
-           
-            std::vector<int/*item_uuid*/> m_removed_itemuuid_queue;
+            // Filled by the network threads, read by the main thread.
+            AM::MPSCQueue<AM::ItemBase, ITEMBASE_QUEUE_SIZE>          m_itembase_queue;
+            AM::MPSCQueue<int/*item_uuid*/, REMOVED_ITEM_QUEUE_SIZE> m_removed_itemuuid_queue;
+            AM::OverflowList<int/*item_uuid*/>                       m_removed_itemuuid_overflow;
+            std::vector<int>                                         m_removed_itemuuid_read; // Reused by the main thread.
+            std::atomic<uint32_t>                                    m_num_dropped_itembases { 0 };
 
             // Item renderables(models) are loaded
             // if client receives items (see ITEM_UPDATE packet)
@@ -16,22 +16,6 @@ namespace AM {
         float    cutoff;
         float    strength;
 
-        size_t   id { 0 };
-        bool     force_update { false };
-
-        bool equal(const Light& rhs) {
-            return (
-                    FloatEquals(this->pos.x, rhs.pos.x) &&
-                    FloatEquals(this->pos.y, rhs.pos.y) &&
-                    FloatEquals(this->pos.z, rhs.pos.z) &&
-                    (this->color.r == rhs.color.r) &&
-                    (this->color.g == rhs.color.g) && 
-                    (this->color.b == rhs.color.b) &&
-                    FloatEquals(this->strength, rhs.strength) &&
-                    FloatEquals(this->cutoff, rhs.cutoff)
-                    ); 
-        }
-
     };
 }
 
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <cmath>
+
+#include "light_clusters.hpp"
+#include "raymath.h"
+
+
+// Attenuation constants of 'compute_lights' in LIGHTS_GLSL.
+static constexpr float ATTENUATION_L = 0.8f;
+static constexpr float ATTENUATION_Q = 2.3f;
+static constexpr float AMBIENT_FACTOR = 0.15f;
+static constexpr float MAX_DIFFUSE_SPECULAR = 1.5f;
+
+
+float AM::light_range(const AM::Light& light) {
+    // Diffuse, specular and ambient together are at most a * (1.5 + AMBIENT_FACTOR * d)
+    // where a = 1 / (2 + L*d + Q*d*d) and d = pow(distance / radius, cutoff)
+    // Solved for the 'd' where it equals LIGHT_MIN_INFLUENCE.
+    constexpr float k = AM::LIGHT_MIN_INFLUENCE;
+    const float a = k * ATTENUATION_Q;
+    const float b = k * ATTENUATION_L - AMBIENT_FACTOR;
+    const float c = k * 2.0f - MAX_DIFFUSE_SPECULAR;
+    const float d = (-b + sqrtf(b * b - 4.0f * a * c)) / (2.0f * a);
+
+    const float cutoff = std::max(light.cutoff, 0.01f);
+    return std::max(light.strength, 0.0f) * powf(d, 1.0f / cutoff);
+}
+
+int AM::LightClusters::m_depth_slice(float view_depth) const {
+    if(view_depth < this->params.near) {
+        return 0;
+    }
+    const int slice = 1 + (int)(logf(view_depth / this->params.near) * this->params.slice_scale);
+    return std::min(slice, AM::LIGHT_CLUSTERS_Z - 1);
+}
+
+int AM::LightClusters::find_cluster(float ndc_x, float ndc_y, float view_depth) const {
+    if(view_depth <= 0.0f) {
+        return -1;
+    }
+    const int x = std::clamp((int)((ndc_x * 0.5f + 0.5f) * AM::LIGHT_CLUSTERS_X), 0, AM::LIGHT_CLUSTERS_X - 1);
+    const int y = std::clamp((int)((ndc_y * 0.5f + 0.5f) * AM::LIGHT_CLUSTERS_Y), 0, AM::LIGHT_CLUSTERS_Y - 1);
+    const int z = m_depth_slice(view_depth);
+    return (z * AM::LIGHT_CLUSTERS_Y + y) * AM::LIGHT_CLUSTERS_X + x;
+}
+
+void AM::LightClusters::build(
+        const Matrix& view,
+        const Matrix& projection,
+        int screen_width,
+        int screen_height,
+        const AM::Light* lights,
+        size_t num_lights
+){
+    // Perspective projection:
+    //  m0  = 1 / (aspect * tan(fov/2))
+    //  m5  = 1 / tan(fov/2)
+    //  m10 = -(far + near) / (far - near)
+    //  m14 = -(2 * far * near) / (far - near)
+    // Orthographic projection has m11 = 0 and then every light is in every cluster.
+    const bool perspective = (projection.m11 != 0.0f);
+    const float proj_near = perspective ? (projection.m14 / (projection.m10 - 1.0f)) : 0.0f;
+    const float proj_far  = perspective ? (projection.m14 / (projection.m10 + 1.0f)) : 0.0f;
+    const float slice_far = perspective ? std::max(proj_far, AM::LIGHT_CLUSTER_NEAR * 2.0f) : 1000.0f;
+
+    this->params.near = AM::LIGHT_CLUSTER_NEAR;
+    this->params.slice_scale = (AM::LIGHT_CLUSTERS_Z - 1) / logf(slice_far / AM::LIGHT_CLUSTER_NEAR);
+    this->params.proj_near = proj_near;
+    this->params.proj_far = proj_far;
+    this->params.screen_width = (float)screen_width;
+    this->params.screen_height = (float)screen_height;
+    this->params.num_x = AM::LIGHT_CLUSTERS_X;
+    this->params.num_y = AM::LIGHT_CLUSTERS_Y;
+    this->params.num_z = AM::LIGHT_CLUSTERS_Z;
+
+    // Closest lights are assigned first so they are the ones kept if a cluster gets full.
+    m_view_positions.resize(num_lights);
+    m_light_order.resize(num_lights);
+    for(size_t i = 0; i < num_lights; i++) {
+        m_view_positions[i] = Vector3Transform(lights[i].pos, view);
+        m_light_order[i] = (uint32_t)i;
+    }
+    std::sort(m_light_order.begin(), m_light_order.end(),
+            [this](uint32_t a, uint32_t b) { return m_view_positions[a].z > m_view_positions[b].z; });
+
+    m_refs.clear();
+    for(const uint32_t light_index : m_light_order) {
+        const AM::Light& light = lights[light_index];
+        const Vector3& p = m_view_positions[light_index];
+        const float depth = -p.z;
+        const float range = AM::light_range(light);
+
+        if((depth + range <= 0.0f) || (range <= 0.0f)) {
+            continue; // Behind the camera.
+        }
+        if(perspective && (depth - range >= proj_far)) {
+            continue;
+        }
+
+        // Fragments cant find their depth slice without the perspective near and far planes.
+        const int first_slice = perspective ? m_depth_slice(std::max(depth - range, 0.0f)) : 0;
+        const int last_slice  = perspective ? m_depth_slice(depth + range) : (AM::LIGHT_CLUSTERS_Z - 1);
+
+        for(int z = first_slice; z <= last_slice; z++) {
+            int min_x = 0;
+            int min_y = 0;
+            int max_x = AM::LIGHT_CLUSTERS_X - 1;
+            int max_y = AM::LIGHT_CLUSTERS_Y - 1;
+
+            // Part of the light's bounding box inside of this slice.
+            const float slice_begin = (z == 0) ? 0.0f
+                : this->params.near * expf((z - 1) / this->params.slice_scale);
+            const float slice_end = (z == AM::LIGHT_CLUSTERS_Z - 1) ? (depth + range)
+                : this->params.near * expf(z / this->params.slice_scale);
+            const float near_depth = std::max(depth - range, slice_begin);
+            const float far_depth  = std::min(depth + range, slice_end);
+
+            // Projected bounding box of the light is between the projections at the near
+            // and far depth. Skipped when the box reaches the camera, it covers everything.
+            if(perspective && (near_depth > proj_near)) {
+                const float x0 = (p.x - range) * projection.m0;
+                const float x1 = (p.x + range) * projection.m0;
+                const float y0 = (p.y - range) * projection.m5;
+                const float y1 = (p.y + range) * projection.m5;
+
+                const float ndc_min_x = std::min(x0 / near_depth, x0 / far_depth);
+                const float ndc_max_x = std::max(x1 / near_depth, x1 / far_depth);
+                const float ndc_min_y = std::min(y0 / near_depth, y0 / far_depth);
+                const float ndc_max_y = std::max(y1 / near_depth, y1 / far_depth);
+
+                if((ndc_min_x > 1.0f) || (ndc_max_x < -1.0f) || (ndc_min_y > 1.0f) || (ndc_max_y < -1.0f)) {
+                    continue; // Outside of the screen.
+                }
+
+                min_x = std::max((int)((ndc_min_x * 0.5f + 0.5f) * AM::LIGHT_CLUSTERS_X), 0);
+                max_x = std::min((int)((ndc_max_x * 0.5f + 0.5f) * AM::LIGHT_CLUSTERS_X), AM::LIGHT_CLUSTERS_X - 1);
+                min_y = std::max((int)((ndc_min_y * 0.5f + 0.5f) * AM::LIGHT_CLUSTERS_Y), 0);
+                max_y = std::min((int)((ndc_max_y * 0.5f + 0.5f) * AM::LIGHT_CLUSTERS_Y), AM::LIGHT_CLUSTERS_Y - 1);
+            }
+
+            for(int y = min_y; y <= max_y; y++) {
+                const uint32_t row = (uint32_t)((z * AM::LIGHT_CLUSTERS_Y + y) * AM::LIGHT_CLUSTERS_X);
+                for(int x = min_x; x <= max_x; x++) {
+                    m_refs.push_back(mLightRef{ row + x, light_index });
+                }
+            }
+        }
+    }
+
+    // Counting sort by cluster. Order of the lights inside of a cluster stays the same.
+    m_counts.assign(AM::NUM_LIGHT_CLUSTERS, 0);
+    for(const mLightRef& ref : m_refs) {
+        m_counts[ref.cluster]++;
+    }
+
+    this->num_dropped = 0;
+    uint32_t offset = AM::NUM_LIGHT_CLUSTERS * 2;
+    this->cluster_data.resize(offset);
+    for(uint32_t i = 0; i < AM::NUM_LIGHT_CLUSTERS; i++) {
+        const uint32_t count = std::min(m_counts[i], AM::LIGHT_CLUSTER_MAX_LIGHTS);
+        this->num_dropped += m_counts[i] - count;
+        this->cluster_data[i * 2 + 0] = offset;
+        this->cluster_data[i * 2 + 1] = 0;
+        offset += count;
+    }
+    this->cluster_data.resize(offset);
+
+    for(const mLightRef& ref : m_refs) {
+        uint32_t* cluster = &this->cluster_data[ref.cluster * 2];
+        if(cluster[1] >= AM::LIGHT_CLUSTER_MAX_LIGHTS) {
+            continue;
+        }
+        this->cluster_data[cluster[0] + cluster[1]] = ref.light;
+        cluster[1]++;
+    }
+}
+
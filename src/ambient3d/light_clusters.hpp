@@ -0,0 +1,107 @@
+#ifndef AMBIENT3D_LIGHT_CLUSTERS_HPP
+#define AMBIENT3D_LIGHT_CLUSTERS_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "raylib.h"
+#include "light.hpp"
+
+
+// Clustered light culling.
+//
+// The view frustum is split into a grid of clusters, X and Y in screen tiles
+// and Z in exponentially growing depth slices. Every frame the lights are assigned
+// to the clusters their range touches, so the fragment shader only loops through
+// the lights of its own cluster instead of all of them.
+//
+// 'cluster_data' layout (uploaded as it is, see LIGHTS_GLSL):
+//  [cluster index * 2 + 0] : Offset of the cluster's light indices in 'cluster_data'
+//  [cluster index * 2 + 1] : Number of lights in the cluster
+//  [NUM_LIGHT_CLUSTERS * 2 ...] : Light indices of all clusters.
+//
+// Nothing in here touches OpenGL so it can be used and measured without a window.
+
+namespace AM {
+
+    static constexpr int LIGHT_CLUSTERS_X = 16;
+    static constexpr int LIGHT_CLUSTERS_Y = 9;
+    static constexpr int LIGHT_CLUSTERS_Z = 24;
+    static constexpr int NUM_LIGHT_CLUSTERS = LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y * LIGHT_CLUSTERS_Z;
+
+    // The first depth slice is everything closer than this.
+    // Slicing from the projection's near plane would waste most of the slices
+    // on the first few units in front of the camera.
+    static constexpr float LIGHT_CLUSTER_NEAR = 1.0f;
+
+    // Lights over this are left out of the cluster (the closest ones are kept first).
+    static constexpr uint32_t LIGHT_CLUSTER_MAX_LIGHTS = 128;
+
+    // Enough for every cluster being full.
+    static constexpr size_t LIGHT_CLUSTER_DATA_MAX_SIZE
+        = NUM_LIGHT_CLUSTERS * 2 + NUM_LIGHT_CLUSTERS * LIGHT_CLUSTER_MAX_LIGHTS;
+
+    // Light's range ends where its contribution in the shader drops below this.
+    static constexpr float LIGHT_MIN_INFLUENCE = 0.01f;
+
+    // Distance where the light's contribution drops below LIGHT_MIN_INFLUENCE.
+    // Must match 'compute_lights' in LIGHTS_GLSL.
+    float light_range(const AM::Light& light);
+
+    // Same layout as 'light_cluster_params' in LIGHTS_GLSL. (std430)
+    struct LightClusterParams {
+        float    near;          // LIGHT_CLUSTER_NEAR
+        float    slice_scale;   // Depth slices per log(depth / near)
+        float    proj_near;
+        float    proj_far;
+        float    screen_width;
+        float    screen_height;
+        float    padding[2];
+        uint32_t num_x;
+        uint32_t num_y;
+        uint32_t num_z;
+        uint32_t padding2;
+    };
+
+    class LightClusters {
+        public:
+
+            // 'view' and 'projection' are the camera matrices for current frame.
+            // With raylib: rlGetMatrixModelview() and rlGetMatrixProjection()
+            void build(
+                    const Matrix& view,
+                    const Matrix& projection,
+                    int screen_width,
+                    int screen_height,
+                    const AM::Light* lights,
+                    size_t num_lights);
+
+            AM::LightClusterParams params;
+            std::vector<uint32_t>  cluster_data;
+
+            // Light indices which did not fit in their cluster on the last build.
+            size_t num_dropped { 0 };
+
+            // Returns index of the cluster or -1 if the view space position is behind the camera.
+            int    find_cluster(float ndc_x, float ndc_y, float view_depth) const;
+
+        private:
+
+            struct mLightRef {
+                uint32_t cluster;
+                uint32_t light;
+            };
+
+            std::vector<mLightRef> m_refs;
+            std::vector<uint32_t>  m_counts;
+            std::vector<uint32_t>  m_light_order;
+            std::vector<Vector3>   m_view_positions;
+
+            int m_depth_slice(float view_depth) const;
+    };
+
+};
+
+
+#endif
@@ -0,0 +1,129 @@
+#include <algorithm>
+
+#include "light_store.hpp"
+#include "light_clusters.hpp"
+
+
+AM::LightHandle AM::LightStore::add(const AM::Light& light) {
+    if(m_lights.size() >= m_max_lights) {
+        return AM::LightHandle{};
+    }
+
+    uint32_t slot = 0;
+    if(m_free_slots.empty()) {
+        slot = (uint32_t)m_slots.size();
+        m_slots.push_back(mSlot{ 0, 1 });
+    }
+    else {
+        slot = m_free_slots.back();
+        m_free_slots.pop_back();
+    }
+
+    const uint32_t index = (uint32_t)m_lights.size();
+    m_slots[slot].index = index;
+    m_lights.push_back(light);
+    m_light_slots.push_back(slot);
+    m_shader_data.push_back(AM::LightShaderData{});
+    m_is_dirty.push_back(0);
+    m_mark_dirty(index);
+
+    return AM::LightHandle{ slot, m_slots[slot].generation };
+}
+
+bool AM::LightStore::remove(const AM::LightHandle& handle) {
+    if(!this->valid(handle)) {
+        return false;
+    }
+
+    // Last light is moved to the removed one's place.
+    const uint32_t index = m_slots[handle.slot].index;
+    const uint32_t last = (uint32_t)m_lights.size() - 1;
+    if(index != last) {
+        m_lights[index] = m_lights[last];
+        m_light_slots[index] = m_light_slots[last];
+        m_slots[m_light_slots[index]].index = index;
+        m_mark_dirty(index);
+    }
+
+    m_lights.pop_back();
+    m_light_slots.pop_back();
+    m_shader_data.pop_back();
+    m_is_dirty.pop_back();
+
+    m_slots[handle.slot].generation++;
+    if(m_slots[handle.slot].generation == 0) {
+        m_slots[handle.slot].generation = 1;
+    }
+    m_free_slots.push_back(handle.slot);
+    return true;
+}
+
+bool AM::LightStore::valid(const AM::LightHandle& handle) const {
+    return (handle.slot < m_slots.size())
+        && (handle.generation != 0)
+        && (m_slots[handle.slot].generation == handle.generation);
+}
+
+const AM::Light* AM::LightStore::get(const AM::LightHandle& handle) const {
+    if(!this->valid(handle)) {
+        return NULL;
+    }
+    return &m_lights[m_slots[handle.slot].index];
+}
+
+AM::Light* AM::LightStore::edit(const AM::LightHandle& handle) {
+    if(!this->valid(handle)) {
+        return NULL;
+    }
+    const uint32_t index = m_slots[handle.slot].index;
+    m_mark_dirty(index);
+    return &m_lights[index];
+}
+
+void AM::LightStore::m_mark_dirty(uint32_t index) {
+    if(!m_is_dirty[index]) {
+        m_is_dirty[index] = 1;
+        m_dirty_lights.push_back(index);
+    }
+}
+
+void AM::LightStore::m_update_dirty(size_t* first_out, size_t* count_out) {
+    size_t first = m_lights.size();
+    size_t end = 0;
+
+    for(const uint32_t index : m_dirty_lights) {
+        if(index >= m_lights.size()) {
+            continue; // Removed after it was marked.
+        }
+        m_is_dirty[index] = 0;
+        first = std::min(first, (size_t)index);
+        end = std::max(end, (size_t)index + 1);
+
+        const AM::Light& light = m_lights[index];
+        m_shader_data[index] = AM::LightShaderData {
+            .pos = {
+                light.pos.x,
+                light.pos.y,
+                light.pos.z,
+                0.0f
+            },
+            .color = {
+                (float)light.color.r / 255.0f,
+                (float)light.color.g / 255.0f,
+                (float)light.color.b / 255.0f,
+                1.0f
+            },
+            .settings = {
+                light.strength,
+                light.cutoff,
+                AM::light_range(light),
+                0.0f
+            }
+        };
+    }
+    m_dirty_lights.clear();
+
+    *first_out = (first < end) ? first : 0;
+    *count_out = (first < end) ? (end - first) : 0;
+}
+
@@ -0,0 +1,101 @@
+#ifndef AMBIENT3D_LIGHT_STORE_HPP
+#define AMBIENT3D_LIGHT_STORE_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "light.hpp"
+
+
+// Lights and their shader data.
+//
+// Lights are packed in one array so the shader can index them
+// (removing a light moves the last one into its place).
+// Users refer to them with handles which stay valid until the light is removed,
+// the generation makes handles of removed lights invalid even if the slot is reused.
+//
+// Changing a light through 'edit' marks it dirty. 'flush' converts only the dirty lights
+// and hands out one range covering them, so a frame costs one buffer upload
+// no matter how many lights there are.
+//
+// Nothing in here touches OpenGL so it can be used and measured without a window.
+
+namespace AM {
+
+    struct LightHandle {
+        uint32_t slot       { 0 };
+        uint32_t generation { 0 }; // 0 is never used by a light.
+    };
+
+    // Same layout as 'Light' in LIGHTS_GLSL. (std430)
+    struct LightShaderData {
+        float pos[4];
+        float color[4];
+        float settings[4]; // radius, cutoff, range
+    };
+
+    class LightStore {
+        public:
+
+            LightStore(size_t max_lights) : m_max_lights(max_lights) {}
+
+            // Returns invalid handle if there are already 'max_lights' lights.
+            AM::LightHandle add(const AM::Light& light);
+
+            // Returns false if the handle is not valid.
+            bool remove(const AM::LightHandle& handle);
+
+            bool valid(const AM::LightHandle& handle) const;
+
+            // Returns NULL if the handle is not valid.
+            // The pointers are valid until the next 'add' or 'remove'.
+            const AM::Light* get(const AM::LightHandle& handle) const;
+            AM::Light*       edit(const AM::LightHandle& handle); // Marks the light dirty.
+
+            // Calls 'upload(first_index, data, count)' once if any light has changed
+            // since the previous flush. 'data' points to light at 'first_index'.
+            template<typename UploadFunc>
+            void flush(UploadFunc upload) {
+                size_t first = 0;
+                size_t count = 0;
+                m_update_dirty(&first, &count);
+                if(count > 0) {
+                    upload(first, &m_shader_data[first], count);
+                }
+            }
+
+            size_t size() const { return m_lights.size(); }
+            size_t max_size() const { return m_max_lights; }
+            size_t num_dirty() const { return m_dirty_lights.size(); }
+
+            // Packed lights. Index is the same as in the shader.
+            const AM::Light* data() const { return m_lights.data(); }
+
+        private:
+
+            struct mSlot {
+                uint32_t index;       // In the packed arrays.
+                uint32_t generation;
+            };
+
+            size_t m_max_lights;
+
+            std::vector<mSlot>           m_slots;
+            std::vector<uint32_t>        m_free_slots;
+
+            std::vector<AM::Light>       m_lights;
+            std::vector<uint32_t>        m_light_slots; // Slot of each packed light.
+            std::vector<AM::LightShaderData> m_shader_data;
+
+            std::vector<uint32_t>        m_dirty_lights;
+            std::vector<uint8_t>         m_is_dirty;
+
+            void m_mark_dirty(uint32_t index);
+            void m_update_dirty(size_t* first_out, size_t* count_out);
+    };
+
+};
+
+
+#endif
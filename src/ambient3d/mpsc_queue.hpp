@@ -0,0 +1,186 @@
+#ifndef AMBIENT3D_MPSC_QUEUE_HPP
+#define AMBIENT3D_MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+
+namespace AM {
+
+    // Bounded lock-free queue for handing data from the network threads to the main thread.
+    // Any number of threads can push, only one thread can read (front, pop).
+    //
+    // All slots are allocated when the queue is created. Producers fill
+    // the slot in place (begin_push, end_push) so large elements are not copied twice.
+    // Each slot has a sequence number telling if it is free or ready to be read
+    // (bounded queue by Dmitry Vyukov), so producers only compete for the write position.
+    //
+    // IMPORTANT NOTE: Pushing fails when the queue is full, nothing waits.
+    //                 (see OverflowList for data which cant be dropped)
+    //                 'CAPACITY' must be power of 2.
+
+    template<typename T, size_t CAPACITY>
+    class MPSCQueue {
+        static_assert((CAPACITY >= 2) && ((CAPACITY & (CAPACITY - 1)) == 0),
+                "MPSCQueue CAPACITY must be power of 2");
+
+        public:
+
+            MPSCQueue() {
+                m_cells = new mCell[CAPACITY];
+                for(size_t i = 0; i < CAPACITY; i++) {
+                    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+            ~MPSCQueue() {
+                delete[] m_cells;
+            }
+            MPSCQueue(const MPSCQueue&) = delete;
+            MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+
+            // Returns a free slot to write into or NULL if the queue is full.
+            // The slot is not visible to the reader until 'end_push' is called with it.
+            // The slot still has the value it was last used with.
+            T* begin_push() {
+                size_t pos = m_write_pos.load(std::memory_order_relaxed);
+                while(true) {
+                    mCell* cell = &m_cells[pos & MASK];
+                    const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                    const ssize_t diff = (ssize_t)sequence - (ssize_t)pos;
+                    if(diff == 0) {
+                        if(m_write_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                            return &cell->value;
+                        }
+                    }
+                    else
+                    if(diff < 0) {
+                        return NULL; // Full. The reader hasnt released this slot yet.
+                    }
+                    else {
+                        pos = m_write_pos.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            void end_push(T* slot) {
+                mCell* cell = m_cell_of(slot);
+                // Only this thread has the slot now, sequence is still its write position.
+                cell->sequence.store(cell->sequence.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_release);
+            }
+
+            bool push(const T& value) {
+                T* slot = this->begin_push();
+                if(!slot) {
+                    return false;
+                }
+                *slot = value;
+                this->end_push(slot);
+                return true;
+            }
+
+
+            // Reader only. Oldest element or NULL if there is nothing to read.
+            // It stays valid until 'pop'
+            [[nodiscard]] T* front() {
+                mCell* cell = &m_cells[m_read_pos & MASK];
+                const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                return (sequence == m_read_pos + 1) ? &cell->value : NULL;
+            }
+
+            // Reader only. Releases the slot returned by 'front'
+            void pop() {
+                mCell* cell = &m_cells[m_read_pos & MASK];
+                cell->sequence.store(m_read_pos + CAPACITY, std::memory_order_release);
+                m_read_pos++;
+            }
+
+            // Reader only. Pops everything.
+            void clear() {
+                while(this->front()) {
+                    this->pop();
+                }
+            }
+
+            // Reader only. Approximate if other threads are pushing.
+            [[nodiscard]] size_t size() const {
+                return m_write_pos.load(std::memory_order_relaxed) - m_read_pos;
+            }
+
+            static constexpr size_t capacity() { return CAPACITY; }
+
+        private:
+
+            static constexpr size_t MASK = CAPACITY - 1;
+
+            struct mCell {
+                std::atomic<size_t> sequence;
+                T                   value;
+            };
+
+            mCell* m_cell_of(T* slot) {
+                const size_t index = ((uint8_t*)slot - (uint8_t*)&m_cells[0].value) / sizeof(mCell);
+                return &m_cells[index];
+            }
+
+            mCell* m_cells { NULL };
+
+            // Separate cache lines so producers dont slow down the reader.
+            alignas(64) std::atomic<size_t> m_write_pos { 0 };
+            alignas(64) size_t              m_read_pos  { 0 };
+    };
+
+
+    // Unbounded list for data which must not be dropped when a MPSCQueue is full.
+    // Producers lock a mutex (this is the slow path), the reader only locks it
+    // when something was added since it last looked.
+    //
+    // To keep the order of one producer it should push here while 'has_items' is true.
+    // The reader checks 'has_items' before it reads the queue and takes the list
+    // after the queue is empty only if it was true. (Otherwise the queue could fill up
+    // and overflow again between the two, and newer data would be read first)
+
+    template<typename T>
+    class OverflowList {
+        public:
+
+            void push(T value) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_items.push_back(std::move(value));
+                m_has_items.store(true, std::memory_order_release);
+            }
+
+            [[nodiscard]] bool has_items() const {
+                return m_has_items.load(std::memory_order_acquire);
+            }
+
+            // Reader only. Moves everything to 'out' (it is cleared first).
+            // Returns false if there was nothing.
+            bool take(std::vector<T>* out) {
+                out->clear();
+                if(!this->has_items()) {
+                    return false;
+                }
+                std::lock_guard<std::mutex> lock(m_mutex);
+                out->swap(m_items);
+                m_has_items.store(false, std::memory_order_relaxed);
+                return !out->empty();
+            }
+
+        private:
+
+            std::mutex          m_mutex;
+            std::vector<T>      m_items;
+            std::atomic<bool>   m_has_items { false };
+    };
+};
+
+
+
+#endif
@@ -1,12 +1,13 @@
 #include <cstdio>
-#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <array>
 #include <filesystem>
+#include <unordered_map>
 
 #include "assets_downloader.hpp"
 #include "shared/include/file_sha256.hpp"
 #include "shared/include/packet_parser.hpp"
 
-using json = nlohmann::json;
 namespace fs = std::filesystem;
 
 
@@ -16,58 +17,28 @@ void AM::AssetsDownloader::m_handle_recv_data(size_t size) {
 
     switch(packet_id) {
         case AM::PacketID::DO_ACCEPT_ASSETS_DOWNLOAD:
-            if(size <= sizeof(size_t)) {
+            if(size < sizeof(size_t) * 2) {
                 fprintf(stderr, "[AssetsDownloader]: Invalid packet size(%li)"
                         " for DO_ACCEPT_ASSETS_DOWNLOAD\n", size);
                 return;
             }
             {
-                size_t total_sizeb = 0;
-                memmove(&total_sizeb, m_recv_data, sizeof(total_sizeb));
-
-                json files_json = json::parse(m_recv_data + sizeof(size_t));
-                printf("------------------------------------------\n");
-
-                // Print size in bytes for each downloadable file.
-                for(const json& j : files_json["files"]) {
-                    printf(" %-20s - %i Bytes\n",
-                            j[0].template get<std::string>().c_str(),
-                            j[1].template get<int>());
+                size_t list_sizeb = 0;
+                memmove(&m_download_total_sizeb, m_recv_data, sizeof(size_t));
+                memmove(&list_sizeb, m_recv_data + sizeof(size_t), sizeof(size_t));
+
+                // Beginning of the file list may have been read with the packet.
+                const size_t received = std::min(size - sizeof(size_t) * 2, list_sizeb);
+                m_file_list_bytes.assign(
+                        m_recv_data + sizeof(size_t) * 2,
+                        m_recv_data + sizeof(size_t) * 2 + received);
+
+                if(received < list_sizeb) {
+                    m_stream_target = STREAM_FILE_LIST;
+                    m_stream_remaining = list_sizeb - received;
                 }
-
-                //printf("%s\n", m_recv_data + sizeof(size_t));
-                printf("\n\033[32mAccept download of %li bytes?\033[0m\n", total_sizeb);
-               
-                // Wait for user input to get permission to continue downloading.
-                // TODO: Maybe gui would be more user friendly 
-                // so the game dont need to be launched from command line.
-                bool accepted_download = false;
-                while(true) {
-                    printf(" [Yes/No]: ");
-                    fflush(stdout);
-                
-                    constexpr int INPUTBUF_SIZE = 7;
-                    char input_buf[INPUTBUF_SIZE+1] = { 0 };
-                    size_t read_size = read(1, input_buf, INPUTBUF_SIZE);
-                    
-                    if(read_size <= 0) {
-                        printf("\n");
-                        continue;
-                    }
-
-                    if((input_buf[0] == 'Y') || (input_buf[0] == 'y')) {
-                        accepted_download = true;
-                        break;
-                    }
-                    if((input_buf[0] == 'N') || (input_buf[0] == 'n')) {
-                        m_keep_connection_alive = false;
-                        break;
-                    }
-                }
-
-                if(accepted_download) {
-                    m_packet.prepare(AM::PacketID::ACCEPTED_ASSETS_DOWNLOAD);
-                    m_send_packet();
+                else {
+                    m_handle_file_list();
                 }
             }
             break;
@@ -80,9 +51,22 @@ void AM::AssetsDownloader::m_handle_recv_data(size_t size) {
                 std::string filegroup = fileinfo["filegroup"].template get<std::string>();
                 size_t      filesize  = fileinfo["filesize"].template get<size_t>();
 
+                const std::string encoding = fileinfo.value("encoding", AM::ASSET_ENCODING_NONE);
+                m_decode_download = (encoding != AM::ASSET_ENCODING_NONE);
+                if(m_decode_download) {
+                    if(!m_file_decoder.begin(encoding)) {
+                        m_keep_connection_alive = false;
+                        return;
+                    }
+                    filesize = fileinfo["encoded_size"].template get<size_t>();
+                }
+
                 m_downloaded_bytes = 0;
                 m_download_sizeb = filesize;
                 m_download_filename = filename;
+                m_stream_target = fileinfo.value("stream", false) ? STREAM_FILE : STREAM_NONE;
+                m_stream_remaining = filesize;
+                m_stream_progress_bytes = 0;
 
                 /*
                 printf("File name:  \"%s\"\n", filename.c_str());
@@ -96,6 +80,21 @@ void AM::AssetsDownloader::m_handle_recv_data(size_t size) {
 
                 // TODO: Make filepath "building" more stable.
                 std::string filepath = m_config.game_asset_dir + filegroup +"/"+ filename;
+                m_download_filepath = filepath;
+
+                if(fileinfo.value("delta", false)) {
+                    m_download_sha256 = fileinfo["sha256"].template get<std::string>();
+                    m_manifest_bytes.resize(fileinfo["manifest_size"].template get<size_t>());
+                    m_stream_target = STREAM_MANIFEST;
+                    m_stream_remaining = m_manifest_bytes.size();
+
+                    if(m_old_file.is_open()) {
+                        m_old_file.close();
+                    }
+                    m_old_file.open(filepath, std::ios::binary);
+                    filepath += ".part";
+                }
+
                 m_download_file.open(filepath, std::ios::binary | std::ios::trunc);
 
                 if(!m_download_file.is_open()) {
@@ -111,6 +110,10 @@ void AM::AssetsDownloader::m_handle_recv_data(size_t size) {
                 printf("\n");
                 m_packet.prepare(AM::PacketID::CLIENT_CREATED_ASSET_FILE);
                 m_send_packet();
+
+                if((m_stream_target == STREAM_FILE) && (m_download_sizeb == 0)) {
+                    m_finish_streamed_file(); // Nothing will be streamed.
+                }
             }
             catch(const std::exception& e) {
                 fprintf(stderr, "[AssetsDownloader(CREATE_ASSET_FILE)]: %s\n", e.what());
@@ -136,7 +139,7 @@ void AM::AssetsDownloader::m_handle_recv_data(size_t size) {
             printf("\n");
             */
             
-            m_download_file.write(m_recv_data, size);
+            m_write_download_file(m_recv_data, size);
 
             // Inform the server we received some bytes so it will keep sending more.
             m_packet.prepare(AM::PacketID::GOT_SOME_FILE_BYTES);
@@ -154,6 +157,454 @@ void AM::AssetsDownloader::m_handle_recv_data(size_t size) {
     }
 }
 
+
+void AM::AssetsDownloader::m_handle_stream_data(size_t size) {
+    if(m_stream_target == STREAM_FRAMES) {
+        m_handle_frame_data(size);
+        return;
+    }
+
+    m_stream_remaining -= std::min(size, m_stream_remaining);
+
+    switch(m_stream_target) {
+        case STREAM_FILE:
+            m_handle_file_stream_data(size);
+            break;
+
+        case STREAM_MANIFEST:
+            memmove(&m_manifest_bytes[m_manifest_bytes.size() - (m_stream_remaining + size)], m_recv_data, size);
+            if(m_stream_remaining == 0) {
+                m_request_missing_chunks();
+            }
+            break;
+
+        case STREAM_CHUNKS:
+            m_assemble_delta_file(m_recv_data, size);
+            break;
+
+        case STREAM_FILE_LIST:
+            m_file_list_bytes.insert(m_file_list_bytes.end(), m_recv_data, m_recv_data + size);
+            if(m_stream_remaining == 0) {
+                m_handle_file_list();
+            }
+            break;
+    }
+}
+
+void AM::AssetsDownloader::m_handle_file_list() {
+    m_stream_target = STREAM_NONE;
+    try {
+        json files_json = json::parse(m_file_list_bytes.begin(), m_file_list_bytes.end());
+        printf("------------------------------------------\n");
+
+        // Print size in bytes for each downloadable file.
+        for(const json& j : files_json["files"]) {
+            printf(" %-20s - %i Bytes\n",
+                    j[0].template get<std::string>().c_str(),
+                    j[1].template get<int>());
+        }
+
+        const bool multi_stream = (files_json.value("streams", 0) > 0);
+        json accept_json = json::parse("{}");
+        if(multi_stream) {
+            accept_json["resume"] = m_prepare_file_streams(files_json);
+        }
+
+        printf("\n\033[32mAccept download of %li bytes?\033[0m\n", m_download_total_sizeb);
+   
+        // Wait for user input to get permission to continue downloading.
+        // TODO: Maybe gui would be more user friendly 
+        // so the game dont need to be launched from command line.
+        bool accepted_download = !this->ask_download_permission;
+        while(!accepted_download) {
+            printf(" [Yes/No]: ");
+            fflush(stdout);
+    
+            constexpr int INPUTBUF_SIZE = 7;
+            char input_buf[INPUTBUF_SIZE+1] = { 0 };
+            size_t read_size = read(1, input_buf, INPUTBUF_SIZE);
+        
+            if(read_size <= 0) {
+                printf("\n");
+                continue;
+            }
+
+            if((input_buf[0] == 'Y') || (input_buf[0] == 'y')) {
+                accepted_download = true;
+                break;
+            }
+            if((input_buf[0] == 'N') || (input_buf[0] == 'n')) {
+                m_keep_connection_alive = false;
+                break;
+            }
+        }
+
+        if(accepted_download) {
+            m_packet.prepare(AM::PacketID::ACCEPTED_ASSETS_DOWNLOAD);
+            m_packet.write_string({ accept_json.dump() });
+            m_send_packet();
+        }
+
+        if(accepted_download && multi_stream) {
+            // Empty files and part files which were complete but not yet verified.
+            for(mFileStream& stream : m_file_streams) {
+                if(!stream.complete && (stream.received >= stream.size)) {
+                    stream.file.open(stream.part_filepath, std::ios::binary | std::ios::app);
+                    m_finish_file_stream(stream);
+                }
+            }
+            if(m_incomplete_streams > 0) {
+                printf("\n");
+                m_frame_header_received = 0;
+                m_stream_target = STREAM_FRAMES;
+            }
+        }
+    }
+    catch(const std::exception& e) {
+        fprintf(stderr, "[AssetsDownloader(DO_ACCEPT_ASSETS_DOWNLOAD)]: %s\n", e.what());
+        m_keep_connection_alive = false;
+    }
+}
+
+void AM::AssetsDownloader::m_write_download_file(const char* data, size_t size) {
+    if(!m_decode_download) {
+        m_download_file.write(data, size);
+        return;
+    }
+    if(!m_file_decoder.write(m_download_file, data, size)) {
+        fprintf(stderr, "[AssetsDownloader]: Failed to decompress '%s'\n", m_download_filename.c_str());
+        m_decode_download = false;
+        m_keep_connection_alive = false;
+    }
+}
+
+void AM::AssetsDownloader::m_handle_file_stream_data(size_t size) {
+    m_write_download_file(m_recv_data, size);
+    m_downloaded_bytes += size;
+
+    // Printing for every read would slow down the download.
+    if((m_downloaded_bytes - m_stream_progress_bytes >= STREAM_PROGRESS_INTERVAL_BYTES)
+    || (m_downloaded_bytes >= m_download_sizeb)) {
+        m_stream_progress_bytes = m_downloaded_bytes;
+        printf("\033[1A Downloading: %-20s - %li / %li bytes\n", 
+                m_download_filename.c_str(),
+                m_downloaded_bytes,
+                m_download_sizeb);
+    }
+
+    if(m_downloaded_bytes >= m_download_sizeb) {
+        m_finish_streamed_file();
+    }
+}
+
+void AM::AssetsDownloader::m_finish_streamed_file() {
+    m_stream_target = STREAM_NONE;
+    if(m_download_file.is_open()) {
+        m_download_file.close();
+    }
+
+    m_packet.prepare(AM::PacketID::GOT_ASSET_FILE);
+    m_send_packet();
+}
+
+json AM::AssetsDownloader::m_prepare_file_streams(const json& files_json) {
+    json resume_json = json::array();
+    const json& files = files_json["files"];
+
+    for(mFileStream& stream : m_file_streams) {
+        delete stream.decoder;
+    }
+    m_file_streams.clear();
+    m_file_streams.resize(files.size());
+    m_incomplete_streams = 0;
+    m_frames_received_bytes = 0;
+    m_frames_total_bytes = 0;
+    m_stream_progress_bytes = 0;
+
+    for(size_t i = 0; i < files.size(); i++) {
+        mFileStream& stream = m_file_streams[i];
+        stream.complete = true;
+        stream.decoder = NULL;
+
+        if(files[i][4].template get<bool>()) {
+            continue; // Delta updates are sent one by one later.
+        }
+
+        const std::string group = files[i][2].template get<std::string>();
+        stream.name = files[i][0].template get<std::string>();
+        stream.size = files[i][1].template get<size_t>();
+        stream.sha256_hash = files[i][3].template get<std::string>();
+        stream.filepath = m_config.game_asset_dir + group +"/"+ stream.name;
+        stream.part_filepath = stream.filepath +"."+ stream.sha256_hash.substr(0, 16) + ".part";
+        stream.received = 0;
+        stream.complete = false;
+
+        const std::string encoding = (files[i].size() > 6)
+            ? files[i][5].template get<std::string>() : AM::ASSET_ENCODING_NONE;
+        if(encoding != AM::ASSET_ENCODING_NONE) {
+            stream.size = files[i][6].template get<size_t>();
+            stream.decoder = new AM::AssetFileDecoder;
+            if(!stream.decoder->begin(encoding)) {
+                m_keep_connection_alive = false;
+            }
+        }
+
+        // Part file name has the hash so it is from the same version of the file.
+        std::error_code ec;
+        const size_t part_size = fs::file_size(stream.part_filepath, ec);
+        if(!ec && stream.decoder) {
+            fs::remove(stream.part_filepath, ec);
+        }
+        else
+        if(!ec) {
+            if(part_size <= stream.size) {
+                stream.received = part_size;
+                resume_json.push_back({ i, part_size });
+                printf(" %-20s - Resuming from %li bytes\n", stream.name.c_str(), part_size);
+            }
+            else {
+                fs::remove(stream.part_filepath, ec);
+            }
+        }
+
+        m_frames_total_bytes += stream.size - stream.received;
+        m_incomplete_streams++;
+    }
+
+    return resume_json;
+}
+
+size_t AM::AssetsDownloader::m_next_frame_read_size() {
+    if(m_frame_header_received < sizeof(m_frame_header)) {
+        return sizeof(m_frame_header) - m_frame_header_received;
+    }
+    return std::min(m_frame_remaining, AM::MAX_PACKET_SIZE);
+}
+
+void AM::AssetsDownloader::m_handle_frame_data(size_t size) {
+    if(m_frame_header_received < sizeof(m_frame_header)) {
+        memmove((char*)&m_frame_header + m_frame_header_received, m_recv_data, size);
+        m_frame_header_received += size;
+        if(m_frame_header_received < sizeof(m_frame_header)) {
+            return;
+        }
+
+        if((m_frame_header.stream_id >= m_file_streams.size())
+        || m_file_streams[m_frame_header.stream_id].complete
+        || (m_frame_header.size > (m_file_streams[m_frame_header.stream_id].size 
+                                 - m_file_streams[m_frame_header.stream_id].received))) {
+            fprintf(stderr, "[AssetsDownloader]: Invalid stream frame (stream_id=%i, size=%i)\n",
+                    m_frame_header.stream_id, m_frame_header.size);
+            m_stream_target = STREAM_NONE;
+            m_keep_connection_alive = false;
+            return;
+        }
+
+        m_frame_stream = &m_file_streams[m_frame_header.stream_id];
+        m_frame_remaining = m_frame_header.size;
+
+        if(!m_frame_stream->file.is_open()) {
+            m_frame_stream->file.open(m_frame_stream->part_filepath, std::ios::binary | std::ios::app);
+            if(!m_frame_stream->file.is_open()) {
+                fprintf(stderr, "[AssetsDownloader]: Failed to open '%s'\n", m_frame_stream->part_filepath.c_str());
+                m_stream_target = STREAM_NONE;
+                m_keep_connection_alive = false;
+                return;
+            }
+        }
+    }
+    else {
+        if(!m_frame_stream->decoder) {
+            m_frame_stream->file.write(m_recv_data, size);
+        }
+        else
+        if(!m_frame_stream->decoder->write(m_frame_stream->file, m_recv_data, size)) {
+            fprintf(stderr, "[AssetsDownloader]: Failed to decompress '%s'\n", m_frame_stream->name.c_str());
+            m_stream_target = STREAM_NONE;
+            m_keep_connection_alive = false;
+            return;
+        }
+        m_frame_stream->received += size;
+        m_frame_remaining -= size;
+        m_frames_received_bytes += size;
+
+        // Printing for every read would slow down the download.
+        if((m_frames_received_bytes - m_stream_progress_bytes >= STREAM_PROGRESS_INTERVAL_BYTES)
+        || (m_frames_received_bytes >= m_frames_total_bytes)) {
+            m_stream_progress_bytes = m_frames_received_bytes;
+            printf("\033[1A Downloading: %li / %li bytes (%li files left)\n", 
+                    m_frames_received_bytes,
+                    m_frames_total_bytes,
+                    m_incomplete_streams);
+        }
+    }
+
+    if(m_frame_remaining == 0) {
+        m_frame_header_received = 0;
+        if(m_frame_stream->received >= m_frame_stream->size) {
+            m_finish_file_stream(*m_frame_stream);
+        }
+    }
+}
+
+void AM::AssetsDownloader::m_finish_file_stream(mFileStream& stream) {
+    if(stream.file.is_open()) {
+        stream.file.close();
+    }
+    stream.complete = true;
+    delete stream.decoder;
+    stream.decoder = NULL;
+    
+    std::string hash;
+    if(AM::compute_sha256_filehash(stream.part_filepath, &hash) && (hash == stream.sha256_hash)) {
+        std::error_code ec;
+        fs::rename(stream.part_filepath, stream.filepath, ec);
+        if(ec) {
+            fprintf(stderr, "[AssetsDownloader]: Failed to replace '%s' (%s)\n",
+                    stream.filepath.c_str(), ec.message().c_str());
+        }
+    }
+    else {
+        // Downloaded again from the beginning on next start.
+        fprintf(stderr, "[AssetsDownloader]: '%s' hash doesnt match after download.\n",
+                stream.name.c_str());
+        std::error_code ec;
+        fs::remove(stream.part_filepath, ec);
+    }
+
+    m_incomplete_streams--;
+    if(m_incomplete_streams == 0) {
+        m_stream_target = STREAM_NONE; // Next is delta updates or ASSET_FILE_END.
+    }
+}
+
+void AM::AssetsDownloader::m_request_missing_chunks() {
+    if(!AM::read_content_manifest(m_manifest_bytes.data(), m_manifest_bytes.size(), &m_remote_chunks)) {
+        fprintf(stderr, "[AssetsDownloader]: Invalid content manifest for '%s'\n", m_download_filename.c_str());
+        m_stream_target = STREAM_NONE;
+        m_keep_connection_alive = false;
+        return;
+    }
+
+    m_local_chunks.clear();
+    if(m_old_file.is_open()) {
+        AM::split_file_content_chunks(m_download_filepath, &m_local_chunks);
+    }
+
+    // Chunks are looked up with the first 8 bytes of their hash.
+    std::unordered_map<uint64_t, size_t> local_lookup;
+    local_lookup.reserve(m_local_chunks.size());
+    for(size_t i = 0; i < m_local_chunks.size(); i++) {
+        uint64_t key = 0;
+        memmove(&key, m_local_chunks[i].hash.data(), sizeof(key));
+        local_lookup.insert(std::make_pair(key, i));
+    }
+
+    std::vector<char> bitmap((m_remote_chunks.size() + 7) / 8, 0);
+    m_chunk_sources.resize(m_remote_chunks.size());
+    size_t missing_bytes = 0;
+
+    for(size_t i = 0; i < m_remote_chunks.size(); i++) {
+        const AM::ContentChunk& chunk = m_remote_chunks[i];
+        uint64_t key = 0;
+        memmove(&key, chunk.hash.data(), sizeof(key));
+
+        const auto search = local_lookup.find(key);
+        if((search != local_lookup.end()) 
+        && (m_local_chunks[search->second].hash == chunk.hash)
+        && (m_local_chunks[search->second].size == chunk.size)) {
+            m_chunk_sources[i] = search->second;
+            continue;
+        }
+
+        m_chunk_sources[i] = -1;
+        bitmap[i / 8] |= (1 << (i % 8));
+        missing_bytes += chunk.size;
+    }
+
+    printf(" Updating: %-20s - %li / %li bytes changed\n", 
+            m_download_filename.c_str(), missing_bytes, m_download_sizeb);
+
+    m_assemble_index = 0;
+    m_assemble_chunk_offset = 0;
+
+    if(missing_bytes == 0) {
+        m_stream_target = STREAM_NONE;
+        m_assemble_delta_file(NULL, 0);
+        return;
+    }
+
+    m_stream_target = STREAM_CHUNKS;
+    m_stream_remaining = missing_bytes;
+
+    m_packet.prepare(AM::PacketID::ASSET_CHUNK_REQUEST);
+    m_packet.write_bytes(bitmap.data(), bitmap.size());
+    m_send_packet();
+}
+
+void AM::AssetsDownloader::m_assemble_delta_file(const char* data, size_t size) {
+    while(m_assemble_index < m_remote_chunks.size()) {
+        const AM::ContentChunk& chunk = m_remote_chunks[m_assemble_index];
+        const int64_t source = m_chunk_sources[m_assemble_index];
+
+        if(source >= 0) {
+            // Copy from the old file.
+            const AM::ContentChunk& local_chunk = m_local_chunks[source];
+            m_chunk_copy_buffer.resize(local_chunk.size);
+            m_old_file.seekg(local_chunk.offset);
+            m_old_file.read(m_chunk_copy_buffer.data(), local_chunk.size);
+            m_download_file.write(m_chunk_copy_buffer.data(), local_chunk.size);
+            m_assemble_index++;
+            continue;
+        }
+
+        if(size == 0) {
+            return; // Wait for more bytes.
+        }
+
+        const size_t count = std::min(size, (size_t)(chunk.size - m_assemble_chunk_offset));
+        m_download_file.write(data, count);
+        data += count;
+        size -= count;
+        m_assemble_chunk_offset += count;
+
+        if(m_assemble_chunk_offset >= chunk.size) {
+            m_assemble_chunk_offset = 0;
+            m_assemble_index++;
+        }
+    }
+
+    m_finish_delta_file();
+}
+
+void AM::AssetsDownloader::m_finish_delta_file() {
+    m_stream_target = STREAM_NONE;
+    m_download_file.close();
+    m_old_file.close();
+    m_remote_chunks.clear();
+    m_local_chunks.clear();
+
+    const std::string part_filepath = m_download_filepath + ".part";
+    std::string hash;
+    if(AM::compute_sha256_filehash(part_filepath, &hash) && (hash == m_download_sha256)) {
+        std::error_code ec;
+        fs::rename(part_filepath, m_download_filepath, ec);
+        if(ec) {
+            fprintf(stderr, "[AssetsDownloader]: Failed to replace '%s' (%s)\n",
+                    m_download_filepath.c_str(), ec.message().c_str());
+        }
+    }
+    else {
+        // Old file is kept and the update is tried again on next start.
+        fprintf(stderr, "[AssetsDownloader]: '%s' hash doesnt match after update.\n",
+                m_download_filename.c_str());
+        std::error_code ec;
+        fs::remove(part_filepath, ec);
+    }
+
+    m_packet.prepare(AM::PacketID::GOT_ASSET_FILE);
+    m_send_packet();
+}
             
 void AM::AssetsDownloader::close_connection(asio::io_context& context) {
     context.stop();
@@ -194,6 +645,9 @@ void AM::AssetsDownloader::m_find_local_gamefiles(
         if(entry.is_directory()) {
             continue;
         }
+        if(entry.path().extension() == ".part") {
+            continue; // Unfinished download.
+        }
 
         local_files->push_back(mAssetFile {
                 entry.path().filename(),
@@ -209,8 +663,6 @@ void AM::AssetsDownloader::update_assets() {
     m_packet.allocate_memory();
 
 
-    json data = json::parse("{}");
-
     std::vector<mAssetFile> local_texture_files;
     std::vector<mAssetFile> local_model_files;
     std::vector<mAssetFile> local_audio_files;
@@ -230,40 +682,27 @@ void AM::AssetsDownloader::update_assets() {
     printf("[AssetsDownloader]: Found %li local files.\n", 
             local_texture_files.size() + local_model_files.size() + local_audio_files.size());
 
-    for(mAssetFile& file : local_texture_files) {
-        data[file.name] = file.sha256_hash;
-    }
-    for(mAssetFile& file : local_model_files) {
-        data[file.name] = file.sha256_hash;
-    }
-    for(mAssetFile& file : local_audio_files) {
-        data[file.name] = file.sha256_hash;
-    }
-    /*
-    for(size_t i = 0; i < local_texture_files.size(); i++) {
-        mAssetFile& file = local_texture_files[i];
-        data[file.type][i] = { file.name, file.sha256_hash };
-    }
-
-    for(size_t i = 0; i < local_model_files.size(); i++) {
-        mAssetFile& file = local_model_files[i];
-        data[file.type][i] = { file.name, file.sha256_hash };
-    }
-
-    for(size_t i = 0; i < local_audio_files.size(); i++) {
-        mAssetFile& file = local_audio_files[i];
-        data[file.type][i] = { file.name, file.sha256_hash };
+    m_local_manifest.clear();
+    for(const std::vector<mAssetFile>* files : { &local_texture_files, &local_model_files, &local_audio_files }) {
+        for(const mAssetFile& file : *files) {
+            AM::AssetManifestEntry entry;
+            entry.name_hash = AM::asset_name_hash(file.name);
+            if(!AM::sha256_hex_to_digest(file.sha256_hash, entry.digest)) {
+                continue; // The file will be downloaded again.
+            }
+            m_local_manifest.push_back(entry);
+        }
     }
-    */
-
+    AM::sort_asset_manifest(&m_local_manifest);
 
+    const uint64_t manifest_sizeb = m_local_manifest.size() * sizeof(AM::AssetManifestEntry);
     m_packet.prepare(AM::PacketID::CLIENT_GAMEASSET_FILE_HASHES);
-    m_packet.write_string({ data.dump() });
-    m_send_packet();
+    m_packet.write<uint64_t>({ manifest_sizeb });
+    m_send_packet_with_data(m_local_manifest.data(), manifest_sizeb);
 
 
     while(m_keep_connection_alive) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
 }
 
@@ -284,17 +723,56 @@ void AM::AssetsDownloader::m_send_packet() {
     m_packet.enable_flag(AM::Packet::FLG_COMPLETE);
 }
 
+void AM::AssetsDownloader::m_send_packet_with_data(const void* data, size_t sizeb) {
+    if((m_packet.get_flags() & AM::Packet::FLG_WRITE_ERROR)) {
+        return;
+    }
+
+    // One write so nothing else can be written between them.
+    const std::array<asio::const_buffer, 2> buffers {
+        asio::buffer(m_packet.data, m_packet.size),
+        asio::buffer(data, sizeb)
+    };
+    asio::async_write(m_tcp_socket, buffers,
+            [](std::error_code ec, std::size_t /*size*/) {
+                if(ec) {
+                    fprintf(stderr, "[AssetsDownloader write](%i): %s\n", ec.value(), ec.message().c_str());
+                }
+            });
+
+    m_packet.enable_flag(AM::Packet::FLG_COMPLETE);
+}
+
 void AM::AssetsDownloader::m_do_read_tcp() {
 
-    memset(m_recv_data, 0, AM::MAX_PACKET_SIZE);
-    m_tcp_socket.async_read_some(asio::buffer(m_recv_data, AM::MAX_PACKET_SIZE),
+    // Streamed bytes are not parsed as packets.
+    size_t read_size = AM::MAX_PACKET_SIZE;
+    if(m_stream_target == STREAM_FRAMES) {
+        read_size = m_next_frame_read_size();
+    }
+    else
+    if(m_stream_target != STREAM_NONE) {
+        read_size = std::min(read_size, m_stream_remaining);
+    }
+    else {
+        memset(m_recv_data, 0, AM::MAX_PACKET_SIZE);
+    }
+
+    m_tcp_socket.async_read_some(asio::buffer(m_recv_data, read_size),
             [this](std::error_code ec, std::size_t size) {
                 if(ec) {
                     fprintf(stderr, "[AssetsDownloader read](%i): %s\n", ec.value(), ec.message().c_str());
+                    // Unfinished downloads are resumed from the part files next time.
+                    m_keep_connection_alive = false;
                     return;
                 }
 
-                m_handle_recv_data(size); 
+                if(m_stream_target != STREAM_NONE) {
+                    m_handle_stream_data(size);
+                }
+                else {
+                    m_handle_recv_data(size); 
+                }
                 m_do_read_tcp();
             });
 
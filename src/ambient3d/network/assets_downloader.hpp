@@ -3,11 +3,16 @@
 
 #include <asio.hpp>
 #include <fstream>
+#include <nlohmann/json.hpp>
 #include "shared/include/networking_agreements.hpp"
 #include "shared/include/client_config.hpp"
 #include "shared/include/packet_writer.hpp"
+#include "shared/include/content_chunks.hpp"
+#include "shared/include/asset_compression.hpp"
+#include "shared/include/asset_manifest.hpp"
 
 using namespace asio::ip;
+using json = nlohmann::json;
 
 
 // Depending on the server admin, 
@@ -18,6 +23,8 @@ using namespace asio::ip;
 
 namespace AM {
     
+    // How often download progress is printed when the file is streamed.
+    static constexpr size_t STREAM_PROGRESS_INTERVAL_BYTES = 1024 * 1024;
    
     class AssetsDownloader {
         public:
@@ -31,6 +38,9 @@ namespace AM {
             void update_assets();
             void close_connection(asio::io_context& context);
 
+            // When false the download is accepted without asking from the command line.
+            bool ask_download_permission { true };
+
         private:
 
             std::atomic<bool> m_keep_connection_alive { true };
@@ -44,6 +54,17 @@ namespace AM {
             AM::Packet m_packet;
             void m_send_packet();
 
+            // 'data' is written right after the packet and must stay valid until it is sent.
+            void m_send_packet_with_data(const void* data, size_t sizeb);
+
+            // Sent to the server. (see AM::PacketID::CLIENT_GAMEASSET_FILE_HASHES)
+            std::vector<AM::AssetManifestEntry> m_local_manifest;
+
+            // File list of DO_ACCEPT_ASSETS_DOWNLOAD. It is written after the packet.
+            std::vector<char> m_file_list_bytes;
+            size_t m_download_total_sizeb { 0 };
+            void   m_handle_file_list();
+
             std::thread m_event_handler_th;
 
             void m_write_data(const std::string& data);
@@ -63,6 +84,75 @@ namespace AM {
             std::string   m_download_filename;
             std::ofstream m_download_file;
 
+            // Set if the file is sent compressed. 
+            // 'm_download_sizeb' is then the compressed size.
+            bool                  m_decode_download { false };
+            AM::AssetFileDecoder  m_file_decoder;
+            void   m_write_download_file(const char* data, size_t size);
+
+            // Set when the server streams raw bytes instead of packets.
+            // Everything received goes to the target until 'm_stream_remaining' bytes are read.
+            enum StreamTarget : int {
+                STREAM_NONE,
+                STREAM_FILE,      // Whole file.
+                STREAM_MANIFEST,  // Content chunk manifest of the file. (delta update)
+                STREAM_CHUNKS,    // Missing content chunks. (delta update)
+                STREAM_FRAMES,    // Frames of many files. (see AM::AssetStreamFrameHeader)
+                STREAM_FILE_LIST  // Rest of the DO_ACCEPT_ASSETS_DOWNLOAD file list.
+            };
+            int    m_stream_target { STREAM_NONE };
+            size_t m_stream_remaining { 0 };
+            size_t m_stream_progress_bytes { 0 };
+            void   m_handle_stream_data(size_t size);
+            void   m_handle_file_stream_data(size_t size);
+            void   m_finish_streamed_file();
+
+            // Multi file streaming. (see AM::PacketID::ACCEPTED_ASSETS_DOWNLOAD)
+            // Files are downloaded into "<file>.<hash prefix>.part" first, 
+            // so an interrupted download continues from the same offset next time.
+            // Compressed files are always downloaded from the beginning.
+            // The part file replaces the old file when it is complete and its hash is correct.
+            struct mFileStream {
+                std::string   name;
+                std::string   filepath;
+                std::string   part_filepath;
+                std::string   sha256_hash;
+                size_t        size;          // Bytes sent. (Compressed size if 'decoder' is set)
+                size_t        received;
+                bool          complete;
+                std::ofstream file;
+                AM::AssetFileDecoder* decoder;
+            };
+            std::vector<mFileStream> m_file_streams; // Index is the stream id.
+            size_t m_incomplete_streams { 0 };
+            size_t m_frames_received_bytes { 0 };
+            size_t m_frames_total_bytes { 0 };
+            size_t m_frame_header_received { 0 };
+            size_t m_frame_remaining { 0 };
+            mFileStream* m_frame_stream { NULL };
+            AM::AssetStreamFrameHeader m_frame_header;
+            json   m_prepare_file_streams(const json& files_json);
+            size_t m_next_frame_read_size();
+            void   m_handle_frame_data(size_t size);
+            void   m_finish_file_stream(mFileStream& stream);
+
+            // Delta updates. 
+            // The new version is assembled into "<file>.part" from the chunks of the old file
+            // and the downloaded chunks. It replaces the old file if its hash is correct.
+            std::string   m_download_filepath;
+            std::string   m_download_sha256;
+            std::ifstream m_old_file;
+            std::vector<char>             m_manifest_bytes;
+            std::vector<AM::ContentChunk> m_remote_chunks;
+            std::vector<AM::ContentChunk> m_local_chunks;
+            std::vector<int64_t>          m_chunk_sources; // Index in 'm_local_chunks' or -1 if downloaded.
+            std::vector<char>             m_chunk_copy_buffer;
+            size_t   m_assemble_index { 0 };
+            uint32_t m_assemble_chunk_offset { 0 };
+            void     m_request_missing_chunks();
+            void     m_assemble_delta_file(const char* data, size_t size);
+            void     m_finish_delta_file();
+
             AM::ClientConfig m_config;
     };
 
@@ -207,29 +207,17 @@ void AM::Network::m_attach_main_UDP_packet_callbacks() {
         m_engine->player.set_chunk_pos(AM::ChunkPos(chunk_x, chunk_z));
         m_engine->player.on_ground = (bool)std::clamp(on_ground, 0, 1);
 
-        if(update_axis_flags != 0) {
-            if((update_axis_flags & AM::FLG_PLAYER_UPDATE_XZ_AXIS)
-            && (update_axis_flags & AM::FLG_PLAYER_UPDATE_Y_AXIS)) {
-                memmove(&position, &data[byte_offset], sizeof(Vector3));
-                
-                // Update stacks to interpolate the position.
-                m_engine->player.Y_pos_update_stack.push_front(position.y);
-                m_engine->player.XZ_pos_update_stack.push_front(Vector2(position.x, position.z));
-            }
-            else
-            if((update_axis_flags & AM::FLG_PLAYER_UPDATE_Y_AXIS)
-            && !(update_axis_flags & AM::FLG_PLAYER_UPDATE_XZ_AXIS)) { // Only Y
-                memmove(&position.y, &data[byte_offset], sizeof(float));
-                
-                // Update stacks to interpolate the position.
-                m_engine->player.Y_pos_update_stack.push_front(position.y);
-                m_engine->player.XZ_pos_update_stack.pop_back();
-            }
+        if((update_axis_flags & AM::FLG_PLAYER_UPDATE_XZ_AXIS)
+        && (update_axis_flags & AM::FLG_PLAYER_UPDATE_Y_AXIS)) {
+            memmove(&position, &data[byte_offset], sizeof(Vector3));
         }
-        else {
-            m_engine->player.XZ_pos_update_stack.pop_back();
-            m_engine->player.Y_pos_update_stack.pop_back();
+        else
+        if(update_axis_flags & AM::FLG_PLAYER_UPDATE_Y_AXIS) { // Only Y
+            memmove(&position.y, &data[byte_offset], sizeof(float));
         }
+
+        // The main thread updates the stacks to interpolate the position.
+        m_engine->player.push_position_update({ update_axis_flags, position });
     });
 
 
@@ -1,4 +1,5 @@
 #include <cstdio>
+#include <algorithm>
 
 
 #include "player.hpp"
@@ -291,11 +292,26 @@ void AM::Player::update_gravity() {
 
 
 void AM::Player::update_position_from_server() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Updates in the overflow list are newer than everything in the queue.
+    const bool overflowed = m_position_updates_overflow.has_items();
+    while(const PositionUpdate* update = m_position_updates.front()) {
+        m_apply_position_update(*update);
+        m_position_updates.pop();
+    }
+    if(overflowed && m_position_updates_overflow.take(&m_position_updates_read)) {
+        printf("[PLAYER]: Position update queue was full, %li updates waited in the overflow list\n",
+                m_position_updates_read.size());
+        for(const PositionUpdate& update : m_position_updates_read) {
+            m_apply_position_update(update);
+        }
+        m_position_updates_read.clear();
+    }
+
     if(!m_engine->ready) {
         return;
     }
-    
-    std::lock_guard<std::mutex> lock(m_mutex);
 
     if(Y_pos_update_stack.size() >= 2) {
         m_update_Y_axis_position();
@@ -306,11 +322,36 @@ void AM::Player::update_position_from_server() {
     }
 }
 
+void AM::Player::push_position_update(const PositionUpdate& update) {
+    // While the overflow list has updates new ones go there too so they stay in order.
+    if(m_position_updates_overflow.has_items() || !m_position_updates.push(update)) {
+        m_position_updates_overflow.push(update);
+    }
+}
+
+void AM::Player::m_apply_position_update(const PositionUpdate& update) {
+    if((update.axis_flags & AM::FLG_PLAYER_UPDATE_XZ_AXIS)
+    && (update.axis_flags & AM::FLG_PLAYER_UPDATE_Y_AXIS)) {
+        this->Y_pos_update_stack.push_front(update.position.y);
+        this->XZ_pos_update_stack.push_front(Vector2(update.position.x, update.position.z));
+    }
+    else
+    if(update.axis_flags & AM::FLG_PLAYER_UPDATE_Y_AXIS) { // Only Y
+        this->Y_pos_update_stack.push_front(update.position.y);
+        this->XZ_pos_update_stack.pop_back();
+    }
+    else
+    if(update.axis_flags == 0) {
+        this->XZ_pos_update_stack.pop_back();
+        this->Y_pos_update_stack.pop_back();
+    }
+}
+
 void AM::Player::m_update_Y_axis_position() {
 
-    AM::Timer* ypos_interp_timer = m_engine->get_named_timer("PLAYER_YPOS_INTERP_TIMER");
+    AM::Timer* pos_interp_timer = m_engine->get_named_timer("PLAYER_POS_INTERP_TIMER");
     float interp_t 
-        = ypos_interp_timer->time_ms()
+        = pos_interp_timer->time_ms()
         / m_engine->net->get_packet_interval_ms(AM::PacketID::PLAYER_POSITION);
 
     m_position.y = Lerp(
@@ -322,7 +363,23 @@ void AM::Player::m_update_Y_axis_position() {
 }
 
 void AM::Player::m_update_XZ_axis_position() {
-    printf("%s NOT IMPLEMENTED\n", __func__);
+
+    // Server didnt accept the position. Move back towards the position it gave
+    // and stop moving so the client doesnt keep pushing against it.
+    AM::Timer* pos_interp_timer = m_engine->get_named_timer("PLAYER_POS_INTERP_TIMER");
+    float interp_t 
+        = pos_interp_timer->time_ms()
+        / m_engine->net->get_packet_interval_ms(AM::PacketID::PLAYER_POSITION);
+
+    const Vector2 xz = Vector2Lerp(
+            this->XZ_pos_update_stack.read_index(1),
+            this->XZ_pos_update_stack.read_index(0),
+            std::clamp(interp_t, 0.0f, 1.0f));
+
+    m_position.x = xz.x;
+    m_position.z = xz.y;
+    m_velocity.x = 0.0f;
+    m_velocity.z = 0.0f;
 }
 
 
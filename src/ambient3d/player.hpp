@@ -9,6 +9,7 @@
 
 #include "anim_ids.hpp"
 #include "threadsafe_stack.hpp"
+#include "mpsc_queue.hpp"
 #include "shared/include/inventory.hpp"
 #include "shared/include/chunk_pos.hpp"
 
@@ -77,6 +78,15 @@ namespace AM {
             std::atomic<bool> on_ground { false };
             std::atomic<bool> fully_connected { false };
 
+            struct PositionUpdate {
+                int     axis_flags; // FLG_PLAYER_UPDATE_* or 0 if the server didnt move the player.
+                Vector3 position;
+            };
+
+            // Called by the network thread. 'update_position_from_server'
+            // moves the updates to the stacks below.
+            void push_position_update(const PositionUpdate& update); // < thread safe >
+
             // Position stack sent from server side.
             // Latest one is at first index.
             // Y and XZ are separeted because sometimes XZ position is not needed to update.
@@ -96,6 +106,13 @@ namespace AM {
 
             //void m_update_animation();
             void m_jump();
+            void m_apply_position_update(const PositionUpdate& update);
+
+            // Every update must be applied because each one pushes to or pops from the stacks.
+            // The server doesnt send them again, so when the queue is full they go to the overflow list.
+            AM::MPSCQueue<PositionUpdate, 16>    m_position_updates;
+            AM::OverflowList<PositionUpdate>     m_position_updates_overflow;
+            std::vector<PositionUpdate>          m_position_updates_read;
             Vector3 m_position { 0.0f, 0.0f, 0.0f };
             Vector3 m_velocity { 0.0f, 0.0f, 0.0f };
             float   m_camera_yaw { 0.0f };
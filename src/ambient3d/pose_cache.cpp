@@ -0,0 +1,100 @@
+#include <cstdio>
+#include <cmath>
+
+#include "pose_cache.hpp"
+#include "raymath.h"
+
+
+Matrix AM::transform_matrix(const Transform& t) {
+    return MatrixMultiply(MatrixMultiply(
+                MatrixScale(t.scale.x, t.scale.y, t.scale.z),
+                QuaternionToMatrix(t.rotation)),
+                MatrixTranslate(t.translation.x, t.translation.y, t.translation.z));
+}
+
+int AM::sample_animation_frame(float time, float frame_duration, int frame_count) {
+    if((frame_count <= 0) || (frame_duration <= 0.0f) || (time <= 0.0f)) {
+        return 0;
+    }
+    const double frame = floor((double)time / (double)frame_duration);
+    return (int)fmod(frame, (double)frame_count);
+}
+
+bool AM::PoseCache::init(const Transform* bind_pose, int bone_count,
+        const ModelAnimation* anims, uint32_t num_anims) {
+    this->clear();
+
+    if(bone_count > AM::MAX_SKINNING_BONES) {
+        fprintf(stderr, "ERROR! %s: Too many bones (%i), the limit is %i\n",
+                __func__, bone_count, AM::MAX_SKINNING_BONES);
+        return false;
+    }
+
+    size_t num_frames = 0;
+    for(uint32_t i = 0; i < num_anims; i++) {
+        if(anims[i].boneCount != bone_count) {
+            fprintf(stderr, "ERROR! %s: Number of bones in model and animation %i doesnt match.\n",
+                    __func__, i);
+            this->clear();
+            return false;
+        }
+        m_anim_offsets.push_back(num_frames);
+        num_frames += (size_t)anims[i].frameCount;
+    }
+
+    m_anims = anims;
+    m_bone_count = bone_count;
+
+    m_inverse_bind.resize(bone_count);
+    for(int i = 0; i < bone_count; i++) {
+        m_inverse_bind[i] = MatrixInvert(AM::transform_matrix(bind_pose[i]));
+    }
+
+    m_computed.assign(num_frames, 0);
+    m_matrices.resize(num_frames * bone_count);
+    return true;
+}
+
+void AM::PoseCache::clear() {
+    m_anims = NULL;
+    m_bone_count = 0;
+    m_num_computed = 0;
+    m_inverse_bind.clear();
+    m_anim_offsets.clear();
+    m_computed.clear();
+    m_matrices.clear();
+}
+
+int AM::PoseCache::frame_count(uint32_t anim_index) const {
+    return (anim_index < m_anim_offsets.size()) ? m_anims[anim_index].frameCount : 0;
+}
+
+const Matrix* AM::PoseCache::get(uint32_t anim_index, int frame) {
+    if(anim_index >= m_anim_offsets.size()) {
+        return NULL;
+    }
+    const ModelAnimation& anim = m_anims[anim_index];
+    if(anim.frameCount <= 0) {
+        return NULL;
+    }
+    frame %= anim.frameCount;
+    if(frame < 0) {
+        frame += anim.frameCount;
+    }
+
+    const size_t frame_index = m_anim_offsets[anim_index] + frame;
+    Matrix* matrices = &m_matrices[frame_index * m_bone_count];
+    if(m_computed[frame_index]) {
+        return matrices;
+    }
+
+    // Same as raylib's UpdateModelAnimationBones
+    const Transform* pose = anim.framePoses[frame];
+    for(int i = 0; i < m_bone_count; i++) {
+        matrices[i] = MatrixMultiply(m_inverse_bind[i], AM::transform_matrix(pose[i]));
+    }
+    m_computed[frame_index] = 1;
+    m_num_computed++;
+    return matrices;
+}
+
@@ -0,0 +1,66 @@
+#ifndef AMBIENT3D_POSE_CACHE_HPP
+#define AMBIENT3D_POSE_CACHE_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "raylib.h"
+
+
+// Bone matrices of animation frames for GPU skinning.
+//
+// Each (animation, frame) is computed once when it is first needed and then
+// shared by every instance of the model showing the same frame.
+// The vertices are skinned in the vertex shader (DEFAULT_SKINNED)
+// so nothing is done per vertex on the CPU.
+//
+// Nothing in here touches OpenGL so it can be used and measured without a window.
+
+namespace AM {
+
+    // Must match MAX_BONES in DEFAULT_VERTEX.
+    static constexpr int MAX_SKINNING_BONES = 128;
+
+    // Frame of a looping animation 'time' seconds after it started.
+    int sample_animation_frame(float time, float frame_duration, int frame_count);
+
+    // Scale, rotation and then translation.
+    Matrix transform_matrix(const Transform& transform);
+
+    class PoseCache {
+        public:
+
+            // 'bind_pose' is from the model and 'anims' from LoadModelAnimations.
+            // They must stay valid until 'clear'. Returns false if the bones dont match.
+            bool init(const Transform* bind_pose, int bone_count,
+                    const ModelAnimation* anims, uint32_t num_anims);
+            void clear();
+
+            // Skinning matrices for every bone (inverse bind pose * frame pose).
+            // Returns NULL if 'anim_index' is out of bounds. Frame wraps around.
+            const Matrix* get(uint32_t anim_index, int frame);
+
+            int      bone_count() const { return m_bone_count; }
+            int      frame_count(uint32_t anim_index) const;
+            uint32_t num_anims() const { return (uint32_t)m_anim_offsets.size(); }
+
+            // How many frames have been computed since 'init'
+            size_t   num_computed() const { return m_num_computed; }
+
+        private:
+
+            const ModelAnimation* m_anims { NULL };
+            int                   m_bone_count { 0 };
+            size_t                m_num_computed { 0 };
+
+            std::vector<Matrix>   m_inverse_bind;
+            std::vector<size_t>   m_anim_offsets;  // First frame of each animation.
+            std::vector<uint8_t>  m_computed;      // For every frame of every animation.
+            std::vector<Matrix>   m_matrices;      // 'm_bone_count' for every frame.
+    };
+
+};
+
+
+#endif
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cstring>
+
+#include "render_queue.hpp"
+#include "raymath.h"
+
+
+static constexpr int KEY_DEPTH_BITS    = 24;
+static constexpr int KEY_MESH_BITS     = 16;
+static constexpr int KEY_MATERIAL_BITS = 12;
+static constexpr int KEY_SHADER_BITS   = 10;
+
+static constexpr int KEY_MESH_SHIFT     = KEY_DEPTH_BITS;
+static constexpr int KEY_MATERIAL_SHIFT = KEY_MESH_SHIFT + KEY_MESH_BITS;
+static constexpr int KEY_SHADER_SHIFT   = KEY_MATERIAL_SHIFT + KEY_MATERIAL_BITS;
+static constexpr int KEY_PASS_SHIFT     = KEY_SHADER_SHIFT + KEY_SHADER_BITS;
+
+static constexpr int RADIX_BITS = 8;
+static constexpr int RADIX_SIZE = 1 << RADIX_BITS;
+static constexpr int RADIX_PASSES = 64 / RADIX_BITS;
+
+
+// Ids over the bit count are folded so the low bits dont decide alone.
+static uint64_t _fold_id(uint64_t id, int bits) {
+    const uint64_t mask = (1ULL << bits) - 1;
+    uint64_t folded = 0;
+    while(id) {
+        folded ^= id & mask;
+        id >>= bits;
+    }
+    return folded;
+}
+
+uint64_t AM::make_render_key(AM::RenderPass pass,
+        uint32_t shader_id, uint64_t material_id, uint32_t mesh_id, float depth) {
+    constexpr uint32_t max_depth = (1U << KEY_DEPTH_BITS) - 1;
+    const float depth_n = std::clamp(depth / AM::RENDER_QUEUE_MAX_DEPTH, 0.0f, 1.0f);
+
+    uint64_t depth_bits = (uint64_t)(depth_n * max_depth);
+    if(pass == AM::RenderPass::RP_TRANSPARENT) {
+        depth_bits = max_depth - depth_bits;
+    }
+
+    return ((uint64_t)pass << KEY_PASS_SHIFT)
+        | (_fold_id(shader_id, KEY_SHADER_BITS) << KEY_SHADER_SHIFT)
+        | (_fold_id(material_id, KEY_MATERIAL_BITS) << KEY_MATERIAL_SHIFT)
+        | (_fold_id(mesh_id, KEY_MESH_BITS) << KEY_MESH_SHIFT)
+        | depth_bits;
+}
+
+void AM::RenderQueue::begin(const Vector3& view_pos) {
+    m_view_pos = view_pos;
+    this->clear();
+}
+
+void AM::RenderQueue::clear() {
+    m_packets.clear();
+    m_items.clear();
+}
+
+void AM::RenderQueue::submit(AM::RenderPass pass, const Mesh* mesh, const Material* material,
+        const Matrix& transform, const AM::MeshAttrib* attrib, const Matrix* bone_matrices) {
+    const Vector3 pos = Vector3(transform.m12, transform.m13, transform.m14);
+
+    // Materials have no id, the address is used instead. They are aligned to at least 8.
+    const uint64_t material_id = (uint64_t)((uintptr_t)material >> 3);
+
+    m_items.push_back(mSortItem{
+            AM::make_render_key(pass, material->shader.id, material_id, mesh->vaoId,
+                    Vector3Distance(pos, m_view_pos)),
+            (uint32_t)m_packets.size()
+    });
+    m_packets.push_back(AM::RenderPacket{ mesh, material, attrib, bone_matrices, transform, pass });
+}
+
+void AM::RenderQueue::sort() {
+    const size_t num_items = m_items.size();
+    if(num_items < 2) {
+        return;
+    }
+
+    // LSD radix sort, 8 bits at a time. Counts for all digits are taken in one go
+    // and digits where every key is the same (unused passes or shaders for example) are skipped.
+    uint32_t counts[RADIX_PASSES][RADIX_SIZE];
+    memset(counts, 0, sizeof(counts));
+    for(const mSortItem& item : m_items) {
+        for(int d = 0; d < RADIX_PASSES; d++) {
+            counts[d][(item.key >> (d * RADIX_BITS)) & (RADIX_SIZE - 1)]++;
+        }
+    }
+
+    m_sort_tmp.resize(num_items);
+    for(int d = 0; d < RADIX_PASSES; d++) {
+        const int shift = d * RADIX_BITS;
+        uint32_t* digit_counts = counts[d];
+        if(digit_counts[(m_items[0].key >> shift) & (RADIX_SIZE - 1)] == num_items) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for(int i = 0; i < RADIX_SIZE; i++) {
+            const uint32_t count = digit_counts[i];
+            digit_counts[i] = offset;
+            offset += count;
+        }
+
+        for(const mSortItem& item : m_items) {
+            m_sort_tmp[digit_counts[(item.key >> shift) & (RADIX_SIZE - 1)]++] = item;
+        }
+        m_items.swap(m_sort_tmp);
+    }
+}
+
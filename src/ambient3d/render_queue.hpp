@@ -0,0 +1,84 @@
+#ifndef AMBIENT3D_RENDER_QUEUE_HPP
+#define AMBIENT3D_RENDER_QUEUE_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "raylib.h"
+#include "renderable.hpp"
+
+
+// Draws submitted during the frame are collected here and sorted
+// before they are drawn, so objects using the same shader, material and mesh
+// are drawn one after another and the state has to be changed less often.
+//
+// Sort key (64 bits, highest first):
+//  pass (2) | shader (10) | material (12) | mesh (16) | depth (24)
+//
+// The shader, material and mesh parts are only used for grouping,
+// ids which dont fit are folded into the bits so two different ones
+// may end up next to each other. The renderer still compares the real state.
+//
+// Nothing in here touches OpenGL so it can be used and measured without a window.
+
+namespace AM {
+
+    enum RenderPass : uint8_t {
+        RP_SKY,          // No depth writes and no backface culling.
+        RP_OPAQUE,       // Front to back.
+        RP_TRANSPARENT,  // Back to front.
+
+        RP_NUM_PASSES
+    };
+
+    // Distance from the view position where the depth part of the key stops growing.
+    static constexpr float RENDER_QUEUE_MAX_DEPTH = 4096.0f;
+
+    uint64_t make_render_key(AM::RenderPass pass,
+            uint32_t shader_id, uint64_t material_id, uint32_t mesh_id, float depth);
+
+    struct RenderPacket {
+        const Mesh*           mesh;
+        const Material*       material;
+        const AM::MeshAttrib* attrib;  // NULL uses the MeshAttrib defaults.
+        const Matrix*         bone_matrices; // 'mesh->boneCount' of them or NULL if not skinned.
+        Matrix                transform;
+        AM::RenderPass        pass;
+    };
+
+    class RenderQueue {
+        public:
+
+            // Clears the queue. Depth of the packets is measured from 'view_pos'
+            void begin(const Vector3& view_pos);
+            void clear();
+
+            // 'mesh', 'material', 'attrib' and 'bone_matrices' must stay valid until the queue is cleared.
+            void submit(AM::RenderPass pass, const Mesh* mesh, const Material* material,
+                    const Matrix& transform, const AM::MeshAttrib* attrib = NULL,
+                    const Matrix* bone_matrices = NULL);
+
+            void   sort();
+            size_t size() const { return m_packets.size(); }
+
+            // Valid after 'sort'
+            const AM::RenderPacket& sorted(size_t i) const { return m_packets[m_items[i].index]; }
+
+        private:
+
+            struct mSortItem {
+                uint64_t key;
+                uint32_t index;
+            };
+
+            Vector3                       m_view_pos { 0, 0, 0 };
+            std::vector<AM::RenderPacket> m_packets;
+            std::vector<mSortItem>        m_items;
+            std::vector<mSortItem>        m_sort_tmp;
+    };
+
+};
+
+
+#endif
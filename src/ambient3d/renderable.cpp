@@ -37,6 +37,9 @@ bool AM::Renderable::load(
 
     if((load_flags & RLF_ANIMATIONS)) {
         this->anim.load(path);
+        if(this->anim.is_loaded()) {
+            this->anim.init_pose_cache(m_model);
+        }
     }
 
     m_mesh_attribs = new MeshAttrib[m_model.meshCount];
@@ -92,6 +95,8 @@ void AM::Renderable::m_name_from_path(const char* path) {
 
 void AM::Renderable::unload() {
     if(!m_loaded) { return; }
+
+    m_pose = NULL;
     
     if(this->mesh_transforms) {
         delete[] this->mesh_transforms;
@@ -118,6 +123,11 @@ void AM::Renderable::mesh_attribute(size_t mesh_index, const MeshAttrib& mesh_at
 }
 
             
+const Matrix* AM::Renderable::m_mesh_pose(int mesh_index) {
+    const Mesh& mesh = m_model.meshes[mesh_index];
+    return (m_pose && mesh.boneWeights && (mesh.boneCount > 0)) ? m_pose : NULL;
+}
+
 void AM::Renderable::render() {
     if(!m_loaded) { return; }
 
@@ -142,7 +152,15 @@ void AM::Renderable::render() {
             ? m_model.transform
             : MatrixMultiply(this->mesh_transforms[i], m_model.transform);
 
-        DrawMesh(m_model.meshes[i], mat, mesh_transform);
+        // DrawMesh uploads the bone matrices from the mesh.
+        Mesh mesh = m_model.meshes[i];
+        const Matrix* pose = m_mesh_pose(i);
+        if(pose) {
+            mesh.boneMatrices = (Matrix*)pose;
+        }
+        AM::set_uniform_int(mat.shader.id, "u_skinned", (pose != NULL));
+
+        DrawMesh(mesh, mat, mesh_transform);
         
         AM::set_uniform_float(mat.shader.id, "u_material_shine_level", MATERIAL_DEFAULT_SHINE);
         AM::set_uniform_float(mat.shader.id, "u_material_specular", MATERIAL_DEFAULT_SPECULAR);
@@ -156,23 +174,41 @@ void AM::Renderable::render() {
     }
 }
             
-/*
-void AM::Renderable::render_instanced(Matrix* transforms, size_t size) {
-    if(!m_loaded) { return; }
+void AM::Renderable::render_instanced(const Matrix* transforms, size_t count, const Shader& instanced_shader) {
+    if(!m_loaded || (count == 0)) { return; }
 
     for(int i = 0; i < m_model.meshCount; i++) {
-        Material& mat = m_model.materials[m_model.meshMaterial[i]];
+        Material mat = m_model.materials[m_model.meshMaterial[i]];
+        mat.shader = instanced_shader;
 
-        const MeshAttrib& mesh_attr = ((size_t)i < m_model.meshCount)
+        const MeshAttrib& mesh_attr = (i < m_model.meshCount)
             ? m_mesh_attribs[i] : MeshAttrib{};
 
         if(mesh_attr.render_backface) {
             rlDisableBackfaceCulling();
         }
 
+        mat.maps[MATERIAL_MAP_DIFFUSE].color = mesh_attr.tint;
+
         AM::set_uniform_int(mat.shader.id, "u_affected_by_wind", mesh_attr.affected_by_wind);
-        DrawMeshInstanced(m_model.meshes[i], mat, transforms, size);
-        
+        AM::set_uniform_float(mat.shader.id, "u_material_shine_level", mesh_attr.shine);
+        AM::set_uniform_float(mat.shader.id, "u_material_specular", mesh_attr.specular);
+
+        // Instance transforms replace the model transform.
+        const Matrix* mesh_instances = transforms;
+        if(this->mesh_transforms) {
+            m_instance_transforms.resize(count);
+            for(size_t k = 0; k < count; k++) {
+                m_instance_transforms[k] = MatrixMultiply(this->mesh_transforms[i], transforms[k]);
+            }
+            mesh_instances = m_instance_transforms.data();
+        }
+
+        DrawMeshInstanced(m_model.meshes[i], mat, mesh_instances, (int)count);
+
+        AM::set_uniform_float(mat.shader.id, "u_material_shine_level", MATERIAL_DEFAULT_SHINE);
+        AM::set_uniform_float(mat.shader.id, "u_material_specular", MATERIAL_DEFAULT_SPECULAR);
+
         if(mesh_attr.render_backface) {
             rlEnableBackfaceCulling();
         }
@@ -181,5 +217,22 @@ void AM::Renderable::render_instanced(Matrix* transforms, size_t size) {
         }
     }  
 }
-*/
+void AM::Renderable::submit(AM::RenderQueue* queue) {
+    if(!m_loaded) { return; }
+
+    for(int i = 0; i < m_model.meshCount; i++) {
+        Matrix mesh_transform =
+            (this->mesh_transforms == NULL) 
+            ? m_model.transform
+            : MatrixMultiply(this->mesh_transforms[i], m_model.transform);
+
+        queue->submit(AM::RenderPass::RP_OPAQUE,
+                &m_model.meshes[i],
+                &m_model.materials[m_model.meshMaterial[i]],
+                mesh_transform,
+                &m_mesh_attribs[i],
+                m_mesh_pose(i));
+    }
+}
+
 
@@ -11,6 +11,8 @@
 
 
 namespace AM {
+
+    class RenderQueue;
     
     static constexpr size_t RENDERABLE_MAX_NAME_SIZE = 24;
     static constexpr float MATERIAL_DEFAULT_SHINE = 0.1f;
@@ -57,6 +59,14 @@ namespace AM {
 
             void unload();
             void render();
+
+            // Renders the model once for each transform in one draw call per mesh.
+            // The transforms replace 'transform'. 'instanced_shader' is used instead of the
+            // model's shaders, it must be an instanced version of them. (see AM::init_instanced_shader)
+            void render_instanced(const Matrix* transforms, size_t count, const Shader& instanced_shader);
+
+            // Same as 'render' but the meshes are drawn later with the rest of the queue.
+            void submit(AM::RenderQueue* queue);
             void mesh_attribute(size_t mesh_index, const MeshAttrib& mesh_attrib);
 
             bool is_loaded() { return m_loaded; }
@@ -70,14 +80,24 @@ namespace AM {
             AM::Animation  anim;
             void           update_animation(float frame_time);
 
+            // Bone matrices used by 'render' and 'submit' for meshes which have bone weights.
+            // Usually from 'anim.pose()', must stay valid until the frame is rendered.
+            // The shader must be DEFAULT_SKINNED. NULL renders the bind pose.
+            void           set_pose(const Matrix* bone_matrices) { m_pose = bone_matrices; }
+
             uint32_t num_meshes()  { return (uint32_t)m_model.meshCount; }
             Model* get_model()     { return &m_model; }
 
         private:
 
             MeshAttrib*  m_mesh_attribs;
+            std::vector<Matrix> m_instance_transforms; // Mesh transforms applied.
             bool         m_loaded { false };
             Model        m_model;
+            const Matrix* m_pose { NULL };
+
+            // Bone matrices for the mesh or NULL if it isnt skinned.
+            const Matrix* m_mesh_pose(int mesh_index);
 
             void m_name_from_path(const char* path);
     };
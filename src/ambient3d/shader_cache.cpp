@@ -0,0 +1,232 @@
+#include <cstdio>
+#include <cstring>
+#include <cinttypes>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+
+#include "shader_cache.hpp"
+#include "glsl_preproc.hpp"
+#include "rlgl.h"
+#include "external/glad.h"
+
+
+namespace {
+
+    static constexpr uint32_t BINARY_MAGIC = 0x42534D41; // "AMSB"
+    static constexpr uint32_t BINARY_VERSION = 1;
+
+    struct mBinaryHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t format;
+        uint32_t size;
+        uint64_t key;     // Checked again in case the file was renamed.
+    };
+
+    struct mLocationName {
+        int         loc;
+        const char* name;
+        bool        attrib;
+    };
+
+    // Same names as raylib's LoadShaderFromMemory looks for.
+    static constexpr mLocationName LOCATION_NAMES[] = {
+        { SHADER_LOC_VERTEX_POSITION,    "vertexPosition",    true },
+        { SHADER_LOC_VERTEX_TEXCOORD01,  "vertexTexCoord",    true },
+        { SHADER_LOC_VERTEX_TEXCOORD02,  "vertexTexCoord2",   true },
+        { SHADER_LOC_VERTEX_NORMAL,      "vertexNormal",      true },
+        { SHADER_LOC_VERTEX_TANGENT,     "vertexTangent",     true },
+        { SHADER_LOC_VERTEX_COLOR,       "vertexColor",       true },
+        { SHADER_LOC_VERTEX_BONEIDS,     "vertexBoneIds",     true },
+        { SHADER_LOC_VERTEX_BONEWEIGHTS, "vertexBoneWeights", true },
+        { SHADER_LOC_VERTEX_INSTANCE_TX, "instanceTransform", true },
+        { SHADER_LOC_MATRIX_MVP,         "mvp",               false },
+        { SHADER_LOC_MATRIX_VIEW,        "matView",           false },
+        { SHADER_LOC_MATRIX_PROJECTION,  "matProjection",     false },
+        { SHADER_LOC_MATRIX_MODEL,       "matModel",          false },
+        { SHADER_LOC_MATRIX_NORMAL,      "matNormal",         false },
+        { SHADER_LOC_BONE_MATRICES,      "boneMatrices",      false },
+        { SHADER_LOC_COLOR_DIFFUSE,      "colDiffuse",        false },
+        { SHADER_LOC_MAP_DIFFUSE,        "texture0",          false },
+        { SHADER_LOC_MAP_SPECULAR,       "texture1",          false },
+        { SHADER_LOC_MAP_NORMAL,         "texture2",          false }
+    };
+
+    static AM::ShaderCacheStats stats;
+    static uint64_t driver_hash = 0;
+    static bool     binaries_supported = false;
+    static bool     initialized = false;
+};
+
+
+static void _init_cache() {
+    if(::initialized) {
+        return;
+    }
+    ::initialized = true;
+
+    std::string driver;
+    for(const GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        const char* str = (const char*)glGetString(name);
+        driver += (str) ? str : "?";
+        driver += '\n';
+    }
+    ::driver_hash = AM::GLSL_hash(driver);
+
+    GLint num_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+    ::binaries_supported = (num_formats > 0);
+    if(!::binaries_supported) {
+        printf("[SHADER_CACHE]: Driver has no program binary formats, cache is disabled.\n");
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(AM::SHADER_CACHE_DIR, ec);
+    if(ec) {
+        fprintf(stderr, "ERROR! %s: Failed to create \"%s\" (%s)\n",
+                __func__, AM::SHADER_CACHE_DIR, ec.message().c_str());
+        ::binaries_supported = false;
+    }
+}
+
+static std::string _cache_path(uint64_t key) {
+    char name[32] = { 0 };
+    snprintf(name, sizeof(name), "%016" PRIx64 ".bin", key);
+    return (std::filesystem::path(AM::SHADER_CACHE_DIR) / name).string();
+}
+
+static void _set_locations(Shader* shader) {
+    shader->locs = (int*)RL_CALLOC(RL_MAX_SHADER_LOCATIONS, sizeof(int));
+    for(int i = 0; i < RL_MAX_SHADER_LOCATIONS; i++) {
+        shader->locs[i] = -1;
+    }
+    for(const mLocationName& loc : ::LOCATION_NAMES) {
+        shader->locs[loc.loc] = (loc.attrib)
+            ? rlGetLocationAttrib(shader->id, loc.name)
+            : rlGetLocationUniform(shader->id, loc.name);
+    }
+}
+
+// Returns program id or 0 if there is no usable binary for 'key'.
+static unsigned int _load_binary(uint64_t key, const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if(!file.is_open()) {
+        return 0;
+    }
+
+    mBinaryHeader header;
+    std::vector<char> binary;
+    bool valid = false;
+    if(file.read((char*)&header, sizeof(header))
+    && (header.magic == ::BINARY_MAGIC)
+    && (header.version == ::BINARY_VERSION)
+    && (header.key == key)
+    && (header.size > 0)) {
+        binary.resize(header.size);
+        valid = (bool)file.read(binary.data(), header.size);
+    }
+    file.close();
+
+    unsigned int program = 0;
+    if(valid) {
+        program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), header.size);
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if(!linked) {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    if(!program) {
+        // Driver was updated or the file is broken. It will be saved again after compiling.
+        printf("[SHADER_CACHE]: Rejected \"%s\"\n", path.c_str());
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+    return program;
+}
+
+static void _save_binary(uint64_t key, const std::string& path, unsigned int program) {
+    // NOTE: raylib links the program so GL_PROGRAM_BINARY_RETRIEVABLE_HINT cant be set before it.
+    //       Common drivers give the binary anyway, if not then it just isnt cached.
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0) {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if(written <= 0) {
+        return;
+    }
+
+    const mBinaryHeader header = {
+        ::BINARY_MAGIC, ::BINARY_VERSION, (uint32_t)format, (uint32_t)written, key
+    };
+
+    // Written to temporary file first so a crash cant leave half of a file.
+    const std::string tmp_path = path + ".tmp";
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    if(!file.is_open()) {
+        fprintf(stderr, "ERROR! %s: Failed to open \"%s\"\n",
+                __func__, tmp_path.c_str());
+        return;
+    }
+    file.write((const char*)&header, sizeof(header));
+    file.write(binary.data(), written);
+    file.close();
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if(ec) {
+        fprintf(stderr, "ERROR! %s: Failed to save \"%s\" (%s)\n",
+                __func__, path.c_str(), ec.message().c_str());
+        std::filesystem::remove(tmp_path, ec);
+    }
+}
+
+Shader AM::load_shader_cached(const std::string& vertex_code, const std::string& fragment_code,
+        int vertex_flags, int fragment_flags) {
+    const double start_time = GetTime();
+    _init_cache();
+
+    const std::string vs_code = AM::GLSL_preproc(vertex_code, vertex_flags);
+    const std::string fs_code = AM::GLSL_preproc(fragment_code, fragment_flags);
+
+    const uint64_t key = AM::GLSL_hash(fs_code, AM::GLSL_hash(vs_code, ::driver_hash));
+    const std::string path = _cache_path(key);
+
+    Shader shader = { 0 };
+    if(::binaries_supported) {
+        shader.id = _load_binary(key, path);
+    }
+
+    if(shader.id) {
+        _set_locations(&shader);
+        ::stats.num_loaded++;
+    }
+    else {
+        shader = LoadShaderFromMemory(vs_code.c_str(), fs_code.c_str());
+        if(::binaries_supported && (shader.id > 0) && (shader.id != rlGetShaderIdDefault())) {
+            _save_binary(key, path, shader.id);
+        }
+        ::stats.num_compiled++;
+    }
+
+    ::stats.load_time += GetTime() - start_time;
+    return shader;
+}
+
+const AM::ShaderCacheStats& AM::shader_cache_stats() {
+    return ::stats;
+}
+
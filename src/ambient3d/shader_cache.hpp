@@ -0,0 +1,38 @@
+#ifndef AMBIENT3D_SHADER_CACHE_HPP
+#define AMBIENT3D_SHADER_CACHE_HPP
+
+#include <string>
+#include <cstdint>
+
+#include "raylib.h"
+
+
+// Linked shader programs are saved to disk (glGetProgramBinary)
+// and loaded from there next time instead of compiling them again.
+//
+// Files are named by a hash of the preprocessed code and the driver
+// (vendor, renderer and version) so updating either of them uses new files.
+// If the driver doesnt accept a saved program it is removed
+// and the shader is compiled from the code like before.
+
+namespace AM {
+
+    static constexpr const char* SHADER_CACHE_DIR = "shader_cache";
+
+    // Same as LoadShaderFromMemory but the program is
+    // loaded from the cache when possible. Code is preprocessed with GLSL_preproc.
+    Shader load_shader_cached(const std::string& vertex_code, const std::string& fragment_code,
+            int vertex_flags = 0, int fragment_flags = 0);
+
+    // How many programs were loaded from the cache and how many were compiled.
+    struct ShaderCacheStats {
+        uint32_t num_loaded   { 0 };
+        uint32_t num_compiled { 0 };
+        double   load_time    { 0.0 }; // Seconds spent in 'load_shader_cached'
+    };
+    const ShaderCacheStats& shader_cache_stats();
+};
+
+
+
+#endif
@@ -1,80 +1,214 @@
 #include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
 #include <unordered_map>
 
 #include "raylib.h"
 
 #include "shader_util.hpp"
 #include "glsl_preproc.hpp"
+#include "transparent_str_hash.hpp"
 #include "external/glad.h"
 
 namespace {
-    //         shader id,    uniform name,   uniform location
-    static std::unordered_map<int, std::unordered_map<const char*, int>>
-        g_shader_map;
 
     static constexpr int LOCATION_NOTFOUND = -1;
-    static int _find_location(int shader_id, const char* u_name) {
+    static constexpr size_t MAX_UNIFORM_VALUE_SIZE = 16; // mat4
+
+    struct mUniform {
+        int   location;
+        bool  has_value;
+        float value[MAX_UNIFORM_VALUE_SIZE];
+    };
+
+    struct mProgram {
+        std::unordered_map<std::string, int, 
+            AM::TransparentStringHash, std::equal_to<>> index_by_name;
+        std::vector<mUniform> uniforms;
+    };
+
+    static int _gl_get_location(int program, const char* name) {
+        return glGetUniformLocation(program, name);
+    }
+    static void _gl_uniform_1i(int program, int location, int value) {
+        glProgramUniform1i(program, location, value);
+    }
+    static void _gl_uniform_1f(int program, int location, float value) {
+        glProgramUniform1f(program, location, value);
+    }
+    static void _gl_uniform_2f(int program, int location, float x, float y) {
+        glProgramUniform2f(program, location, x, y);
+    }
+    static void _gl_uniform_3f(int program, int location, float x, float y, float z) {
+        glProgramUniform3f(program, location, x, y, z);
+    }
+    static void _gl_uniform_4f(int program, int location, float x, float y, float z, float w) {
+        glProgramUniform4f(program, location, x, y, z, w);
+    }
+    static void _gl_uniform_matrix4(int program, int location, const float* value) {
+        glProgramUniformMatrix4fv(program, location, 1, false, value);
+    }
+
+    static AM::ShaderUniformFuncs g_funcs {
+        .get_location    = _gl_get_location,
+        .uniform_1i      = _gl_uniform_1i,
+        .uniform_1f      = _gl_uniform_1f,
+        .uniform_2f      = _gl_uniform_2f,
+        .uniform_3f      = _gl_uniform_3f,
+        .uniform_4f      = _gl_uniform_4f,
+        .uniform_matrix4 = _gl_uniform_matrix4
+    };
+
+    // Index is the shader id.
+    static std::vector<mProgram> g_programs;
 
-        int location = -1;
 
-        const auto search0 = g_shader_map.find(shader_id);
-        if((search0 == g_shader_map.end())
-        || (search0->second.find(u_name) == search0->second.end())) {
-            location = glGetUniformLocation(shader_id, u_name);
-            printf("[SHADERS]: Found uniform \"%s\" (%i)\n", u_name, location);
-            g_shader_map[shader_id].insert(std::make_pair(u_name, location));
+    static mUniform* _get_uniform(const AM::UniformHandle& handle) {
+        if((handle.program < 0) || ((size_t)handle.program >= g_programs.size())) {
+            return NULL;
         }
-        else {
-            location = search0->second.find(u_name)->second;
+        std::vector<mUniform>& uniforms = g_programs[handle.program].uniforms;
+        if((handle.index < 0) || ((size_t)handle.index >= uniforms.size())) {
+            return NULL;
         }
+        mUniform* uniform = &uniforms[handle.index];
+        return (uniform->location == LOCATION_NOTFOUND) ? NULL : uniform;
+    }
 
-        return location;
+    // Returns the uniform if the value is different than the previous one.
+    static mUniform* _changed_uniform(const AM::UniformHandle& handle, const float* value, size_t size) {
+        mUniform* uniform = _get_uniform(handle);
+        if(!uniform) {
+            return NULL;
+        }
+        if(uniform->has_value && (memcmp(uniform->value, value, size * sizeof(float)) == 0)) {
+            return NULL;
+        }
+        memmove(uniform->value, value, size * sizeof(float));
+        uniform->has_value = true;
+        return uniform;
     }
 };
 
+void AM::set_shader_uniform_funcs(const ShaderUniformFuncs& funcs) {
+    g_funcs = funcs;
+    g_programs.clear();
+}
+
 void AM::init_instanced_shader(Shader* shader) {
-    shader->locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(*shader, "instanceTransform");
+    shader->locs[SHADER_LOC_VERTEX_INSTANCE_TX] = GetShaderLocationAttrib(*shader, "instanceTransform");
+}
+
+AM::UniformHandle AM::find_uniform(int shader_id, const char* uniform_name) {
+    if(shader_id < 0) {
+        return AM::UniformHandle{};
+    }
+    if((size_t)shader_id >= g_programs.size()) {
+        g_programs.resize(shader_id + 1);
+    }
+
+    mProgram& program = g_programs[shader_id];
+    const auto search = program.index_by_name.find(uniform_name);
+    if(search != program.index_by_name.end()) {
+        return AM::UniformHandle{ shader_id, search->second };
+    }
+
+    const int location = g_funcs.get_location(shader_id, uniform_name);
+    printf("[SHADERS]: Found uniform \"%s\" (%i)\n", uniform_name, location);
+
+    const int index = (int)program.uniforms.size();
+    program.uniforms.push_back(mUniform{ location, false, {} });
+    program.index_by_name.insert(std::make_pair(std::string(uniform_name), index));
+    return AM::UniformHandle{ shader_id, index };
+}
+
+void AM::forget_shader_uniforms(int shader_id) {
+    if((shader_id >= 0) && ((size_t)shader_id < g_programs.size())) {
+        g_programs[shader_id] = mProgram{};
+    }
+}
+
+
+void AM::set_uniform_int(const UniformHandle& handle, int value) {
+    float bits = 0;
+    memmove(&bits, &value, sizeof(value));
+    if(mUniform* u = _changed_uniform(handle, &bits, 1)) {
+        g_funcs.uniform_1i(handle.program, u->location, value);
+    }
+}
+
+void AM::set_uniform_float(const UniformHandle& handle, float value) {
+    if(mUniform* u = _changed_uniform(handle, &value, 1)) {
+        g_funcs.uniform_1f(handle.program, u->location, value);
+    }
+}
+
+void AM::set_uniform_vec2(const UniformHandle& handle, const Vector2& value) {
+    const float v[2] = { value.x, value.y };
+    if(mUniform* u = _changed_uniform(handle, v, 2)) {
+        g_funcs.uniform_2f(handle.program, u->location, v[0], v[1]);
+    }
+}
+
+void AM::set_uniform_vec3(const UniformHandle& handle, const Vector3& value) {
+    const float v[3] = { value.x, value.y, value.z };
+    if(mUniform* u = _changed_uniform(handle, v, 3)) {
+        g_funcs.uniform_3f(handle.program, u->location, v[0], v[1], v[2]);
+    }
+}
+
+void AM::set_uniform_vec4(const UniformHandle& handle, const Vector4& value) {
+    const float v[4] = { value.x, value.y, value.z, value.w };
+    if(mUniform* u = _changed_uniform(handle, v, 4)) {
+        g_funcs.uniform_4f(handle.program, u->location, v[0], v[1], v[2], v[3]);
+    }
+}
+
+void AM::set_uniform_matrix(const UniformHandle& handle, const Matrix& value) {
+    // Matrix members are not stored in column order. (same as raylib MatrixToFloat)
+    const float v[16] = {
+        value.m0,  value.m1,  value.m2,  value.m3,
+        value.m4,  value.m5,  value.m6,  value.m7,
+        value.m8,  value.m9,  value.m10, value.m11,
+        value.m12, value.m13, value.m14, value.m15
+    };
+    if(mUniform* u = _changed_uniform(handle, v, 16)) {
+        g_funcs.uniform_matrix4(handle.program, u->location, v);
+    }
 }
 
-// TODO: Implement something when the value has not changed, it dont need to be updated.
  
 void AM::set_uniform_int(int shader_id, const char* uniform_name, int value) {
-    glUseProgram(shader_id);
-    glUniform1i(_find_location(shader_id, uniform_name), value);
+    AM::set_uniform_int(AM::find_uniform(shader_id, uniform_name), value);
 }   
 
 void AM::set_uniform_float(int shader_id, const char* uniform_name, float value) {
-    glUseProgram(shader_id);
-    glUniform1f(_find_location(shader_id, uniform_name), value);
+    AM::set_uniform_float(AM::find_uniform(shader_id, uniform_name), value);
 }
 
 void AM::set_uniform_vec2(int shader_id, const char* uniform_name, const Vector2& value) {
-    glUseProgram(shader_id);
-    glUniform2f(_find_location(shader_id, uniform_name), value.x, value.y);
+    AM::set_uniform_vec2(AM::find_uniform(shader_id, uniform_name), value);
 }
 
 void AM::set_uniform_vec3(int shader_id, const char* uniform_name, const Vector3& value) {
-    glUseProgram(shader_id);
-    glUniform3f(_find_location(shader_id, uniform_name), value.x, value.y, value.z);
+    AM::set_uniform_vec3(AM::find_uniform(shader_id, uniform_name), value);
 }
  
 void AM::set_uniform_vec4(int shader_id, const char* uniform_name, const Vector4& value) {
-    glUseProgram(shader_id);
-    glUniform4f(_find_location(shader_id, uniform_name), value.x, value.y, value.z, value.w);
+    AM::set_uniform_vec4(AM::find_uniform(shader_id, uniform_name), value);
 }
     
 
 void AM::set_uniform_matrix(int shader_id, const char* uniform_name, const Matrix& value) {
-    glUseProgram(shader_id);
-    glUniformMatrix3fv(_find_location(shader_id, uniform_name), 1, false, &value.m0);
+    AM::set_uniform_matrix(AM::find_uniform(shader_id, uniform_name), value);
 }
 
     
 void AM::set_uniform_sampler(int shader_id, const char* uniform_name, const Texture2D& texture, int slot) {
-    glUseProgram(shader_id);
-    int location = _find_location(shader_id, uniform_name);
-    if(location) {
-        glUniform1i(location, slot);
+    const AM::UniformHandle handle = AM::find_uniform(shader_id, uniform_name);
+    if(_get_uniform(handle)) {
+        AM::set_uniform_int(handle, slot);
         glActiveTexture(GL_TEXTURE0 + slot);
         glBindTexture(GL_TEXTURE_2D, texture.id);
     }
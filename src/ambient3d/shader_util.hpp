@@ -2,10 +2,49 @@
 #define AMBIENT3D_SHADER_UTIL_HPP
 
 
+// Uniform locations are looked up once per shader and name.
+// The last value set for each uniform is remembered so setting
+// the same value again does nothing. Uniforms are set with glProgramUniform*
+// so the shader doesnt need to be bound.
+//
+// If the value is changed outside of these functions (raylib SetShaderValue)
+// the cache doesnt know about it. Use 'forget_shader_uniforms' after unloading a shader.
+
 namespace AM {
 
+    // Found with 'find_uniform', faster than looking up the name every time.
+    struct UniformHandle {
+        int program { -1 };
+        int index   { -1 };
+    };
+
+    // OpenGL calls used by the uniform cache.
+    // Can be replaced for counting the calls without a window.
+    struct ShaderUniformFuncs {
+        int  (*get_location)(int program, const char* name);
+        void (*uniform_1i)(int program, int location, int value);
+        void (*uniform_1f)(int program, int location, float value);
+        void (*uniform_2f)(int program, int location, float x, float y);
+        void (*uniform_3f)(int program, int location, float x, float y, float z);
+        void (*uniform_4f)(int program, int location, float x, float y, float z, float w);
+        void (*uniform_matrix4)(int program, int location, const float* value);
+    };
+
+    // Previously cached uniforms are forgotten.
+    void set_shader_uniform_funcs(const ShaderUniformFuncs& funcs);
+
     void init_instanced_shader(Shader* shader);
 
+    UniformHandle find_uniform(int shader_id, const char* uniform_name);
+    void forget_shader_uniforms(int shader_id);
+
+    void set_uniform_int    (const UniformHandle& handle, int value);
+    void set_uniform_float  (const UniformHandle& handle, float value);
+    void set_uniform_vec2   (const UniformHandle& handle, const Vector2& value);
+    void set_uniform_vec3   (const UniformHandle& handle, const Vector3& value);
+    void set_uniform_vec4   (const UniformHandle& handle, const Vector4& value);
+    void set_uniform_matrix (const UniformHandle& handle, const Matrix&  value);
+
     void set_uniform_int    (int shader_id, const char* uniform_name, int value);
     void set_uniform_float  (int shader_id, const char* uniform_name, float value);
     void set_uniform_vec2   (int shader_id, const char* uniform_name, const Vector2& value);
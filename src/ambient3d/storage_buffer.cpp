@@ -0,0 +1,46 @@
+#include <cstdio>
+
+#include "storage_buffer.hpp"
+#include "external/glad.h"
+
+
+
+void StorageBuffer::create(int binding_point, size_t sizeb) {
+    if(m_created) {
+        fprintf(stderr, "ERROR! Trying to create storage buffer, but its already created.\n");
+        return;
+    }
+
+    m_total_sizeb = sizeb;
+
+    glGenBuffers(1, &this->id);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->id);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, m_total_sizeb, NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding_point, this->id);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    m_binding_point = binding_point;
+    m_created = true;
+}
+
+void StorageBuffer::update(size_t offset, const void* data, size_t size) {
+    if(offset + size > m_total_sizeb) {
+        fprintf(stderr, "ERROR! %s: Data doesnt fit in the storage buffer (%li + %li > %li)\n",
+                __func__, offset, size, m_total_sizeb);
+        return;
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->id);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, size, data);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+
+void StorageBuffer::free() {
+    if(m_created && this->id > 0) {
+        glDeleteBuffers(1, &this->id);
+        m_created = false;
+        this->id = 0;
+    }
+}
+
+
@@ -0,0 +1,37 @@
+#ifndef AMBIENT3D_STORAGE_BUFFER_HPP
+#define AMBIENT3D_STORAGE_BUFFER_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+// Shader storage buffer (std430 layout in GLSL)
+// Used for data which is too large for an uniform buffer
+// or which size is not known when the shader is compiled.
+
+
+class StorageBuffer {
+    public:
+        void create(int binding_point, size_t sizeb);
+        void update(size_t offset, const void* data, size_t size);
+        void free();
+
+        size_t size_inbytes() { return m_total_sizeb; }
+        int    get_binding_point() { return m_binding_point; }
+
+        StorageBuffer() {
+            m_created = false;
+            this->id = 0;
+        }
+
+        uint32_t id;
+
+    private:
+        int     m_binding_point;
+        bool    m_created;
+        size_t  m_total_sizeb;
+};
+
+
+
+
+#endif
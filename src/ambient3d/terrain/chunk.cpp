@@ -2,131 +2,142 @@
 #include <cstdlib>
 #include <cstdint>
 #include <cstring>
+#include <algorithm>
 
 #include "chunk.hpp"
+#include "../render_queue.hpp"
 #include "raymath.h"
 #include "rlgl.h"
 
 
             
-float AM::Chunk::m_get_height_at_local(int x, int z) {
-    int64_t idx = z * (m_chunk_size+1) + x;
-    if(idx < 0) {
-        return 0.0f;
-    }
-    if(idx >= (m_chunk_size+1)*(m_chunk_size+1)) {
-        return 0.0f;
-    }
-    return this->height_points[idx];
+// Number of floats needed for 'num_values' of 16 bit indices.
+static size_t _indices_num_floats(size_t num_values) {
+    return (num_values * sizeof(uint16_t) + sizeof(float) - 1) / sizeof(float);
 }
 
-void AM::Chunk::load(float* points, size_t points_sizeb, int chunk_size, float scale, Material* mat) {
-    m_mesh = Mesh{
-        .vertexCount = 0,
-        .triangleCount = 0,
-        .vertices = NULL,
-        .texcoords = NULL,
-        .texcoords2 = NULL,
-        .normals = NULL,
-        .tangents = NULL,
-        .colors = NULL,
-        .indices = NULL,
-        .animVertices = NULL,
-        .animNormals = NULL,
-        .boneIds = NULL,
-        .boneWeights = NULL,
-        .boneMatrices = NULL,
-        .boneCount = 0,
-        .vaoId = 0,
-        .vboId = NULL
-    };
-
-    this->height_points = new float[points_sizeb / sizeof(float)];
-    m_chunk_size = chunk_size;
-    m_material = mat;
-    m_scale = scale;
-
-    memmove(this->height_points, points, points_sizeb);
-
-    m_mesh.triangleCount = (chunk_size * chunk_size) * 2;  // 2 Triangles per quad.
-    m_mesh.vertexCount = m_mesh.triangleCount * 3;         // 3 Vertices per triangle.
+size_t AM::Chunk::buffer_num_floats(int chunk_size) {
+    const size_t num_points = AM::ChunkMesh::num_grid_vertices(chunk_size);
+    size_t num_floats = num_points * 4; // Height points and full resolution normals.
 
-    m_mesh.vertices    = new float[m_mesh.vertexCount * 3];
-    m_mesh.normals     = new float[m_mesh.vertexCount * 3];
-  //m_mesh.texcoords   = new float[m_mesh.vertexCount * 2];  <-- TODO
-
-    // Used for calculating normals.
-    Vector3 vA{ 0, 0, 0 };
-    Vector3 vB{ 0, 0, 0 };
-    Vector3 vC{ 0, 0, 0 };
-
-    int v_counter = 0; // Count vertices.
-    int tc_counter = 0; // Count texture coords.
+    const int num_levels = AM::ChunkMesh::num_lod_levels(chunk_size);
+    for(int level = 0; level < num_levels; level++) {
+        num_floats += AM::ChunkMesh::num_vertices(chunk_size, level) * 6; // Vertices and normals.
+        num_floats += _indices_num_floats(AM::ChunkMesh::num_indices(chunk_size, level));
+    }
+    return num_floats;
+}
 
-    for(int z = 0; z < chunk_size; z++) {
-        for(int x = 0; x < chunk_size; x++) {
-            const float xf = (float)x;
-            const float zf = (float)z;
+void AM::Chunk::load(float* points, size_t points_sizeb, int chunk_size, float scale, Material* mat,
+        const AM::ChunkMesh::Neighbours& neighbours, AM::ChunkPool* pool) {
+    if(chunk_size > AM::ChunkMesh::MAX_CHUNK_SIZE) {
+        fprintf(stderr, "ERROR! %s: Chunk size %i is too big for 16 bit indices.\n",
+                __func__, chunk_size);
+        return;
+    }
 
+    const size_t num_points = AM::ChunkMesh::num_grid_vertices(chunk_size);
+    if(points_sizeb != num_points * sizeof(float)) {
+        fprintf(stderr, "ERROR! %s: Unexpected height points size (%li bytes)\n",
+                __func__, points_sizeb);
+        return;
+    }
 
-            // Left up corner triangle.
+    m_buffer = pool->acquire();
+    if(!m_buffer) {
+        return;
+    }
 
-            m_mesh.vertices[v_counter+0] = xf * scale;
-            m_mesh.vertices[v_counter+1] = m_get_height_at_local(x, z);
-            m_mesh.vertices[v_counter+2] = zf * scale;
+    m_pool = pool;
+    m_chunk_size = chunk_size;
+    m_material = mat;
+    m_scale = scale;
 
-            m_mesh.vertices[v_counter+3] = xf * scale;
-            m_mesh.vertices[v_counter+4] = m_get_height_at_local(x, z+1);
-            m_mesh.vertices[v_counter+5] = (zf+1.0f) * scale;
+    // The block is split into:
+    // height points, full resolution normals, and vertices, normals, indices for each level.
+    float* next = m_buffer;
 
-            m_mesh.vertices[v_counter+6] = (xf+1.0f) * scale;
-            m_mesh.vertices[v_counter+7] = m_get_height_at_local(x+1, z);
-            m_mesh.vertices[v_counter+8] = zf * scale;
+    this->height_points = next;
+    next += num_points;
+    memmove(this->height_points, points, points_sizeb);
 
-            // Right bottom corner triangle.
+    m_normals = next;
+    next += num_points * 3;
+    AM::ChunkMesh::build_normals(this->height_points, chunk_size, scale, neighbours, m_normals);
+
+    m_num_lod_levels = AM::ChunkMesh::num_lod_levels(chunk_size);
+    const float skirt_depth 
+        = AM::ChunkMesh::skirt_depth(this->height_points, chunk_size, scale, m_num_lod_levels);
+
+    const float min_height = *std::min_element(this->height_points, this->height_points + num_points);
+    const float max_height = *std::max_element(this->height_points, this->height_points + num_points);
+    const float chunk_world_size = chunk_size * scale;
+
+    this->boundingbox = BoundingBox(
+            Vector3(
+                this->pos.x * chunk_world_size,
+                min_height - skirt_depth,
+                this->pos.z * chunk_world_size),
+            Vector3(
+                (this->pos.x + 1) * chunk_world_size,
+                max_height,
+                (this->pos.z + 1) * chunk_world_size));
+
+    for(int level = 0; level < m_num_lod_levels; level++) {
+        Mesh& mesh = m_lod_meshes[level];
+        mesh = Mesh{
+            .vertexCount = 0,
+            .triangleCount = 0,
+            .vertices = NULL,
+            .texcoords = NULL,
+            .texcoords2 = NULL,
+            .normals = NULL,
+            .tangents = NULL,
+            .colors = NULL,
+            .indices = NULL,
+            .animVertices = NULL,
+            .animNormals = NULL,
+            .boneIds = NULL,
+            .boneWeights = NULL,
+            .boneMatrices = NULL,
+            .boneCount = 0,
+            .vaoId = 0,
+            .vboId = NULL
+        };
+
+        // Every point in the height grid is one vertex shared by the quads around it.
+        mesh.vertexCount   = AM::ChunkMesh::num_vertices(chunk_size, level);
+        mesh.triangleCount = AM::ChunkMesh::num_indices(chunk_size, level) / 3;
+
+        mesh.vertices    = next;
+        next += mesh.vertexCount * 3;
+        mesh.normals     = next;
+        next += mesh.vertexCount * 3;
+        mesh.indices     = (unsigned short*)next;
+        next += _indices_num_floats(AM::ChunkMesh::num_indices(chunk_size, level));
+      //mesh.texcoords   = ...  <-- TODO
+
+        AM::ChunkMesh::build_vertices(this->height_points, chunk_size, scale, level, skirt_depth, mesh.vertices);
+        AM::ChunkMesh::build_indices(chunk_size, level, mesh.indices);
+        AM::ChunkMesh::build_level_normals(m_normals, chunk_size, level, mesh.normals);
+
+        UploadMesh(&mesh, false);
+    }
 
-            m_mesh.vertices[v_counter+9]  = m_mesh.vertices[v_counter+6];
-            m_mesh.vertices[v_counter+10] = m_mesh.vertices[v_counter+7];
-            m_mesh.vertices[v_counter+11] = m_mesh.vertices[v_counter+8];
-            
-            m_mesh.vertices[v_counter+12] = m_mesh.vertices[v_counter+3];
-            m_mesh.vertices[v_counter+13] = m_mesh.vertices[v_counter+4];
-            m_mesh.vertices[v_counter+14] = m_mesh.vertices[v_counter+5];
-            
-            m_mesh.vertices[v_counter+15] = (xf+1.0f) * scale;
-            m_mesh.vertices[v_counter+16] = m_get_height_at_local(x+1, z+1);
-            m_mesh.vertices[v_counter+17] = (zf+1.0f) * scale;
+    m_loaded = true;
+}
 
-            v_counter += 18;
-        }
+void AM::Chunk::update_border_normals(const AM::ChunkMesh::Neighbours& neighbours) {
+    if(!m_loaded) {
+        return;
     }
 
-    // Calculate normals.
-    for(int idx = 0; idx < m_mesh.vertexCount*3; idx += 9) {
-        vA = Vector3(m_mesh.vertices[idx + 0],
-                     m_mesh.vertices[idx + 1],
-                     m_mesh.vertices[idx + 2]);
-        
-        vB = Vector3(m_mesh.vertices[idx + 3],
-                     m_mesh.vertices[idx + 4],
-                     m_mesh.vertices[idx + 5]);
-        
-        vC = Vector3(m_mesh.vertices[idx + 6],
-                     m_mesh.vertices[idx + 7],
-                     m_mesh.vertices[idx + 8]);
-
-        Vector3 vN = Vector3CrossProduct(Vector3Subtract(vB, vA), Vector3Subtract(vC, vA));
-        vN = Vector3Normalize(vN);
-
-        for(int k = 0; k < 9; k += 3) {
-            m_mesh.normals[idx + k + 0] = vN.x;
-            m_mesh.normals[idx + k + 1] = vN.y;
-            m_mesh.normals[idx + k + 2] = vN.z;
-        }
+    AM::ChunkMesh::build_normals(this->height_points, m_chunk_size, m_scale, neighbours, m_normals, true);
+    for(int level = 0; level < m_num_lod_levels; level++) {
+        Mesh& mesh = m_lod_meshes[level];
+        AM::ChunkMesh::build_level_normals(m_normals, m_chunk_size, level, mesh.normals);
+        UpdateMeshBuffer(mesh, 2/*normals*/, mesh.normals, mesh.vertexCount * 3 * sizeof(float), 0);
     }
-
-    UploadMesh(&m_mesh, false);
-    m_loaded = true;
 }
 
 void AM::Chunk::unload() {
@@ -135,36 +146,47 @@ void AM::Chunk::unload() {
         return;
     }
 
-    rlUnloadVertexArray(m_mesh.vaoId);
-    if(m_mesh.vboId) {
-        for(int i = 0; i < 9/*MAX_MESH_VERTEX_BUFFERS*/; i++) {
-            rlUnloadVertexBuffer(m_mesh.vboId[i]);
+    for(int level = 0; level < m_num_lod_levels; level++) {
+        Mesh& mesh = m_lod_meshes[level];
+
+        rlUnloadVertexArray(mesh.vaoId);
+        if(mesh.vboId) {
+            for(int i = 0; i < 9/*MAX_MESH_VERTEX_BUFFERS*/; i++) {
+                rlUnloadVertexBuffer(mesh.vboId[i]);
+            }
+            MemFree(mesh.vboId);
         }
-    }
 
+        mesh.vertices = NULL;
+        mesh.normals = NULL;
+        mesh.indices = NULL;
+        mesh.vboId = NULL;
+    }
 
-    if(m_mesh.vertices) { delete[] m_mesh.vertices; }
-    if(m_mesh.normals)  { delete[] m_mesh.normals; }
-    if(this->height_points) { delete[] this->height_points; }
+    m_pool->release(m_buffer);
 
-    m_mesh.vertices = NULL;
-    m_mesh.normals = NULL;
+    m_buffer = NULL;
+    m_normals = NULL;
     this->height_points = NULL;
 
     m_loaded = false;
 }
 
-void AM::Chunk::render() {
+void AM::Chunk::submit(AM::RenderQueue* queue, int lod_level) {
     if(!m_loaded) {
         return;
     }
 
+    if(lod_level >= m_num_lod_levels) {
+        lod_level = m_num_lod_levels-1;
+    }
+
     Matrix translation = MatrixTranslate(
             this->pos.x * (m_chunk_size * m_scale),
             0,
             this->pos.z * (m_chunk_size * m_scale));
     
-    DrawMesh(m_mesh, *m_material, translation);
+    queue->submit(AM::RenderPass::RP_OPAQUE, &m_lod_meshes[lod_level], m_material, translation);
 }
 
 float AM::Chunk::get_height_at(const AM::iVec2& local_coords) {
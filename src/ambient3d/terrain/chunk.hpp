@@ -2,35 +2,59 @@
 #define AMBIENT3D_CHUNK_HPP
 
 #include <cstddef>
+#include <array>
 
 #include "raylib.h"
+#include "chunk_mesh.hpp"
+#include "chunk_pool.hpp"
 #include "shared/include/ivec2.hpp"
 #include "shared/include/chunk_pos.hpp"
 
 namespace AM {
 
+    class RenderQueue;
     class Chunk {
         public:
             
             AM::ChunkPos pos;
             float* height_points;
 
-            void load(float* points, size_t points_sizeb, int chunk_size, float scale, Material* mat);
+            // World space bounds including the skirts. Set when the chunk is loaded.
+            BoundingBox boundingbox;
+
+            // Height points and mesh data are stored in one block from the pool.
+            // 'pool' must be initialized with block size of 'buffer_num_floats(chunk_size)'
+            void load(float* points, size_t points_sizeb, int chunk_size, float scale, Material* mat,
+                    const AM::ChunkMesh::Neighbours& neighbours, AM::ChunkPool* pool);
             void unload();
+
+            // How many floats one chunk needs for its height points and all mesh levels.
+            static size_t buffer_num_floats(int chunk_size);
+
+            // Recalculates the normals on the chunk edges and uploads them.
+            // Called when a neighbour chunk has been loaded or unloaded.
+            void update_border_normals(const AM::ChunkMesh::Neighbours& neighbours);
             bool is_loaded() { return m_loaded; }
 
-            void render();
+            // Level 0 is full resolution. See chunk_mesh.hpp
+            void submit(AM::RenderQueue* queue, int lod_level = 0);
+            int  num_lod_levels() { return m_num_lod_levels; }
             
             float get_height_at(const AM::iVec2& local_coords);
 
         private:
 
             bool       m_loaded;
-            Mesh       m_mesh;
             Material*  m_material;
             int        m_chunk_size;
-            float      m_get_height_at_local(int x, int z);
             float      m_scale;
+
+            std::array<Mesh, AM::ChunkMesh::MAX_LOD_LEVELS> m_lod_meshes;
+            int        m_num_lod_levels;
+            float*     m_normals; // Full resolution normals, lower levels are picked from these.
+
+            AM::ChunkPool* m_pool;
+            float*         m_buffer; // Block from 'm_pool'
     };
 
 };
@@ -0,0 +1,253 @@
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "chunk_mesh.hpp"
+
+
+// Edges in the order their skirt vertices are stored.
+enum ChunkEdge : int {
+    EDGE_BACK,   // z = 0
+    EDGE_FRONT,  // z = chunk_size
+    EDGE_LEFT,   // x = 0
+    EDGE_RIGHT,  // x = chunk_size
+    
+    NUM_EDGES
+};
+
+// Index of the 'k'th point on the edge in a grid with 'row' points per row.
+static size_t _edge_point_index(int edge, int k, int row) {
+    switch(edge) {
+        case EDGE_BACK:  return k;
+        case EDGE_FRONT: return (row-1) * row + k;
+        case EDGE_LEFT:  return k * row;
+        case EDGE_RIGHT: return k * row + (row-1);
+    }
+    return 0;
+}
+
+
+int AM::ChunkMesh::num_lod_levels(int chunk_size) {
+    int levels = 1;
+    while(levels < MAX_LOD_LEVELS 
+    && (chunk_size % lod_step(levels)) == 0) {
+        levels++;
+    }
+    return levels;
+}
+
+float AM::ChunkMesh::skirt_depth(const float* heights, int chunk_size, float scale, int num_levels) {
+    const int row = chunk_size+1;
+    float max_deviation = 0.0f;
+
+    // Find how much the full resolution edge points differ from the lines
+    // between the points used by lower levels.
+    for(int level = 1; level < num_levels; level++) {
+        const int step = lod_step(level);
+        for(int edge = 0; edge < NUM_EDGES; edge++) {
+            for(int i = 0; i < chunk_size; i++) {
+                const int j = (i / step) * step;
+                const float t = (float)(i - j) / (float)step;
+                const float hA = heights[_edge_point_index(edge, j, row)];
+                const float hB = heights[_edge_point_index(edge, j + step, row)];
+                const float h  = heights[_edge_point_index(edge, i, row)];
+                max_deviation = std::max(max_deviation, fabsf(h - (hA + t * (hB - hA))));
+            }
+        }
+    }
+
+    // Both sides of the edge may be off by 'max_deviation' in different directions.
+    return max_deviation * 2.0f + scale * 0.5f;
+}
+
+void AM::ChunkMesh::build_vertices(
+        const float* heights,
+        int chunk_size,
+        float scale,
+        int level,
+        float skirt_depth,
+        float* vertices_out
+){
+    const int full_row = chunk_size+1;
+    const int step = lod_step(level);
+    const int row = (chunk_size >> level) + 1;
+    size_t v = 0;
+    for(int z = 0; z < row; z++) {
+        for(int x = 0; x < row; x++) {
+            vertices_out[v+0] = (float)(x * step) * scale;
+            vertices_out[v+1] = heights[(z * step) * full_row + (x * step)];
+            vertices_out[v+2] = (float)(z * step) * scale;
+            v += 3;
+        }
+    }
+
+    // Skirts.
+    for(int edge = 0; edge < NUM_EDGES; edge++) {
+        for(int k = 0; k < row; k++) {
+            const size_t src = _edge_point_index(edge, k, row) * 3;
+            vertices_out[v+0] = vertices_out[src+0];
+            vertices_out[v+1] = vertices_out[src+1] - skirt_depth;
+            vertices_out[v+2] = vertices_out[src+2];
+            v += 3;
+        }
+    }
+}
+
+void AM::ChunkMesh::build_indices(int chunk_size, int level, uint16_t* indices_out) {
+    const int cells = chunk_size >> level;
+    const int row = cells+1;
+    size_t i = 0;
+    for(int z = 0; z < cells; z++) {
+        for(int x = 0; x < cells; x++) {
+            const uint16_t i00 = (uint16_t)(z * row + x);  // (x,   z)
+            const uint16_t i10 = i00 + 1;                   // (x+1, z)
+            const uint16_t i01 = i00 + row;                 // (x,   z+1)
+            const uint16_t i11 = i01 + 1;                   // (x+1, z+1)
+
+            // Left up corner triangle.
+            indices_out[i+0] = i00;
+            indices_out[i+1] = i01;
+            indices_out[i+2] = i10;
+
+            // Right bottom corner triangle.
+            indices_out[i+3] = i10;
+            indices_out[i+4] = i01;
+            indices_out[i+5] = i11;
+            i += 6;
+        }
+    }
+
+    // Skirts. Back and right edges go the same way as the grid triangles,
+    // front and left edges are flipped so all skirts face outwards.
+    const uint16_t skirt_begin = (uint16_t)(row * row);
+    for(int edge = 0; edge < NUM_EDGES; edge++) {
+        const bool flip = (edge == EDGE_FRONT) || (edge == EDGE_LEFT);
+        for(int k = 0; k < cells; k++) {
+            const uint16_t a  = (uint16_t)_edge_point_index(edge, k, row);
+            const uint16_t b  = (uint16_t)_edge_point_index(edge, k+1, row);
+            const uint16_t sa = skirt_begin + edge * row + k;
+            const uint16_t sb = sa + 1;
+
+            const uint16_t quad[6] = { a, b, sa,  b, sb, sa };
+            for(int n = 0; n < 6; n++) {
+                // Flipping reverses the order of both triangles.
+                indices_out[i+n] = flip ? quad[(n / 3) * 3 + (2 - n % 3)] : quad[n];
+            }
+            i += 6;
+        }
+    }
+}
+
+static void _build_normal(
+        const float* heights,
+        int chunk_size,
+        float scale,
+        const AM::ChunkMesh::Neighbours& nb,
+        int x, int z,
+        float* normal_out
+){
+    const int row = chunk_size+1;
+    const float h = heights[z * row + x];
+
+    // Neighbour chunks share the edge points with this chunk
+    // so the point next to the edge is one step inside of them.
+
+    float dx = 0.0f;
+    {
+        const float* hl = NULL;
+        const float* hr = NULL;
+        if(x > 0)                { hl = &heights[z * row + x-1]; }
+        else if(nb.left)         { hl = &nb.left[z * row + chunk_size-1]; }
+        if(x < chunk_size)       { hr = &heights[z * row + x+1]; }
+        else if(nb.right)        { hr = &nb.right[z * row + 1]; }
+
+        if(hl && hr)  { dx = (*hr - *hl) / (2.0f * scale); }
+        else if(hr)   { dx = (*hr - h) / scale; }
+        else if(hl)   { dx = (h - *hl) / scale; }
+    }
+
+    float dz = 0.0f;
+    {
+        const float* hb = NULL;
+        const float* hf = NULL;
+        if(z > 0)                { hb = &heights[(z-1) * row + x]; }
+        else if(nb.back)         { hb = &nb.back[(chunk_size-1) * row + x]; }
+        if(z < chunk_size)       { hf = &heights[(z+1) * row + x]; }
+        else if(nb.front)        { hf = &nb.front[1 * row + x]; }
+
+        if(hb && hf)  { dz = (*hf - *hb) / (2.0f * scale); }
+        else if(hf)   { dz = (*hf - h) / scale; }
+        else if(hb)   { dz = (h - *hb) / scale; }
+    }
+
+    const float inv_len = 1.0f / sqrtf(dx*dx + 1.0f + dz*dz);
+    normal_out[0] = -dx * inv_len;
+    normal_out[1] = inv_len;
+    normal_out[2] = -dz * inv_len;
+}
+
+void AM::ChunkMesh::build_normals(
+        const float* heights,
+        int chunk_size,
+        float scale,
+        const Neighbours& neighbours,
+        float* normals_out,
+        bool borders_only
+){
+    const int row = chunk_size+1;
+    for(int z = 0; z < row; z++) {
+        const bool z_border = (z == 0) || (z == chunk_size);
+        for(int x = 0; x < row; x++) {
+            if(borders_only && !z_border && (x > 0) && (x < chunk_size)) {
+                x = chunk_size-1; // Jump to the right edge.
+                continue;
+            }
+            _build_normal(heights, chunk_size, scale, neighbours, x, z, &normals_out[(z * row + x) * 3]);
+        }
+    }
+}
+
+void AM::ChunkMesh::build_level_normals(
+        const float* full_normals,
+        int chunk_size,
+        int level,
+        float* normals_out
+){
+    const int full_row = chunk_size+1;
+    const int step = lod_step(level);
+    const int row = (chunk_size >> level) + 1;
+    size_t v = 0;
+    for(int z = 0; z < row; z++) {
+        for(int x = 0; x < row; x++) {
+            const size_t src = ((z * step) * full_row + (x * step)) * 3;
+            normals_out[v+0] = full_normals[src+0];
+            normals_out[v+1] = full_normals[src+1];
+            normals_out[v+2] = full_normals[src+2];
+            v += 3;
+        }
+    }
+
+    // Skirts use the same normal as the edge vertex above them
+    // so the lighting doesnt change where they meet.
+    for(int edge = 0; edge < NUM_EDGES; edge++) {
+        for(int k = 0; k < row; k++) {
+            const size_t src = _edge_point_index(edge, k, row) * 3;
+            normals_out[v+0] = normals_out[src+0];
+            normals_out[v+1] = normals_out[src+1];
+            normals_out[v+2] = normals_out[src+2];
+            v += 3;
+        }
+    }
+}
+
+int AM::ChunkMesh::select_lod(
+        const AM::ChunkPos& origin,
+        const AM::ChunkPos& chunk_pos,
+        int num_levels,
+        int lod_distance
+){
+    const int distance = std::max(abs(origin.x - chunk_pos.x), abs(origin.z - chunk_pos.z));
+    const int level = distance / std::max(lod_distance, 1);
+    return std::min(level, num_levels-1);
+}
+
@@ -0,0 +1,103 @@
+#ifndef AMBIENT3D_CHUNK_MESH_HPP
+#define AMBIENT3D_CHUNK_MESH_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+#include "shared/include/chunk_pos.hpp"
+
+
+// Builds indexed chunk meshes from the height grid.
+// Nothing in here touches OpenGL so it can be used and measured without a window.
+//
+// The height grid has (chunk_size+1) * (chunk_size+1) points
+// and every point becomes exactly one vertex (shared between the quads around it).
+//
+// Level of detail:
+// Level 'L' uses every (1 << L)th height point, so chunk size must be divisible by it.
+// Every level has a skirt around it (edge vertices copied downwards)
+// which hides the cracks between chunks using different levels.
+// Skirt vertices are stored after the grid vertices.
+
+namespace AM {
+    namespace ChunkMesh {
+
+        // Height points of the neighbour chunks. NULL if the neighbour is not loaded.
+        // Used for calculating smooth normals over the chunk borders.
+        struct Neighbours {
+            const float* left   { NULL }; // (x-1, z)
+            const float* right  { NULL }; // (x+1, z)
+            const float* back   { NULL }; // (x, z-1)
+            const float* front  { NULL }; // (x, z+1)
+        };
+
+        // Grid and skirt vertices of the full resolution level must fit in 16 bit indices.
+        static constexpr int MAX_CHUNK_SIZE = 253;
+        static constexpr int MAX_LOD_LEVELS = 4;
+
+        constexpr int lod_step(int level) { return 1 << level; }
+
+        constexpr size_t num_grid_vertices(int chunk_size, int level = 0) {
+            return ((chunk_size >> level) + 1) * ((chunk_size >> level) + 1);
+        }
+        constexpr size_t num_vertices(int chunk_size, int level = 0) {
+            return num_grid_vertices(chunk_size, level) + 4 * ((chunk_size >> level) + 1);
+        }
+        constexpr size_t num_indices(int chunk_size, int level = 0) {
+            return ((chunk_size >> level) * (chunk_size >> level) + 4 * (chunk_size >> level)) * 6;
+        }
+        static_assert(num_vertices(MAX_CHUNK_SIZE) <= 0xFFFF+1);
+
+        // How many levels (1 to MAX_LOD_LEVELS) can be built for this chunk size.
+        int num_lod_levels(int chunk_size);
+
+        // How far the skirts have to go down so they cover the gap
+        // between any two levels on the chunk edges.
+        float skirt_depth(const float* heights, int chunk_size, float scale, int num_levels);
+
+        // 'vertices_out' must have space for num_vertices(chunk_size, level) * 3 floats.
+        void build_vertices(
+                const float* heights,
+                int chunk_size,
+                float scale,
+                int level,
+                float skirt_depth,
+                float* vertices_out);
+
+        // 'indices_out' must have space for num_indices(chunk_size, level) values.
+        // Triangles use the same diagonal and winding as the old non-indexed mesh did.
+        void build_indices(int chunk_size, int level, uint16_t* indices_out);
+
+        // 'normals_out' must have space for num_grid_vertices(chunk_size) * 3 floats.
+        // Full resolution normals are calculated with central differences from the height grid.
+        // Neighbour chunks are used on the borders if they are available,
+        // otherwise one sided difference is used.
+        // If 'borders_only' is true only the outer ring of vertices is written.
+        void build_normals(
+                const float* heights,
+                int chunk_size,
+                float scale,
+                const Neighbours& neighbours,
+                float* normals_out,
+                bool borders_only = false);
+
+        // Picks the level normals from full resolution normals (see build_normals)
+        // 'normals_out' must have space for num_vertices(chunk_size, level) * 3 floats.
+        void build_level_normals(
+                const float* full_normals,
+                int chunk_size,
+                int level,
+                float* normals_out);
+
+        // Chunks closer than 'lod_distance' (in chunks) to the origin get level 0,
+        // the next 'lod_distance' rings of chunks level 1 and so on.
+        int select_lod(
+                const AM::ChunkPos& origin,
+                const AM::ChunkPos& chunk_pos,
+                int num_levels,
+                int lod_distance);
+    };
+};
+
+
+#endif
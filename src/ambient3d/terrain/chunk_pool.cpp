@@ -0,0 +1,82 @@
+#include <cstdio>
+#include <cstring>
+
+#include "chunk_pool.hpp"
+
+
+void AM::ChunkPool::init(size_t block_num_floats, size_t blocks_per_slab) {
+    if(this->is_initialized()) {
+        fprintf(stderr, "WARNING! %s: Chunk pool is already initialized.\n",
+                __func__);
+        return;
+    }
+
+    // The block must have space for the free list pointer.
+    const size_t min_num_floats = (sizeof(float*) + sizeof(float) - 1) / sizeof(float);
+    m_block_num_floats = (block_num_floats < min_num_floats) ? min_num_floats : block_num_floats;
+    m_blocks_per_slab = (blocks_per_slab > 0) ? blocks_per_slab : 1;
+
+    m_allocate_slab();
+}
+
+void AM::ChunkPool::m_allocate_slab() {
+    float* slab = new float[m_block_num_floats * m_blocks_per_slab];
+    m_slabs.push_back(slab);
+
+    // Push the new blocks to the free list.
+    for(size_t i = m_blocks_per_slab; i > 0; i--) {
+        float* block = slab + (i-1) * m_block_num_floats;
+        memcpy(block, &m_free_head, sizeof(float*));
+        m_free_head = block;
+    }
+
+    m_num_blocks_allocated += m_blocks_per_slab;
+    printf("[TERRAIN]: Chunk pool has now %li blocks (%li bytes)\n",
+            m_num_blocks_allocated, m_num_blocks_allocated * m_block_num_floats * sizeof(float));
+}
+
+float* AM::ChunkPool::acquire() {
+    if(!this->is_initialized()) {
+        fprintf(stderr, "ERROR! %s: Chunk pool is not initialized.\n",
+                __func__);
+        return NULL;
+    }
+
+    if(!m_free_head) {
+        m_allocate_slab();
+    }
+
+    float* block = m_free_head;
+    memcpy(&m_free_head, block, sizeof(float*));
+    m_num_blocks_in_use++;
+    return block;
+}
+
+void AM::ChunkPool::release(float* block) {
+    if(!block) {
+        return;
+    }
+
+    memcpy(block, &m_free_head, sizeof(float*));
+    m_free_head = block;
+    m_num_blocks_in_use--;
+}
+
+void AM::ChunkPool::free_all() {
+    if(m_num_blocks_in_use > 0) {
+        fprintf(stderr, "WARNING! %s: %li chunk blocks are still in use.\n",
+                __func__, m_num_blocks_in_use);
+    }
+
+    for(float* slab : m_slabs) {
+        delete[] slab;
+    }
+
+    m_slabs.clear();
+    m_free_head = NULL;
+    m_block_num_floats = 0;
+    m_blocks_per_slab = 0;
+    m_num_blocks_allocated = 0;
+    m_num_blocks_in_use = 0;
+}
+
@@ -0,0 +1,54 @@
+#ifndef AMBIENT3D_CHUNK_POOL_HPP
+#define AMBIENT3D_CHUNK_POOL_HPP
+
+#include <vector>
+#include <cstddef>
+
+
+namespace AM {
+
+    // All chunks have the same size so every chunk needs exactly
+    // the same amount of memory for its height points and meshes.
+    // The pool hands out blocks of that size from bigger slabs
+    // and keeps released blocks in a free list for the next chunk.
+    // Memory is only given back to the system when 'free_all' is called.
+    //
+    // IMPORTANT NOTE: Not thread safe. Only used from main thread.
+
+    class ChunkPool {
+        public:
+
+            ~ChunkPool() { this->free_all(); }
+
+            // 'block_num_floats' is the size of one chunk buffer.
+            // 'blocks_per_slab' is how many blocks are allocated at once when the pool runs out.
+            void    init(size_t block_num_floats, size_t blocks_per_slab);
+            bool    is_initialized() const { return m_block_num_floats > 0; }
+
+            float*  acquire();
+            void    release(float* block);
+
+            // Every acquired block must be released before this.
+            void    free_all();
+
+            size_t  num_blocks_allocated() const { return m_num_blocks_allocated; }
+            size_t  num_blocks_in_use() const    { return m_num_blocks_in_use; }
+
+        private:
+
+            void    m_allocate_slab();
+
+            // Released blocks store the pointer to the next free block in their first bytes.
+            float*  m_free_head { NULL };
+
+            std::vector<float*> m_slabs;
+            size_t  m_block_num_floats      { 0 };
+            size_t  m_blocks_per_slab       { 0 };
+            size_t  m_num_blocks_allocated  { 0 };
+            size_t  m_num_blocks_in_use     { 0 };
+    };
+
+};
+
+
+#endif
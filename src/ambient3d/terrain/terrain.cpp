@@ -1,10 +1,11 @@
 #include <cstring>
 #include <lz4.h>
 #include <cstdio>
+#include <chrono>
 
 #include "terrain.hpp"
 #include "../ambient3d.hpp"
-#include "shared/include/ray.hpp"
+#include "shared/include/terrain_height.hpp"
 
 
 void AM::Terrain::allocate_regenbuf(size_t num_bytes) {
@@ -40,130 +41,316 @@ void AM::Terrain::update_chunkdata_queue() {
     SetTraceLogLevel(LOG_NONE);
     
     const int chunk_size = m_engine->net->server_cfg.chunk_size;
-    const size_t chunk_height_points_sizeb = ((chunk_size+1)*(chunk_size+1)) * sizeof(float);
 
-    m_chunkdata_queue_mutex.lock();
-        
+    if(!m_chunk_pool.is_initialized()) {
+        // Enough blocks for every chunk inside of the unload radius.
+        const size_t area = 2 * this->chunk_unload_radius() + 1;
+        m_chunk_pool.init(AM::Chunk::buffer_num_floats(chunk_size), area * area);
+    }
+
     // TODO: request resend if something fails
 
-    for(size_t i = 0; i < m_chunkdata_queue.size(); i++) {
-        mChunkData* chunkdata = &m_chunkdata_queue[i]; // <- Compressed data.
-        if(chunkdata->num_bytes >= m_chunkdata_regenbuf_memsize) {
-            fprintf(stderr, "ERROR! %s: Received chunk data has unexpectedly too many bytes (%li)."
-                    " Has allocated %li bytes\n",
-                    __func__, chunkdata->num_bytes, m_chunkdata_regenbuf_memsize);
-            continue;
-        }
+    // Network threads dont wait for this, they only fill free slots.
+    // Packets in the overflow list are newer than everything in the queue.
+    const bool overflowed = m_chunkdata_overflow.has_items();
+    while(const mChunkData* chunkdata = m_chunkdata_queue.front()) {
+        m_load_chunkdata(chunkdata->bytes.data(), chunkdata->num_bytes);
+        m_chunkdata_queue.pop();
+    }
 
-        // chunk_x + chunk_z = 4*2 bytes.
-        if(chunkdata->num_bytes <= (sizeof(int)*2)) {
-            fprintf(stderr, "ERROR! %s: Received chunk data is too small to be valid. Got %li bytes\n",
-                    __func__, chunkdata->num_bytes);
-            continue;
+    if(overflowed && m_chunkdata_overflow.take(&m_chunkdata_overflow_read)) {
+        printf("[TERRAIN]: Chunk data queue was full, %li packets waited in the overflow list\n",
+                m_chunkdata_overflow_read.size());
+        for(const std::vector<char>& bytes : m_chunkdata_overflow_read) {
+            m_load_chunkdata(bytes.data(), bytes.size());
         }
+        m_chunkdata_overflow_read.clear();
+    }
+    
+    SetTraceLogLevel(LOG_ALL);
+}
 
-        if(m_chunkdata_regenbuf_memsize < chunkdata->num_bytes) {
-            fprintf(stderr, "ERROR! %s: Chunk data has too many bytes to be handled.\n",
-                    __func__);
-            continue;
-        }
+void AM::Terrain::m_load_chunkdata(const char* bytes, size_t num_bytes) {
+    const int chunk_size = m_engine->net->server_cfg.chunk_size;
+    const size_t chunk_height_points_sizeb = ((chunk_size+1)*(chunk_size+1)) * sizeof(float);
 
-        // Clear previously added data.
-        if(m_chunkdata_regenbuf_size > 0) {
-            memset(m_chunkdata_regenbuf, 0, m_chunkdata_regenbuf_size);
-            m_chunkdata_regenbuf_size = 0;
-        }
+    if(num_bytes >= m_chunkdata_regenbuf_memsize) {
+        fprintf(stderr, "ERROR! %s: Received chunk data has unexpectedly too many bytes (%li)."
+                " Has allocated %li bytes\n",
+                __func__, num_bytes, m_chunkdata_regenbuf_memsize);
+        return;
+    }
 
-        ssize_t decompressed_size
-            = LZ4_decompress_safe(
-                    chunkdata->bytes.data(), // Source.
-                    m_chunkdata_regenbuf,    // Destination.
-                    chunkdata->num_bytes,    // Source size.
-                    m_chunkdata_regenbuf_memsize); // Destination max size.
-        
-        if(decompressed_size <= 0) {
-            fprintf(stderr, "ERROR! %s: Failed to decompress chunk data.\n",
-                    __func__);
-            continue;
-        }
+    // chunk_x + chunk_z = 4*2 bytes.
+    if(num_bytes <= (sizeof(int)*2)) {
+        fprintf(stderr, "ERROR! %s: Received chunk data is too small to be valid. Got %li bytes\n",
+                __func__, num_bytes);
+        return;
+    }
 
+    if(m_chunkdata_regenbuf_memsize < num_bytes) {
+        fprintf(stderr, "ERROR! %s: Chunk data has too many bytes to be handled.\n",
+                __func__);
+        return;
+    }
 
-        size_t byte_offset = 0;
-        while(byte_offset < (size_t)decompressed_size) {
+    // Clear previously added data.
+    if(m_chunkdata_regenbuf_size > 0) {
+        memset(m_chunkdata_regenbuf, 0, m_chunkdata_regenbuf_size);
+        m_chunkdata_regenbuf_size = 0;
+    }
 
-            AM::ChunkPos chunk_pos;
+    ssize_t decompressed_size
+        = LZ4_decompress_safe(
+                bytes,                  // Source.
+                m_chunkdata_regenbuf,    // Destination.
+                num_bytes,              // Source size.
+                m_chunkdata_regenbuf_memsize); // Destination max size.
+    
+    if(decompressed_size <= 0) {
+        fprintf(stderr, "ERROR! %s: Failed to decompress chunk data.\n",
+                __func__);
+        return;
+    }
 
 
-            memmove(&chunk_pos.x, &m_chunkdata_regenbuf[byte_offset], sizeof(int));
-            byte_offset += sizeof(int);
-            
-            memmove(&chunk_pos.z, &m_chunkdata_regenbuf[byte_offset], sizeof(int));
-            byte_offset += sizeof(int);
-            
+    size_t byte_offset = 0;
+    while(byte_offset < (size_t)decompressed_size) {
 
-            // Server is going to keep track of what chunks it has send to client
-            // but its good idea to check here too.
-            auto chunk_search = this->chunk_map.find(chunk_pos);
-            if(chunk_search != this->chunk_map.end()) {
-                fprintf(stderr, "WARNING! %s: Server sent chunk which is already loaded\n",
-                        __func__);
-                break; // TODO: Dont break here.
-            }
+        AM::ChunkPos chunk_pos;
 
-            auto chunk = this->chunk_map.insert(std::make_pair(chunk_pos, AM::Chunk{})).first;
 
-            chunk->second.pos = chunk_pos;
-            chunk->second.load(
-                    (float*)&m_chunkdata_regenbuf[byte_offset],
-                    chunk_height_points_sizeb,
-                    m_engine->net->server_cfg.chunk_size,
-                    m_engine->net->server_cfg.chunk_scale,
-                    &m_chunk_materials[AM::ChunkMaterial::CM_GRASS]);
+        memmove(&chunk_pos.x, &m_chunkdata_regenbuf[byte_offset], sizeof(int));
+        byte_offset += sizeof(int);
+        
+        memmove(&chunk_pos.z, &m_chunkdata_regenbuf[byte_offset], sizeof(int));
+        byte_offset += sizeof(int);
+        
 
+        // Server is going to keep track of what chunks it has send to client
+        // but its good idea to check here too.
+        auto chunk_search = this->chunk_map.find(chunk_pos);
+        if(chunk_search != this->chunk_map.end()) {
+            fprintf(stderr, "WARNING! %s: Server sent chunk which is already loaded\n",
+                    __func__);
             byte_offset += chunk_height_points_sizeb;
+            continue;
         }
+
+        auto chunk = this->chunk_map.insert(std::make_pair(chunk_pos, AM::Chunk{})).first;
+
+        chunk->second.pos = chunk_pos;
+        chunk->second.load(
+                (float*)&m_chunkdata_regenbuf[byte_offset],
+                chunk_height_points_sizeb,
+                m_engine->net->server_cfg.chunk_size,
+                m_engine->net->server_cfg.chunk_scale,
+                &m_chunk_materials[AM::ChunkMaterial::CM_GRASS],
+                m_get_chunk_neighbours(chunk_pos),
+                &m_chunk_pool);
+
+        // Already loaded neighbours used one sided normals on the shared edge.
+        m_update_neighbour_normals(chunk_pos);
+        m_new_chunks.push_back(chunk_pos);
+
+        byte_offset += chunk_height_points_sizeb;
     }
+}
 
-    m_chunkdata_queue.clear();
-    m_chunkdata_queue_mutex.unlock();
-    
-    SetTraceLogLevel(LOG_ALL);
+AM::ChunkMesh::Neighbours AM::Terrain::m_get_chunk_neighbours(const AM::ChunkPos& chunk_pos) {
+    AM::ChunkMesh::Neighbours neighbours;
+    auto get_points = [this](const AM::ChunkPos& pos) -> const float* {
+        auto search = this->chunk_map.find(pos);
+        if(search == this->chunk_map.end() || !search->second.is_loaded()) {
+            return NULL;
+        }
+        return search->second.height_points;
+    };
+
+    neighbours.left  = get_points(AM::ChunkPos(chunk_pos.x-1, chunk_pos.z));
+    neighbours.right = get_points(AM::ChunkPos(chunk_pos.x+1, chunk_pos.z));
+    neighbours.back  = get_points(AM::ChunkPos(chunk_pos.x, chunk_pos.z-1));
+    neighbours.front = get_points(AM::ChunkPos(chunk_pos.x, chunk_pos.z+1));
+    return neighbours;
+}
+
+static std::array<AM::ChunkPos, 4> _neighbour_positions(const AM::ChunkPos& chunk_pos) {
+    return {
+        AM::ChunkPos(chunk_pos.x-1, chunk_pos.z),
+        AM::ChunkPos(chunk_pos.x+1, chunk_pos.z),
+        AM::ChunkPos(chunk_pos.x, chunk_pos.z-1),
+        AM::ChunkPos(chunk_pos.x, chunk_pos.z+1)
+    };
+}
+
+void AM::Terrain::m_update_neighbour_normals(const AM::ChunkPos& chunk_pos) {
+    for(const AM::ChunkPos& pos : _neighbour_positions(chunk_pos)) {
+        auto search = this->chunk_map.find(pos);
+        if(search == this->chunk_map.end()) {
+            continue;
+        }
+        search->second.update_border_normals(m_get_chunk_neighbours(pos));
+    }
 }
 
 void AM::Terrain::add_chunkdata_to_queue(char* compressed_data, size_t sizeb) {
-    m_chunkdata_queue_mutex.lock();
-    
     if(!compressed_data || (sizeb == 0)) {
         return;
     }
-    
-    mChunkData& data_added = m_chunkdata_queue.emplace_back();
+    if(sizeb > AM::MAX_PACKET_SIZE) {
+        fprintf(stderr, "ERROR! %s: Chunk data is too big (%li bytes)\n",
+                __func__, sizeb);
+        return;
+    }
 
-    memmove(data_added.bytes.data(), compressed_data, sizeb);
-    data_added.num_bytes = sizeb;
-    m_chunkdata_queue_mutex.unlock();
+    // Written straight to the slot, the main thread reads it from there.
+    // While the overflow list has packets new ones go there too so they stay in order.
+    mChunkData* data_added = (m_chunkdata_overflow.has_items()) ? NULL : m_chunkdata_queue.begin_push();
+    if(!data_added) {
+        m_chunkdata_overflow.push(std::vector<char>(compressed_data, compressed_data + sizeb));
+        return;
+    }
+
+    memmove(data_added->bytes.data(), compressed_data, sizeb);
+    data_added->num_bytes = sizeb;
+    m_chunkdata_queue.end_push(data_added);
 }
             
 void AM::Terrain::unload_all_chunks() {
     SetTraceLogLevel(LOG_NONE);
     size_t num_chunks = 0;
     for(auto it = this->chunk_map.begin(); it != this->chunk_map.end(); ++it) {
-        it->second.unload();
+        if(it->second.is_loaded()) {
+            it->second.unload();
+        }
         num_chunks++;
     }
+    this->chunk_map.clear();
+    m_eviction_queue.clear();
+    m_new_chunks.clear();
+    m_chunk_pool.free_all();
     printf("[TERRAIN]: Unloaded %li chunks\n", num_chunks);
     SetTraceLogLevel(LOG_ALL);
 }
 
+int AM::Terrain::chunk_load_radius() {
+    // The server sends chunks in square area of 'render_distance' around the player.
+    return m_engine->config.render_distance / 2;
+}
+
+int AM::Terrain::chunk_unload_radius() {
+    return this->chunk_load_radius() + AM::CHUNK_UNLOAD_MARGIN;
+}
+
+void AM::Terrain::evict_far_chunks(const AM::ChunkPos& origin, float budget_ms,
+        std::vector<AM::ChunkPos>* unloaded_out) {
+    const int unload_radius = this->chunk_unload_radius();
+    auto is_far = [&origin, unload_radius](const AM::ChunkPos& pos) {
+        return (abs(origin.x - pos.x) > unload_radius)
+            || (abs(origin.z - pos.z) > unload_radius);
+    };
+
+    // Loaded chunks can only become far away when the origin moves to another chunk
+    // so the whole map is scanned only then. Otherwise only the chunks loaded
+    // after the last call are checked, they may have arrived after the player moved.
+    if(!m_eviction_origin_valid || !(origin == m_eviction_origin)) {
+        m_eviction_origin = origin;
+        m_eviction_origin_valid = true;
+        m_eviction_queue.clear();
+
+        for(auto it = this->chunk_map.begin(); it != this->chunk_map.end(); ++it) {
+            if(is_far(it->first)) {
+                m_eviction_queue.push_back(it->first);
+            }
+        }
+    }
+    else {
+        for(const AM::ChunkPos& chunk_pos : m_new_chunks) {
+            if(is_far(chunk_pos)) {
+                m_eviction_queue.push_back(chunk_pos);
+            }
+        }
+    }
+    m_new_chunks.clear();
+
+    if(m_eviction_queue.empty()) {
+        return;
+    }
+
+    SetTraceLogLevel(LOG_NONE);
+    const auto start_time = std::chrono::steady_clock::now();
+
+    while(!m_eviction_queue.empty()) {
+        const AM::ChunkPos chunk_pos = m_eviction_queue.back();
+        m_eviction_queue.pop_back();
+
+        auto chunk_search = this->chunk_map.find(chunk_pos);
+        if(chunk_search == this->chunk_map.end()) {
+            continue;
+        }
+
+        if(chunk_search->second.is_loaded()) {
+            chunk_search->second.unload();
+        }
+        this->chunk_map.erase(chunk_search);
+        unloaded_out->push_back(chunk_pos);
+
+        // Neighbours which stay loaded used this chunk for their edge normals.
+        for(const AM::ChunkPos& pos : _neighbour_positions(chunk_pos)) {
+            if(is_far(pos)) {
+                continue;
+            }
+            auto search = this->chunk_map.find(pos);
+            if(search != this->chunk_map.end()) {
+                search->second.update_border_normals(m_get_chunk_neighbours(pos));
+            }
+        }
+
+        const std::chrono::duration<float, std::milli> elapsed 
+            = std::chrono::steady_clock::now() - start_time;
+        if(elapsed.count() >= budget_ms) {
+            break;
+        }
+    }
+
+    SetTraceLogLevel(LOG_ALL);
+}
+
 void AM::Terrain::unload_materials() {
     for(size_t i = 0; i < m_chunk_materials.size(); i++) {
         UnloadMaterial(m_chunk_materials[i], RL_DONT_UNLOAD_MAT_SHADER);
     }
 }
             
-void AM::Terrain::render() {
+void AM::Terrain::render(const AM::Frustum& view_frustum, AM::RenderQueue* queue) {
+    m_chunk_bounds.clear();
+    m_cull_chunks.clear();
     for(auto it = this->chunk_map.begin(); it != this->chunk_map.end(); ++it) {
-        it->second.render();
+        AM::Chunk& chunk = it->second;
+        if(!chunk.is_loaded()) {
+            continue;
+        }
+        m_chunk_bounds.add(chunk.boundingbox);
+        m_cull_chunks.push_back(&chunk);
+    }
+
+    const float chunk_world_size 
+        = m_engine->net->server_cfg.chunk_size * m_engine->net->server_cfg.chunk_scale;
+    const float max_distance = (m_engine->config.render_distance + 1) * chunk_world_size;
+
+    AM::Culling::find_visible(
+            view_frustum,
+            m_chunk_bounds,
+            m_engine->player.camera.position,
+            max_distance,
+            &m_visible_chunks);
+
+    const AM::ChunkPos origin = m_engine->player.chunk_pos();
+    const int lod_distance = m_engine->config.terrain_lod_distance;
+
+    for(const uint32_t idx : m_visible_chunks) {
+        AM::Chunk* chunk = m_cull_chunks[idx];
+        chunk->submit(queue, AM::ChunkMesh::select_lod(origin, chunk->pos, chunk->num_lod_levels(), lod_distance));
     }
 }
             
@@ -237,59 +424,35 @@ AM::Rect AM::Terrain::get_chunk_meshrect(float world_x, float world_z, AM::iVec2
     // This could be optimized to save memory because only 4 vertices are needed, 
     // 2 of them are shared between the 2 triangles.
     // It will waste some memory for now because it feels more easy.
+    //
+    // The triangles are split the same way as the chunk mesh (see terrain_height.hpp)
 
     return AM::Rect(
                 AM::Triangle(
                     vertex_A,
-                    vertex_B,
-                    vertex_C
+                    vertex_D,
+                    vertex_B
                 ),
                 AM::Triangle(
+                    vertex_B,
                     vertex_D,
-                    vertex_A,
                     vertex_C
                 )   
             );
 }
 
 float AM::Terrain::get_surface_level(const Vector3& world_pos) {
-    
-    AM::Ray ray(
-            AM::Vec3(world_pos.x, world_pos.y+10.0f, world_pos.z), // Ray origin
-            AM::Vec3(0.0f, -1.0f, 0.0f));            // Ray direction
-
-    AM::RayHitResult hit_result = {};
-    AM::Rect rect = {};
-
-    // Check the most likely hit first.
-    rect = this->get_chunk_meshrect(world_pos.x, world_pos.z, AM::iVec2(0, 0));
-    hit_result = ray.rectangle_intersection(rect);
-   
-    if(!hit_result.hit) {
-        // The rectangle was not hit under the player, search bigger area.
-        // Resulting search area will be (AREA_HALF*2) * (AREA_HALF*2)
-        constexpr int AREA_HALF = 1;
-
-        for(int z = -AREA_HALF; z <= AREA_HALF; z++) {
-            for(int x = -AREA_HALF; x <= AREA_HALF; x++) {
-                rect = this->get_chunk_meshrect(world_pos.x, world_pos.z, AM::iVec2(x, z));
-                
-                hit_result = ray.triangle_intersection(rect.tA);
-                if(hit_result.hit) {
-                    goto loop_exit;
-                }
-
-                hit_result = ray.triangle_intersection(rect.tB);
-                if(hit_result.hit) {
-                    goto loop_exit;
-                }
-            }
-        }
-    }
+    const int chunk_size = m_engine->net->server_cfg.chunk_size;
+    const AM::TerrainHeight::GridPoint point 
+        = AM::TerrainHeight::world_to_grid(world_pos.x, world_pos.z, 
+                chunk_size, m_engine->net->server_cfg.chunk_scale);
 
-loop_exit:
+    auto chunk_search = this->chunk_map.find(point.chunk_pos);
+    if(chunk_search == this->chunk_map.end() || !chunk_search->second.is_loaded()) {
+        return 0.0f;
+    }
 
-    return hit_result.point.y;
+    return AM::TerrainHeight::sample(chunk_search->second.height_points, chunk_size, point.local_x, point.local_z);
 }
 
 
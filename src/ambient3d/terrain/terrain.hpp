@@ -8,8 +8,12 @@
 #include <cstddef>
 
 #include "chunk.hpp"
+#include "chunk_pool.hpp"
+#include "../culling.hpp"
+#include "../mpsc_queue.hpp"
 #include "raylib.h"
 #include "shared/include/chunk_pos.hpp"
+#include "shared/include/chunk_map.hpp"
 #include "shared/include/geometry/rect.hpp"
 #include "shared/include/networking_agreements.hpp"
 #include "shared/include/ivec2.hpp"
@@ -23,11 +27,20 @@ namespace AM {
     };
 
 
+    // Maximum time used for unloading chunks per fast fixed tick.
+    static constexpr float CHUNK_EVICTION_BUDGET_MS = 1.0f;
+
+    // Chunk data packets waiting for the main thread. Slots are MAX_PACKET_SIZE each.
+    // When it is full packets go to an overflow list. The server doesnt send
+    // a chunk again after it was sent once, so they cant be dropped.
+    static constexpr size_t CHUNKDATA_QUEUE_SIZE = 32;
+
     class State;
+    class RenderQueue;
     class Terrain {
         public:
 
-            std::unordered_map<AM::ChunkPos, AM::Chunk> chunk_map;
+            AM::ChunkMap<AM::Chunk> chunk_map;
 
             // 'allocate_regenbuf' is called from 
             // "./network/network.cpp" handle_tcp_packet(size_t). case AM::PacketID::SERVER_CONFIG
@@ -37,6 +50,8 @@ namespace AM {
             void free_regenbuf();
             void create_chunk_materials();
             
+            // Can be called from any thread. Data is never dropped,
+            // if the queue is full it is copied to the overflow list.
             void add_chunkdata_to_queue(char* compressed_data, size_t sizeb);
            
 
@@ -44,7 +59,8 @@ namespace AM {
             void update_chunkdata_queue();
             void unload_all_chunks();
             void unload_materials();
-            void render();
+            // Only chunks inside of the frustum are submitted to 'queue'
+            void render(const AM::Frustum& view_frustum, AM::RenderQueue* queue);
  
             AM::ChunkPos get_chunk_pos       (float world_x, float world_z);
             AM::Rect     get_chunk_meshrect  (float world_x, float world_z, AM::iVec2 offset = {});
@@ -57,6 +73,19 @@ namespace AM {
 
             bool chunkpos_in_renderdist(const AM::ChunkPos& origin, const AM::ChunkPos& chunk_pos);
 
+            // Distances are in chunks (square area around the origin)
+            int  chunk_load_radius();
+            int  chunk_unload_radius();
+
+            // Unloads chunks further than 'chunk_unload_radius()' from 'origin'
+            // until 'budget_ms' milliseconds have been used.
+            // The rest are unloaded on the next calls.
+            // Border normals of the neighbours which stay loaded are updated.
+            // Positions of the unloaded chunks are added to 'unloaded_out'
+            // IMPORTANT NOTE: must be called from main thread.
+            void evict_far_chunks(const AM::ChunkPos& origin, float budget_ms,
+                    std::vector<AM::ChunkPos>* unloaded_out);
+
             void set_engine_state(AM::State* engine_state) {
                 m_engine = engine_state;
             }
@@ -69,8 +98,10 @@ namespace AM {
                 size_t                                num_bytes { 0 };
             };
 
-            std::mutex              m_chunkdata_queue_mutex;
-            std::vector<mChunkData> m_chunkdata_queue;
+            AM::MPSCQueue<mChunkData, CHUNKDATA_QUEUE_SIZE> m_chunkdata_queue;
+            AM::OverflowList<std::vector<char>>             m_chunkdata_overflow;
+            std::vector<std::vector<char>>                  m_chunkdata_overflow_read; // Reused by the main thread.
+            void m_load_chunkdata(const char* bytes, size_t num_bytes);
 
             // Used for decompressing chunk data.
             char* m_chunkdata_regenbuf { NULL };
@@ -80,6 +111,20 @@ namespace AM {
             std::array<Material, AM::ChunkMaterial::CM_NUM_MATERIALS>
                 m_chunk_materials;
 
+            AM::ChunkPool             m_chunk_pool;
+            std::vector<AM::ChunkPos> m_eviction_queue;
+            std::vector<AM::ChunkPos> m_new_chunks; // Loaded after the last 'evict_far_chunks' call.
+            AM::ChunkPos              m_eviction_origin;
+            bool                      m_eviction_origin_valid { false };
+
+            // Rebuilt every frame from 'chunk_map' for culling.
+            AM::CullBounds          m_chunk_bounds;
+            std::vector<AM::Chunk*> m_cull_chunks;
+            std::vector<uint32_t>   m_visible_chunks;
+
+            AM::ChunkMesh::Neighbours m_get_chunk_neighbours(const AM::ChunkPos& chunk_pos);
+            void m_update_neighbour_normals(const AM::ChunkPos& chunk_pos);
+
             AM::State* m_engine;
     };
 };
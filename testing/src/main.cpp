@@ -1,11 +1,14 @@
 
 #include "src/ambient3d/ambient3d.hpp"
 #include "src/ambient3d/animation.hpp"
+#include "src/ambient3d/animator.hpp"
 #include "src/ambient3d/network/assets_downloader.hpp"
 
 #include <cstdio>
 #include <raymath.h>
 #include <chrono>
+#include <map>
+#include <set>
 
 
 struct GameState {
@@ -13,32 +16,62 @@ struct GameState {
     //AM::Renderable robot;
 
     AM::Renderable robot; // test player model.
+    AM::Animator   robot_animator;
+    std::map<int /*player_id*/, uint32_t /*animator id*/> player_animators;
 
 
-    AM::Light** lightA { NULL };
-    AM::Light** lightB { NULL };
-    AM::Light** lightC { NULL };
-    AM::Light** lightD { NULL };
+    AM::LightHandle lightA;
+    AM::LightHandle lightB;
+    AM::LightHandle lightC;
+    AM::LightHandle lightD;
 };
 
 
 
+void update_player_animations(AM::State* st, GameState* gst) {
+    std::set<int> online;
+    st->net->foreach_online_players(
+    [gst, &online](AM::N_Player* player) {
+        online.insert(player->id);
+        auto it = gst->player_animators.find(player->id);
+        if(it == gst->player_animators.end()) {
+            gst->player_animators[player->id] = gst->robot_animator.add(player->anim_id);
+            return;
+        }
+        gst->robot_animator.play(it->second, player->anim_id);
+    });
+
+    for(auto it = gst->player_animators.begin(); it != gst->player_animators.end(); ) {
+        if(online.find(it->first) == online.end()) {
+            gst->robot_animator.remove(it->second);
+            it = gst->player_animators.erase(it);
+            continue;
+        }
+        ++it;
+    }
+
+    gst->robot_animator.update(GetFrameTime());
+}
+
 void render_scene(AM::State* st, GameState* gst) {
-    const float frame_time = GetFrameTime();
+    update_player_animations(st, gst);
     
-    DrawSphere((*gst->lightA)->pos, 1.0f, (*gst->lightA)->color);
-    DrawSphere((*gst->lightB)->pos, 1.0f, (*gst->lightB)->color);
-    DrawSphere((*gst->lightC)->pos, 1.0f, (*gst->lightC)->color);
-    DrawSphere((*gst->lightD)->pos, 1.0f, (*gst->lightD)->color);
+    DrawSphere(st->get_light(gst->lightA)->pos, 1.0f, st->get_light(gst->lightA)->color);
+    DrawSphere(st->get_light(gst->lightB)->pos, 1.0f, st->get_light(gst->lightB)->color);
+    DrawSphere(st->get_light(gst->lightC)->pos, 1.0f, st->get_light(gst->lightC)->color);
+    DrawSphere(st->get_light(gst->lightD)->pos, 1.0f, st->get_light(gst->lightD)->color);
 
     //gst->tree.render();
  
 
     // Render other players in the server.
     st->net->foreach_online_players(
-    [st, gst, frame_time](AM::N_Player* player) {
-     
-        gst->robot.anim.update(player->anim_id, frame_time, gst->robot.get_model());
+    [st, gst](AM::N_Player* player) {
+        auto animator = gst->player_animators.find(player->id);
+        if(animator == gst->player_animators.end()) {
+            return; // Joined after the animations were updated.
+        }
+        gst->robot.set_pose(gst->robot_animator.pose(animator->second));
 
         Matrix translation = MatrixTranslate(
                 player->pos.x,
@@ -50,7 +83,7 @@ void render_scene(AM::State* st, GameState* gst) {
         gst->robot.mesh_transforms[1] = MatrixRotateX(-player->cam_pitch);
         
         *gst->robot.transform = MatrixMultiply(body_rotation, translation);
-        gst->robot.render();         
+        gst->robot.submit(&st->render_queue);
     });
 }
  
@@ -67,11 +100,12 @@ void main_loop(AM::State* st) {
     //*gst.gun.transform = MatrixTranslate(7, 2, 20);
 
     gst.robot.load("game_assets/models/test_player.glb",
-            { st->shaders[AM::ShaderIDX::DEFAULT] },
+            { st->shaders[AM::ShaderIDX::DEFAULT_SKINNED] },
             AM::RLF_MESH_TRANSFORMS | AM::RLF_ANIMATIONS );
 
     gst.robot.anim.set_animation_speed(0, 0.025f);
     gst.robot.anim.set_animation_speed(1, 0.006f);
+    gst.robot_animator.init(*gst.robot.get_model(), gst.robot.anim);
 
     // Valot -----------------------------------
     gst.lightA = st->add_light(AM::Light {
@@ -120,11 +154,12 @@ void main_loop(AM::State* st) {
         */
 
 
-        (*gst.lightB)->pos.x += sin(GetTime()) * 0.01;
-        (*gst.lightB)->pos.z += cos(GetTime()) * 0.01;
-        (*gst.lightB)->pos.y += sin(GetTime() * 2.0) * 0.005;
+        AM::Light* lightB = st->edit_light(gst.lightB);
+        lightB->pos.x += sin(GetTime()) * 0.01;
+        lightB->pos.z += cos(GetTime()) * 0.01;
+        lightB->pos.y += sin(GetTime() * 2.0) * 0.005;
 
-        (*gst.lightC)->pos.x += cos(GetTime())*0.005;
+        st->edit_light(gst.lightC)->pos.x += cos(GetTime())*0.005;
         
 
 
@@ -0,0 +1,47 @@
+#ifndef AMBIENT3D_TEST_HPP
+#define AMBIENT3D_TEST_HPP
+
+#include <cstdio>
+#include <cmath>
+
+
+// Minimal checks for the headless tests in this directory.
+// A failed check is printed and counted, the test keeps going.
+// main() returns AM::Test::finish() so 'make run' stops on the first failed program.
+
+namespace AM {
+    namespace Test {
+
+        inline int num_checks = 0;
+        inline int num_failed = 0;
+
+        inline bool check(bool ok, const char* expr, const char* file, int line) {
+            num_checks++;
+            if(!ok) {
+                num_failed++;
+                fprintf(stderr, "FAILED %s:%i: %s\n", file, line, expr);
+            }
+            return ok;
+        }
+
+        inline bool check_near(double a, double b, double epsilon,
+                const char* expr, const char* file, int line) {
+            const bool ok = (fabs(a - b) <= epsilon);
+            if(!ok) {
+                fprintf(stderr, "  %g != %g (epsilon %g)\n", a, b, epsilon);
+            }
+            return check(ok, expr, file, line);
+        }
+
+        inline int finish(const char* name) {
+            printf("%s: %i checks, %i failed\n", name, num_checks, num_failed);
+            return (num_failed > 0) ? 1 : 0;
+        }
+    };
+};
+
+#define CHECK(expr) AM::Test::check((expr), #expr, __FILE__, __LINE__)
+#define CHECK_NEAR(a, b, epsilon) AM::Test::check_near((a), (b), (epsilon), #a " ~= " #b, __FILE__, __LINE__)
+
+
+#endif
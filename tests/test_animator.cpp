@@ -0,0 +1,237 @@
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <chrono>
+
+#include "test.hpp"
+#include "src/ambient3d/animator.hpp"
+#include "raymath.h"
+
+
+// Animator playback without a window: poses dont depend on the frame rate,
+// interpolation between frames, crossfades and instance ids.
+
+static constexpr int   BONE_COUNT = 40;
+static constexpr float FRAME_DURATION = 0.05f;
+static constexpr float MAX_FRAME_RATE_ERROR = 4e-5f;
+
+// Bone 'b' on frame 'f' is at (f * 0.1, b, anim) turned around an axis of the bone
+// by f * 0.2 radians, so the rotation changes every frame.
+struct TestAnimation {
+    std::vector<std::vector<Transform>> frames;
+    std::vector<Transform*> frame_ptrs;
+    std::vector<BoneInfo> bones;
+
+    TestAnimation(int frame_count, int anim_index) {
+        frames.resize(frame_count);
+        for(int f = 0; f < frame_count; f++) {
+            for(int b = 0; b < BONE_COUNT; b++) {
+                const Vector3 axis = Vector3Normalize({ 1.0f, (float)b, (float)anim_index + 0.5f });
+                frames[f].push_back(Transform {
+                    .translation = { f * 0.1f, (float)b, (float)anim_index },
+                    .rotation = QuaternionFromAxisAngle(axis, f * 0.2f + anim_index),
+                    .scale = { 1.0f, 1.0f + f * 0.01f, 1.0f }
+                });
+            }
+            frame_ptrs.push_back(frames[f].data());
+        }
+        bones.resize(BONE_COUNT);
+    }
+
+    ModelAnimation anim() {
+        ModelAnimation anim {};
+        anim.boneCount = BONE_COUNT;
+        anim.frameCount = (int)frames.size();
+        anim.bones = bones.data();
+        anim.framePoses = frame_ptrs.data();
+        return anim;
+    }
+};
+
+// Bind pose at the origin, so the skinning matrix holds the sampled transform as it is.
+static const std::vector<Transform> g_bind_pose(BONE_COUNT, Transform {
+    .translation = { 0.0f, 0.0f, 0.0f },
+    .rotation = { 0.0f, 0.0f, 0.0f, 1.0f },
+    .scale = { 1.0f, 1.0f, 1.0f }
+});
+
+static TestAnimation g_walk(10, 0);
+static TestAnimation g_run(7, 1);
+static const ModelAnimation g_anims[2] = { g_walk.anim(), g_run.anim() };
+
+static bool _init(AM::Animator* animator) {
+    return animator->init(g_bind_pose.data(), BONE_COUNT, g_anims, 2);
+}
+
+static float _max_difference(const Matrix* a, const Matrix* b) {
+    float max_diff = 0.0f;
+    for(int i = 0; i < BONE_COUNT; i++) {
+        const float* fa = &a[i].m0;
+        const float* fb = &b[i].m0;
+        for(int k = 0; k < 16; k++) {
+            max_diff = std::max(max_diff, fabsf(fa[k] - fb[k]));
+        }
+    }
+    return max_diff;
+}
+
+static void _step(AM::Animator* animator, int fps, float seconds) {
+    const int steps = (int)roundf(seconds * fps);
+    for(int i = 0; i < steps; i++) {
+        animator->update(1.0f / (float)fps);
+    }
+}
+
+static void _test_frame_rate() {
+    AM::Animator at_30;
+    AM::Animator at_144;
+    CHECK(_init(&at_30));
+    CHECK(_init(&at_144));
+    const uint32_t id_30 = at_30.add(0);
+    const uint32_t id_144 = at_144.add(0);
+
+    // 1 second is two loops of the walk animation.
+    _step(&at_30, 30, 1.0f);
+    _step(&at_144, 144, 1.0f);
+    const float walk_diff = _max_difference(at_30.pose(id_30), at_144.pose(id_144));
+    CHECK(walk_diff <= MAX_FRAME_RATE_ERROR);
+    CHECK_NEAR(at_30.current_time(id_30), at_144.current_time(id_144), 1e-5);
+
+    // Crossfade in the middle of a frame, then the new animation past its loop.
+    // (Times are multiples of 1/6 seconds so both frame rates step the same time)
+    at_30.play(id_30, 1);
+    at_144.play(id_144, 1);
+    _step(&at_30, 30, 1.0f / 6.0f);
+    _step(&at_144, 144, 1.0f / 6.0f);
+    const float fade_diff = _max_difference(at_30.pose(id_30), at_144.pose(id_144));
+    CHECK(fade_diff <= MAX_FRAME_RATE_ERROR);
+
+    _step(&at_30, 30, 0.5f);
+    _step(&at_144, 144, 0.5f);
+    const float run_diff = _max_difference(at_30.pose(id_30), at_144.pose(id_144));
+    CHECK(run_diff <= MAX_FRAME_RATE_ERROR);
+
+    printf("  30 fps and 144 fps differ by %g (walk), %g (crossfading), %g (run)\n",
+            walk_diff, fade_diff, run_diff);
+}
+
+static void _test_interpolation() {
+    AM::Animator animator;
+    CHECK(_init(&animator));
+    const uint32_t id = animator.add(0);
+
+    // Halfway between frames 3 and 4.
+    animator.update(FRAME_DURATION * 3.5f);
+    const Matrix* pose = animator.pose(id);
+    for(int b = 0; b < BONE_COUNT; b++) {
+        CHECK_NEAR(pose[b].m12, 0.35f, 1e-5);
+        CHECK_NEAR(pose[b].m13, (float)b, 1e-5);
+    }
+
+    // Between the last and the first frame it blends back to the start.
+    animator.update(FRAME_DURATION * 6.0f);
+    CHECK_NEAR(animator.current_time(id), FRAME_DURATION * 9.5f, 1e-5);
+    CHECK_NEAR(pose[0].m12, 0.45f, 1e-5);
+}
+
+static void _test_crossfade() {
+    AM::Animator animator;
+    CHECK(_init(&animator));
+    const uint32_t id = animator.add(0);
+    const uint32_t reference = animator.add(1);
+    animator.update(0.12f);
+
+    animator.play(id, 1, 0.2f);
+    CHECK(animator.current_animation(id) == 1);
+    CHECK(animator.current_time(id) == 0.0f);
+
+    // Halfway: the pose is neither animation.
+    // Reference instance started the run earlier, so it is compared after the fade to a fresh one.
+    const uint32_t fresh = animator.add(1);
+    animator.update(0.1f);
+    const float mid_diff = _max_difference(animator.pose(id), animator.pose(fresh));
+    CHECK(mid_diff > 0.01f);
+
+    // Finished: same as the instance which played only the new animation.
+    animator.update(0.1f);
+    animator.update(0.05f);
+    CHECK(_max_difference(animator.pose(id), animator.pose(fresh)) < 1e-5f);
+    CHECK_NEAR(animator.current_time(id), animator.current_time(fresh), 1e-6);
+
+    // Playing the same animation again does nothing.
+    const float time = animator.current_time(id);
+    animator.play(id, 1);
+    CHECK(animator.current_time(id) == time);
+
+    // No crossfade switches right away.
+    animator.play(reference, 0, 0.0f);
+    animator.play(fresh, 0, 0.0f);
+    animator.update(0.01f);
+    CHECK(_max_difference(animator.pose(reference), animator.pose(fresh)) < 1e-5f);
+
+    // Bad ids and animations are ignored.
+    animator.play(100, 1);
+    animator.play(id, 5);
+    CHECK(animator.current_animation(id) == 1);
+}
+
+static void _test_instances() {
+    AM::Animator animator;
+    CHECK(_init(&animator));
+    const uint32_t a = animator.add(0);
+    const uint32_t b = animator.add(1);
+    const uint32_t c = animator.add(7); // Out of bounds uses the first animation.
+    CHECK(animator.num_instances() == 3);
+    CHECK(animator.current_animation(c) == 0);
+
+    animator.remove(b);
+    animator.remove(b);
+    CHECK(animator.num_instances() == 2);
+    CHECK(animator.pose(b) == NULL);
+    CHECK(animator.pose(a) != NULL);
+
+    // Id is reused and starts from the beginning.
+    animator.update(0.3f);
+    const uint32_t d = animator.add(1);
+    CHECK(d == b);
+    CHECK(animator.current_time(d) == 0.0f);
+    CHECK(animator.num_instances() == 3);
+
+    // Bones dont match.
+    AM::Animator broken;
+    CHECK(!broken.init(g_bind_pose.data(), BONE_COUNT - 1, g_anims, 2));
+
+    // Many instances, then all of them crossfading.
+    const int num_instances = 256;
+    AM::Animator many;
+    CHECK(_init(&many));
+    for(int i = 0; i < num_instances; i++) {
+        many.add(i % 2);
+    }
+    const int num_updates = 100;
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < num_updates; i++) {
+        many.update(1.0f / 144.0f);
+    }
+    const std::chrono::duration<double, std::milli> time = (std::chrono::steady_clock::now() - start) / num_updates;
+
+    for(int i = 0; i < num_instances; i++) {
+        many.play(i, (i + 1) % 2, 10.0f);
+    }
+    start = std::chrono::steady_clock::now();
+    for(int i = 0; i < num_updates; i++) {
+        many.update(1.0f / 144.0f);
+    }
+    const std::chrono::duration<double, std::milli> fade_time = (std::chrono::steady_clock::now() - start) / num_updates;
+    printf("  %i instances, %i bones: update %0.2f ms, %0.2f ms crossfading\n",
+            num_instances, BONE_COUNT, time.count(), fade_time.count());
+}
+
+int main() {
+    _test_frame_rate();
+    _test_interpolation();
+    _test_crossfade();
+    _test_instances();
+    return AM::Test::finish("test_animator");
+}
+
@@ -0,0 +1,394 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "test.hpp"
+#include "server/assets_server/src/server.hpp"
+#include "src/ambient3d/network/assets_downloader.hpp"
+#include "shared/include/file_sha256.hpp"
+#include "shared/include/logger.hpp"
+
+namespace fs = std::filesystem;
+
+
+// Interrupted multi file download and its resume, through the assets server
+// and AssetsDownloader on loopback. The client connects through a proxy which
+// cuts the connection after a number of bytes, in the middle of the stream frames.
+
+static constexpr int SERVER_PORT = 34592;
+static constexpr int PROXY_PORT  = 34593;
+static constexpr int NUM_FILES   = 4;
+
+static const fs::path _test_dir() {
+    return fs::temp_directory_path() / "ambient3d_test_asset_resume";
+}
+
+static const fs::path _client_dir() {
+    return _test_dir() / "client";
+}
+
+static std::string _model_name(int i) {
+    return "file_" + std::to_string(i) + ".glb";
+}
+
+static std::vector<char> _read_file(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// Files of different sizes so the streams end at different times.
+// 'compressible' files are words from a small alphabet.
+static std::vector<std::vector<char>> _create_files(bool compressible) {
+    std::vector<std::vector<char>> files(NUM_FILES);
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for(int i = 0; i < NUM_FILES; i++) {
+        files[i].resize((size_t)(i + 1) * 700 * 1024 + 123 * i);
+        for(char& byte : files[i]) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            byte = compressible ? (char)('a' + (seed % 6)) : (char)seed;
+        }
+        const fs::path path = _test_dir() / "host" / "models" / _model_name(i);
+        fs::create_directories(path.parent_path());
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(files[i].data(), files[i].size());
+    }
+    return files;
+}
+
+
+// Forwards one client connection to the server.
+// The connection is closed after 'cut_after_bytes' were sent to the client. (0 never cuts)
+class CuttingProxy {
+    public:
+        CuttingProxy(size_t cut_after_bytes) {
+            m_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+            int enable = 1;
+            setsockopt(m_listen_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+            const sockaddr_in address = _address(PROXY_PORT);
+            bind(m_listen_fd, (const sockaddr*)&address, sizeof(address));
+            listen(m_listen_fd, 1);
+            m_thread = std::thread(&CuttingProxy::m_forward, this, cut_after_bytes);
+        }
+
+        ~CuttingProxy() {
+            if(m_thread.joinable()) {
+                m_thread.join();
+            }
+            close(m_listen_fd);
+        }
+
+        // Bytes sent to the client. Valid after the client is done.
+        size_t forwarded_bytes() {
+            if(m_thread.joinable()) {
+                m_thread.join();
+            }
+            return m_forwarded_bytes;
+        }
+
+    private:
+        int         m_listen_fd { -1 };
+        size_t      m_forwarded_bytes { 0 };
+        std::thread m_thread;
+
+        static sockaddr_in _address(int port) {
+            sockaddr_in address {};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(port);
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            return address;
+        }
+
+        static bool _write_all(int fd, const char* data, size_t size) {
+            while(size > 0) {
+                const ssize_t written = send(fd, data, size, MSG_NOSIGNAL);
+                if(written <= 0) {
+                    return false;
+                }
+                data += written;
+                size -= written;
+            }
+            return true;
+        }
+
+        void m_forward(size_t cut_after_bytes) {
+            const int client_fd = accept(m_listen_fd, NULL, NULL);
+            const int server_fd = socket(AF_INET, SOCK_STREAM, 0);
+            const sockaddr_in address = _address(SERVER_PORT);
+            if((client_fd < 0) || (connect(server_fd, (const sockaddr*)&address, sizeof(address)) != 0)) {
+                close(server_fd);
+                close(client_fd);
+                return;
+            }
+
+            std::vector<char> buffer(64 * 1024);
+            pollfd fds[2] = {
+                { client_fd, POLLIN, 0 },
+                { server_fd, POLLIN, 0 }
+            };
+            bool open = true;
+            while(open && (poll(fds, 2, -1) > 0)) {
+                if(fds[0].revents) {
+                    const ssize_t size = read(client_fd, buffer.data(), buffer.size());
+                    open = (size > 0) && _write_all(server_fd, buffer.data(), size);
+                }
+                if(open && fds[1].revents) {
+                    size_t read_size = buffer.size();
+                    if(cut_after_bytes > 0) {
+                        read_size = std::min(read_size, cut_after_bytes - m_forwarded_bytes);
+                    }
+                    const ssize_t size = read(server_fd, buffer.data(), read_size);
+                    open = (size > 0) && _write_all(client_fd, buffer.data(), size);
+                    m_forwarded_bytes += std::max(size, (ssize_t)0);
+                    if((cut_after_bytes > 0) && (m_forwarded_bytes >= cut_after_bytes)) {
+                        open = false;
+                    }
+                }
+            }
+            close(server_fd);
+            close(client_fd);
+        }
+};
+
+
+static AM::Config _server_config(bool compress_files) {
+    AM::Config config;
+    config.port = SERVER_PORT;
+    config.host_dir = (_test_dir() / "host").string();
+    config.allowed_model_file_exts = ".glb";
+    config.allowed_texture_file_exts = ".png";
+    config.watch_host_dir = false;
+    config.hash_cache_path = (_test_dir() / "hash_cache.json").string();
+    config.hash_threads = 0;
+    config.stream_files = true;
+    config.stream_window_bytes = 256 * 1024;
+    config.max_concurrent_streams = 4;
+    config.delta_updates = false;
+    config.compress_files = compress_files;
+    config.compression_cache_dir = (_test_dir() / "compressed_cache").string();
+    config.compression_level = 1;
+    config.compression_encodings["models"] = "lz4hc";
+    return config;
+}
+
+struct TestServer {
+    AM::AssetFileStorage  file_storage;
+    asio::io_context      context;
+    std::thread           thread;
+    AM::GameAssetsServer* server { NULL };
+
+    TestServer(const AM::Config& config) {
+        AM::find_asset_files(config, &file_storage);
+        AM::compute_asset_file_hashes(config, &file_storage);
+        file_storage.update_sorted_files();
+        if(config.compress_files) {
+            AM::compress_asset_files(config, &file_storage);
+        }
+        server = new AM::GameAssetsServer(config, &file_storage, context);
+        thread = std::thread([this]() {
+            server->start(context);
+        });
+    }
+
+    ~TestServer() {
+        context.stop();
+        thread.join();
+        delete server;
+    }
+};
+
+// Downloads through the proxy. Returns bytes the client received.
+static size_t _download(size_t cut_after_bytes) {
+    AM::ClientConfig client_config;
+    client_config.game_asset_dir = _client_dir().string() + "/";
+
+    CuttingProxy proxy(cut_after_bytes);
+
+    // Progress is printed to stdout and the cut connection to stderr.
+    fflush(stdout);
+    fflush(stderr);
+    const int stdout_fd = dup(1);
+    const int stderr_fd = dup(2);
+    const int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, 1);
+    dup2(null_fd, 2);
+    {
+        asio::io_context client_context;
+        AM::AssetsDownloader downloader(client_config, client_context, "127.0.0.1",
+                std::to_string(PROXY_PORT).c_str());
+        downloader.ask_download_permission = false;
+        downloader.update_assets(); // Must return when the connection is cut.
+        downloader.close_connection(client_context);
+    }
+    fflush(stdout);
+    fflush(stderr);
+    dup2(stdout_fd, 1);
+    dup2(stderr_fd, 2);
+    close(stdout_fd);
+    close(stderr_fd);
+    close(null_fd);
+
+    return proxy.forwarded_bytes();
+}
+
+// Part files are named "<file>.<first 16 chars of sha256>.part"
+static fs::path _part_path(const AM::AssetFileStorage& file_storage, int i) {
+    const AM::AssetFile& file = *file_storage.files.at(_model_name(i));
+    return _client_dir() / "models" / (_model_name(i) + "." + file.sha256_hash.substr(0, 16) + ".part");
+}
+
+static size_t _part_size(const AM::AssetFileStorage& file_storage, int i) {
+    std::error_code ec;
+    const size_t size = fs::file_size(_part_path(file_storage, i), ec);
+    return ec ? 0 : size;
+}
+
+static void _check_complete(const std::vector<std::vector<char>>& files, const AM::AssetFileStorage& file_storage) {
+    for(int i = 0; i < NUM_FILES; i++) {
+        CHECK(_read_file(_client_dir() / "models" / _model_name(i)) == files[i]);
+        CHECK(!fs::exists(_part_path(file_storage, i)));
+    }
+}
+
+static void _test_interrupt_and_resume() {
+    fs::remove_all(_test_dir());
+    const std::vector<std::vector<char>> files = _create_files(false);
+    TestServer server(_server_config(false));
+
+    size_t total_bytes = 0;
+    for(const std::vector<char>& file : files) {
+        total_bytes += file.size();
+    }
+
+    // Cut in the middle of a frame.
+    const size_t cut_after_bytes = total_bytes * 2 / 5 + 777;
+    const size_t received_bytes = _download(cut_after_bytes);
+    CHECK(received_bytes == cut_after_bytes);
+
+    // Streams are interleaved, so more than one file has a part.
+    // Nothing is written for the frame headers and the packets.
+    size_t part_bytes = 0;
+    size_t complete_bytes = 0;
+    int num_parts = 0;
+    for(int i = 0; i < NUM_FILES; i++) {
+        if(fs::exists(_client_dir() / "models" / _model_name(i))) {
+            CHECK(_read_file(_client_dir() / "models" / _model_name(i)) == files[i]);
+            CHECK(!fs::exists(_part_path(server.file_storage, i)));
+            complete_bytes += files[i].size();
+            continue;
+        }
+        const size_t part_size = _part_size(server.file_storage, i);
+        CHECK(part_size < files[i].size());
+        if(part_size > 0) {
+            const std::vector<char> part = _read_file(_part_path(server.file_storage, i));
+            CHECK(std::equal(part.begin(), part.end(), files[i].begin()));
+            num_parts++;
+        }
+        part_bytes += part_size;
+    }
+    printf("  cut after %zu / %zu bytes: %zu bytes in %i part files, %zu in complete files\n",
+            cut_after_bytes, total_bytes, part_bytes, num_parts, complete_bytes);
+    CHECK(num_parts >= 2);
+    CHECK(part_bytes + complete_bytes > cut_after_bytes / 2);
+    CHECK(part_bytes + complete_bytes <= cut_after_bytes);
+
+    // Resume sends only the rest. (and the file list, frame headers and packets)
+    const size_t missing_bytes = total_bytes - part_bytes - complete_bytes;
+    const size_t resumed_bytes = _download(0);
+    printf("  resumed: %zu bytes received, %zu were missing\n", resumed_bytes, missing_bytes);
+    CHECK(resumed_bytes >= missing_bytes);
+    CHECK(resumed_bytes < missing_bytes + 16 * 1024);
+    _check_complete(files, server.file_storage);
+
+    // Nothing is downloaded when the files are up to date.
+    CHECK(_download(0) < 1024);
+}
+
+static void _test_broken_parts() {
+    fs::remove_all(_test_dir());
+    const std::vector<std::vector<char>> files = _create_files(false);
+    TestServer server(_server_config(false));
+
+    _download(files[0].size() + files[1].size());
+
+    // Part with wrong bytes is resumed, fails the hash and is removed.
+    // Part larger than the file is downloaded again from the beginning.
+    int broken = -1;
+    int too_large = -1;
+    for(int i = 0; i < NUM_FILES; i++) {
+        if(fs::exists(_client_dir() / "models" / _model_name(i))) {
+            continue;
+        }
+        if((broken < 0) && (_part_size(server.file_storage, i) > 0)) {
+            broken = i;
+        }
+        else
+        if(too_large < 0) {
+            too_large = i;
+        }
+    }
+    if(!CHECK(broken >= 0) || !CHECK(too_large >= 0)) {
+        return;
+    }
+    {
+        std::fstream part(_part_path(server.file_storage, broken), std::ios::binary | std::ios::in | std::ios::out);
+        part.seekp(0);
+        part.put((char)(files[broken][0] ^ 0xFF));
+    }
+    {
+        std::ofstream part(_part_path(server.file_storage, too_large), std::ios::binary | std::ios::trunc);
+        part.write(files[too_large].data(), files[too_large].size());
+        part.write("extra", 5);
+    }
+
+    _download(0);
+    for(int i = 0; i < NUM_FILES; i++) {
+        CHECK(!fs::exists(_part_path(server.file_storage, i)));
+        if(i == broken) {
+            CHECK(!fs::exists(_client_dir() / "models" / _model_name(i)));
+            continue;
+        }
+        CHECK(_read_file(_client_dir() / "models" / _model_name(i)) == files[i]);
+    }
+
+    // Next start downloads the broken one.
+    _download(0);
+    _check_complete(files, server.file_storage);
+}
+
+static void _test_compressed_restart() {
+    fs::remove_all(_test_dir());
+    const std::vector<std::vector<char>> files = _create_files(true);
+    TestServer server(_server_config(true));
+    for(int i = 0; i < NUM_FILES; i++) {
+        CHECK(server.file_storage.files.at(_model_name(i))->encoding == "lz4hc");
+    }
+
+    // Compressed files are written decompressed, so they cant be resumed from the part size.
+    _download(server.file_storage.files.at(_model_name(0))->transfer_size() / 2);
+    _download(0);
+    _check_complete(files, server.file_storage);
+}
+
+int main() {
+    // A downloader which doesnt notice the cut connection would wait forever.
+    alarm(60);
+    AM::set_log_level(AM::LL_NONE);
+    _test_interrupt_and_resume();
+    _test_broken_parts();
+    _test_compressed_restart();
+    fs::remove_all(_test_dir());
+    return AM::Test::finish("test_asset_resume");
+}
+
@@ -0,0 +1,271 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <filesystem>
+#include <unistd.h>
+
+#include "test.hpp"
+#include "server/assets_server/src/asset_watcher.hpp"
+#include "shared/include/file_sha256.hpp"
+#include "shared/include/asset_compression.hpp"
+#include "shared/include/logger.hpp"
+
+namespace fs = std::filesystem;
+
+
+// Bulk change in the host directory while the io_context keeps running.
+// Files are hashed and compressed on the watcher thread, so a timer on the
+// io_context (standing in for the sessions) must keep firing on time.
+
+static constexpr int NUM_FILES = 100;
+static constexpr int TICK_MS = 2;
+static constexpr double MAX_ALLOWED_STALL_MS = 100.0;
+
+static const fs::path _test_dir() {
+    return fs::temp_directory_path() / "ambient3d_test_asset_watcher";
+}
+
+static fs::path _model_path(int i) {
+    return _test_dir() / "host" / "models" / ("file_" + std::to_string(i) + ".glb");
+}
+
+// Text like bytes so the files are compressed.
+static void _write_file(const fs::path& path, size_t size, uint64_t seed) {
+    std::vector<char> bytes(size);
+    for(char& byte : bytes) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        byte = (char)('a' + (seed % 12));
+    }
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), bytes.size());
+}
+
+static std::vector<char> _read_file(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+static AM::Config _config() {
+    AM::Config config;
+    config.port = 0;
+    config.host_dir = (_test_dir() / "host").string();
+    config.allowed_model_file_exts = ".glb";
+    config.allowed_texture_file_exts = ".png";
+    config.watch_host_dir = true;
+    config.hash_cache_path = (_test_dir() / "hash_cache.json").string();
+    config.hash_threads = 0;
+    config.stream_files = true;
+    config.stream_window_bytes = 1024 * 1024;
+    config.max_concurrent_streams = 4;
+    config.delta_updates = false;
+    config.compress_files = true;
+    config.compression_cache_dir = (_test_dir() / "compressed_cache").string();
+    config.compression_level = 9;
+    config.compression_encodings["models"] = "lz4hc";
+    return config;
+}
+
+// Ticks on the io_context and measures how late each tick is.
+// 'done' is called on the io_context thread after every tick, the ticking stops when it returns true.
+class Ticker {
+    public:
+        Ticker(asio::io_context& context, std::function<bool()> done)
+        : m_timer(context), m_done(done) {
+            m_next = std::chrono::steady_clock::now();
+            m_tick();
+        }
+
+        double max_late_ms { 0.0 };
+        std::atomic<bool> finished { false };
+
+    private:
+        asio::steady_timer m_timer;
+        std::function<bool()> m_done;
+        std::chrono::steady_clock::time_point m_next;
+
+        void m_tick() {
+            m_next += std::chrono::milliseconds(TICK_MS);
+            m_timer.expires_at(m_next);
+            m_timer.async_wait([this](std::error_code ec) {
+                if(ec) {
+                    return;
+                }
+                const auto now = std::chrono::steady_clock::now();
+                const std::chrono::duration<double, std::milli> late = now - m_next;
+                max_late_ms = std::max(max_late_ms, late.count());
+                if(m_done()) {
+                    finished = true;
+                    return;
+                }
+                // Late ticks are not repeated.
+                if(now > m_next) {
+                    m_next = now;
+                }
+                m_tick();
+            });
+        }
+};
+
+static bool _wait(Ticker& ticker, double timeout_seconds) {
+    const auto start = std::chrono::steady_clock::now();
+    while(!ticker.finished) {
+        if(std::chrono::steady_clock::now() - start > std::chrono::duration<double>(timeout_seconds)) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+}
+
+static bool _has_current_hash(const AM::AssetFileStorage& file_storage, const fs::path& path) {
+    const auto search = file_storage.files.find(path.filename());
+    if(search == file_storage.files.end()) {
+        return false;
+    }
+    std::string hash;
+    return AM::compute_sha256_filehash(path, &hash) && (search->second->sha256_hash == hash);
+}
+
+int main() {
+    AM::set_log_level(AM::LL_WARNING);
+    fs::remove_all(_test_dir());
+    fs::create_directories(_test_dir() / "host" / "models");
+
+    const AM::Config config = _config();
+    AM::AssetFileStorage file_storage;
+    AM::find_asset_files(config, &file_storage);
+    AM::compute_asset_file_hashes(config, &file_storage);
+    file_storage.update_sorted_files();
+
+    asio::io_context context;
+    auto work = asio::make_work_guard(context);
+    AM::AssetWatcher watcher(config, &file_storage, context);
+    CHECK(watcher.start());
+    std::thread io_th([&context]() {
+        context.run();
+    });
+
+    // Bulk copy of new files.
+    const auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> update_time { 0 };
+    Ticker bulk_ticker(context, [&]() {
+        if(file_storage.files.size() < (size_t)NUM_FILES) {
+            return false;
+        }
+        update_time = std::chrono::steady_clock::now() - start;
+        return true;
+    });
+    for(int i = 0; i < NUM_FILES; i++) {
+        _write_file(_model_path(i), 256 * 1024 + i, i + 1);
+    }
+    const std::chrono::duration<double, std::milli> write_time = std::chrono::steady_clock::now() - start;
+    CHECK(_wait(bulk_ticker, 60.0));
+
+    printf("  %i files written in %0.1fms, in the storage after %0.1fms, longest io_context stall %0.2fms\n",
+            NUM_FILES, write_time.count(), update_time.count(), bulk_ticker.max_late_ms);
+    CHECK(bulk_ticker.max_late_ms < MAX_ALLOWED_STALL_MS);
+
+    // Changes made while an update is in progress are applied after it.
+    // File 0 is changed twice, file 1 is removed.
+    std::atomic<bool> changed_again { false };
+    Ticker change_ticker(context, [&]() {
+        return changed_again
+            && (file_storage.files.find(_model_path(1).filename()) == file_storage.files.end())
+            && _has_current_hash(file_storage, _model_path(0));
+    });
+    for(int i = 2; i < NUM_FILES; i++) {
+        _write_file(_model_path(i), 256 * 1024 + i, i + 1000);
+    }
+    _write_file(_model_path(0), 64 * 1024, 7);
+    std::this_thread::sleep_for(std::chrono::milliseconds(AM::WATCHER_SETTLE_MS * 2));
+    fs::remove(_model_path(1));
+    _write_file(_model_path(0), 128 * 1024, 8);
+    changed_again = true;
+    CHECK(_wait(change_ticker, 60.0));
+    CHECK(change_ticker.max_late_ms < MAX_ALLOWED_STALL_MS);
+
+    // Everything is checked on the io_context thread.
+    std::atomic<bool> checked { false };
+    asio::post(context, [&]() {
+        CHECK(file_storage.files.size() == (size_t)NUM_FILES - 1);
+        CHECK(file_storage.sorted_files.size() == file_storage.files.size());
+        for(int i = 0; i < NUM_FILES; i++) {
+            if(i == 1) {
+                continue;
+            }
+            CHECK(_has_current_hash(file_storage, _model_path(i)));
+            const auto search = file_storage.files.find(_model_path(i).filename());
+            if(search != file_storage.files.end()) {
+                CHECK(search->second->encoding == "lz4hc");
+                CHECK(search->second->encoded_size < search->second->size);
+            }
+        }
+        checked = true;
+    });
+    while(!checked) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Same files updated on the io_context thread, like before the worker thread.
+    // Own compression cache so they are compressed again.
+    AM::Config sync_config = config;
+    sync_config.compression_cache_dir = (_test_dir() / "sync_compressed_cache").string();
+    sync_config.hash_cache_path = (_test_dir() / "sync_hash_cache.json").string();
+    std::vector<std::string> all_paths;
+    for(int i = 2; i < NUM_FILES; i++) {
+        all_paths.push_back(_model_path(i));
+    }
+    const auto sync_start = std::chrono::steady_clock::now();
+    AM::AssetFileStorage sync_storage;
+    AM::update_asset_files(sync_config, &sync_storage, all_paths);
+    const std::chrono::duration<double, std::milli> sync_time = std::chrono::steady_clock::now() - sync_start;
+    printf("  %i files updated on the io_context thread would stall it for %0.1fms\n",
+            NUM_FILES - 2, sync_time.count());
+    CHECK(sync_storage.files.size() == (size_t)NUM_FILES - 2);
+
+    // Identical files share one cache file which is compressed once.
+    AM::Config same_config = sync_config;
+    same_config.compression_cache_dir = (_test_dir() / "same_compressed_cache").string();
+    same_config.hash_cache_path = (_test_dir() / "same_hash_cache.json").string();
+    same_config.hash_threads = 4;
+    std::vector<std::string> same_paths;
+    for(int i = 0; i < 8; i++) {
+        const fs::path path = _test_dir() / "host" / "models" / ("same_" + std::to_string(i) + ".glb");
+        _write_file(path, 256 * 1024, 42);
+        same_paths.push_back(path);
+    }
+    AM::AssetFileStorage same_storage;
+    AM::update_asset_files(same_config, &same_storage, same_paths);
+    CHECK(same_storage.files.size() == same_paths.size());
+    CHECK(std::distance(fs::directory_iterator(same_config.compression_cache_dir), fs::directory_iterator()) == 1);
+    for(const auto& [name, file] : same_storage.files) {
+        CHECK(file->encoding == "lz4hc");
+        CHECK(file->encoded_path == same_storage.files.begin()->second->encoded_path);
+        CHECK(file->encoded_size == fs::file_size(file->encoded_path));
+    }
+    if(!same_storage.files.empty()) {
+        const AM::AssetFile& file = *same_storage.files.begin()->second;
+        const std::vector<char> encoded = _read_file(file.encoded_path);
+        const fs::path decoded_path = _test_dir() / "same_decoded";
+        {
+            std::ofstream decoded(decoded_path, std::ios::binary | std::ios::trunc);
+            AM::AssetFileDecoder decoder;
+            CHECK(decoder.begin(file.encoding));
+            CHECK(decoder.write(decoded, encoded.data(), encoded.size()));
+            CHECK(decoder.complete());
+        }
+        CHECK(_read_file(decoded_path) == _read_file(same_paths[0]));
+    }
+
+    work.reset();
+    context.stop();
+    io_th.join();
+    fs::remove_all(_test_dir());
+    return AM::Test::finish("test_asset_watcher");
+}
+
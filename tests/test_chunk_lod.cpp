@@ -0,0 +1,147 @@
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+#include "test.hpp"
+#include "src/ambient3d/terrain/chunk_mesh.hpp"
+
+
+static void _test_select_lod() {
+    const AM::ChunkPos origin(10, -5);
+    const int num_levels = 4;
+    const int lod_distance = 3;
+
+    // Chebyshev distance: the level only depends on the larger axis distance.
+    for(int dz = -15; dz <= 15; dz++) {
+        for(int dx = -15; dx <= 15; dx++) {
+            const int distance = std::max(abs(dx), abs(dz));
+            const int expected = std::min(distance / lod_distance, num_levels-1);
+            const int level = AM::ChunkMesh::select_lod(
+                    origin, AM::ChunkPos(origin.x + dx, origin.z + dz), num_levels, lod_distance);
+            if(!CHECK(level == expected)) {
+                fprintf(stderr, "  offset (%i, %i) level %i expected %i\n", dx, dz, level, expected);
+            }
+        }
+    }
+
+    // Band edges.
+    CHECK(AM::ChunkMesh::select_lod(origin, AM::ChunkPos(12, -5), 4, 3) == 0);
+    CHECK(AM::ChunkMesh::select_lod(origin, AM::ChunkPos(13, -5), 4, 3) == 1);
+    CHECK(AM::ChunkMesh::select_lod(origin, AM::ChunkPos(10, -10), 4, 3) == 1);
+    CHECK(AM::ChunkMesh::select_lod(origin, AM::ChunkPos(10, -11), 4, 3) == 2);
+    CHECK(AM::ChunkMesh::select_lod(origin, AM::ChunkPos(4, 1), 4, 3) == 2);
+    CHECK(AM::ChunkMesh::select_lod(origin, AM::ChunkPos(-100, 0), 4, 3) == 3);
+
+    // Chunk sizes with fewer levels and a zero distance.
+    CHECK(AM::ChunkMesh::select_lod(origin, AM::ChunkPos(40, 40), 1, 3) == 0);
+    CHECK(AM::ChunkMesh::select_lod(origin, AM::ChunkPos(40, 40), 2, 3) == 1);
+    CHECK(AM::ChunkMesh::select_lod(origin, AM::ChunkPos(11, -5), 4, 0) == 1);
+    CHECK(AM::ChunkMesh::select_lod(origin, origin, 4, 0) == 0);
+}
+
+static void _test_num_lod_levels() {
+    CHECK(AM::ChunkMesh::num_lod_levels(16) == 4);
+    CHECK(AM::ChunkMesh::num_lod_levels(64) == 4);
+    CHECK(AM::ChunkMesh::num_lod_levels(12) == 3);
+    CHECK(AM::ChunkMesh::num_lod_levels(6) == 2);
+    CHECK(AM::ChunkMesh::num_lod_levels(5) == 1);
+}
+
+// Height of the level 'level' edge at full resolution point 'i'.
+// Coarser levels only have every step'th point, the edge is a line between them.
+static float _edge_height(const std::vector<float>& edge, int level, int i) {
+    const int step = AM::ChunkMesh::lod_step(level);
+    const int j = (i / step) * step;
+    if(j == i) {
+        return edge[i];
+    }
+    const float t = (float)(i - j) / (float)step;
+    return edge[j] + t * (edge[j + step] - edge[j]);
+}
+
+static void _test_skirt_depth() {
+    const int chunk_size = 16;
+    const int row = chunk_size+1;
+    const float scale = 4.0f;
+    const int num_levels = AM::ChunkMesh::num_lod_levels(chunk_size);
+
+    // Flat terrain only needs the minimum depth.
+    std::vector<float> heights(row * row, 7.0f);
+    CHECK_NEAR(AM::ChunkMesh::skirt_depth(heights.data(), chunk_size, scale, num_levels), scale * 0.5f, 1e-6);
+
+    // Sloped terrain is still linear on every level.
+    for(int z = 0; z < row; z++) {
+        for(int x = 0; x < row; x++) {
+            heights[z * row + x] = x * 0.5f - z * 0.25f;
+        }
+    }
+    CHECK_NEAR(AM::ChunkMesh::skirt_depth(heights.data(), chunk_size, scale, num_levels), scale * 0.5f, 1e-5);
+
+    // Rough terrain: where two chunks using any two levels meet,
+    // the skirt has to reach below the lower of the two edges.
+    uint32_t seed = 1234;
+    for(int round = 0; round < 50; round++) {
+        for(float& h : heights) {
+            seed = seed * 1664525u + 1013904223u;
+            h = (float)(seed >> 8) / (float)(1u << 24) * 40.0f - 20.0f;
+        }
+        const float depth = AM::ChunkMesh::skirt_depth(heights.data(), chunk_size, scale, num_levels);
+
+        // Back edge (z = 0), the other edges use the same formula.
+        std::vector<float> edge(heights.begin(), heights.begin() + row);
+        float max_gap = -INFINITY;
+        for(int a = 0; a < num_levels; a++) {
+            for(int b = 0; b < num_levels; b++) {
+                for(int i = 0; i < row; i++) {
+                    const float top_a = _edge_height(edge, a, i);
+                    const float top_b = _edge_height(edge, b, i);
+                    // Skirt of 'a' hangs 'depth' under its edge and has to cover the edge of 'b'
+                    max_gap = std::max(max_gap, (top_a - depth) - top_b);
+                }
+            }
+        }
+        if(!CHECK(max_gap < 0.0f)) {
+            fprintf(stderr, "  round %i: skirt depth %f leaves a gap of %f\n", round, depth, max_gap);
+        }
+    }
+
+    // Skirt vertices are the edge vertices moved down by the depth.
+    const int level = 1;
+    std::vector<float> vertices(AM::ChunkMesh::num_vertices(chunk_size, level) * 3);
+    AM::ChunkMesh::build_vertices(heights.data(), chunk_size, scale, level, 3.5f, vertices.data());
+    const int level_row = (chunk_size >> level) + 1;
+    const size_t skirt_begin = AM::ChunkMesh::num_grid_vertices(chunk_size, level);
+    for(int k = 0; k < level_row; k++) {
+        const float* top = &vertices[k * 3];
+        const float* skirt = &vertices[(skirt_begin + k) * 3]; // Back edge skirt is first.
+        CHECK(top[0] == skirt[0]);
+        CHECK(top[2] == skirt[2]);
+        CHECK_NEAR(top[1] - skirt[1], 3.5f, 1e-5);
+        CHECK(top[1] == heights[k * AM::ChunkMesh::lod_step(level)]);
+    }
+}
+
+static void _test_indices_in_range() {
+    for(const int chunk_size : { 16, 24, 64 }) {
+        for(int level = 0; level < AM::ChunkMesh::num_lod_levels(chunk_size); level++) {
+            std::vector<uint16_t> indices(AM::ChunkMesh::num_indices(chunk_size, level));
+            AM::ChunkMesh::build_indices(chunk_size, level, indices.data());
+            const size_t num_vertices = AM::ChunkMesh::num_vertices(chunk_size, level);
+            bool in_range = true;
+            for(const uint16_t index : indices) {
+                in_range = in_range && (index < num_vertices);
+            }
+            CHECK(in_range);
+        }
+    }
+}
+
+int main() {
+    _test_select_lod();
+    _test_num_lod_levels();
+    _test_skirt_depth();
+    _test_indices_in_range();
+    return AM::Test::finish("test_chunk_lod");
+}
+
@@ -0,0 +1,197 @@
+#include <set>
+#include <vector>
+#include <utility>
+#include <cstdlib>
+#include <algorithm>
+
+#include "test.hpp"
+#include "server/src/chunk_window.hpp"
+
+
+// ChunkWindow against a std::set of loaded positions.
+// Random insert, erase, slide and scan operations with windows
+// smaller than a word, exactly a word and several words wide.
+
+struct Random {
+    uint64_t state { 0x2545F4914F6CDD1DULL };
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return (uint32_t)(state >> 32);
+    }
+    int range(int min, int max) {
+        return min + (int)(next() % (uint32_t)(max - min + 1));
+    }
+};
+
+using Pos = std::pair<int, int>;
+
+struct Reference {
+    std::set<Pos> loaded;
+    AM::ChunkPos center { 0, 0 };
+    int radius { 0 };
+
+    bool inside(int x, int z) const {
+        return (abs(x - center.x) <= radius) && (abs(z - center.z) <= radius);
+    }
+
+    void insert(int x, int z) {
+        if(inside(x, z)) {
+            loaded.insert({ x, z });
+        }
+    }
+
+    // Returns the positions which left the window.
+    std::set<Pos> set_center(const AM::ChunkPos& new_center) {
+        center = new_center;
+        std::set<Pos> dropped;
+        for(auto it = loaded.begin(); it != loaded.end();) {
+            if(!inside(it->first, it->second)) {
+                dropped.insert(*it);
+                it = loaded.erase(it);
+                continue;
+            }
+            ++it;
+        }
+        return dropped;
+    }
+
+    std::set<Pos> missing(int distance) const {
+        const int d = std::clamp(distance, 0, radius);
+        std::set<Pos> result;
+        for(int z = center.z - d; z <= center.z + d; z++) {
+            for(int x = center.x - d; x <= center.x + d; x++) {
+                if(!loaded.count({ x, z })) {
+                    result.insert({ x, z });
+                }
+            }
+        }
+        return result;
+    }
+};
+
+static std::set<Pos> _missing(const AM::ChunkWindow& window, int distance, size_t* num_calls) {
+    std::set<Pos> result;
+    *num_calls = 0;
+    window.foreach_missing(distance, [&](const AM::ChunkPos& pos) {
+        result.insert({ pos.x, pos.z });
+        (*num_calls)++;
+    });
+    return result;
+}
+
+static bool _matches(const AM::ChunkWindow& window, const Reference& reference) {
+    bool ok = true;
+    const int r = reference.radius + 2;
+    for(int z = reference.center.z - r; z <= reference.center.z + r; z++) {
+        for(int x = reference.center.x - r; x <= reference.center.x + r; x++) {
+            ok &= (window.contains(AM::ChunkPos(x, z)) == (bool)reference.loaded.count({ x, z }));
+        }
+    }
+    return ok;
+}
+
+static void _test_random_operations(int radius, Random& random) {
+    AM::ChunkWindow window;
+    window.resize(radius);
+    Reference reference;
+    reference.radius = radius;
+
+    const int num_steps = (radius < 10) ? 3000 : 600;
+    for(int step = 0; step < num_steps; step++) {
+        const AM::ChunkPos& c = reference.center;
+        switch(random.range(0, 9)) {
+            // Insert, sometimes just outside of the window.
+            case 0: case 1: case 2: case 3:
+                {
+                    const int count = random.range(1, 2 * radius + 2);
+                    for(int i = 0; i < count; i++) {
+                        const int x = c.x + random.range(-radius - 2, radius + 2);
+                        const int z = c.z + random.range(-radius - 2, radius + 2);
+                        window.insert(AM::ChunkPos(x, z));
+                        reference.insert(x, z);
+                    }
+                }
+                break;
+
+            case 4:
+                {
+                    const int x = c.x + random.range(-radius - 1, radius + 1);
+                    const int z = c.z + random.range(-radius - 1, radius + 1);
+                    window.erase(AM::ChunkPos(x, z));
+                    reference.loaded.erase({ x, z });
+                }
+                break;
+
+            // Walking, and sometimes teleporting past the whole window.
+            case 5: case 6: case 7:
+                {
+                    const int jump = (random.range(0, 9) == 0) ? (radius * 3 + 3) : 2;
+                    const AM::ChunkPos new_center(
+                            c.x + random.range(-jump, jump),
+                            c.z + random.range(-jump, jump));
+                    std::set<Pos> dropped;
+                    window.set_center(new_center, [&dropped](const AM::ChunkPos& pos) {
+                        CHECK(dropped.insert({ pos.x, pos.z }).second);
+                    });
+                    CHECK(dropped == reference.set_center(new_center));
+                    CHECK(window.center() == new_center);
+                }
+                break;
+
+            case 8:
+                {
+                    const int distance = random.range(-1, radius + 2);
+                    size_t num_calls = 0;
+                    const std::set<Pos> missing = _missing(window, distance, &num_calls);
+                    CHECK(missing == reference.missing(distance));
+                    CHECK(num_calls == missing.size());
+                }
+                break;
+
+            case 9:
+                if(random.range(0, 19) == 0) {
+                    window.clear();
+                    reference.loaded.clear();
+                }
+                break;
+        }
+
+        if(!CHECK(_matches(window, reference))) {
+            fprintf(stderr, "  radius %i, step %i\n", radius, step);
+            return;
+        }
+    }
+}
+
+// Everything in the window loaded: nothing is missing.
+static void _test_full_window() {
+    AM::ChunkWindow window;
+    window.resize(40);
+    window.set_center(AM::ChunkPos(-1000, 77));
+    for(int z = 77 - 40; z <= 77 + 40; z++) {
+        for(int x = -1000 - 40; x <= -1000 + 40; x++) {
+            window.insert(AM::ChunkPos(x, z));
+        }
+    }
+    size_t num_calls = 0;
+    CHECK(_missing(window, 40, &num_calls).empty());
+    CHECK(num_calls == 0);
+
+    // One step to the side leaves exactly one column missing.
+    window.set_center(AM::ChunkPos(-999, 77));
+    const std::set<Pos> missing = _missing(window, 40, &num_calls);
+    CHECK(missing.size() == 81);
+    CHECK(std::all_of(missing.begin(), missing.end(), [](const Pos& pos) { return pos.first == -999 + 40; }));
+}
+
+int main() {
+    Random random;
+    const int radii[] = { 0, 1, 3, 7, 31, 32, 40, 70 };
+    for(int radius : radii) {
+        _test_random_operations(radius, random);
+    }
+    _test_full_window();
+    return AM::Test::finish("test_chunk_window");
+}
@@ -0,0 +1,244 @@
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "test.hpp"
+#include "src/ambient3d/culling.hpp"
+#include "raymath.h"
+
+
+// extract_frustum planes against clip space, and find_visible (4 boxes at once)
+// against the same test done one box at a time. Random boxes, boxes straddling
+// each plane, the distance cutoff and box counts which are not a multiple of 4.
+
+struct Random {
+    uint64_t state { 0x2545F4914F6CDD1DULL };
+    float uniform(float min, float max) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return min + (float)((state >> 11) * (1.0 / (double)(1ULL << 53))) * (max - min);
+    }
+};
+
+static const Vector3 CAMERA_POSITION = { 10.0f, 20.0f, 10.0f };
+
+static Matrix _view_projection() {
+    const Matrix view = MatrixLookAt(CAMERA_POSITION, { 40.0f, 10.0f, -60.0f }, { 0.0f, 1.0f, 0.0f });
+    const Matrix projection = MatrixPerspective(60.0f * DEG2RAD, 16.0 / 9.0, 1.0, 500.0);
+    return MatrixMultiply(view, projection);
+}
+
+static float _plane_distance(const AM::Frustum& frustum, int p, const Vector3& point) {
+    return frustum.a[p] * point.x + frustum.b[p] * point.y + frustum.c[p] * point.z + frustum.d[p];
+}
+
+static std::vector<uint32_t> _find_visible_scalar(
+        const AM::Frustum& frustum,
+        const std::vector<BoundingBox>& boxes,
+        const Vector3& origin,
+        float max_distance
+){
+    std::vector<uint32_t> visible;
+    for(size_t i = 0; i < boxes.size(); i++) {
+        const BoundingBox& box = boxes[i];
+        const float dx = fmaxf(fmaxf(box.min.x - origin.x, origin.x - box.max.x), 0.0f);
+        const float dy = fmaxf(fmaxf(box.min.y - origin.y, origin.y - box.max.y), 0.0f);
+        const float dz = fmaxf(fmaxf(box.min.z - origin.z, origin.z - box.max.z), 0.0f);
+        bool inside = (dx*dx + dy*dy + dz*dz) <= max_distance * max_distance;
+        for(int p = 0; (p < 6) && inside; p++) {
+            const Vector3 corner = {
+                (frustum.a[p] >= 0.0f) ? box.max.x : box.min.x,
+                (frustum.b[p] >= 0.0f) ? box.max.y : box.min.y,
+                (frustum.c[p] >= 0.0f) ? box.max.z : box.min.z
+            };
+            inside = _plane_distance(frustum, p, corner) >= 0.0f;
+        }
+        if(inside) {
+            visible.push_back((uint32_t)i);
+        }
+    }
+    return visible;
+}
+
+static std::vector<uint32_t> _find_visible(
+        const AM::Frustum& frustum,
+        const std::vector<BoundingBox>& boxes,
+        const Vector3& origin,
+        float max_distance
+){
+    AM::CullBounds bounds;
+    for(const BoundingBox& box : boxes) {
+        bounds.add(box);
+    }
+    // Leftovers from a previous call must not matter.
+    std::vector<uint32_t> visible(123, 0xFFFFFFFF);
+    const size_t num_visible = AM::Culling::find_visible(frustum, bounds, origin, max_distance, &visible);
+    CHECK(num_visible == visible.size());
+    return visible;
+}
+
+static BoundingBox _box_around(const Vector3& center, float half_size) {
+    return BoundingBox {
+        Vector3Subtract(center, { half_size, half_size, half_size }),
+        Vector3Add(center, { half_size, half_size, half_size })
+    };
+}
+
+static void _test_extract_frustum() {
+    const Matrix m = _view_projection();
+    const AM::Frustum frustum = AM::Culling::extract_frustum(m);
+
+    // Left, right, bottom, top, near, far are w + x, w - x, w + y, w - y, w + z, w - z in clip space.
+    Random random;
+    for(int i = 0; i < 1000; i++) {
+        const Vector3 point = { random.uniform(-600.0f, 600.0f), random.uniform(-600.0f, 600.0f), random.uniform(-600.0f, 600.0f) };
+        const float x = m.m0 * point.x + m.m4 * point.y + m.m8  * point.z + m.m12;
+        const float y = m.m1 * point.x + m.m5 * point.y + m.m9  * point.z + m.m13;
+        const float z = m.m2 * point.x + m.m6 * point.y + m.m10 * point.z + m.m14;
+        const float w = m.m3 * point.x + m.m7 * point.y + m.m11 * point.z + m.m15;
+        const float expected[6] = { w + x, w - x, w + y, w - y, w + z, w - z };
+        for(int p = 0; p < 6; p++) {
+            CHECK_NEAR(_plane_distance(frustum, p, point), expected[p], 1e-3 * fmax(1.0, fabs(w)));
+        }
+    }
+
+    // Straight ahead between the near and far planes is inside of all of them.
+    const Vector3 forward = Vector3Normalize(Vector3Subtract({ 40.0f, 10.0f, -60.0f }, CAMERA_POSITION));
+    const Vector3 ahead = Vector3Add(CAMERA_POSITION, Vector3Scale(forward, 100.0f));
+    const Vector3 behind = Vector3Add(CAMERA_POSITION, Vector3Scale(forward, -10.0f));
+    const Vector3 too_close = Vector3Add(CAMERA_POSITION, Vector3Scale(forward, 0.5f));
+    const Vector3 too_far = Vector3Add(CAMERA_POSITION, Vector3Scale(forward, 600.0f));
+    for(int p = 0; p < 6; p++) {
+        CHECK(_plane_distance(frustum, p, ahead) > 0.0f);
+    }
+    CHECK(_plane_distance(frustum, 4, behind) < 0.0f);
+    CHECK(_plane_distance(frustum, 4, too_close) < 0.0f);
+    CHECK(_plane_distance(frustum, 5, too_close) > 0.0f);
+    CHECK(_plane_distance(frustum, 5, too_far) < 0.0f);
+}
+
+static void _test_random_boxes() {
+    const AM::Frustum frustum = AM::Culling::extract_frustum(_view_projection());
+    Random random;
+
+    // Every count up to a few vectors, then a big one.
+    std::vector<size_t> counts;
+    for(size_t count = 0; count <= 13; count++) {
+        counts.push_back(count);
+    }
+    counts.push_back(4001);
+
+    size_t num_visible = 0;
+    for(size_t count : counts) {
+        for(int repeat = 0; repeat < 20; repeat++) {
+            std::vector<BoundingBox> boxes;
+            for(size_t i = 0; i < count; i++) {
+                const Vector3 center = { random.uniform(-400.0f, 400.0f), random.uniform(-100.0f, 100.0f), random.uniform(-400.0f, 400.0f) };
+                const Vector3 half = { random.uniform(0.1f, 40.0f), random.uniform(0.1f, 40.0f), random.uniform(0.1f, 40.0f) };
+                boxes.push_back({ Vector3Subtract(center, half), Vector3Add(center, half) });
+            }
+            const float max_distance = random.uniform(50.0f, 600.0f);
+            const std::vector<uint32_t> visible = _find_visible(frustum, boxes, CAMERA_POSITION, max_distance);
+            CHECK(visible == _find_visible_scalar(frustum, boxes, CAMERA_POSITION, max_distance));
+            num_visible += visible.size();
+        }
+    }
+    CHECK(num_visible > 0);
+}
+
+// A small box on each plane is visible, moved out of the plane it is not.
+static void _test_plane_straddling() {
+    const AM::Frustum frustum = AM::Culling::extract_frustum(_view_projection());
+    const Vector3 forward = Vector3Normalize(Vector3Subtract({ 40.0f, 10.0f, -60.0f }, CAMERA_POSITION));
+    const Vector3 center = Vector3Add(CAMERA_POSITION, Vector3Scale(forward, 50.0f));
+    const float half_size = 0.05f;
+
+    for(int p = 0; p < 6; p++) {
+        // Point on plane 'p' straight from the center against the plane normal.
+        const Vector3 normal = Vector3Normalize({ frustum.a[p], frustum.b[p], frustum.c[p] });
+        const float scale = Vector3Length({ frustum.a[p], frustum.b[p], frustum.c[p] });
+        const float distance = _plane_distance(frustum, p, center) / scale;
+        const Vector3 on_plane = Vector3Subtract(center, Vector3Scale(normal, distance));
+        const Vector3 outside = Vector3Subtract(on_plane, Vector3Scale(normal, half_size * 4.0f));
+        const Vector3 inside = Vector3Add(on_plane, Vector3Scale(normal, half_size * 4.0f));
+
+        const std::vector<BoundingBox> boxes = {
+            _box_around(on_plane, half_size),
+            _box_around(outside, half_size),
+            _box_around(inside, half_size),
+            _box_around(center, half_size)
+        };
+        const std::vector<uint32_t> visible = _find_visible(frustum, boxes, CAMERA_POSITION, 1000.0f);
+        if(!CHECK((visible == std::vector<uint32_t>{ 0, 2, 3 }))) {
+            fprintf(stderr, "  plane %i, %zu visible\n", p, visible.size());
+        }
+        CHECK(visible == _find_visible_scalar(frustum, boxes, CAMERA_POSITION, 1000.0f));
+    }
+}
+
+// Distance is to the closest point of the box, not to its center.
+static void _test_max_distance() {
+    const AM::Frustum frustum = AM::Culling::extract_frustum(_view_projection());
+    const Vector3 forward = Vector3Normalize(Vector3Subtract({ 40.0f, 10.0f, -60.0f }, CAMERA_POSITION));
+    const float max_distance = 100.0f;
+    const float half_size = 5.0f;
+
+    std::vector<BoundingBox> boxes;
+    const float distances[] = { 20.0f, 99.0f, 101.0f, 104.9f, 105.1f, 200.0f, 450.0f };
+    for(float distance : distances) {
+        boxes.push_back(_box_around(Vector3Add(CAMERA_POSITION, Vector3Scale(forward, distance)), half_size));
+    }
+    // Box around the camera is inside of the distance but crosses the near plane.
+    boxes.push_back(_box_around(CAMERA_POSITION, half_size));
+    // Close but behind the camera.
+    boxes.push_back(_box_around(Vector3Subtract(CAMERA_POSITION, Vector3Scale(forward, 20.0f)), half_size));
+
+    // Boxes near the cutoff depend on their corners, only the clear ones are checked by index.
+    const std::vector<uint32_t> visible = _find_visible(frustum, boxes, CAMERA_POSITION, max_distance);
+    CHECK(visible == _find_visible_scalar(frustum, boxes, CAMERA_POSITION, max_distance));
+    CHECK(std::find(visible.begin(), visible.end(), 0) != visible.end());
+    CHECK(std::find(visible.begin(), visible.end(), 1) != visible.end());
+    CHECK(std::find(visible.begin(), visible.end(), 5) == visible.end());
+    CHECK(std::find(visible.begin(), visible.end(), 6) == visible.end());
+    CHECK(std::find(visible.begin(), visible.end(), 7) != visible.end());
+    CHECK(std::find(visible.begin(), visible.end(), 8) == visible.end());
+
+    // Without a distance limit only the frustum culls.
+    const std::vector<uint32_t> unlimited = _find_visible(frustum, boxes, CAMERA_POSITION, INFINITY);
+    CHECK(unlimited == (std::vector<uint32_t>{ 0, 1, 2, 3, 4, 5, 6, 7 }));
+
+    // Nothing is visible at zero distance except what contains the origin.
+    const std::vector<uint32_t> zero = _find_visible(frustum, boxes, CAMERA_POSITION, 0.0f);
+    CHECK(zero == (std::vector<uint32_t>{ 7 }));
+}
+
+// Boxes are added again after clear(), the padding of the old ones must not show up.
+static void _test_reuse_bounds() {
+    const AM::Frustum frustum = AM::Culling::extract_frustum(_view_projection());
+    const Vector3 forward = Vector3Normalize(Vector3Subtract({ 40.0f, 10.0f, -60.0f }, CAMERA_POSITION));
+    const BoundingBox visible_box = _box_around(Vector3Add(CAMERA_POSITION, Vector3Scale(forward, 50.0f)), 1.0f);
+
+    AM::CullBounds bounds;
+    for(int i = 0; i < 7; i++) {
+        bounds.add(visible_box);
+    }
+    bounds.clear();
+    for(int i = 0; i < 3; i++) {
+        bounds.add(visible_box);
+    }
+    CHECK(bounds.size() == 3);
+
+    std::vector<uint32_t> visible;
+    CHECK(AM::Culling::find_visible(frustum, bounds, CAMERA_POSITION, 1000.0f, &visible) == 3);
+    CHECK(visible == (std::vector<uint32_t>{ 0, 1, 2 }));
+}
+
+int main() {
+    _test_extract_frustum();
+    _test_random_boxes();
+    _test_plane_straddling();
+    _test_max_distance();
+    _test_reuse_bounds();
+    return AM::Test::finish("test_culling");
+}
@@ -0,0 +1,170 @@
+#include <cstdio>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "test.hpp"
+#include "src/ambient3d/instance_batcher.hpp"
+
+
+// Batches are in the order their key was first submitted and the transforms
+// of a batch stay in submit order (the counting sort is stable).
+// Transform's m12 holds the submit index so the order can be checked.
+
+static Matrix _transform(int index) {
+    Matrix m {};
+    m.m0 = m.m5 = m.m10 = m.m15 = 1.0f;
+    m.m12 = (float)index;
+    return m;
+}
+
+static void* _key(int i) {
+    return (void*)(uintptr_t)(0x1000 + i * 16);
+}
+
+// Compared against std::stable_sort of the submits by the first submit of their key.
+static bool _matches_stable_sort(const AM::InstanceBatcher& batcher, const std::vector<void*>& keys) {
+    std::vector<void*> key_order;
+    for(void* key : keys) {
+        if(std::find(key_order.begin(), key_order.end(), key) == key_order.end()) {
+            key_order.push_back(key);
+        }
+    }
+    std::vector<int> expected(keys.size());
+    for(size_t i = 0; i < keys.size(); i++) {
+        expected[i] = (int)i;
+    }
+    std::stable_sort(expected.begin(), expected.end(), [&](int a, int b) {
+        return (std::find(key_order.begin(), key_order.end(), keys[a]) - key_order.begin())
+             < (std::find(key_order.begin(), key_order.end(), keys[b]) - key_order.begin());
+    });
+
+    const std::vector<AM::InstanceBatcher::Batch>& batches = batcher.batches();
+    const std::vector<Matrix>& transforms = batcher.transforms();
+    if((batches.size() != key_order.size()) || (transforms.size() != keys.size())) {
+        return false;
+    }
+    uint32_t first = 0;
+    for(size_t i = 0; i < batches.size(); i++) {
+        if((batches[i].key != key_order[i]) || (batches[i].first != first)) {
+            return false;
+        }
+        for(uint32_t k = batches[i].first; k < batches[i].first + batches[i].count; k++) {
+            if(keys[(int)transforms[k].m12] != batches[i].key) {
+                return false;
+            }
+        }
+        first += batches[i].count;
+    }
+    for(size_t i = 0; i < expected.size(); i++) {
+        if((int)transforms[i].m12 != expected[i]) {
+            return false;
+        }
+    }
+    return (first == keys.size());
+}
+
+static void _test_order() {
+    AM::InstanceBatcher batcher;
+    batcher.build();
+    CHECK(batcher.batches().empty());
+    CHECK(batcher.transforms().empty());
+
+    // B A B C A A B
+    const std::vector<void*> keys = { _key(1), _key(0), _key(1), _key(2), _key(0), _key(0), _key(1) };
+    for(size_t i = 0; i < keys.size(); i++) {
+        batcher.submit(keys[i], _transform((int)i));
+    }
+    CHECK(batcher.num_submitted() == keys.size());
+    batcher.build();
+
+    const std::vector<AM::InstanceBatcher::Batch>& batches = batcher.batches();
+    CHECK(batches.size() == 3);
+    if(batches.size() == 3) {
+        CHECK(batches[0].key == _key(1));
+        CHECK(batches[1].key == _key(0));
+        CHECK(batches[2].key == _key(2));
+        CHECK(batches[0].first == 0 && batches[0].count == 3);
+        CHECK(batches[1].first == 3 && batches[1].count == 3);
+        CHECK(batches[2].first == 6 && batches[2].count == 1);
+    }
+    const int expected[] = { 0, 2, 6, 1, 4, 5, 3 };
+    for(int i = 0; i < 7; i++) {
+        CHECK(batcher.transforms()[i].m12 == (float)expected[i]);
+    }
+    CHECK(_matches_stable_sort(batcher, keys));
+
+    // Building again gives the same result.
+    batcher.build();
+    CHECK(_matches_stable_sort(batcher, keys));
+
+    // NULL is a key like any other, also as the first submit after clear.
+    batcher.clear();
+    CHECK(batcher.num_submitted() == 0);
+    const std::vector<void*> null_keys = { NULL, NULL, _key(3), NULL };
+    for(size_t i = 0; i < null_keys.size(); i++) {
+        batcher.submit(null_keys[i], _transform((int)i));
+    }
+    batcher.build();
+    CHECK(batcher.batches().size() == 2);
+    CHECK(_matches_stable_sort(batcher, null_keys));
+}
+
+// Random keys, mostly in runs like the items of a chunk.
+static void _test_random() {
+    AM::InstanceBatcher batcher;
+    uint64_t seed = 0x853C49E6748FEA9BULL;
+    auto next = [&seed]() {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return seed;
+    };
+
+    bool all_ok = true;
+    for(int round = 0; round < 50; round++) {
+        batcher.clear();
+        std::vector<void*> keys;
+        const int num_types = 1 + (int)(next() % 20);
+        const int num_items = (int)(next() % 3000);
+        int type = 0;
+        for(int i = 0; i < num_items; i++) {
+            if(next() % 4 == 0) {
+                type = (int)(next() % num_types);
+            }
+            keys.push_back(_key(type));
+            batcher.submit(keys.back(), _transform(i));
+        }
+        batcher.build();
+        all_ok = all_ok && _matches_stable_sort(batcher, keys);
+    }
+    CHECK(all_ok);
+
+    // Same amount as the commit measured: 10000 items over 20 types.
+    const int num_items = 10000;
+    const int num_types = 20;
+    std::vector<void*> keys(num_items);
+    for(int i = 0; i < num_items; i++) {
+        keys[i] = _key((int)(next() % num_types));
+    }
+    const int num_reps = 50;
+    const auto start = std::chrono::steady_clock::now();
+    for(int rep = 0; rep < num_reps; rep++) {
+        batcher.clear();
+        for(int i = 0; i < num_items; i++) {
+            batcher.submit(keys[i], _transform(i));
+        }
+        batcher.build();
+    }
+    const std::chrono::duration<double, std::micro> time = (std::chrono::steady_clock::now() - start) / num_reps;
+    CHECK(batcher.batches().size() == (size_t)num_types);
+    printf("  %i items, %i types: %zu batches, submit + build %0.1f us\n",
+            num_items, num_types, batcher.batches().size(), time.count());
+}
+
+int main() {
+    _test_order();
+    _test_random();
+    return AM::Test::finish("test_instance_batcher");
+}
+
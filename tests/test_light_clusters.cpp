@@ -0,0 +1,141 @@
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+
+#include "test.hpp"
+#include "src/ambient3d/light_clusters.hpp"
+
+
+// Every light whose range reaches a visible point must be in the cluster of that point.
+// Checked against all lights for random points in the view, with few and many lights.
+// (Build times: bench/bench_light_clusters.cpp)
+
+static constexpr int SCREEN_WIDTH = 1000;
+static constexpr int SCREEN_HEIGHT = 800;
+static constexpr int NUM_VIEW_POINTS = 20000;
+
+struct Random {
+    uint64_t state { 0x2545F4914F6CDD1DULL };
+    float uniform(float min, float max) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return min + (float)((state >> 11) * (1.0 / (double)(1ULL << 53))) * (max - min);
+    }
+};
+
+static bool _cluster_has_light(const AM::LightClusters& clusters, int cluster, uint32_t light) {
+    const uint32_t offset = clusters.cluster_data[cluster * 2];
+    const uint32_t count = clusters.cluster_data[cluster * 2 + 1];
+    for(uint32_t i = 0; i < count; i++) {
+        if(clusters.cluster_data[offset + i] == light) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void _test_coverage(int num_lights, Random& random) {
+    const Vector3 camera_position = { 0.0f, 10.0f, 0.0f };
+    const Matrix view = MatrixLookAt(camera_position, { 0.0f, 10.0f, -1.0f }, { 0.0f, 1.0f, 0.0f });
+    const Matrix projection = MatrixPerspective(60.0f * DEG2RAD,
+            (double)SCREEN_WIDTH / SCREEN_HEIGHT, 0.01, 1000.0);
+    const Matrix inverse_view = MatrixInvert(view);
+
+    std::vector<AM::Light> lights(num_lights);
+    for(AM::Light& light : lights) {
+        light.pos = { random.uniform(-300.0f, 300.0f), random.uniform(0.0f, 30.0f), random.uniform(-300.0f, 300.0f) };
+        light.color = WHITE;
+        light.cutoff = 2.0f;
+        light.strength = random.uniform(2.0f, 15.0f);
+    }
+
+    AM::LightClusters clusters;
+    clusters.build(view, projection, SCREEN_WIDTH, SCREEN_HEIGHT, lights.data(), lights.size());
+
+    size_t num_in_range = 0;
+    size_t num_missing = 0;
+    for(int k = 0; k < NUM_VIEW_POINTS; k++) {
+        const float ndc_x = random.uniform(-0.999f, 0.999f);
+        const float ndc_y = random.uniform(-0.999f, 0.999f);
+        const float depth = random.uniform(0.05f, 400.0f);
+        const Vector3 view_point = { ndc_x * depth / projection.m0, ndc_y * depth / projection.m5, -depth };
+        const Vector3 world_point = Vector3Transform(view_point, inverse_view);
+
+        const int cluster = clusters.find_cluster(ndc_x, ndc_y, depth);
+        if(!CHECK((cluster >= 0) && (cluster < AM::NUM_LIGHT_CLUSTERS))) {
+            continue;
+        }
+        // Full cluster has left out the farthest lights on purpose.
+        const bool full = (clusters.cluster_data[cluster * 2 + 1] >= AM::LIGHT_CLUSTER_MAX_LIGHTS);
+
+        for(int i = 0; i < num_lights; i++) {
+            if(Vector3Distance(world_point, lights[i].pos) >= AM::light_range(lights[i])) {
+                continue;
+            }
+            num_in_range++;
+            if(!full && !_cluster_has_light(clusters, cluster, (uint32_t)i)) {
+                num_missing++;
+            }
+        }
+    }
+
+    size_t total_refs = 0;
+    uint32_t max_count = 0;
+    for(int i = 0; i < AM::NUM_LIGHT_CLUSTERS; i++) {
+        const uint32_t count = clusters.cluster_data[i * 2 + 1];
+        total_refs += count;
+        max_count = std::max(max_count, count);
+        CHECK(count <= AM::LIGHT_CLUSTER_MAX_LIGHTS);
+    }
+    const double avg_count = (double)total_refs / AM::NUM_LIGHT_CLUSTERS;
+
+    printf("  %4i lights: %.1f lights per cluster (max %u, dropped %zu)"
+           " | %zu light/point pairs in range, %zu missing\n",
+            num_lights, avg_count, max_count, clusters.num_dropped, num_in_range, num_missing);
+
+    CHECK(num_in_range > 0);
+    CHECK(num_missing == 0);
+    CHECK(clusters.cluster_data.size() == AM::NUM_LIGHT_CLUSTERS * 2 + total_refs);
+    CHECK(clusters.cluster_data.size() <= AM::LIGHT_CLUSTER_DATA_MAX_SIZE);
+    // Fragments loop over a small part of the lights.
+    CHECK(avg_count < num_lights * 0.1);
+}
+
+static void _test_find_cluster() {
+    const Matrix view = MatrixLookAt({ 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 1.0f, 0.0f });
+    const Matrix projection = MatrixPerspective(60.0f * DEG2RAD,
+            (double)SCREEN_WIDTH / SCREEN_HEIGHT, 0.01, 1000.0);
+    AM::LightClusters clusters;
+    clusters.build(view, projection, SCREEN_WIDTH, SCREEN_HEIGHT, NULL, 0);
+
+    CHECK(clusters.find_cluster(0.0f, 0.0f, -1.0f) == -1);
+    CHECK(clusters.find_cluster(-0.999f, -0.999f, 0.001f) >= 0);
+    CHECK(clusters.find_cluster(0.999f, 0.999f, 999.0f) < AM::NUM_LIGHT_CLUSTERS);
+
+    // Everything closer than LIGHT_CLUSTER_NEAR is in the first slice, the slices grow with depth.
+    const int slice_size = AM::LIGHT_CLUSTERS_X * AM::LIGHT_CLUSTERS_Y;
+    CHECK(clusters.find_cluster(0.0f, 0.0f, 0.1f) / slice_size == 0);
+    CHECK(clusters.find_cluster(0.0f, 0.0f, AM::LIGHT_CLUSTER_NEAR * 0.99f) / slice_size == 0);
+    int prev_slice = 0;
+    for(float depth = 1.5f; depth < 1000.0f; depth *= 1.5f) {
+        const int slice = clusters.find_cluster(0.0f, 0.0f, depth) / slice_size;
+        CHECK(slice >= prev_slice);
+        prev_slice = slice;
+    }
+    CHECK(prev_slice == AM::LIGHT_CLUSTERS_Z - 1);
+
+    for(int i = 0; i < AM::NUM_LIGHT_CLUSTERS; i++) {
+        CHECK(clusters.cluster_data[i * 2 + 1] == 0);
+    }
+}
+
+int main() {
+    Random random;
+    _test_coverage(64, random);
+    _test_coverage(1000, random);
+    _test_coverage(4096, random);
+    _test_find_cluster();
+    return AM::Test::finish("test_light_clusters");
+}
+
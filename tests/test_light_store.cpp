@@ -0,0 +1,273 @@
+#include <cstdio>
+#include <vector>
+
+#include "test.hpp"
+#include "src/ambient3d/light_store.hpp"
+#include "src/ambient3d/light_clusters.hpp"
+
+
+// Handles, slot reuse, swap-remove and the single dirty range handed to 'flush'.
+// Uploads go to a vector standing in for the shader storage buffer.
+
+struct Upload {
+    size_t first;
+    size_t count;
+};
+
+struct FakeBuffer {
+    std::vector<AM::LightShaderData> data;
+    std::vector<Upload> uploads;
+
+    void flush(AM::LightStore& store) {
+        store.flush([this](size_t first, const AM::LightShaderData* lights, size_t count) {
+            if(data.size() < first + count) {
+                data.resize(first + count);
+            }
+            for(size_t i = 0; i < count; i++) {
+                data[first + i] = lights[i];
+            }
+            uploads.push_back(Upload{ first, count });
+        });
+    }
+};
+
+static AM::Light _light(float x) {
+    return AM::Light {
+        .pos = { x, 1.0f, 2.0f },
+        .color = { 255, 128, 0, 255 },
+        .cutoff = 3.0f,
+        .strength = 4.0f
+    };
+}
+
+// Every light in the store is in the buffer as it is now.
+static bool _buffer_matches(const AM::LightStore& store, const FakeBuffer& buffer) {
+    if(buffer.data.size() < store.size()) {
+        return false;
+    }
+    for(size_t i = 0; i < store.size(); i++) {
+        const AM::Light& light = store.data()[i];
+        const AM::LightShaderData& data = buffer.data[i];
+        if((data.pos[0] != light.pos.x)
+        || (data.pos[1] != light.pos.y)
+        || (data.pos[2] != light.pos.z)
+        || (data.color[1] != (float)light.color.g / 255.0f)
+        || (data.settings[0] != light.strength)
+        || (data.settings[1] != light.cutoff)
+        || (data.settings[2] != AM::light_range(light))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void _test_handles() {
+    AM::LightStore store(4);
+    CHECK(!store.valid(AM::LightHandle{}));
+    CHECK(store.get(AM::LightHandle{}) == NULL);
+
+    const AM::LightHandle a = store.add(_light(0.0f));
+    const AM::LightHandle b = store.add(_light(1.0f));
+    CHECK(store.valid(a));
+    CHECK(store.valid(b));
+    CHECK(a.generation != 0);
+    CHECK(a.slot != b.slot);
+    CHECK(store.get(b)->pos.x == 1.0f);
+
+    // Removed handle stays invalid.
+    CHECK(store.remove(a));
+    CHECK(!store.valid(a));
+    CHECK(store.get(a) == NULL);
+    CHECK(store.edit(a) == NULL);
+    CHECK(!store.remove(a));
+    CHECK(store.size() == 1);
+
+    // Slot is reused with new generation, the old handle does not point to the new light.
+    const AM::LightHandle c = store.add(_light(2.0f));
+    CHECK(c.slot == a.slot);
+    CHECK(c.generation != a.generation);
+    CHECK(!store.valid(a));
+    CHECK(store.get(a) == NULL);
+    CHECK(store.get(c)->pos.x == 2.0f);
+    CHECK(store.get(b)->pos.x == 1.0f);
+
+    // Handle from outside of the slots.
+    CHECK(!store.valid(AM::LightHandle{ 100, 1 }));
+
+    // Full store.
+    store.add(_light(3.0f));
+    store.add(_light(4.0f));
+    CHECK(store.size() == store.max_size());
+    const AM::LightHandle full = store.add(_light(5.0f));
+    CHECK(full.generation == 0);
+    CHECK(!store.valid(full));
+    CHECK(store.size() == 4);
+}
+
+static void _test_swap_remove() {
+    AM::LightStore store(16);
+    FakeBuffer buffer;
+    std::vector<AM::LightHandle> handles;
+    for(int i = 0; i < 8; i++) {
+        handles.push_back(store.add(_light((float)i)));
+    }
+    buffer.flush(store);
+
+    // Last light moves to index 2, only that index is uploaded.
+    buffer.uploads.clear();
+    CHECK(store.remove(handles[2]));
+    CHECK(store.size() == 7);
+    CHECK(store.data()[2].pos.x == 7.0f);
+    CHECK(store.get(handles[7]) == &store.data()[2]);
+    buffer.flush(store);
+    CHECK(buffer.uploads.size() == 1);
+    if(!buffer.uploads.empty()) {
+        CHECK(buffer.uploads[0].first == 2);
+        CHECK(buffer.uploads[0].count == 1);
+    }
+    CHECK(_buffer_matches(store, buffer));
+
+    // Removing the last light moves nothing.
+    buffer.uploads.clear();
+    CHECK(store.remove(handles[6]));
+    CHECK(store.size() == 6);
+    buffer.flush(store);
+    CHECK(buffer.uploads.empty());
+
+    // Other handles still point to their own lights.
+    for(int i = 0; i < 8; i++) {
+        if((i == 2) || (i == 6)) {
+            continue;
+        }
+        const AM::Light* light = store.get(handles[i]);
+        CHECK((light != NULL) && (light->pos.x == (float)i));
+    }
+}
+
+static void _test_dirty_range() {
+    AM::LightStore store(64);
+    FakeBuffer buffer;
+    std::vector<AM::LightHandle> handles;
+    for(int i = 0; i < 32; i++) {
+        handles.push_back(store.add(_light((float)i)));
+    }
+
+    // New lights are uploaded in one range.
+    CHECK(store.num_dirty() == 32);
+    buffer.flush(store);
+    CHECK(buffer.uploads.size() == 1);
+    if(!buffer.uploads.empty()) {
+        CHECK(buffer.uploads[0].first == 0);
+        CHECK(buffer.uploads[0].count == 32);
+    }
+    CHECK(_buffer_matches(store, buffer));
+    CHECK(store.num_dirty() == 0);
+
+    // Nothing changed, nothing uploaded.
+    buffer.uploads.clear();
+    buffer.flush(store);
+    CHECK(buffer.uploads.empty());
+
+    // Scattered edits are coalesced to one range from the first to the last.
+    // Editing the same light again does not mark it twice.
+    buffer.uploads.clear();
+    store.edit(handles[20])->pos.x = 100.0f;
+    store.edit(handles[5])->pos.x = 101.0f;
+    store.edit(handles[20])->strength = 9.0f;
+    store.edit(handles[11])->color.g = 7;
+    CHECK(store.num_dirty() == 3);
+    buffer.flush(store);
+    CHECK(buffer.uploads.size() == 1);
+    if(!buffer.uploads.empty()) {
+        CHECK(buffer.uploads[0].first == 5);
+        CHECK(buffer.uploads[0].count == 16);
+    }
+    CHECK(_buffer_matches(store, buffer));
+
+    // Dirty light removed before the flush is skipped.
+    buffer.uploads.clear();
+    store.edit(handles[31])->pos.x = 102.0f;
+    CHECK(store.remove(handles[31]));
+    buffer.flush(store);
+    CHECK(buffer.uploads.empty());
+
+    // Edit + remove in the middle: the moved light is uploaded to the removed one's place.
+    buffer.uploads.clear();
+    store.edit(handles[3])->pos.x = 103.0f;
+    CHECK(store.remove(handles[1]));
+    buffer.flush(store);
+    CHECK(buffer.uploads.size() == 1);
+    if(!buffer.uploads.empty()) {
+        CHECK(buffer.uploads[0].first == 1);
+        CHECK(buffer.uploads[0].count == 3);
+    }
+    CHECK(_buffer_matches(store, buffer));
+}
+
+// Random adds, removes and edits against a plain list of the live handles.
+static void _test_random() {
+    AM::LightStore store(256);
+    FakeBuffer buffer;
+    std::vector<AM::LightHandle> live;
+    std::vector<float> live_x;
+    std::vector<AM::LightHandle> dead;
+
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    auto next = [&seed]() {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return seed;
+    };
+
+    bool all_ok = true;
+    for(int frame = 0; frame < 2000; frame++) {
+        const int num_ops = (int)(next() % 8);
+        for(int op = 0; op < num_ops; op++) {
+            const uint64_t r = next() % 3;
+            if((r == 0) && (store.size() < store.max_size())) {
+                const float x = (float)(next() % 10000);
+                live.push_back(store.add(_light(x)));
+                live_x.push_back(x);
+            }
+            else if((r == 1) && !live.empty()) {
+                const size_t i = next() % live.size();
+                all_ok = all_ok && store.remove(live[i]);
+                dead.push_back(live[i]);
+                live[i] = live.back();
+                live_x[i] = live_x.back();
+                live.pop_back();
+                live_x.pop_back();
+            }
+            else if(!live.empty()) {
+                const size_t i = next() % live.size();
+                live_x[i] = (float)(next() % 10000);
+                store.edit(live[i])->pos.x = live_x[i];
+            }
+        }
+
+        const size_t num_uploads = buffer.uploads.size();
+        buffer.flush(store);
+        all_ok = all_ok && (buffer.uploads.size() <= num_uploads + 1);
+        all_ok = all_ok && _buffer_matches(store, buffer);
+        all_ok = all_ok && (store.size() == live.size());
+        for(size_t i = 0; i < live.size(); i++) {
+            const AM::Light* light = store.get(live[i]);
+            all_ok = all_ok && (light != NULL) && (light->pos.x == live_x[i]);
+        }
+        for(const AM::LightHandle& handle : dead) {
+            all_ok = all_ok && !store.valid(handle);
+        }
+    }
+    CHECK(all_ok);
+    CHECK(dead.size() > 1000);
+}
+
+int main() {
+    _test_handles();
+    _test_swap_remove();
+    _test_dirty_range();
+    _test_random();
+    return AM::Test::finish("test_light_store");
+}
+
@@ -0,0 +1,116 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <unistd.h>
+
+#include "test.hpp"
+#include "shared/include/logger.hpp"
+
+namespace fs = std::filesystem;
+
+
+// Format checks done at compile time, and the text the logger thread writes
+// for every kind of argument. stdout goes to a file which is read back.
+
+using AM::log_internal::check_format;
+using AM::log_internal::FormatError;
+
+enum TestEnum : uint8_t { TEST_ENUM_VALUE = 7 };
+
+// Accepted.
+static_assert(check_format<>("No arguments\n") == FormatError::NONE);
+static_assert(check_format<>("100%% done\n") == FormatError::NONE);
+static_assert(check_format<int, const char*>("%i %s\n") == FormatError::NONE);
+static_assert(check_format<std::string, std::string_view, AM::LogBytes>("%s %s %s") == FormatError::NONE);
+static_assert(check_format<char[6]>("%s") == FormatError::NONE);
+static_assert(check_format<float, double>("%0.2f %g") == FormatError::NONE);
+static_assert(check_format<long double>("%Lf") == FormatError::NONE);
+static_assert(check_format<int64_t, size_t, uint64_t>("%li %zu %lu") == FormatError::NONE);
+static_assert(check_format<long long>("%lld") == FormatError::NONE);
+static_assert(check_format<char, bool, uint16_t, TestEnum>("%c %i %hu %i") == FormatError::NONE);
+static_assert(check_format<std::string, int, const char*>("%-16s %*s") == FormatError::NONE);
+static_assert(check_format<int, int, const char*>("%*.*s") == FormatError::NONE);
+static_assert(check_format<void*, const char*>("%p %p") == FormatError::NONE);
+
+// Rejected.
+static_assert(check_format<>("%i") == FormatError::TOO_FEW_ARGUMENTS);
+static_assert(check_format<int>("%*i") == FormatError::TOO_FEW_ARGUMENTS);
+static_assert(check_format<int, int>("%i") == FormatError::TOO_MANY_ARGUMENTS);
+static_assert(check_format<std::string>("%i") == FormatError::WRONG_ARGUMENT_TYPE);
+static_assert(check_format<int>("%s") == FormatError::WRONG_ARGUMENT_TYPE);
+static_assert(check_format<int64_t>("%i") == FormatError::WRONG_ARGUMENT_TYPE);
+static_assert(check_format<int>("%li") == FormatError::WRONG_ARGUMENT_TYPE);
+static_assert(check_format<float>("%i") == FormatError::WRONG_ARGUMENT_TYPE);
+static_assert(check_format<int>("%f") == FormatError::WRONG_ARGUMENT_TYPE);
+static_assert(check_format<size_t, const char*>("%*s") == FormatError::WRONG_ARGUMENT_TYPE);
+static_assert(check_format<int>("%p") == FormatError::WRONG_ARGUMENT_TYPE);
+static_assert(check_format<int*>("%n") == FormatError::UNKNOWN_CONVERSION);
+static_assert(check_format<int>("%y") == FormatError::UNKNOWN_CONVERSION);
+static_assert(check_format<>("50%") == FormatError::UNKNOWN_CONVERSION);
+
+
+static std::string _read_file(const fs::path& path) {
+    std::ifstream file(path);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+static void _test_output(const fs::path& out_path) {
+    const std::string name = "chunk_12";
+    const std::string_view view = std::string_view("abcdef").substr(1, 3);
+    const char name_array[] = "array";
+    const char* null_str = NULL;
+    const uint8_t bytes[] = { 0x0A, 0x1B, 0xFF };
+    std::vector<uint8_t> many_bytes(AM::LOG_MAX_HEX_BYTES + 10, 0xAB);
+
+    AM::log_info("int %i, float %0.2f, size %zu, enum %i\n", -5, 1.5f, (size_t)123, TEST_ENUM_VALUE);
+    AM::log_info("%s|%s|%s|%s|%-6s|\n", name, view, name_array, null_str, "lit");
+    AM::log_info("%*.*s|\n", 4, 2, "xyz");
+    AM::log_info("bytes %s\n", AM::LogBytes { bytes, sizeof(bytes) });
+    AM::log_info("many %s\n", AM::LogBytes { many_bytes.data(), many_bytes.size() });
+    AM::log_debug("hidden %i\n", 1);
+
+    // Messages of other threads are in the order they were logged.
+    std::thread([]() { AM::log_info("from thread %i\n", 1); }).join();
+    AM::log_info("after thread\n");
+    AM::log_flush();
+
+    std::string expected_many = "many ";
+    for(size_t i = 0; i < AM::LOG_MAX_HEX_BYTES; i++) {
+        expected_many += "AB ";
+    }
+    expected_many += "...\n";
+    const std::string output = _read_file(out_path);
+    CHECK(output.find("int -5, float 1.50, size 123, enum 7\n") != std::string::npos);
+    CHECK(output.find("chunk_12|bcd|array|(null)|lit   |\n") != std::string::npos);
+    CHECK(output.find("  xy|\n") != std::string::npos);
+    CHECK(output.find("bytes 0A 1B FF\n") != std::string::npos);
+    CHECK(output.find("hidden") == std::string::npos);
+    CHECK(output.find("from thread 1\nafter thread\n") != std::string::npos);
+    // Hex is cut to LOG_MAX_HEX_BYTES.
+    CHECK(output.find(expected_many) != std::string::npos);
+    CHECK(AM::log_num_dropped() == 0);
+}
+
+int main() {
+    const fs::path out_path = fs::temp_directory_path() / "ambient3d_test_logger.txt";
+    const int stdout_copy = dup(STDOUT_FILENO);
+    if(!freopen(out_path.c_str(), "w", stdout)) {
+        fprintf(stderr, "ERROR! Failed to redirect stdout to %s\n", out_path.c_str());
+        return 1;
+    }
+
+    _test_output(out_path);
+
+    fflush(stdout);
+    dup2(stdout_copy, STDOUT_FILENO);
+    close(stdout_copy);
+    fs::remove(out_path);
+    return AM::Test::finish("test_logger");
+}
+
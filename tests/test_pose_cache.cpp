@@ -0,0 +1,187 @@
+#include <cstdio>
+#include <vector>
+
+#include "test.hpp"
+#include "src/ambient3d/pose_cache.hpp"
+#include "raymath.h"
+
+
+// Frame sampling with wrap-around and the lazily computed skinning matrices
+// of PoseCache, on a small made up skeleton.
+
+static constexpr int   BONE_COUNT = 4;
+static constexpr float FRAME_DURATION = 1.0f / 30.0f;
+
+// Frame poses of one animation. Bone 'b' on frame 'f' is at (f, b, anim)
+// and turned around Y by f * 0.1 radians.
+struct TestAnimation {
+    std::vector<std::vector<Transform>> frames;
+    std::vector<Transform*> frame_ptrs;
+    std::vector<BoneInfo> bones;
+
+    TestAnimation(int frame_count, int anim_index) {
+        frames.resize(frame_count);
+        for(int f = 0; f < frame_count; f++) {
+            for(int b = 0; b < BONE_COUNT; b++) {
+                frames[f].push_back(Transform {
+                    .translation = { (float)f, (float)b, (float)anim_index },
+                    .rotation = QuaternionFromAxisAngle({ 0.0f, 1.0f, 0.0f }, f * 0.1f),
+                    .scale = { 1.0f, 1.0f, 1.0f }
+                });
+            }
+            frame_ptrs.push_back(frames[f].data());
+        }
+        bones.resize(BONE_COUNT);
+    }
+
+    ModelAnimation anim() {
+        ModelAnimation anim {};
+        anim.boneCount = BONE_COUNT;
+        anim.frameCount = (int)frames.size();
+        anim.bones = bones.data();
+        anim.framePoses = frame_ptrs.data();
+        return anim;
+    }
+};
+
+static std::vector<Transform> _bind_pose() {
+    std::vector<Transform> bind_pose;
+    for(int b = 0; b < BONE_COUNT; b++) {
+        bind_pose.push_back(Transform {
+            .translation = { 0.0f, (float)b * 2.0f, 0.0f },
+            .rotation = QuaternionIdentity(),
+            .scale = { 1.0f, 1.0f, 1.0f }
+        });
+    }
+    return bind_pose;
+}
+
+static void _test_sample_frame() {
+    const int count = 10;
+    // Middle of frames so float rounding at the frame boundaries does not matter.
+    auto time_of = [](double frame) { return (float)((frame + 0.5) * FRAME_DURATION); };
+
+    CHECK(AM::sample_animation_frame(0.0f, FRAME_DURATION, count) == 0);
+    CHECK(AM::sample_animation_frame(-1.0f, FRAME_DURATION, count) == 0);
+    CHECK(AM::sample_animation_frame(time_of(0), FRAME_DURATION, count) == 0);
+    CHECK(AM::sample_animation_frame(time_of(3), FRAME_DURATION, count) == 3);
+    CHECK(AM::sample_animation_frame(time_of(9), FRAME_DURATION, count) == 9);
+
+    // Wraps around.
+    CHECK(AM::sample_animation_frame(time_of(10), FRAME_DURATION, count) == 0);
+    CHECK(AM::sample_animation_frame(time_of(13), FRAME_DURATION, count) == 3);
+    CHECK(AM::sample_animation_frame(time_of(10 * 7 + 9), FRAME_DURATION, count) == 9);
+
+    // Hours of playing stay in range.
+    const int late = AM::sample_animation_frame(time_of(30.0 * 3600.0 * 5.0 + 4), FRAME_DURATION, count);
+    CHECK((late >= 0) && (late < count));
+    CHECK(AM::sample_animation_frame(1e9f, FRAME_DURATION, count) < count);
+
+    // Broken animations.
+    CHECK(AM::sample_animation_frame(1.0f, 0.0f, count) == 0);
+    CHECK(AM::sample_animation_frame(1.0f, FRAME_DURATION, 0) == 0);
+    CHECK(AM::sample_animation_frame(1.0f, FRAME_DURATION, 1) == 0);
+
+    // Every frame is visited in order over two loops.
+    bool in_order = true;
+    for(int frame = 0; frame < count * 2; frame++) {
+        in_order = in_order && (AM::sample_animation_frame(time_of(frame), FRAME_DURATION, count) == frame % count);
+    }
+    CHECK(in_order);
+}
+
+static void _test_lazy_frames() {
+    TestAnimation walk(10, 0);
+    TestAnimation run(6, 1);
+    const ModelAnimation anims[2] = { walk.anim(), run.anim() };
+    const std::vector<Transform> bind_pose = _bind_pose();
+
+    AM::PoseCache cache;
+    CHECK(cache.init(bind_pose.data(), BONE_COUNT, anims, 2));
+    CHECK(cache.num_anims() == 2);
+    CHECK(cache.frame_count(0) == 10);
+    CHECK(cache.frame_count(1) == 6);
+    CHECK(cache.frame_count(2) == 0);
+    CHECK(cache.bone_count() == BONE_COUNT);
+
+    // Nothing is computed before it is asked for.
+    CHECK(cache.num_computed() == 0);
+
+    const Matrix* frame_3 = cache.get(0, 3);
+    CHECK(frame_3 != NULL);
+    CHECK(cache.num_computed() == 1);
+
+    // Same frame again, also through wrap-around, is not computed again.
+    CHECK(cache.get(0, 3) == frame_3);
+    CHECK(cache.get(0, 13) == frame_3);
+    CHECK(cache.get(0, -7) == frame_3);
+    CHECK(cache.num_computed() == 1);
+
+    // Other animation has its own frames.
+    const Matrix* run_3 = cache.get(1, 3);
+    CHECK((run_3 != NULL) && (run_3 != frame_3));
+    CHECK(cache.get(1, 9) == run_3);
+    CHECK(cache.num_computed() == 2);
+
+    CHECK(cache.get(0, -1) == cache.get(0, 9));
+    CHECK(cache.num_computed() == 3);
+
+    CHECK(cache.get(2, 0) == NULL);
+    CHECK(cache.num_computed() == 3);
+
+    // Many instances showing a few frames.
+    for(int instance = 0; instance < 32; instance++) {
+        for(int frame = 0; frame < 4; frame++) {
+            cache.get(instance % 2, frame);
+        }
+    }
+    CHECK(cache.num_computed() == 3 + 6);
+
+    // Skinning matrix moves a vertex from the bind pose to the frame pose:
+    // relative to the bone's bind position, then turned and moved to the frame position.
+    const float angle = 3 * 0.1f;
+    for(int b = 0; b < BONE_COUNT; b++) {
+        const Vector3 vertex = { 0.5f, (float)b * 2.0f + 0.25f, -1.0f };
+        const Vector3 local = Vector3Subtract(vertex, bind_pose[b].translation);
+        const Vector3 expected = Vector3Add(
+                Vector3RotateByAxisAngle(local, { 0.0f, 1.0f, 0.0f }, angle),
+                walk.frames[3][b].translation);
+        const Vector3 skinned = Vector3Transform(vertex, frame_3[b]);
+        CHECK_NEAR(skinned.x, expected.x, 1e-5);
+        CHECK_NEAR(skinned.y, expected.y, 1e-5);
+        CHECK_NEAR(skinned.z, expected.z, 1e-5);
+    }
+
+    // Clear forgets the computed frames.
+    cache.clear();
+    CHECK(cache.num_anims() == 0);
+    CHECK(cache.num_computed() == 0);
+    CHECK(cache.get(0, 0) == NULL);
+}
+
+static void _test_init_errors() {
+    TestAnimation walk(4, 0);
+    ModelAnimation anim = walk.anim();
+    const std::vector<Transform> bind_pose = _bind_pose();
+
+    AM::PoseCache cache;
+    anim.boneCount = BONE_COUNT - 1;
+    CHECK(!cache.init(bind_pose.data(), BONE_COUNT, &anim, 1));
+    CHECK(cache.num_anims() == 0);
+
+    std::vector<Transform> big_bind_pose(AM::MAX_SKINNING_BONES + 1, bind_pose[0]);
+    anim.boneCount = AM::MAX_SKINNING_BONES + 1;
+    CHECK(!cache.init(big_bind_pose.data(), AM::MAX_SKINNING_BONES + 1, &anim, 1));
+
+    // No animations is fine, there is just nothing to get.
+    CHECK(cache.init(bind_pose.data(), BONE_COUNT, NULL, 0));
+    CHECK(cache.get(0, 0) == NULL);
+}
+
+int main() {
+    _test_sample_frame();
+    _test_lazy_frames();
+    _test_init_errors();
+    return AM::Test::finish("test_pose_cache");
+}
+
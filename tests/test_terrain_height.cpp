@@ -0,0 +1,145 @@
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "test.hpp"
+#include "shared/include/terrain_height.hpp"
+#include "shared/include/chunk_map.hpp"
+#include "shared/include/ray.hpp"
+
+
+// TerrainHeight::sample against the ray cast it replaced.
+// The ray path is get_chunk_meshrect (split along the mesh diagonal) + Ray::rectangle_intersection.
+
+static constexpr int   CHUNK_SIZE = 16;
+static constexpr float CHUNK_SCALE = 4.0f;
+static constexpr int   WORLD_RADIUS = 2; // Chunks -2..2 on both axes.
+
+// Height of a global grid point. Neighbour chunks share their edge points like the server generates them.
+static float _grid_height(int grid_x, int grid_z) {
+    uint32_t h = (uint32_t)grid_x * 0x8DA6B343u ^ (uint32_t)grid_z * 0xD8163841u;
+    h ^= h >> 13;
+    h *= 0x5BD1E995u;
+    h ^= h >> 15;
+    return (float)(h & 0xFFFF) / 65535.0f * 30.0f - 10.0f;
+}
+
+static AM::ChunkMap<std::vector<float>> _create_world() {
+    const int row = CHUNK_SIZE+1;
+    AM::ChunkMap<std::vector<float>> world;
+    for(int cz = -WORLD_RADIUS; cz <= WORLD_RADIUS; cz++) {
+        for(int cx = -WORLD_RADIUS; cx <= WORLD_RADIUS; cx++) {
+            std::vector<float> heights(row * row);
+            for(int z = 0; z < row; z++) {
+                for(int x = 0; x < row; x++) {
+                    heights[z * row + x] = _grid_height(cx * CHUNK_SIZE + x, cz * CHUNK_SIZE + z);
+                }
+            }
+            world[AM::ChunkPos(cx, cz)] = heights;
+        }
+    }
+    return world;
+}
+
+static float _sample(const AM::ChunkMap<std::vector<float>>& world, float world_x, float world_z) {
+    const AM::TerrainHeight::GridPoint point
+        = AM::TerrainHeight::world_to_grid(world_x, world_z, CHUNK_SIZE, CHUNK_SCALE);
+    auto search = world.find(point.chunk_pos);
+    if(!CHECK(search != world.end())) {
+        return 0.0f;
+    }
+    return AM::TerrainHeight::sample(search->second.data(), CHUNK_SIZE, point.local_x, point.local_z);
+}
+
+// Same triangles as Terrain::get_chunk_meshrect.
+static AM::Rect _meshrect(float world_x, float world_z) {
+    const int gx = (int)floorf(world_x / CHUNK_SCALE);
+    const int gz = (int)floorf(world_z / CHUNK_SCALE);
+    auto vertex = [](int x, int z) {
+        return AM::Vec3(x * CHUNK_SCALE, _grid_height(x, z), z * CHUNK_SCALE);
+    };
+    const AM::Vec3 A = vertex(gx,   gz);
+    const AM::Vec3 B = vertex(gx+1, gz);
+    const AM::Vec3 C = vertex(gx+1, gz+1);
+    const AM::Vec3 D = vertex(gx,   gz+1);
+    return AM::Rect(AM::Triangle(A, D, B), AM::Triangle(B, D, C));
+}
+
+static bool _ray_height(float world_x, float world_z, float* height_out) {
+    AM::Ray ray(AM::Vec3(world_x, 100.0f, world_z), AM::Vec3(0.0f, -1.0f, 0.0f));
+    const AM::RayHitResult hit = ray.rectangle_intersection(_meshrect(world_x, world_z));
+    *height_out = hit.point.y;
+    return hit.hit;
+}
+
+static void _test_random_positions(const AM::ChunkMap<std::vector<float>>& world) {
+    const float world_half = WORLD_RADIUS * CHUNK_SIZE * CHUNK_SCALE;
+    uint32_t seed = 77;
+    auto random_coord = [&seed, world_half]() {
+        seed = seed * 1664525u + 1013904223u;
+        return ((float)(seed >> 8) / (float)(1u << 24)) * 2.0f * world_half * 0.999f - world_half;
+    };
+
+    int num_missed = 0;
+    float max_error = 0.0f;
+    for(int i = 0; i < 200000; i++) {
+        const float world_x = random_coord();
+        const float world_z = random_coord();
+        float ray_height = 0.0f;
+        if(!_ray_height(world_x, world_z, &ray_height)) {
+            num_missed++;
+            continue;
+        }
+        max_error = fmaxf(max_error, fabsf(ray_height - _sample(world, world_x, world_z)));
+    }
+    printf("  random positions: max difference %g, ray misses %i\n", max_error, num_missed);
+    CHECK(max_error < 1e-4f);
+    CHECK(num_missed == 0);
+}
+
+static void _test_grid_points(const AM::ChunkMap<std::vector<float>>& world) {
+    // Grid points and chunk corners give the stored height, including the
+    // last row and column of a chunk (local coordinate == chunk size).
+    for(int gz = -20; gz <= 20; gz += 3) {
+        for(int gx = -20; gx <= 20; gx += 3) {
+            CHECK_NEAR(_sample(world, gx * CHUNK_SCALE, gz * CHUNK_SCALE), _grid_height(gx, gz), 1e-5);
+        }
+    }
+    CHECK_NEAR(_sample(world, CHUNK_SIZE * CHUNK_SCALE, 0.0f), _grid_height(CHUNK_SIZE, 0), 1e-5);
+    // Continuous over the chunk border: just left of it is inside of chunk (-1, 0)
+    CHECK_NEAR(_sample(world, -CHUNK_SCALE * 0.0001f, 0.0f), _grid_height(0, 0), 1e-2);
+
+    // Along the diagonal both triangles give the same height.
+    for(int k = 1; k < 10; k++) {
+        const float t = k / 10.0f;
+        const float world_x = (3.0f + t) * CHUNK_SCALE;
+        const float world_z = (5.0f + (1.0f - t)) * CHUNK_SCALE;
+        const float expected = _grid_height(3, 6) + t * (_grid_height(4, 5) - _grid_height(3, 6));
+        CHECK_NEAR(_sample(world, world_x, world_z), expected, 1e-4);
+    }
+}
+
+// The ray-triangle test used to check u > 1 instead of u + v > 1,
+// so points past the diagonal were reported as hits on the wrong triangle.
+static void _test_ray_triangle_bounds() {
+    const AM::Triangle triangle(AM::Vec3(0, 0, 0), AM::Vec3(0, 0, 1), AM::Vec3(1, 0, 0));
+    auto hits = [&triangle](float x, float z) {
+        AM::Ray ray(AM::Vec3(x, 1.0f, z), AM::Vec3(0.0f, -1.0f, 0.0f));
+        return ray.triangle_intersection(triangle).hit;
+    };
+    CHECK(hits(0.2f, 0.2f));
+    CHECK(hits(0.45f, 0.45f));
+    CHECK(!hits(0.55f, 0.55f));
+    CHECK(!hits(0.9f, 0.9f));
+    CHECK(!hits(-0.1f, 0.5f));
+    CHECK(!hits(0.5f, -0.1f));
+}
+
+int main() {
+    const AM::ChunkMap<std::vector<float>> world = _create_world();
+    _test_random_positions(world);
+    _test_grid_points(world);
+    _test_ray_triangle_bounds();
+    return AM::Test::finish("test_terrain_height");
+}
+
@@ -0,0 +1,240 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "test.hpp"
+#include "raylib.h"
+#include "raymath.h"
+#include "external/glad.h"
+#include "src/ambient3d/shader_util.hpp"
+#include "src/ambient3d/renderable.hpp"
+
+
+// Uniform cache against mock OpenGL functions which only count the calls.
+// The mock replaces the glad function pointers, so the default path in shader_util.cpp
+// is what gets counted. No window or GL context is needed.
+
+struct GLCalls {
+    int get_location;
+    int uniform;
+    int active_texture;
+    int bind_texture;
+    int total() const { return get_location + uniform + active_texture + bind_texture; }
+};
+
+static GLCalls g_calls {};
+static std::vector<float> g_last_matrix;
+static int g_next_location = 0;
+
+// Uniforms starting with "u_missing" are not in the shader.
+static GLint _mock_get_location(GLuint, const GLchar* name) {
+    g_calls.get_location++;
+    if(std::string(name).starts_with("u_missing")) {
+        return -1;
+    }
+    return g_next_location++;
+}
+static void _mock_uniform_1i(GLuint, GLint, GLint) { g_calls.uniform++; }
+static void _mock_uniform_1f(GLuint, GLint, GLfloat) { g_calls.uniform++; }
+static void _mock_uniform_2f(GLuint, GLint, GLfloat, GLfloat) { g_calls.uniform++; }
+static void _mock_uniform_3f(GLuint, GLint, GLfloat, GLfloat, GLfloat) { g_calls.uniform++; }
+static void _mock_uniform_4f(GLuint, GLint, GLfloat, GLfloat, GLfloat, GLfloat) { g_calls.uniform++; }
+static void _mock_uniform_matrix4(GLuint, GLint, GLsizei count, GLboolean, const GLfloat* value) {
+    g_calls.uniform++;
+    g_last_matrix.assign(value, value + 16 * count);
+}
+static void _mock_active_texture(GLenum) { g_calls.active_texture++; }
+static void _mock_bind_texture(GLenum, GLuint) { g_calls.bind_texture++; }
+
+PFNGLGETUNIFORMLOCATIONPROC      glad_glGetUniformLocation      = _mock_get_location;
+PFNGLPROGRAMUNIFORM1IPROC        glad_glProgramUniform1i        = _mock_uniform_1i;
+PFNGLPROGRAMUNIFORM1FPROC        glad_glProgramUniform1f        = _mock_uniform_1f;
+PFNGLPROGRAMUNIFORM2FPROC        glad_glProgramUniform2f        = _mock_uniform_2f;
+PFNGLPROGRAMUNIFORM3FPROC        glad_glProgramUniform3f        = _mock_uniform_3f;
+PFNGLPROGRAMUNIFORM4FPROC        glad_glProgramUniform4f        = _mock_uniform_4f;
+PFNGLPROGRAMUNIFORMMATRIX4FVPROC glad_glProgramUniformMatrix4fv = _mock_uniform_matrix4;
+PFNGLACTIVETEXTUREPROC           glad_glActiveTexture           = _mock_active_texture;
+PFNGLBINDTEXTUREPROC             glad_glBindTexture             = _mock_bind_texture;
+
+int GetShaderLocationAttrib(Shader, const char*) {
+    return -1;
+}
+
+
+static constexpr int NUM_MESHES = 300;
+static constexpr int NUM_SHADERS = 3;
+static constexpr int NUM_FRAMES = 100;
+
+// Same uniform calls as Renderable::render makes for each mesh.
+// Skinned meshes are drawn with their own shader.
+static void _render_mesh(int shader_id, const AM::MeshAttrib& mesh_attr, bool skinned) {
+    AM::set_uniform_int(shader_id, "u_affected_by_wind", mesh_attr.affected_by_wind);
+    AM::set_uniform_float(shader_id, "u_material_shine_level", mesh_attr.shine);
+    AM::set_uniform_float(shader_id, "u_material_specular", mesh_attr.specular);
+    AM::set_uniform_int(shader_id, "u_skinned", skinned);
+
+    AM::set_uniform_float(shader_id, "u_material_shine_level", AM::MATERIAL_DEFAULT_SHINE);
+    AM::set_uniform_float(shader_id, "u_material_specular", AM::MATERIAL_DEFAULT_SPECULAR);
+    if(mesh_attr.affected_by_wind) {
+        AM::set_uniform_int(shader_id, "u_affected_by_wind", 0);
+    }
+}
+
+static void _render_frame(const std::vector<AM::MeshAttrib>& meshes) {
+    for(int i = 0; i < NUM_MESHES; i++) {
+        const int shader_id = 1 + i % NUM_SHADERS;
+        _render_mesh(shader_id, meshes[i], (shader_id == NUM_SHADERS));
+    }
+}
+
+static void _test_frames() {
+    std::vector<AM::MeshAttrib> meshes(NUM_MESHES);
+
+    g_calls = GLCalls{};
+    _render_frame(meshes);
+    const GLCalls first = g_calls;
+
+    // 4 names per shader: one lookup each, at most one value each.
+    CHECK(first.get_location == 4 * NUM_SHADERS);
+    CHECK(first.uniform <= 4 * NUM_SHADERS);
+
+    g_calls = GLCalls{};
+    for(int frame = 0; frame < NUM_FRAMES; frame++) {
+        _render_frame(meshes);
+    }
+    const GLCalls same = g_calls;
+    CHECK(same.total() == 0);
+
+    printf("  %i meshes, %i shaders: first frame %i GL calls, next %i frames %i calls (%.2f per frame)\n",
+            NUM_MESHES, NUM_SHADERS, first.total(), NUM_FRAMES, same.total(),
+            (double)same.total() / NUM_FRAMES);
+
+    // One mesh with its own material values: set and reset every frame,
+    // each change is sent once.
+    meshes[7].affected_by_wind = true;
+    meshes[7].shine = 0.5f;
+    g_calls = GLCalls{};
+    for(int frame = 0; frame < NUM_FRAMES; frame++) {
+        _render_frame(meshes);
+    }
+    CHECK(g_calls.get_location == 0);
+    CHECK(g_calls.uniform == NUM_FRAMES * 4);
+
+    printf("  1 mesh with own material values: %.2f calls per frame\n",
+            (double)g_calls.total() / NUM_FRAMES);
+}
+
+static void _test_values() {
+    const int shader_id = 10;
+
+    // Equal names in different buffers are the same uniform.
+    g_calls = GLCalls{};
+    const std::string name = "u_scale";
+    AM::set_uniform_float(shader_id, name.c_str(), 1.0f);
+    AM::set_uniform_float(shader_id, std::string(name).c_str(), 1.0f);
+    AM::set_uniform_float(shader_id, "u_scale", 1.0f);
+    CHECK(g_calls.get_location == 1);
+    CHECK(g_calls.uniform == 1);
+
+    // Same name in other shader is another uniform.
+    AM::set_uniform_float(shader_id + 1, "u_scale", 1.0f);
+    CHECK(g_calls.get_location == 2);
+    CHECK(g_calls.uniform == 2);
+
+    // Every type is sent only when it changes.
+    g_calls = GLCalls{};
+    const AM::UniformHandle vec2 = AM::find_uniform(shader_id, "u_vec2");
+    const AM::UniformHandle vec3 = AM::find_uniform(shader_id, "u_vec3");
+    const AM::UniformHandle vec4 = AM::find_uniform(shader_id, "u_vec4");
+    const AM::UniformHandle matrix = AM::find_uniform(shader_id, "u_matrix");
+    const AM::UniformHandle integer = AM::find_uniform(shader_id, "u_int");
+    CHECK(g_calls.get_location == 5);
+    for(int i = 0; i < 3; i++) {
+        AM::set_uniform_vec2(vec2, { 1.0f, 2.0f });
+        AM::set_uniform_vec3(vec3, { 1.0f, 2.0f, 3.0f });
+        AM::set_uniform_vec4(vec4, { 1.0f, 2.0f, 3.0f, 4.0f });
+        AM::set_uniform_matrix(matrix, MatrixTranslate(1.0f, 2.0f, 3.0f));
+        AM::set_uniform_int(integer, 5);
+    }
+    CHECK(g_calls.uniform == 5);
+    CHECK(g_last_matrix.size() == 16);
+    if(g_last_matrix.size() == 16) {
+        CHECK(g_last_matrix[12] == 1.0f);
+        CHECK(g_last_matrix[13] == 2.0f);
+        CHECK(g_last_matrix[14] == 3.0f);
+    }
+
+    g_calls = GLCalls{};
+    AM::set_uniform_vec3(vec3, { 1.0f, 2.0f, 3.5f });
+    AM::set_uniform_int(integer, 6);
+    AM::set_uniform_int(integer, 6);
+    CHECK(g_calls.uniform == 2);
+
+    // Uniform not in the shader: looked up once, never sent.
+    g_calls = GLCalls{};
+    for(int i = 0; i < 10; i++) {
+        AM::set_uniform_float(shader_id, "u_missing", (float)i);
+    }
+    CHECK(g_calls.get_location == 1);
+    CHECK(g_calls.uniform == 0);
+
+    // Invalid handles and shaders.
+    AM::set_uniform_float(AM::UniformHandle{}, 1.0f);
+    AM::set_uniform_float(-1, "u_scale", 1.0f);
+    CHECK(g_calls.get_location == 1);
+    CHECK(g_calls.uniform == 0);
+
+    // Sampler slot is sent once, the texture is bound every time.
+    g_calls = GLCalls{};
+    const Texture2D texture { .id = 3 };
+    for(int i = 0; i < 4; i++) {
+        AM::set_uniform_sampler(shader_id, "u_texture", texture, 2);
+    }
+    CHECK(g_calls.uniform == 1);
+    CHECK(g_calls.active_texture == 4);
+    CHECK(g_calls.bind_texture == 4);
+
+    // Sampler with location 0.
+    g_next_location = 0;
+    g_calls = GLCalls{};
+    AM::set_uniform_sampler(shader_id + 2, "u_texture", texture, 1);
+    CHECK(g_calls.bind_texture == 1);
+
+    // Forgotten shader (unloaded and its id reused) is looked up and sent again.
+    g_calls = GLCalls{};
+    AM::forget_shader_uniforms(shader_id);
+    AM::set_uniform_float(shader_id, "u_scale", 1.0f);
+    AM::set_uniform_int(shader_id + 1, "u_scale", 1);
+    CHECK(g_calls.get_location == 1);
+    CHECK(g_calls.uniform == 2);
+}
+
+static int g_replaced_calls = 0;
+
+static void _test_replaced_funcs() {
+    AM::ShaderUniformFuncs funcs {
+        .get_location    = [](int, const char*) { g_replaced_calls++; return 0; },
+        .uniform_1i      = [](int, int, int) { g_replaced_calls++; },
+        .uniform_1f      = [](int, int, float) { g_replaced_calls++; },
+        .uniform_2f      = [](int, int, float, float) { g_replaced_calls++; },
+        .uniform_3f      = [](int, int, float, float, float) { g_replaced_calls++; },
+        .uniform_4f      = [](int, int, float, float, float, float) { g_replaced_calls++; },
+        .uniform_matrix4 = [](int, int, const float*) { g_replaced_calls++; }
+    };
+
+    // Values cached before are forgotten.
+    g_calls = GLCalls{};
+    AM::set_shader_uniform_funcs(funcs);
+    AM::set_uniform_float(10, "u_scale", 1.0f);
+    AM::set_uniform_float(10, "u_scale", 1.0f);
+    CHECK(g_replaced_calls == 2);
+    CHECK(g_calls.total() == 0);
+}
+
+int main() {
+    _test_frames();
+    _test_values();
+    _test_replaced_funcs();
+    return AM::Test::finish("test_uniform_cache");
+}
+